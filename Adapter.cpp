@@ -47,6 +47,29 @@ void Adapter::ClearList(bool freeAllMemory) {
 	}
 }
 
+// Move all adapters to a caller's list without deleting them (used when rescanning)
+//
+void Adapter::DetachList(vector <Adapter *> & detachedList) {
+	detachedList.clear();
+	if (adapterList) {
+		detachedList.swap(*adapterList);
+	}
+}
+
+// Return 'true' if this is the adapter described by an EnumDisplayDevices() result
+//
+bool Adapter::Matches(const DISPLAY_DEVICEW & displayAdapter) const {
+	return (DeviceKey == displayAdapter.DeviceKey) && (DeviceID == displayAdapter.DeviceID);
+}
+
+// Update the parts of an adapter that can change without it becoming a different adapter
+//
+void Adapter::Refresh(const DISPLAY_DEVICEW & displayAdapter) {
+	DeviceName = displayAdapter.DeviceName;
+	DeviceString = displayAdapter.DeviceString;
+	StateFlags = displayAdapter.StateFlags;
+}
+
 // Return 'true' if this adapter is active and part of the desktop
 //
 bool Adapter::IsActive(const DISPLAY_DEVICEW * displayAdapter) {
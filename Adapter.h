@@ -11,6 +11,10 @@ public:
 
 	static Adapter * Add(Adapter * adapter);
 	static void ClearList(bool freeAllMemory);
+	static void DetachList(vector <Adapter *> & detachedList);
+
+	bool Matches(const DISPLAY_DEVICEW & displayAdapter) const;
+	void Refresh(const DISPLAY_DEVICEW & displayAdapter);
 
 	DWORD GetStateFlags(void);
 	wstring GetDeviceName(void);
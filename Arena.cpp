@@ -0,0 +1,119 @@
+// Arena.cpp -- One block of memory for all of a parsed profile's structures
+//
+
+#include "stdafx.h"
+#include "Arena.h"
+#include "Counters.h"
+#include <strsafe.h>
+//#include <banned.h>
+
+// Some constants
+//
+#define ARENA_ROUND_UP(n)			( ((n) + (ARENA_ALIGNMENT - 1)) & ~static_cast<size_t>(ARENA_ALIGNMENT - 1) )
+#define ARENA_CHUNK_HEADER_SIZE		ARENA_ROUND_UP(sizeof(ARENA_CHUNK))
+
+// Constructor
+//
+Arena::Arena(size_t ordinaryChunkSize) :
+		chunkList(0),
+		chunkCount(0),
+		chunkSize(ordinaryChunkSize),
+		bytesReserved(0)
+{
+}
+
+// Destructor
+//
+Arena::~Arena() {
+	Release();
+}
+
+// Get a new chunk from the heap, with 'size' usable bytes
+//
+Arena::ARENA_CHUNK * Arena::NewChunk(size_t size) {
+	ARENA_CHUNK * chunk = reinterpret_cast<ARENA_CHUNK *>(new BYTE[ARENA_CHUNK_HEADER_SIZE + size]);
+	chunk->next = 0;
+	chunk->size = size;
+	chunk->used = 0;
+	bytesReserved += ARENA_CHUNK_HEADER_SIZE + size;
+	CountEvent(PC_ARENA_CHUNKS);
+	return chunk;
+}
+
+void Arena::FreeChunk(ARENA_CHUNK * chunk) {
+	bytesReserved -= ARENA_CHUNK_HEADER_SIZE + chunk->size;
+	delete [] reinterpret_cast<BYTE *>(chunk);
+}
+
+BYTE * Arena::ChunkData(ARENA_CHUNK * chunk) {
+	return reinterpret_cast<BYTE *>(chunk) + ARENA_CHUNK_HEADER_SIZE;
+}
+
+// Return 'byteCount' zeroed bytes that live until Reset() or Release()
+//
+void * Arena::Allocate(size_t byteCount) {
+	size_t roundedCount = ARENA_ROUND_UP(byteCount);
+	if ( 0 == roundedCount ) {
+		roundedCount = ARENA_ALIGNMENT;
+	}
+	ARENA_CHUNK * chunk = chunkList;
+	if ( !chunk || (chunk->size - chunk->used) < roundedCount ) {
+		if ( roundedCount > (chunkSize / 2) ) {
+
+			// A big request (a large 'vcgt', say) gets a chunk to itself.  We put it second on
+			//  the list so that the room left in the current chunk is still used.
+			//
+			chunk = NewChunk(roundedCount);
+			if (chunkList) {
+				chunk->next = chunkList->next;
+				chunkList->next = chunk;
+			} else {
+				chunkList = chunk;
+			}
+		} else {
+			chunk = NewChunk(chunkSize);
+			chunk->next = chunkList;
+			chunkList = chunk;
+		}
+		++chunkCount;
+	}
+	BYTE * p = ChunkData(chunk) + chunk->used;
+	chunk->used += roundedCount;
+	SecureZeroMemory(p, roundedCount);
+	return p;
+}
+
+// Take back everything handed out, but keep the oldest chunk so a reload does not need a new one
+//
+void Arena::Reset(void) {
+	ARENA_CHUNK * chunk = chunkList;
+	while ( chunk && chunk->next ) {
+		ARENA_CHUNK * next = chunk->next;
+		FreeChunk(chunk);
+		chunk = next;
+	}
+	chunkList = chunk;
+	if (chunk) {
+		chunk->used = 0;
+		chunkCount = 1;
+	}
+}
+
+// Take back everything handed out and free all chunks
+//
+void Arena::Release(void) {
+	while (chunkList) {
+		ARENA_CHUNK * next = chunkList->next;
+		FreeChunk(chunkList);
+		chunkList = next;
+	}
+	chunkCount = 0;
+}
+
+size_t Arena::GetChunkCount(void) const {
+	return chunkCount;
+}
+
+size_t Arena::GetBytesReserved(void) const {
+	return bytesReserved;
+}
@@ -0,0 +1,52 @@
+// Arena.h -- One block of memory for all of a parsed profile's structures
+//
+// LoadFullProfile() used to 'new' the header, the tag table, the sorted tag pointers and the
+//  'vcgt' separately, and to delete each of them again on a reload.  An Arena hands out pieces
+//  of one chunk instead, and takes them all back at once in Reset() or the destructor.  A
+//  request that does not fit gets another chunk, so an Arena never runs out; it just costs
+//  one more allocation.
+//
+
+#pragma once
+#include "stdafx.h"
+
+// Some constants
+//
+#define ARENA_CHUNK_SIZE		4096				// Fits a typical profile's header, tags and 'vcgt'
+#define ARENA_ALIGNMENT			8
+
+class Arena {
+
+public:
+	Arena(size_t ordinaryChunkSize = ARENA_CHUNK_SIZE);
+	~Arena();
+
+	void * Allocate(size_t byteCount);				// Zeroed, aligned to ARENA_ALIGNMENT
+	void Reset(void);								// Give everything back, keeping one chunk for reuse
+	void Release(void);								// Give everything back, freeing all chunks
+	size_t GetChunkCount(void) const;
+	size_t GetBytesReserved(void) const;			// Heap bytes held, including chunk headers
+
+	template <typename T> T * AllocateArray(size_t count) {
+		return static_cast<T *>(Allocate(count * sizeof(T)));
+	}
+
+private:
+	Arena(const Arena & other);						// Not copyable; Profile owns its Arena
+	Arena & operator = (const Arena & other);
+
+	typedef struct tag_ARENA_CHUNK {
+		struct tag_ARENA_CHUNK *	next;
+		size_t						size;			// Usable bytes following the chunk header
+		size_t						used;
+	} ARENA_CHUNK;
+
+	ARENA_CHUNK * NewChunk(size_t size);
+	void FreeChunk(ARENA_CHUNK * chunk);
+	static BYTE * ChunkData(ARENA_CHUNK * chunk);
+
+	ARENA_CHUNK *		chunkList;					// We allocate from the first chunk on the list
+	size_t				chunkCount;
+	size_t				chunkSize;					// Size of ordinary (not oversized) chunks
+	size_t				bytesReserved;
+};
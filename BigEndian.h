@@ -0,0 +1,57 @@
+// BigEndian.h -- Types for reading big-endian numbers in place
+//
+// ICC profiles store every number big-endian.  Declaring a field of an on-disk structure as
+//  BigEndian <DWORD> (for example) lets us lay the structure over bytes read from the file and
+//  read the field with Get(), instead of copying the structure field by field with swap32().
+//  The overload of ByteSwap() is picked at compile time from the field's type, and compiles to a
+//  single bswap (or rol for 16 bits) instruction.
+//
+
+#pragma once
+#include "stdafx.h"
+#include <stdlib.h>								// For _byteswap_ushort() and _byteswap_ulong()
+
+// Byte-reverse a value, one overload per type we store in files
+//
+__inline unsigned short ByteSwap(const unsigned short n) {
+	return _byteswap_ushort(n);
+}
+
+__inline short ByteSwap(const short n) {
+	return static_cast<short>(_byteswap_ushort(static_cast<unsigned short>(n)));
+}
+
+__inline unsigned long ByteSwap(const unsigned long n) {
+	return _byteswap_ulong(n);
+}
+
+__inline long ByteSwap(const long n) {
+	return static_cast<long>(_byteswap_ulong(static_cast<unsigned long>(n)));
+}
+
+// A number as stored in a file, big-endian; same size and layout as T, and no constructor, so it
+//  can sit in structures that we read straight from disk
+//
+template <typename T>
+class BigEndian {
+
+public:
+	T Get(void) const {
+		return ByteSwap(storedValue);
+	}
+
+	void Set(const T n) {
+		storedValue = ByteSwap(n);
+	}
+
+private:
+	T				storedValue;
+};
+
+// An ICC XYZNumber: three s15Fixed16Number values
+//
+typedef struct tag_BIG_ENDIAN_XYZ {
+	BigEndian <long>	X;
+	BigEndian <long>	Y;
+	BigEndian <long>	Z;
+} BIG_ENDIAN_XYZ;
@@ -0,0 +1,141 @@
+// ColorDirectoryIndex.cpp -- One shared list of the display profiles in the color directory
+//
+
+#include "stdafx.h"
+#include <algorithm>
+#include <hash_map>
+#include "ColorDirectoryIndex.h"
+#include "Counters.h"
+#include "Profile.h"
+#include "Trace.h"
+#include <strsafe.h>
+//#include <banned.h>
+
+// Symbols defined in other files
+//
+extern wchar_t * ColorDirectory;
+
+// What we know about every file in the color directory, display profile or not, so that Refresh()
+//  can tell which files have changed since we last looked
+//
+typedef struct tag_INDEXED_FILE {
+	FILETIME				lastWriteTime;
+	DWORD					fileSizeHigh;
+	DWORD					fileSizeLow;
+	COLOR_DIRECTORY_ENTRY	entry;						// entry.profile is zero if not a display profile
+} INDEXED_FILE;
+
+typedef stdext::hash_map <wstring, INDEXED_FILE> FILE_INDEX;
+
+// Global static symbols internal to this file
+//
+static FILE_INDEX * fileIndex = 0;						// Keyed by lowercased file name
+static vector <COLOR_DIRECTORY_ENTRY> * displayProfileList = 0;
+static bool indexBuilt = false;
+
+// Sort display profiles by name, the way TVM_SORTCHILDREN would
+//
+static bool CompareEntryNames(const COLOR_DIRECTORY_ENTRY & a, const COLOR_DIRECTORY_ENTRY & b) {
+	return ( lstrcmpi(a.profile->GetName().c_str(), b.profile->GetName().c_str()) < 0 );
+}
+
+// Return the display profiles, listing the color directory if this is the first time we're asked
+//
+const vector <COLOR_DIRECTORY_ENTRY> & ColorDirectoryIndex::GetDisplayProfiles(void) {
+	if ( !indexBuilt ) {
+		Refresh();
+	}
+	return *displayProfileList;
+}
+
+// List the color directory, reusing what we know about files that have not changed
+//
+void ColorDirectoryIndex::Refresh(void) {
+	TRACE_SCOPE(L"ColorDirectoryIndex::Refresh");
+	if ( 0 == fileIndex ) {
+		fileIndex = new FILE_INDEX;
+		displayProfileList = new vector <COLOR_DIRECTORY_ENTRY>;
+	}
+	displayProfileList->clear();
+	FILE_INDEX newIndex;
+
+	if (ColorDirectory) {
+		CountEvent(PC_COLOR_DIRECTORY_SCANS, 1);
+		wchar_t filepath[1024];
+		StringCbCopy(filepath, sizeof(filepath), ColorDirectory);
+		StringCbCat(filepath, sizeof(filepath), L"\\*");
+		WIN32_FIND_DATA findData;
+		SecureZeroMemory(&findData, sizeof(findData));
+		bool keepGoing = true;
+		HANDLE findHandle = FindFirstFile(filepath, &findData);
+		if (INVALID_HANDLE_VALUE != findHandle) {
+			while (keepGoing) {
+#define SKIP_BITS (FILE_ATTRIBUTE_DIRECTORY | FILE_ATTRIBUTE_DEVICE | FILE_ATTRIBUTE_REPARSE_POINT | FILE_ATTRIBUTE_OFFLINE | FILE_ATTRIBUTE_VIRTUAL)
+				if ( 0 == (SKIP_BITS & findData.dwFileAttributes) ) {
+					wstring key(findData.cFileName);
+					CharLowerBuff(&key[0], static_cast<DWORD>(key.size()));
+					FILE_INDEX::iterator it = fileIndex->find(key);
+					bool known = ( it != fileIndex->end() );
+					if ( known
+							&& (0 == CompareFileTime(&it->second.lastWriteTime, &findData.ftLastWriteTime))
+							&& (it->second.fileSizeHigh == findData.nFileSizeHigh)
+							&& (it->second.fileSizeLow == findData.nFileSizeLow) ) {
+						newIndex[key] = it->second;
+					} else {
+
+						// New or changed, so see if it is a display profile from its header and tag
+						//  table; a changed file that we have parsed is parsed again when it is next
+						//  needed, by ProfileLoader
+						//
+						INDEXED_FILE file;
+						file.lastWriteTime = findData.ftLastWriteTime;
+						file.fileSizeHigh = findData.nFileSizeHigh;
+						file.fileSizeLow = findData.nFileSizeLow;
+						file.entry.profile = 0;
+						file.entry.hasVCGT = false;
+						file.entry.hasWCS = false;
+						Profile * profile = Profile::Add(new Profile(findData.cFileName));
+						if (known) {
+							profile->Invalidate();
+						}
+						DWORD profileClass = 0;
+						bool hasVCGT = false;
+						bool hasWCS = false;
+						if ( profile->ReadTagSummary(profileClass, hasVCGT, hasWCS) && (CLASS_MONITOR == profileClass) ) {
+							file.entry.profile = profile;
+							file.entry.hasVCGT = hasVCGT;
+							file.entry.hasWCS = hasWCS;
+						}
+						newIndex[key] = file;
+					}
+					const INDEXED_FILE & indexed = newIndex[key];
+					if (indexed.entry.profile) {
+						displayProfileList->push_back(indexed.entry);
+					}
+				}
+				keepGoing = (0 != FindNextFile(findHandle, &findData));
+			}
+			FindClose(findHandle);
+		}
+	}
+	fileIndex->swap(newIndex);
+	sort(displayProfileList->begin(), displayProfileList->end(), CompareEntryNames);
+	indexBuilt = true;
+}
+
+// Forget everything we know about the color directory
+//
+void ColorDirectoryIndex::ClearList(bool freeAllMemory) {
+	indexBuilt = false;
+	if (fileIndex) {
+		if (freeAllMemory) {
+			delete fileIndex;
+			fileIndex = 0;
+			delete displayProfileList;
+			displayProfileList = 0;
+		} else {
+			fileIndex->clear();
+			displayProfileList->clear();
+		}
+	}
+}
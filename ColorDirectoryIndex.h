@@ -0,0 +1,32 @@
+// ColorDirectoryIndex.h -- One shared list of the display profiles in the color directory
+//
+// Every MonitorPage shows the installed display profiles that are not already on its own monitor's
+//  lists.  Rather than have each page list the color directory and read every file in it, we list
+//  it once here and remember what we learned about each file.  Refresh() lists the directory again,
+//  but only reads the header and tag table of files that are new or whose size or time stamp has
+//  changed; full parsing is left to ProfileLoader.  The display profiles are kept sorted by name,
+//  so a TreeView can show them in order without sorting its items.
+//
+
+#pragma once
+#include "stdafx.h"
+
+// Forward references
+//
+class Profile;
+
+// A valid display profile found in the color directory
+//
+typedef struct tag_COLOR_DIRECTORY_ENTRY {
+	Profile *		profile;
+	bool			hasVCGT;						// Profile has a 'vcgt' tag
+	bool			hasWCS;							// Profile has an embedded WCS profile
+} COLOR_DIRECTORY_ENTRY;
+
+class ColorDirectoryIndex {
+
+public:
+	static const vector <COLOR_DIRECTORY_ENTRY> & GetDisplayProfiles(void);
+	static void Refresh(void);
+	static void ClearList(bool freeAllMemory);
+};
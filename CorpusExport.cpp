@@ -0,0 +1,198 @@
+// CorpusExport.cpp -- Write a reproducible corpus of synthetic profiles to a folder, and test with it
+//
+// Profile i is built from seed SYNTHETIC_CORPUS_SEED + i and written as "synthetic-nnnnn.icm".
+//  A "corpus.txt" file lists the options each one was built with, so a parser failure can be
+//  traced back to the kind of profile that caused it.  The building is done by
+//  SyntheticProfile.cpp; all we do here is name and write the files.
+//
+// The /CT switch writes the corpus and then loads every profile in it with LoadFullProfile(),
+//  checking that each damaged profile fails and each clean one loads, and reports how long the
+//  parses took and how many heap allocations a load makes.
+//
+
+#include "stdafx.h"
+#include "CorpusExport.h"
+#include "Counters.h"
+#include "Profile.h"
+#include "SyntheticProfile.h"
+#include "Utility.h"
+#include <strsafe.h>
+//#include <banned.h>
+
+// Symbols defined in other files
+//
+extern wchar_t * ColorDirectory;
+
+// Global static symbols internal to this file
+//
+static const wchar_t * vcgtNames[] = { L"none", L"table", L"formula" };
+static const wchar_t * curveNames[] = { L"gamma", L"table", L"parametric" };
+static const wchar_t * damageNames[] = { L"none", L"bad-tag-offset", L"oversized-tag-count", L"truncated", L"short-vcgt-tag" };
+
+// Describe one profile's options as a line of "corpus.txt"
+//
+static wstring DescribeOptions(const wchar_t * fileName, unsigned int seed, const SYNTHETIC_PROFILE_OPTIONS & options, size_t size) {
+	wchar_t buf[512];
+	wchar_t vcgtText[64];
+	if ( SVCGT_TABLE == options.vcgt ) {
+		StringCbPrintf(vcgtText, sizeof(vcgtText), L"table(%ux%u%s)",
+				options.adobeMislabeledVcgt ? 256 : options.vcgtEntryCount,
+				options.adobeMislabeledVcgt ? 2 : options.vcgtItemSize,
+				options.adobeMislabeledVcgt ? L",adobe" : L"" );
+	} else {
+		StringCbCopy(vcgtText, sizeof(vcgtText), vcgtNames[options.vcgt]);
+	}
+	StringCbPrintf(buf, sizeof(buf), L"%s\tseed=%u\tsize=%u\tversion=%d\tcurves=%s\tvcgt=%s\twcs=%d\textraTags=%u\tdamage=%s\r\n",
+			fileName,
+			seed,
+			static_cast<unsigned int>(size),
+			options.version4 ? 4 : 2,
+			curveNames[options.curves],
+			vcgtText,
+			options.embeddedWcs ? 1 : 0,
+			options.extraTagCount,
+			damageNames[options.damage] );
+	return buf;
+}
+
+// Return the file name of profile 'i' of the corpus
+//
+static void CorpusFileName(unsigned int i, wchar_t * fileName, size_t fileNameSize) {
+	StringCbPrintf(fileName, fileNameSize, L"synthetic-%05u.icm", i);
+}
+
+// Build SYNTHETIC_CORPUS_SIZE profiles and write them, with an index, to 'outputFolder'
+//
+int WriteSyntheticCorpus(const wchar_t * outputFolder) {
+	int retVal = 0;
+	size_t written = 0;
+	wstring index;
+	vector <unsigned char> fileBytes;
+	SYNTHETIC_PROFILE_OPTIONS options;
+	for (unsigned int i = 0; i < SYNTHETIC_CORPUS_SIZE; ++i) {
+		unsigned int seed = SYNTHETIC_CORPUS_SEED + i;
+		ChooseSyntheticProfileOptions(seed, options);
+		BuildSyntheticProfile(seed, options, fileBytes);
+
+		wchar_t fileName[64];
+		wchar_t filePath[1024];
+		CorpusFileName(i, fileName, sizeof(fileName));
+		StringCbCopy(filePath, sizeof(filePath), outputFolder);
+		StringCbCat(filePath, sizeof(filePath), L"\\");
+		StringCbCat(filePath, sizeof(filePath), fileName);
+		if ( WriteBytesToFile(filePath, fileBytes) ) {
+			++written;
+			index += DescribeOptions(fileName, seed, options, fileBytes.size());
+		} else {
+			wstring s = L"Cannot write \"";
+			s += filePath;
+			s += L"\"\r\n";
+			WriteToConsole(ShowError(L"WriteFile", 0, s.c_str()));
+			retVal = 1;
+			break;
+		}
+	}
+
+	// Write the index as UTF-8; it is all ASCII
+	//
+	if ( !index.empty() ) {
+		wchar_t indexPath[1024];
+		StringCbCopy(indexPath, sizeof(indexPath), outputFolder);
+		StringCbCat(indexPath, sizeof(indexPath), L"\\corpus.txt");
+		vector <unsigned char> indexBytes(index.begin(), index.end());
+		if ( !WriteBytesToFile(indexPath, indexBytes) ) {
+			wstring s = L"Cannot write \"";
+			s += indexPath;
+			s += L"\"\r\n";
+			WriteToConsole(ShowError(L"WriteFile", 0, s.c_str()));
+			retVal = 1;
+		}
+	}
+
+	wchar_t buf[256];
+	StringCbPrintf(buf, sizeof(buf), L"%u synthetic profiles written\r\n", static_cast<unsigned int>(written));
+	WriteToConsole(buf);
+	return retVal;
+}
+
+// Return the number of heap allocations profile parsing has made so far:  arena chunks, buffers
+//  for oversized 'vcgt' tags, and LUT blocks the pool could not supply
+//
+static LONG ParseAllocationCount(void) {
+	return GetEventCount(PC_ARENA_CHUNKS) + GetEventCount(PC_PARSE_HEAP_BUFFERS) + GetEventCount(PC_LUT_ALLOCATIONS);
+}
+
+// Write the corpus to 'folder', then load each profile from there with LoadFullProfile() and
+//  check that it loads or fails as SyntheticProfileShouldLoad() says it should.  Report the time
+//  spent parsing, and the heap allocations made by the first CORPUS_ALLOCATION_LOADS clean loads.
+//  Returns nonzero if any profile had the wrong outcome.
+//
+int TestSyntheticCorpus(const wchar_t * folder) {
+	int retVal = WriteSyntheticCorpus(folder);
+	if (retVal) {
+		return retVal;
+	}
+
+	// Profile builds its file paths from ColorDirectory, so point that at the corpus for now
+	//
+	wchar_t * savedColorDirectory = ColorDirectory;
+	vector <wchar_t> corpusDirectory(folder, folder + wcslen(folder) + 1);
+	ColorDirectory = &corpusDirectory[0];
+
+	unsigned int kindCount[_countof(damageNames)] = { 0 };
+	unsigned int kindWrong[_countof(damageNames)] = { 0 };
+	unsigned int allocationLoads = 0;
+	LONG allocations = 0;
+	LARGE_INTEGER frequency;
+	LARGE_INTEGER start;
+	LARGE_INTEGER end;
+	LONGLONG parseTicks = 0;
+	QueryPerformanceFrequency(&frequency);
+	SYNTHETIC_PROFILE_OPTIONS options;
+	for (unsigned int i = 0; i < SYNTHETIC_CORPUS_SIZE; ++i) {
+		ChooseSyntheticProfileOptions(SYNTHETIC_CORPUS_SEED + i, options);
+		wchar_t fileName[64];
+		CorpusFileName(i, fileName, sizeof(fileName));
+		Profile * profile = new Profile(fileName);
+		LONG allocationsBefore = ParseAllocationCount();
+		QueryPerformanceCounter(&start);
+		profile->LoadFullProfile(false);
+		QueryPerformanceCounter(&end);
+		parseTicks += end.QuadPart - start.QuadPart;
+		bool loaded = !profile->IsBadProfile();
+		++kindCount[options.damage];
+		if ( loaded != SyntheticProfileShouldLoad(options) ) {
+			++kindWrong[options.damage];
+			wchar_t buf[256];
+			StringCbPrintf(buf, sizeof(buf), L"%s (damage=%s) %s\r\n", fileName, damageNames[options.damage], loaded ? L"loaded but should have failed" : L"failed but should have loaded");
+			WriteToConsole(buf);
+			retVal = 1;
+		}
+		if ( loaded && (allocationLoads < CORPUS_ALLOCATION_LOADS) ) {
+			++allocationLoads;
+			allocations += ParseAllocationCount() - allocationsBefore;
+		}
+		delete profile;
+	}
+	ColorDirectory = savedColorDirectory;
+
+	wstring s;
+	wchar_t buf[256];
+	for (size_t kind = 0; kind < _countof(damageNames); ++kind) {
+		StringCbPrintf(buf, sizeof(buf), L"damage=%s:  %u profiles, %u with the wrong outcome\r\n", damageNames[kind], kindCount[kind], kindWrong[kind]);
+		s += buf;
+	}
+	StringCbPrintf(buf, sizeof(buf), L"Parsed %u profiles in %.3f seconds (%.1f microseconds each)\r\n",
+			SYNTHETIC_CORPUS_SIZE,
+			double(parseTicks) / double(frequency.QuadPart),
+			1000000.0 * double(parseTicks) / double(frequency.QuadPart) / double(SYNTHETIC_CORPUS_SIZE) );
+	s += buf;
+	StringCbPrintf(buf, sizeof(buf), L"Heap allocations while parsing:  %d in %u clean loads (%.2f per load)\r\n",
+			allocations,
+			allocationLoads,
+			allocationLoads ? (double(allocations) / double(allocationLoads)) : 0.0 );
+	s += buf;
+	s += retVal ? L"Corpus test FAILED\r\n" : L"Corpus test passed\r\n";
+	WriteToConsole(s);
+	return retVal;
+}
@@ -0,0 +1,14 @@
+// CorpusExport.h -- Write a reproducible corpus of synthetic profiles to a folder
+//
+
+#pragma once
+#include "stdafx.h"
+
+// Some constants
+//
+#define SYNTHETIC_CORPUS_SIZE	10000				// Number of profiles written by /C
+#define SYNTHETIC_CORPUS_SEED	1					// Seed of the first profile; the rest follow in order
+#define CORPUS_ALLOCATION_LOADS	5000				// Clean loads whose heap allocations /CT counts
+
+int WriteSyntheticCorpus(const wchar_t * outputFolder);
+int TestSyntheticCorpus(const wchar_t * folder);
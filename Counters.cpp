@@ -0,0 +1,97 @@
+// Counters.cpp -- Always-on event counters, for spotting regressions in the field
+//
+
+#include "stdafx.h"
+#include "Counters.h"
+#include <strsafe.h>
+//#include <banned.h>
+
+// Global static symbols internal to this file
+//
+static volatile LONG eventCounts[PC_COUNTER_COUNT] = {0};
+
+// Display names, in PERF_COUNTER order
+//
+static const wchar_t * counterNames[PC_COUNTER_COUNT] = {
+	L"Profiles parsed",
+	L"Profile loads from cache",
+	L"Profile bytes read",
+	L"Profile file opens",
+	L"DCs created",
+	L"Gamma ramp reads",
+	L"Gamma ramp writes",
+	L"Gamma ramp writes elided",
+	L"Guard hash hits",
+	L"Guard checks",
+	L"Graph repaints",
+	L"Graph cache hits",
+	L"Graph cache misses",
+	L"Profile arena chunks",
+	L"Parse heap buffers",
+	L"LUT allocations",
+	L"LUT pool reuses",
+	L"Color directory scans"
+};
+
+// Add to a counter
+//
+void CountEvent(PERF_COUNTER counter, LONG amount) {
+	InterlockedExchangeAdd(&eventCounts[counter], amount);
+}
+
+// Return the current value of a counter
+//
+LONG GetEventCount(PERF_COUNTER counter) {
+	return eventCounts[counter];
+}
+
+// Append a "hits out of total" line, as a percentage
+//
+static void AppendHitRate(wstring & s, const wchar_t * name, LONG hits, LONG total) {
+	wchar_t buf[256];
+	if (total) {
+		StringCbPrintf(buf, sizeof(buf), L"%-28s%11.1f%%\r\n", name, (100.0 * hits) / total);
+	} else {
+		StringCbPrintf(buf, sizeof(buf), L"%-28s%12s\r\n", name, L"--");
+	}
+	s += buf;
+}
+
+// Return all counters (and the hit rates that follow from them) as a string
+//
+wstring CountersString(void) {
+	wstring s;
+	wchar_t buf[256];
+
+	for (int i = 0; i < PC_COUNTER_COUNT; ++i) {
+		StringCbPrintf(buf, sizeof(buf), L"%-28s%12ld\r\n", counterNames[i], eventCounts[i]);
+		s += buf;
+	}
+	s += L"\r\n";
+
+	LONG parsed = eventCounts[PC_PROFILES_PARSED];
+	LONG cached = eventCounts[PC_PROFILE_LOADS_CACHED];
+	AppendHitRate(s, L"Profile cache hit rate", cached, cached + parsed);
+	AppendHitRate(s, L"Guard hash hit rate", eventCounts[PC_GUARD_HASH_HITS], eventCounts[PC_GUARD_CHECKS]);
+	LONG graphHits = eventCounts[PC_GRAPH_CACHE_HITS];
+	AppendHitRate(s, L"Graph cache hit rate", graphHits, graphHits + eventCounts[PC_GRAPH_CACHE_MISSES]);
+	LONG lutReuses = eventCounts[PC_LUT_POOL_REUSES];
+	AppendHitRate(s, L"LUT pool hit rate", lutReuses, lutReuses + eventCounts[PC_LUT_ALLOCATIONS]);
+	if (parsed) {
+		StringCbPrintf(
+				buf,
+				sizeof(buf),
+				L"%-28s%12.2f\r\n",
+				L"Arena chunks per parse",
+				static_cast<double>(eventCounts[PC_ARENA_CHUNKS]) / parsed );
+		s += buf;
+		StringCbPrintf(
+				buf,
+				sizeof(buf),
+				L"%-28s%12.2f\r\n",
+				L"Heap allocations per parse",
+				static_cast<double>(eventCounts[PC_ARENA_CHUNKS] + eventCounts[PC_PARSE_HEAP_BUFFERS]) / parsed );
+		s += buf;
+	}
+	return s;
+}
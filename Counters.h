@@ -0,0 +1,36 @@
+// Counters.h -- Always-on event counters, for spotting regressions in the field
+//
+// Counting is a single interlocked add, so call CountEvent() freely.  The totals are shown
+//  by the /stats switch (on the console at exit, and on a Diagnostics page in the GUI).
+//
+
+#pragma once
+#include "stdafx.h"
+
+// The things we count
+//
+typedef enum tag_PERF_COUNTER {
+	PC_PROFILES_PARSED = 0,							// Full parses by LoadFullProfile()
+	PC_PROFILE_LOADS_CACHED,						// LoadFullProfile() calls satisfied by an earlier parse
+	PC_PROFILE_BYTES_READ,							// Bytes read from profile files
+	PC_FILE_OPENS,									// Profile file opens, including ReadProfileBytes()
+	PC_DC_CREATIONS,								// CreateDC() and GetDC() calls for gamma ramp access
+	PC_RAMP_READS,									// GetDeviceGammaRamp() calls
+	PC_RAMP_WRITES,									// SetDeviceGammaRamp() calls
+	PC_RAMP_WRITES_ELIDED,							// Writes skipped because the card already had the right LUT
+	PC_GUARD_HASH_HITS,								// Guard checks settled by the LUT hash alone
+	PC_GUARD_CHECKS,								// All guard checks of a monitor
+	PC_GRAPH_REPAINTS,								// DrawGraphOnDC() calls
+	PC_GRAPH_CACHE_HITS,							// Graphs found already drawn in the GraphCache
+	PC_GRAPH_CACHE_MISSES,							// Graphs that had to be drawn
+	PC_ARENA_CHUNKS,								// Heap allocations made by profile Arenas
+	PC_PARSE_HEAP_BUFFERS,							// Other heap buffers used while parsing (oversized 'vcgt')
+	PC_LUT_ALLOCATIONS,								// LUThandle blocks taken from the heap
+	PC_LUT_POOL_REUSES,								// LUThandle blocks recycled from the pool
+	PC_COLOR_DIRECTORY_SCANS,						// Listings of the color directory by ColorDirectoryIndex
+	PC_COUNTER_COUNT								// Must be last
+} PERF_COUNTER;
+
+void CountEvent(PERF_COUNTER counter, LONG amount = 1);
+LONG GetEventCount(PERF_COUNTER counter);
+wstring CountersString(void);
@@ -0,0 +1,58 @@
+// CpuFeatures.h -- Which SIMD instructions the processor we are running on has
+//
+// Standard C++ plus compiler intrinsics, so the kernels that use it build on any platform.  On
+//  x64 (and with -msse2) SSE2 is always there, so the answer is a compile-time constant and the
+//  scalar fallbacks are never called.  A 32-bit x86 build asks CPUID, once.  Anything else
+//  (ARM, say) gets the scalar code.
+//
+
+#pragma once
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+#define CPU_X86 1
+#include <emmintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#else
+#include <cpuid.h>
+#endif
+#else
+#define CPU_X86 0
+#endif
+
+#if defined(_M_X64) || defined(__x86_64__) || defined(__SSE2__)
+#define CPU_ALWAYS_HAS_SSE2 1
+#else
+#define CPU_ALWAYS_HAS_SSE2 0
+#endif
+
+#if CPU_X86
+// Return CPUID leaf 1's feature bits in EDX
+//
+inline unsigned int CpuFeatureBitsEDX(void) {
+#if defined(_MSC_VER)
+	int info[4];
+	__cpuid(info, 1);
+	return static_cast<unsigned int>(info[3]);
+#else
+	unsigned int eax, ebx, ecx, edx;
+	if ( !__get_cpuid(1, &eax, &ebx, &ecx, &edx) ) {
+		return 0;
+	}
+	return edx;
+#endif
+}
+#endif
+
+// Return 'true' if we can use SSE2 instructions
+//
+inline bool CpuHasSSE2(void) {
+#if CPU_ALWAYS_HAS_SSE2
+	return true;
+#elif CPU_X86
+	static const bool hasSSE2 = ( 0 != (CpuFeatureBitsEDX() & (1 << 26)) );
+	return hasSSE2;
+#else
+	return false;
+#endif
+}
@@ -0,0 +1,843 @@
+// DetailsView.cpp -- Scrolling text pane that formats only the lines it shows
+//
+
+#include "stdafx.h"
+#include "DetailsView.h"
+#include "Profile.h"
+#include "Utility.h"
+#include <strsafe.h>
+//#include <banned.h>
+
+// Symbols defined in other files
+//
+extern HINSTANCE g_hInst;
+
+// Empty the document
+//
+void DetailsDocument::Clear(void) {
+	sections.clear();
+}
+
+// Add a section of text, noting where each line starts so we never have to search for lines later
+//
+void DetailsDocument::AddText(const wstring & text) {
+	if ( text.empty() ) {
+		return;
+	}
+	sections.push_back(DETAILS_SECTION());
+	DETAILS_SECTION & section = sections.back();
+	section.text = text;
+	section.isHexDump = false;
+	section.expanded = true;
+	section.profile = 0;
+	section.tagIndex = -1;
+	section.formatter = 0;
+	section.formatterContext = 0;
+	section.lineStarts.push_back(0);
+	size_t length = text.size();
+	for (size_t i = 0; i < length; ++i) {
+		if ( (L'\n' == text[i]) && ((i + 1) < length) ) {
+			section.lineStarts.push_back(i + 1);
+		}
+	}
+}
+
+// Add a hex dump, collapsed; we keep the bytes and format them a line at a time when shown
+//
+void DetailsDocument::AddHexDump(const wstring & title, const BYTE * bytes, size_t byteCount) {
+	sections.push_back(DETAILS_SECTION());
+	DETAILS_SECTION & section = sections.back();
+	section.text = title;
+	section.bytes.assign(bytes, bytes + byteCount);
+	section.isHexDump = true;
+	section.expanded = false;
+	section.profile = 0;
+	section.tagIndex = -1;
+	section.formatter = 0;
+	section.formatterContext = 0;
+}
+
+// Add a hex dump of a profile tag, collapsed; its bytes are read when it is first expanded
+//
+void DetailsDocument::AddTagHexDump(const wstring & title, Profile * profile, int tagIndex) {
+	sections.push_back(DETAILS_SECTION());
+	DETAILS_SECTION & section = sections.back();
+	section.text = title;
+	section.isHexDump = true;
+	section.expanded = false;
+	section.profile = profile;
+	section.tagIndex = tagIndex;
+	section.formatter = 0;
+	section.formatterContext = 0;
+}
+
+// Add a section of 'lineCount' lines, each formatted by calling 'formatter' the first time it is
+//  needed (for painting, selection or copying)
+//
+void DetailsDocument::AddFormattedLines(DETAILS_LINE_FORMATTER formatter, void * context, size_t lineCount) {
+	if ( 0 == lineCount ) {
+		return;
+	}
+	sections.push_back(DETAILS_SECTION());
+	DETAILS_SECTION & section = sections.back();
+	section.isHexDump = false;
+	section.expanded = true;
+	section.profile = 0;
+	section.tagIndex = -1;
+	section.formatter = formatter;
+	section.formatterContext = context;
+	section.formattedLines.resize(lineCount);
+	section.lineFormatted.resize(lineCount, false);
+}
+
+// Read the bytes of a tag dump, once; if they can't be read, the dump shows no rows
+//
+void DetailsDocument::ReadTagBytes(DETAILS_SECTION & section) {
+	if (section.profile) {
+		if ( !section.profile->GetRawTagBytes(section.tagIndex, section.bytes) ) {
+			section.bytes.clear();
+		}
+		section.profile = 0;
+	}
+}
+
+// Return a line of a formatted section, formatting it if this is the first time it is needed
+//
+const wstring & DetailsDocument::GetFormattedLine(DETAILS_SECTION & section, size_t lineNumber) {
+	if ( !section.lineFormatted[lineNumber] ) {
+		section.formattedLines[lineNumber] = section.formatter(section.formatterContext, lineNumber);
+		section.lineFormatted[lineNumber] = true;
+	}
+	return section.formattedLines[lineNumber];
+}
+
+// Trade contents with another document
+//
+void DetailsDocument::Swap(DetailsDocument & other) {
+	sections.swap(other.sections);
+}
+
+// Return the number of lines a section shows right now
+//
+size_t DetailsDocument::GetSectionLineCount(const DETAILS_SECTION & section) const {
+	if (section.formatter) {
+		return section.formattedLines.size();
+	}
+	if ( !section.isHexDump ) {
+		return section.lineStarts.size();
+	}
+	if ( !section.expanded ) {
+		return 1;
+	}
+	return 1 + (section.bytes.size() + DETAILS_VIEW_BYTES_PER_LINE - 1) / DETAILS_VIEW_BYTES_PER_LINE;
+}
+
+// Return the number of lines in the document, with collapsed hex dumps counting as one line
+//
+size_t DetailsDocument::GetLineCount(void) const {
+	size_t lineCount = 0;
+	size_t count = sections.size();
+	for (size_t i = 0; i < count; ++i) {
+		lineCount += GetSectionLineCount(sections[i]);
+	}
+	return lineCount;
+}
+
+// Format and return one line, without its line ending
+//
+wstring DetailsDocument::GetLine(size_t lineNumber) {
+	size_t count = sections.size();
+	for (size_t i = 0; i < count; ++i) {
+		DETAILS_SECTION & section = sections[i];
+		size_t sectionLines = GetSectionLineCount(section);
+		if ( lineNumber >= sectionLines ) {
+			lineNumber -= sectionLines;
+			continue;
+		}
+		if (section.formatter) {
+			return GetFormattedLine(section, lineNumber);
+		}
+		if (section.isHexDump) {
+			if ( 0 == lineNumber ) {
+				return (section.expanded ? L"[-] " : L"[+] ") + section.text;
+			}
+			return HexDumpLine(
+					&section.bytes[0],
+					section.bytes.size(),
+					(lineNumber - 1) * DETAILS_VIEW_BYTES_PER_LINE,
+					DETAILS_VIEW_BYTES_PER_LINE );
+		}
+		size_t start = section.lineStarts[lineNumber];
+		size_t end = ( (lineNumber + 1) < sectionLines ) ? section.lineStarts[lineNumber + 1] : section.text.size();
+		while ( (end > start) && ((L'\n' == section.text[end - 1]) || (L'\r' == section.text[end - 1])) ) {
+			--end;
+		}
+		return section.text.substr(start, end - start);
+	}
+	return wstring();
+}
+
+// If 'lineNumber' is the title of a hex dump, expand or collapse it and return 'true'
+//
+bool DetailsDocument::ToggleHexDump(size_t lineNumber) {
+	size_t count = sections.size();
+	for (size_t i = 0; i < count; ++i) {
+		DETAILS_SECTION & section = sections[i];
+		if ( 0 == lineNumber ) {
+			if (section.isHexDump) {
+				section.expanded = !section.expanded;
+				if (section.expanded) {
+					ReadTagBytes(section);
+				}
+				return true;
+			}
+			return false;
+		}
+		size_t sectionLines = GetSectionLineCount(section);
+		if ( lineNumber < sectionLines ) {
+			return false;
+		}
+		lineNumber -= sectionLines;
+	}
+	return false;
+}
+
+// Return the whole document as text, with every hex dump expanded (for the clipboard).  If
+//  'readEverything' is false we read nothing from the profile file:  a tag dump that was never
+//  expanded gives just its title, and formatted lines that were never needed are left out.
+//
+wstring DetailsDocument::GetAllText(bool readEverything) {
+	wstring s;
+	size_t count = sections.size();
+	for (size_t i = 0; i < count; ++i) {
+		DETAILS_SECTION & section = sections[i];
+		if (section.formatter) {
+			size_t lineCount = section.formattedLines.size();
+			for (size_t j = 0; j < lineCount; ++j) {
+				if ( readEverything || section.lineFormatted[j] ) {
+					s += GetFormattedLine(section, j);
+					s += L"\r\n";
+				}
+			}
+			continue;
+		}
+		if ( section.isHexDump && readEverything ) {
+			ReadTagBytes(section);
+		}
+		s += section.text;
+		if ( section.text.empty() || (L'\n' != section.text[section.text.size() - 1]) ) {
+			s += L"\r\n";
+		}
+		if ( section.isHexDump && !section.bytes.empty() ) {
+			s += HexDump(&section.bytes[0], section.bytes.size(), DETAILS_VIEW_BYTES_PER_LINE);
+		}
+	}
+	return s;
+}
+
+// Constructor
+//
+DetailsView::DetailsView() :
+		hwnd(0),
+		hFont(0),
+		lineHeight(1),
+		tabStopDialogUnits(32),
+		tabStopPixels(32),
+		topLine(0),
+		xOffset(0),
+		maxLineWidth(0),
+		wheelRemainder(0),
+		selecting(false)
+{
+	ClearSelection();
+}
+
+// Register our window class, so dialog templates can create us by name
+//
+void DetailsView::RegisterWindowClass(void) {
+	WNDCLASSEX wc;
+	SecureZeroMemory(&wc, sizeof(wc));
+	wc.cbSize = sizeof(wc);
+	wc.style = 0;
+	wc.lpfnWndProc = DetailsView::DetailsViewWndProc;
+	wc.cbClsExtra = 0;
+	wc.cbWndExtra = sizeof(DetailsView *);
+	wc.hInstance = g_hInst;
+	wc.hIcon = 0;
+	wc.hCursor = LoadCursor(NULL, IDC_ARROW);
+	wc.hbrBackground = 0;
+	wc.lpszMenuName = 0;
+	wc.lpszClassName = DETAILS_VIEW_CLASS_NAME;
+	wc.hIconSm = 0;
+	RegisterClassEx(&wc);
+}
+
+// Use a new font, and measure our line height and tab stops with it
+//
+void DetailsView::SetFont(HFONT newFont) {
+	hFont = newFont;
+	HDC hdc = GetDC(hwnd);
+	HGDIOBJ oldFont = SelectObject(hdc, hFont ? hFont : GetStockObject(DEFAULT_GUI_FONT));
+	TEXTMETRIC tm;
+	SecureZeroMemory(&tm, sizeof(tm));
+	GetTextMetrics(hdc, &tm);
+	SelectObject(hdc, oldFont);
+	ReleaseDC(hwnd, hdc);
+	lineHeight = max(1, static_cast<int>(tm.tmHeight + tm.tmExternalLeading));
+	tabStopPixels = max(1, MulDiv(tabStopDialogUnits, tm.tmAveCharWidth, 4));	// Four dialog units per character
+	maxLineWidth = 0;
+}
+
+// Show a new document from the top, leaving the caller with our old one
+//
+void DetailsView::SetDocument(DetailsDocument & newDocument) {
+	document.Swap(newDocument);
+	ClearSelection();
+	topLine = 0;
+	xOffset = 0;
+	maxLineWidth = 0;
+	UpdateScrollBars();
+	InvalidateRect(hwnd, NULL, FALSE);
+}
+
+// Return the number of whole lines that fit in the window
+//
+int DetailsView::GetVisibleLineCount(void) const {
+	RECT clientRect;
+	GetClientRect(hwnd, &clientRect);
+	return max(1, static_cast<int>(clientRect.bottom / lineHeight));
+}
+
+// Set the scroll bars from the document size; we only know the widest line once we have painted it
+//
+void DetailsView::UpdateScrollBars(void) {
+	RECT clientRect;
+	GetClientRect(hwnd, &clientRect);
+	int lineCount = static_cast<int>(document.GetLineCount());
+	SCROLLINFO si;
+	SecureZeroMemory(&si, sizeof(si));
+	si.cbSize = sizeof(si);
+	si.fMask = SIF_RANGE | SIF_PAGE | SIF_POS;
+	si.nMin = 0;
+	si.nMax = max(0, lineCount - 1);
+	si.nPage = GetVisibleLineCount();
+	si.nPos = topLine;
+	SetScrollInfo(hwnd, SB_VERT, &si, TRUE);
+	si.nMax = maxLineWidth + DETAILS_VIEW_MARGIN;
+	si.nPage = clientRect.right;
+	si.nPos = xOffset;
+	SetScrollInfo(hwnd, SB_HORZ, &si, TRUE);
+}
+
+// Turn a scroll bar request into a new position
+//
+void DetailsView::HandleScroll(int scrollBar, int request) {
+	bool vertical = (SB_VERT == scrollBar);
+	int position = vertical ? topLine : xOffset;
+	int lineSize = vertical ? 1 : lineHeight;
+	int pageSize = GetVisibleLineCount();
+	if ( !vertical ) {
+		RECT clientRect;
+		GetClientRect(hwnd, &clientRect);
+		pageSize = clientRect.right;
+	}
+	SCROLLINFO si;
+	SecureZeroMemory(&si, sizeof(si));
+	si.cbSize = sizeof(si);
+	switch (request) {
+		case SB_LINEUP:
+			position -= lineSize;
+			break;
+
+		case SB_LINEDOWN:
+			position += lineSize;
+			break;
+
+		case SB_PAGEUP:
+			position -= pageSize;
+			break;
+
+		case SB_PAGEDOWN:
+			position += pageSize;
+			break;
+
+		case SB_TOP:
+			position = 0;
+			break;
+
+		case SB_BOTTOM:
+			position = vertical ? static_cast<int>(document.GetLineCount()) : maxLineWidth;
+			break;
+
+		case SB_THUMBTRACK:
+		case SB_THUMBPOSITION:
+			si.fMask = SIF_TRACKPOS;
+			GetScrollInfo(hwnd, scrollBar, &si);
+			position = si.nTrackPos;
+			break;
+	}
+	if (vertical) {
+		ScrollTo(position, xOffset);
+	} else {
+		ScrollTo(topLine, position);
+	}
+}
+
+// Scroll to a new position, repainting only what scrolls into view
+//
+void DetailsView::ScrollTo(int newTopLine, int newXOffset) {
+	RECT clientRect;
+	GetClientRect(hwnd, &clientRect);
+	int lastTopLine = max(0, static_cast<int>(document.GetLineCount()) - GetVisibleLineCount());
+	int lastXOffset = max(0, maxLineWidth + DETAILS_VIEW_MARGIN - static_cast<int>(clientRect.right));
+	newTopLine = max(0, min(newTopLine, lastTopLine));
+	newXOffset = max(0, min(newXOffset, lastXOffset));
+	if ( (newTopLine != topLine) || (newXOffset != xOffset) ) {
+		ScrollWindowEx(
+				hwnd,
+				xOffset - newXOffset,
+				(topLine - newTopLine) * lineHeight,
+				NULL,
+				NULL,
+				NULL,
+				NULL,
+				SW_INVALIDATE );
+		topLine = newTopLine;
+		xOffset = newXOffset;
+		UpdateScrollBars();
+	}
+}
+
+// Paint the lines that intersect 'updateRect', formatting only those
+//
+void DetailsView::Paint(HDC hdc, const RECT & updateRect) {
+	FillRect(hdc, &updateRect, reinterpret_cast<HBRUSH>(GetStockObject(WHITE_BRUSH)));
+	HGDIOBJ oldFont = SelectObject(hdc, hFont ? hFont : GetStockObject(DEFAULT_GUI_FONT));
+	SetBkMode(hdc, TRANSPARENT);
+	SetTextColor(hdc, GetSysColor(COLOR_WINDOWTEXT));
+
+	int lineCount = static_cast<int>(document.GetLineCount());
+	int firstLine = topLine + (updateRect.top / lineHeight);
+	int endLine = min(lineCount, topLine + ((updateRect.bottom + lineHeight - 1) / lineHeight));
+	int widestLine = maxLineWidth;
+	int x = DETAILS_VIEW_MARGIN - xOffset;
+	for (int i = firstLine; i < endLine; ++i) {
+		wstring line = document.GetLine(i);
+		LONG extent = TabbedTextOut(
+				hdc,
+				x,
+				(i - topLine) * lineHeight,
+				line.c_str(),
+				static_cast<int>(line.size()),
+				1,
+				&tabStopPixels,
+				x );
+		widestLine = max(widestLine, static_cast<int>(LOWORD(extent)));
+		PaintSelection(hdc, i, line, x);
+	}
+	SelectObject(hdc, oldFont);
+	if ( widestLine > maxLineWidth ) {
+		maxLineWidth = widestLine;
+		UpdateScrollBars();
+	}
+}
+
+// Paint the selected part of a line, if any, over the text Paint() has drawn:  fill it with the
+//  highlight color and draw the line again, clipped to that, in the highlight text color
+//
+void DetailsView::PaintSelection(HDC hdc, int lineNumber, const wstring & line, int x) {
+	if ( !HasSelection() ) {
+		return;
+	}
+	DETAILS_POSITION start;
+	DETAILS_POSITION end;
+	GetSelection(start, end);
+	size_t n = static_cast<size_t>(lineNumber);
+	if ( (n < start.line) || (n > end.line) ) {
+		return;
+	}
+	size_t firstColumn = (n == start.line) ? min(start.column, line.size()) : 0;
+	size_t lastColumn = (n == end.line) ? min(end.column, line.size()) : line.size();
+	RECT rect;
+	rect.left = x;
+	rect.right = x;
+	if (firstColumn) {
+		rect.left += LOWORD(GetTabbedTextExtent(hdc, line.c_str(), static_cast<int>(firstColumn), 1, &tabStopPixels));
+	}
+	if (lastColumn) {
+		rect.right += LOWORD(GetTabbedTextExtent(hdc, line.c_str(), static_cast<int>(lastColumn), 1, &tabStopPixels));
+	}
+	if ( n < end.line ) {
+		rect.right += lineHeight / 2;						// Show the line break as selected
+	}
+	if ( rect.right <= rect.left ) {
+		return;
+	}
+	rect.top = (lineNumber - topLine) * lineHeight;
+	rect.bottom = rect.top + lineHeight;
+	int savedDC = SaveDC(hdc);
+	FillRect(hdc, &rect, GetSysColorBrush(COLOR_HIGHLIGHT));
+	IntersectClipRect(hdc, rect.left, rect.top, rect.right, rect.bottom);
+	SetTextColor(hdc, GetSysColor(COLOR_HIGHLIGHTTEXT));
+	TabbedTextOut(hdc, x, rect.top, line.c_str(), static_cast<int>(line.size()), 1, &tabStopPixels, x);
+	RestoreDC(hdc, savedDC);
+}
+
+// Return the document position nearest a point in our client area
+//
+DETAILS_POSITION DetailsView::PositionFromPoint(int x, int y) {
+	DETAILS_POSITION position;
+	position.line = 0;
+	position.column = 0;
+	int lineCount = static_cast<int>(document.GetLineCount());
+	if ( 0 == lineCount ) {
+		return position;
+	}
+	int lineNumber = (y < 0) ? (topLine - 1) : (topLine + (y / lineHeight));
+	lineNumber = max(0, lineNumber);
+	if ( lineNumber >= lineCount ) {
+		position.line = static_cast<size_t>(lineCount - 1);
+		position.column = document.GetLine(position.line).size();
+		return position;
+	}
+	position.line = static_cast<size_t>(lineNumber);
+
+	// Walk along the line until we pass the middle of the character under 'x'
+	//
+	wstring line = document.GetLine(position.line);
+	int target = x - (DETAILS_VIEW_MARGIN - xOffset);
+	HDC hdc = GetDC(hwnd);
+	HGDIOBJ oldFont = SelectObject(hdc, hFont ? hFont : GetStockObject(DEFAULT_GUI_FONT));
+	int previous = 0;
+	size_t length = line.size();
+	for (; position.column < length; ++position.column) {
+		int next = LOWORD(GetTabbedTextExtent(hdc, line.c_str(), static_cast<int>(position.column + 1), 1, &tabStopPixels));
+		if ( target < ((previous + next) / 2) ) {
+			break;
+		}
+		previous = next;
+	}
+	SelectObject(hdc, oldFont);
+	ReleaseDC(hwnd, hdc);
+	return position;
+}
+
+// Return 'true' if any text is selected
+//
+bool DetailsView::HasSelection(void) const {
+	return ( (selectionAnchor.line != selectionCaret.line) || (selectionAnchor.column != selectionCaret.column) );
+}
+
+// Return the selection in document order
+//
+void DetailsView::GetSelection(DETAILS_POSITION & start, DETAILS_POSITION & end) const {
+	bool anchorFirst = (selectionAnchor.line < selectionCaret.line)
+			|| ( (selectionAnchor.line == selectionCaret.line) && (selectionAnchor.column <= selectionCaret.column) );
+	start = anchorFirst ? selectionAnchor : selectionCaret;
+	end = anchorFirst ? selectionCaret : selectionAnchor;
+}
+
+// Return the selected text as it is shown, so a collapsed hex dump gives just its title
+//
+wstring DetailsView::GetSelectedText(void) {
+	wstring s;
+	DETAILS_POSITION start;
+	DETAILS_POSITION end;
+	GetSelection(start, end);
+	for (size_t i = start.line; i <= end.line; ++i) {
+		wstring line = document.GetLine(i);
+		size_t firstColumn = (i == start.line) ? min(start.column, line.size()) : 0;
+		size_t lastColumn = (i == end.line) ? min(end.column, line.size()) : line.size();
+		s += line.substr(firstColumn, lastColumn - firstColumn);
+		if ( i < end.line ) {
+			s += L"\r\n";
+		}
+	}
+	return s;
+}
+
+// Select everything (Ctrl+A)
+//
+void DetailsView::SelectAll(void) {
+	ClearSelection();
+	size_t lineCount = document.GetLineCount();
+	if (lineCount) {
+		selectionCaret.line = lineCount - 1;
+		selectionCaret.column = document.GetLine(lineCount - 1).size();
+	}
+	InvalidateRect(hwnd, NULL, FALSE);
+}
+
+// Select nothing
+//
+void DetailsView::ClearSelection(void) {
+	selectionAnchor.line = 0;
+	selectionAnchor.column = 0;
+	selectionCaret = selectionAnchor;
+}
+
+// Put the selection on the clipboard as text, or the whole document if nothing is selected
+//
+void DetailsView::CopyToClipboard(void) {
+	wstring s = HasSelection() ? GetSelectedText() : document.GetAllText(true);
+	if ( !OpenClipboard(hwnd) ) {
+		return;
+	}
+	EmptyClipboard();
+	size_t byteCount = (s.size() + 1) * sizeof(wchar_t);
+	HGLOBAL hMem = GlobalAlloc(GMEM_MOVEABLE, byteCount);
+	if (hMem) {
+		wchar_t * p = reinterpret_cast<wchar_t *>(GlobalLock(hMem));
+		if (p) {
+			memcpy(p, s.c_str(), byteCount);
+			GlobalUnlock(hMem);
+			if ( 0 == SetClipboardData(CF_UNICODETEXT, hMem) ) {
+				GlobalFree(hMem);
+			}
+		} else {
+			GlobalFree(hMem);
+		}
+	}
+	CloseClipboard();
+}
+
+// Our window procedure
+//
+LRESULT CALLBACK DetailsView::DetailsViewWndProc(HWND hWnd, UINT uMessage, WPARAM wParam, LPARAM lParam) {
+
+	DetailsView * thisView = reinterpret_cast<DetailsView *>(static_cast<LONG_PTR>(GetWindowLongPtr(hWnd, 0)));
+
+	switch (uMessage) {
+		case WM_NCCREATE:
+			thisView = new DetailsView;
+			thisView->hwnd = hWnd;
+			SetWindowLongPtr(hWnd, 0, (__int3264)(LONG_PTR)thisView);
+			break;
+
+		case WM_NCDESTROY:
+			SetWindowLongPtr(hWnd, 0, 0);
+			delete thisView;
+			thisView = 0;
+			break;
+	}
+	if ( 0 == thisView ) {
+		return DefWindowProc(hWnd, uMessage, wParam, lParam);
+	}
+
+	switch (uMessage) {
+
+		// SetDlgItemText() replaces the document with plain text
+		//
+		case WM_SETTEXT:
+		{
+			DetailsDocument newDocument;
+			if (lParam) {
+				newDocument.AddText(reinterpret_cast<const wchar_t *>(lParam));
+			}
+			thisView->SetDocument(newDocument);
+			return TRUE;
+		}
+
+		case DVM_SETDOCUMENT:
+			if (lParam) {
+				thisView->SetDocument(*reinterpret_cast<DetailsDocument *>(lParam));
+				reinterpret_cast<DetailsDocument *>(lParam)->Clear();
+			}
+			return 0;
+			break;
+
+		// Other programs (screen readers, for one) can send these at any time, so they get only
+		//  what is already in memory rather than making us read the profile on the UI thread
+		//
+		case WM_GETTEXTLENGTH:
+			return static_cast<LRESULT>(thisView->document.GetAllText(false).size());
+			break;
+
+		case WM_GETTEXT:
+			if ( wParam && lParam ) {
+				wstring s = thisView->document.GetAllText(false);
+				StringCchCopyN(reinterpret_cast<wchar_t *>(lParam), wParam, s.c_str(), s.size());
+				return static_cast<LRESULT>(min(s.size(), static_cast<size_t>(wParam - 1)));
+			}
+			return 0;
+			break;
+
+		case WM_SETFONT:
+			thisView->SetFont(reinterpret_cast<HFONT>(wParam));
+			thisView->UpdateScrollBars();
+			if (LOWORD(lParam)) {
+				InvalidateRect(hWnd, NULL, FALSE);
+			}
+			return 0;
+			break;
+
+		case WM_GETFONT:
+			return reinterpret_cast<LRESULT>(thisView->hFont);
+			break;
+
+		// Tab stops are in dialog units, as for an edit control; we support a single spacing
+		//
+		case EM_SETTABSTOPS:
+			thisView->tabStopDialogUnits = ( wParam && lParam ) ? *reinterpret_cast<int *>(lParam) : 32;
+			thisView->SetFont(thisView->hFont);
+			InvalidateRect(hWnd, NULL, FALSE);
+			return TRUE;
+			break;
+
+		case WM_SIZE:
+			thisView->UpdateScrollBars();
+			thisView->ScrollTo(thisView->topLine, thisView->xOffset);
+			return 0;
+			break;
+
+		case WM_ERASEBKGND:
+			return 1;
+			break;
+
+		case WM_PAINT:
+			PAINTSTRUCT ps;
+			BeginPaint(hWnd, &ps);
+			thisView->Paint(ps.hdc, ps.rcPaint);
+			EndPaint(hWnd, &ps);
+			return 0;
+			break;
+
+		case WM_VSCROLL:
+			thisView->HandleScroll(SB_VERT, LOWORD(wParam));
+			return 0;
+			break;
+
+		case WM_HSCROLL:
+			thisView->HandleScroll(SB_HORZ, LOWORD(wParam));
+			return 0;
+			break;
+
+		case WM_MOUSEWHEEL:
+			UINT scrollLines;
+			int notches;
+			scrollLines = 3;
+			SystemParametersInfo(SPI_GETWHEELSCROLLLINES, 0, &scrollLines, 0);
+			thisView->wheelRemainder += GET_WHEEL_DELTA_WPARAM(wParam);
+			notches = thisView->wheelRemainder / WHEEL_DELTA;
+			thisView->wheelRemainder -= notches * WHEEL_DELTA;
+			if ( WHEEL_PAGESCROLL == scrollLines ) {
+				thisView->ScrollTo(thisView->topLine - notches * thisView->GetVisibleLineCount(), thisView->xOffset);
+			} else {
+				thisView->ScrollTo(thisView->topLine - notches * static_cast<int>(scrollLines), thisView->xOffset);
+			}
+			return 0;
+			break;
+
+		// Clicking a hex dump's title expands or collapses it; anywhere else starts a selection,
+		//  or extends it with Shift
+		//
+		case WM_LBUTTONDOWN:
+		{
+			SetFocus(hWnd);
+			int x = static_cast<signed short>(LOWORD(lParam));
+			int y = static_cast<signed short>(HIWORD(lParam));
+			bool extend = ( 0 != (wParam & MK_SHIFT) );
+			if ( !extend && thisView->document.ToggleHexDump(thisView->topLine + y / thisView->lineHeight) ) {
+				thisView->ClearSelection();
+				thisView->UpdateScrollBars();
+				thisView->ScrollTo(thisView->topLine, thisView->xOffset);
+			} else {
+				DETAILS_POSITION position = thisView->PositionFromPoint(x, y);
+				if ( !extend ) {
+					thisView->selectionAnchor = position;
+				}
+				thisView->selectionCaret = position;
+				thisView->selecting = true;
+				SetCapture(hWnd);
+			}
+			InvalidateRect(hWnd, NULL, FALSE);
+			return 0;
+			break;
+		}
+
+		// Dragging extends the selection, scrolling if the mouse is above or below us
+		//
+		case WM_MOUSEMOVE:
+			if (thisView->selecting) {
+				int y = static_cast<signed short>(HIWORD(lParam));
+				RECT clientRect;
+				GetClientRect(hWnd, &clientRect);
+				if ( y < 0 ) {
+					thisView->ScrollTo(thisView->topLine - 1, thisView->xOffset);
+				} else if ( y >= clientRect.bottom ) {
+					thisView->ScrollTo(thisView->topLine + 1, thisView->xOffset);
+				}
+				thisView->selectionCaret = thisView->PositionFromPoint(static_cast<signed short>(LOWORD(lParam)), y);
+				InvalidateRect(hWnd, NULL, FALSE);
+			}
+			return 0;
+			break;
+
+		case WM_LBUTTONUP:
+			if (thisView->selecting) {
+				ReleaseCapture();
+			}
+			return 0;
+			break;
+
+		case WM_CAPTURECHANGED:
+			thisView->selecting = false;
+			return 0;
+			break;
+
+		case WM_GETDLGCODE:
+			return DLGC_WANTARROWS;
+			break;
+
+		case WM_KEYDOWN:
+			switch (wParam) {
+				case VK_UP:
+					thisView->HandleScroll(SB_VERT, SB_LINEUP);
+					break;
+
+				case VK_DOWN:
+					thisView->HandleScroll(SB_VERT, SB_LINEDOWN);
+					break;
+
+				case VK_LEFT:
+					thisView->HandleScroll(SB_HORZ, SB_LINEUP);
+					break;
+
+				case VK_RIGHT:
+					thisView->HandleScroll(SB_HORZ, SB_LINEDOWN);
+					break;
+
+				case VK_PRIOR:
+					thisView->HandleScroll(SB_VERT, SB_PAGEUP);
+					break;
+
+				case VK_NEXT:
+					thisView->HandleScroll(SB_VERT, SB_PAGEDOWN);
+					break;
+
+				case VK_HOME:
+					thisView->HandleScroll(SB_VERT, SB_TOP);
+					break;
+
+				case VK_END:
+					thisView->HandleScroll(SB_VERT, SB_BOTTOM);
+					break;
+
+				case 'A':
+					if ( GetKeyState(VK_CONTROL) < 0 ) {
+						thisView->SelectAll();
+					}
+					break;
+
+				case 'C':
+					if ( GetKeyState(VK_CONTROL) < 0 ) {
+						thisView->CopyToClipboard();
+					}
+					break;
+			}
+			return 0;
+			break;
+
+	}
+	return DefWindowProc(hWnd, uMessage, wParam, lParam);
+}
@@ -0,0 +1,124 @@
+// DetailsView.h -- Scrolling text pane that formats only the lines it shows
+//
+// The details pane used to be a read-only edit control, which needs its whole text formatted up
+//  front.  A DetailsView shows a DetailsDocument instead: a list of sections, where a text section
+//  is split into lines once and a hex dump section keeps only its bytes, formats a line when that
+//  line is painted, and starts out collapsed to a one-line title until it is clicked.  A dump of a
+//  profile tag doesn't even read its bytes until it is first expanded.  A formatted section has a
+//  fixed number of lines and a callback that formats each one the first time it is needed, so a
+//  profile's tag list reads tag contents from the file only for the tags that are shown.
+//  WM_SETTEXT still works, so SetDlgItemText() can show plain text as before.
+//
+// Text can be selected with the mouse (Shift+click extends) or with Ctrl+A, and Ctrl+C copies the
+//  selection, or the whole document with every dump expanded if nothing is selected; that can
+//  read every tag from the file.  WM_GETTEXT and WM_GETTEXTLENGTH never read the file:  they
+//  return what has been loaded so far, leaving out dump rows and formatted lines not yet shown.
+//
+
+#pragma once
+#include "stdafx.h"
+
+// Some constants
+//
+#define DETAILS_VIEW_CLASS_NAME			(L"LUT Loader Details View")
+#define DETAILS_VIEW_BYTES_PER_LINE		16
+#define DETAILS_VIEW_MARGIN				2			// Pixels of white space left of the text
+
+// Messages a DetailsView understands besides WM_SETTEXT and WM_SETFONT
+//
+#define DVM_SETDOCUMENT					(WM_USER + 1)	// lParam is a DetailsDocument *, which we empty
+
+// Forward references
+//
+class Profile;
+
+// Format line 'lineNumber' of a formatted section; 'context' is whatever was passed to
+//  AddFormattedLines()
+//
+typedef wstring (* DETAILS_LINE_FORMATTER)(void * context, size_t lineNumber);
+
+// A section of a DetailsDocument
+//
+typedef struct tag_DETAILS_SECTION {
+	wstring						text;					// Lines of text, or the title of a hex dump
+	vector <size_t>				lineStarts;				// Offset of each line in 'text'
+	vector <BYTE>				bytes;					// The bytes of a hex dump (empty for text)
+	bool						isHexDump;
+	bool						expanded;				// Hex dumps start out collapsed
+	Profile *					profile;				// For a tag dump, where to get the bytes, else zero
+	int							tagIndex;
+	DETAILS_LINE_FORMATTER		formatter;				// For a formatted section, else zero
+	void *						formatterContext;
+	vector <wstring>			formattedLines;			// Lines formatted so far, one slot per line
+	vector <bool>				lineFormatted;
+} DETAILS_SECTION;
+
+// A place in a DetailsDocument, as a line and a character within it
+//
+typedef struct tag_DETAILS_POSITION {
+	size_t						line;
+	size_t						column;
+} DETAILS_POSITION;
+
+class DetailsDocument {
+
+public:
+	void Clear(void);
+	void AddText(const wstring & text);
+	void AddHexDump(const wstring & title, const BYTE * bytes, size_t byteCount);
+	void AddTagHexDump(const wstring & title, Profile * profile, int tagIndex);
+	void AddFormattedLines(DETAILS_LINE_FORMATTER formatter, void * context, size_t lineCount);
+	void Swap(DetailsDocument & other);
+	size_t GetLineCount(void) const;
+	wstring GetLine(size_t lineNumber);
+	bool ToggleHexDump(size_t lineNumber);
+	wstring GetAllText(bool readEverything);
+
+private:
+	size_t GetSectionLineCount(const DETAILS_SECTION & section) const;
+	void ReadTagBytes(DETAILS_SECTION & section);
+	const wstring & GetFormattedLine(DETAILS_SECTION & section, size_t lineNumber);
+
+	vector <DETAILS_SECTION>	sections;
+};
+
+class DetailsView {
+
+public:
+	DetailsView();
+
+	static void RegisterWindowClass(void);
+
+private:
+	void SetFont(HFONT newFont);
+	void SetDocument(DetailsDocument & newDocument);
+	void UpdateScrollBars(void);
+	void HandleScroll(int scrollBar, int request);
+	void ScrollTo(int newTopLine, int newXOffset);
+	void Paint(HDC hdc, const RECT & updateRect);
+	void PaintSelection(HDC hdc, int lineNumber, const wstring & line, int x);
+	DETAILS_POSITION PositionFromPoint(int x, int y);
+	bool HasSelection(void) const;
+	void GetSelection(DETAILS_POSITION & start, DETAILS_POSITION & end) const;
+	wstring GetSelectedText(void);
+	void SelectAll(void);
+	void ClearSelection(void);
+	void CopyToClipboard(void);
+	int GetVisibleLineCount(void) const;
+
+	static LRESULT CALLBACK DetailsViewWndProc(HWND hWnd, UINT uMessage, WPARAM wParam, LPARAM lParam);
+
+	HWND						hwnd;
+	DetailsDocument				document;
+	HFONT						hFont;
+	int							lineHeight;
+	int							tabStopDialogUnits;		// As set by EM_SETTABSTOPS
+	int							tabStopPixels;
+	int							topLine;				// First line shown
+	int							xOffset;				// Pixels scrolled to the right
+	int							maxLineWidth;			// Widest line painted so far
+	int							wheelRemainder;			// Mouse wheel delta not yet used
+	DETAILS_POSITION			selectionAnchor;		// Where the selection started
+	DETAILS_POSITION			selectionCaret;			// Where it ends; the same as the anchor if empty
+	bool						selecting;				// The mouse is captured for a drag
+};
@@ -0,0 +1,105 @@
+// GraphCache.cpp -- Rendered LUT graph bitmaps, shared by all LUTview windows
+//
+
+#include "stdafx.h"
+#include <list>
+#include "Counters.h"
+#include "GraphCache.h"
+#include <strsafe.h>
+//#include <banned.h>
+
+// Global static symbols internal to this file
+//
+static list <GRAPH_CACHE_ENTRY> * graphCacheList = 0;	// Most recently used first
+static size_t graphCacheByteCount = 0;
+
+// Return 'true' if two keys describe the same graph
+//
+bool GraphCache::KeysMatch(const GRAPH_CACHE_KEY & a, const GRAPH_CACHE_KEY & b) {
+	return (a.lutHash == b.lutHash)
+		&& (a.textHash == b.textHash)
+		&& (a.width == b.width)
+		&& (a.height == b.height)
+		&& (a.style == b.style)
+		&& (a.dpiScale == b.dpiScale);
+}
+
+// Find a cached graph, mark it as in use and most recently used, or return zero
+//
+HBITMAP GraphCache::Acquire(const GRAPH_CACHE_KEY & key) {
+	if (graphCacheList) {
+		for (list <GRAPH_CACHE_ENTRY>::iterator it = graphCacheList->begin(); it != graphCacheList->end(); ++it) {
+			if ( KeysMatch(it->key, key) ) {
+				++it->useCount;
+				graphCacheList->splice(graphCacheList->begin(), *graphCacheList, it);
+				CountEvent(PC_GRAPH_CACHE_HITS);
+				return graphCacheList->front().bitmap;
+			}
+		}
+	}
+	CountEvent(PC_GRAPH_CACHE_MISSES);
+	return 0;
+}
+
+// Add a newly drawn graph (already in use by the caller, who must Release() it); we own the bitmap
+//
+void GraphCache::Add(const GRAPH_CACHE_KEY & key, HBITMAP bitmap) {
+	if ( 0 == graphCacheList ) {
+		graphCacheList = new list <GRAPH_CACHE_ENTRY>;
+	}
+	GRAPH_CACHE_ENTRY entry;
+	entry.key = key;
+	entry.bitmap = bitmap;
+	entry.byteCount = static_cast<size_t>(key.width) * key.height * 4;
+	entry.useCount = 1;
+	graphCacheList->push_front(entry);
+	graphCacheByteCount += entry.byteCount;
+	Trim();
+}
+
+// Say that a LUTview is done showing a bitmap
+//
+void GraphCache::Release(HBITMAP bitmap) {
+	if (graphCacheList) {
+		for (list <GRAPH_CACHE_ENTRY>::iterator it = graphCacheList->begin(); it != graphCacheList->end(); ++it) {
+			if ( it->bitmap == bitmap ) {
+				if (it->useCount > 0) {
+					--it->useCount;
+				}
+				break;
+			}
+		}
+		Trim();
+	}
+}
+
+// Evict unused bitmaps, oldest first, until we are under the cap
+//
+void GraphCache::Trim(void) {
+	list <GRAPH_CACHE_ENTRY>::iterator it = graphCacheList->end();
+	while ( (graphCacheByteCount > GRAPH_CACHE_MAXIMUM_BYTES) && (it != graphCacheList->begin()) ) {
+		--it;
+		if ( 0 == it->useCount ) {
+			DeleteObject(it->bitmap);
+			graphCacheByteCount -= it->byteCount;
+			it = graphCacheList->erase(it);
+		}
+	}
+}
+
+// Delete all cached bitmaps
+//
+void GraphCache::ClearList(bool freeAllMemory) {
+	if (graphCacheList) {
+		for (list <GRAPH_CACHE_ENTRY>::iterator it = graphCacheList->begin(); it != graphCacheList->end(); ++it) {
+			DeleteObject(it->bitmap);
+		}
+		if (freeAllMemory) {
+			delete graphCacheList;
+			graphCacheList = 0;
+		} else {
+			graphCacheList->clear();
+		}
+	}
+	graphCacheByteCount = 0;
+}
@@ -0,0 +1,46 @@
+// GraphCache.h -- Rendered LUT graph bitmaps, shared by all LUTview windows
+//
+// The Summary page and the monitor pages often show the same LUT at the same size and style,
+//  so a graph is drawn once and kept here.  A LUTview acquires the bitmap it is showing and
+//  releases it when it needs a different one; bitmaps that nobody is showing are evicted,
+//  least recently used first, once the cache holds more than GRAPH_CACHE_MAXIMUM_BYTES.
+//
+
+#pragma once
+#include "stdafx.h"
+#include "GraphRaster.h"
+
+// Some constants
+//
+#define GRAPH_CACHE_MAXIMUM_BYTES	(16 * 1024 * 1024)
+
+// Everything that affects how a graph looks
+//
+typedef struct tag_GRAPH_CACHE_KEY {
+	DWORD						lutHash;				// HashLUT() of the LUT
+	DWORD						textHash;				// HashBytes() of the heading text
+	int							width;
+	int							height;
+	LUT_GRAPH_DISPLAY_STYLE		style;
+	double						dpiScale;				// Heading font size and indents depend on it
+} GRAPH_CACHE_KEY;
+
+typedef struct tag_GRAPH_CACHE_ENTRY {
+	GRAPH_CACHE_KEY				key;
+	HBITMAP						bitmap;
+	size_t						byteCount;
+	LONG						useCount;				// LUTviews currently showing this bitmap
+} GRAPH_CACHE_ENTRY;
+
+class GraphCache {
+
+public:
+	static bool KeysMatch(const GRAPH_CACHE_KEY & a, const GRAPH_CACHE_KEY & b);
+	static HBITMAP Acquire(const GRAPH_CACHE_KEY & key);
+	static void Add(const GRAPH_CACHE_KEY & key, HBITMAP bitmap);
+	static void Release(HBITMAP bitmap);
+	static void ClearList(bool freeAllMemory);
+
+private:
+	static void Trim(void);
+};
@@ -0,0 +1,80 @@
+// GraphExport.cpp -- Write LUT graph images for every profile in the color directory
+//
+// Each profile with a 'vcgt' tag gets a PNG file named after it (as in "Monitor.icc.png") in the
+//  output folder.  The drawing is done by GraphRaster.cpp, so no window or DC is involved.
+//
+
+#include "stdafx.h"
+#include "GraphExport.h"
+#include "GraphRaster.h"
+#include "Profile.h"
+#include "Utility.h"
+#include <strsafe.h>
+//#include <banned.h>
+
+// Symbols defined in other files
+//
+extern wchar_t * ColorDirectory;
+extern wchar_t * ColorDirectoryErrorString;
+
+// Render a graph for each profile that has a LUT and write it to 'outputFolder'
+//
+int ExportProfileGraphs(const wchar_t * outputFolder) {
+	if ( 0 == ColorDirectory ) {
+		WriteToConsole(ColorDirectoryErrorString ? ColorDirectoryErrorString : L"No color directory\r\n");
+		return 1;
+	}
+
+	wchar_t searchPath[1024];
+	StringCbCopy(searchPath, sizeof(searchPath), ColorDirectory);
+	StringCbCat(searchPath, sizeof(searchPath), L"\\*.ic?");
+	WIN32_FIND_DATA findData;
+	HANDLE hFind = FindFirstFile(searchPath, &findData);
+	if ( INVALID_HANDLE_VALUE == hFind ) {
+		WriteToConsole(ShowError(L"FindFirstFile", 0, L"Cannot list profiles in the color directory\r\n"));
+		return 1;
+	}
+
+	int retVal = 0;
+	size_t written = 0;
+	GRAPH_IMAGE image;
+	SetGraphImageSize(image, GRAPH_EXPORT_SIZE, GRAPH_EXPORT_SIZE);
+	vector <unsigned char> fileBytes;
+	do {
+		if (findData.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY) {
+			continue;
+		}
+		Profile * profile = Profile::Find(findData.cFileName);
+		if ( 0 == profile ) {
+			profile = Profile::Add(new Profile(findData.cFileName));
+		}
+		profile->LoadFullProfile(false);
+		const LUT * pLUT = profile->GetLutPointer();
+		if ( 0 == pLUT ) {
+			continue;
+		}
+		RasterizeLutGraph(image, pLUT->red, pLUT->green, pLUT->blue, LGDS_WHITE);
+		EncodeGraphImagePNG(image, fileBytes);
+
+		wchar_t filePath[1024];
+		StringCbCopy(filePath, sizeof(filePath), outputFolder);
+		StringCbCat(filePath, sizeof(filePath), L"\\");
+		StringCbCat(filePath, sizeof(filePath), findData.cFileName);
+		StringCbCat(filePath, sizeof(filePath), L".png");
+		if ( WriteBytesToFile(filePath, fileBytes) ) {
+			++written;
+		} else {
+			wstring s = L"Cannot write \"";
+			s += filePath;
+			s += L"\"\r\n";
+			WriteToConsole(ShowError(L"WriteFile", 0, s.c_str()));
+			retVal = 1;
+		}
+	} while ( FindNextFile(hFind, &findData) );
+	FindClose(hFind);
+
+	wchar_t buf[256];
+	StringCbPrintf(buf, sizeof(buf), L"%u graph images written\r\n", static_cast<unsigned int>(written));
+	WriteToConsole(buf);
+	return retVal;
+}
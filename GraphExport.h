@@ -0,0 +1,11 @@
+// GraphExport.h -- Write LUT graph images for every profile in the color directory
+//
+
+#pragma once
+#include "stdafx.h"
+
+// Some constants
+//
+#define GRAPH_EXPORT_SIZE	256						// Width and height of each image, in pixels
+
+int ExportProfileGraphs(const wchar_t * outputFolder);
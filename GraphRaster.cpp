@@ -0,0 +1,550 @@
+// GraphRaster.cpp -- Draw a LUT graph into an in-memory image, without GDI
+//
+// This is the same graph that LUTview used to draw with GDI pens and GradientFill, with the
+//  curves drawn anti-aliased.  Each curve is first drawn into a coverage mask (Xiaolin Wu's
+//  line algorithm, keeping the larger coverage where segments meet), then blended into the
+//  image in a single pass over the mask.
+//
+
+#include <math.h>
+#include <string.h>
+#include "GraphRaster.h"
+
+// Some constants
+//
+#define GRID_DOT_LENGTH			3					// Pixels on, then pixels off, for dotted gridlines
+#define PNG_STORED_BLOCK_SIZE	65535				// Largest "stored" (uncompressed) deflate block
+
+#define GRAPH_RGB(r, g, b)		(0xFF000000u | ((r) << 16) | ((g) << 8) | (b))
+
+#define RED_COLOR_NORMAL		GRAPH_RGB(255,  0,  0)
+#define GREEN_COLOR_NORMAL		GRAPH_RGB(  0,255,  0)
+#define BLUE_COLOR_NORMAL		GRAPH_RGB(  0,  0,255)
+#define WHITE_COLOR				GRAPH_RGB(255,255,255)
+#define BLACK_COLOR				GRAPH_RGB(  0,  0,  0)
+#define LIGHT_GRAY_COLOR		GRAPH_RGB(192,192,192)
+
+typedef struct tag_STYLE_SET {
+	unsigned int	background;
+	unsigned int	frame;
+	unsigned int	grid;
+	unsigned int	gridDashBkColor;
+	unsigned int	text;
+	unsigned int	red;
+	unsigned int	green;
+	unsigned int	blue;
+	unsigned int	gridlineCount;
+	bool			mergeCurves;					// Combine overlapping curves (as R2_MERGEPEN did)
+} STYLE_SET;
+
+static const STYLE_SET styleTable[3] = {
+	{		// LGDS_WHITE style
+		WHITE_COLOR,			// background
+		GRAPH_RGB(  0,  0,  0),	// frame
+		LIGHT_GRAY_COLOR,		// grid
+		GRAPH_RGB(240,240,240),	// grid dashes
+		BLACK_COLOR,			// text
+		RED_COLOR_NORMAL,		// red
+		GREEN_COLOR_NORMAL,		// green
+		BLUE_COLOR_NORMAL,		// blue
+		14,						// how many grid lines to draw
+		false					// merge curves
+	},
+	{		// LGDS_BLACK style
+		BLACK_COLOR,			// background
+		GRAPH_RGB(128,128,128),	// frame
+		GRAPH_RGB( 96, 96, 96),	// grid
+		GRAPH_RGB( 64, 64, 64),	// grid dashes
+		WHITE_COLOR,			// text
+		RED_COLOR_NORMAL,		// red
+		GREEN_COLOR_NORMAL,		// green
+		BLUE_COLOR_NORMAL,		// blue
+		6,						// how many grid lines to draw
+		true					// merge curves
+	},
+	{		// LGDS_GRADIENT style
+		WHITE_COLOR,			// background
+		GRAPH_RGB(128,128,128),	// frame
+		GRAPH_RGB(160,160,160),	// grid
+		GRAPH_RGB( 96, 96, 96),	// grid dashes
+		BLACK_COLOR,			// text
+		RED_COLOR_NORMAL,		// red
+		GREEN_COLOR_NORMAL,		// green
+		BLUE_COLOR_NORMAL,		// blue
+		0,						// how many grid lines to draw
+		false					// merge curves
+	}
+};
+
+// Size an image (contents are undefined until drawn)
+//
+void SetGraphImageSize(GRAPH_IMAGE & image, int width, int height) {
+	image.width = (width > 0) ? width : 0;
+	image.height = (height > 0) ? height : 0;
+	image.pixels.resize(static_cast<size_t>(image.width) * image.height);
+}
+
+// Return the caption color for a style, as 0x00RRGGBB
+//
+unsigned int GetGraphTextColor(LUT_GRAPH_DISPLAY_STYLE style) {
+	if (style > LGDS_GRADIENT) {
+		style = LGDS_WHITE;
+	}
+	return styleTable[style].text & 0x00FFFFFF;
+}
+
+// Fill the image with the four-corner gradient that GradientFill() drew:  gray in the upper
+//  left and lower right, white in the upper right and black in the lower left
+//
+static void FillGradient(GRAPH_IMAGE & image) {
+	int spanX = image.width - 3;
+	int spanY = image.height - 3;
+	if ( spanX < 1 || spanY < 1 ) {
+		return;
+	}
+	for (int y = 1; y < image.height - 1; ++y) {
+		double v = double(y - 1) / spanY;
+		unsigned int * row = &image.pixels[static_cast<size_t>(y) * image.width];
+		for (int x = 1; x < image.width - 1; ++x) {
+			double u = double(x - 1) / spanX;
+			double level = (u >= v) ? (128.0 + 127.0 * (u - v)) : (128.0 + 128.0 * (u - v));
+			unsigned int gray = static_cast<unsigned int>(level + 0.5);
+			if (gray > 255) {
+				gray = 255;
+			}
+			row[x] = GRAPH_RGB(gray, gray, gray);
+		}
+	}
+}
+
+// Draw one vertical gridline from 'top' down to (but not including) 'bottom'
+//
+static void DrawVerticalGridline(GRAPH_IMAGE & image, int x, int top, int bottom, unsigned int color, unsigned int dashColor, bool dotted) {
+	if ( x < 0 || x >= image.width ) {
+		return;
+	}
+	if (top < 0) {
+		top = 0;
+	}
+	if (bottom > image.height) {
+		bottom = image.height;
+	}
+	for (int y = top; y < bottom; ++y) {
+		bool dash = dotted && ( 0 != (((y - top) / GRID_DOT_LENGTH) & 1) );
+		image.pixels[static_cast<size_t>(y) * image.width + x] = dash ? dashColor : color;
+	}
+}
+
+// Draw one horizontal gridline from 'left' across to (but not including) 'right'
+//
+static void DrawHorizontalGridline(GRAPH_IMAGE & image, int y, int left, int right, unsigned int color, unsigned int dashColor, bool dotted) {
+	if ( y < 0 || y >= image.height ) {
+		return;
+	}
+	if (left < 0) {
+		left = 0;
+	}
+	if (right > image.width) {
+		right = image.width;
+	}
+	unsigned int * row = &image.pixels[static_cast<size_t>(y) * image.width];
+	for (int x = left; x < right; ++x) {
+		bool dash = dotted && ( 0 != (((x - left) / GRID_DOT_LENGTH) & 1) );
+		row[x] = dash ? dashColor : color;
+	}
+}
+
+// Draw the crosshatch:  up to six solid lines at quarters, then eight dotted lines at eighths
+//
+static void DrawGridlines(GRAPH_IMAGE & image, const STYLE_SET & styleSet, int captionRight, int captionBottom) {
+	int gridRight = image.width;
+	int gridBottom = image.height;
+
+	int vertical2 = gridBottom / 2;
+	int horizontal2 = gridRight / 2;
+	int vertical1 = vertical2 / 2;
+	int horizontal1 = horizontal2 / 2;
+	int vertical3 = (vertical2 + gridBottom) / 2;
+	int horizontal3 = (horizontal2 + gridRight) / 2;
+
+	// Vertical lines first, then horizontal, so that a smaller gridlineCount favors the verticals
+	//
+	int solidX[3] = { horizontal1, horizontal2, horizontal3 };
+	int solidY[3] = { vertical1, vertical2, vertical3 };
+	unsigned int lineCount = styleSet.gridlineCount;
+	for (unsigned int i = 0; i < 6 && i < lineCount; ++i) {
+		if (i < 3) {
+			int top = (solidX[i] < captionRight) ? captionBottom : 0;
+			DrawVerticalGridline(image, solidX[i], top, gridBottom, styleSet.grid, styleSet.grid, false);
+		} else {
+			DrawHorizontalGridline(image, solidY[i - 3], 0, gridRight, styleSet.grid, styleSet.grid, false);
+		}
+	}
+
+	if (lineCount > 6) {
+		int fractionX[4] = {
+			horizontal1 / 2,
+			(horizontal1 + horizontal2) / 2,
+			(horizontal2 + horizontal3) / 2,
+			(horizontal3 + gridRight) / 2
+		};
+		int fractionY[4] = {
+			vertical1 / 2,
+			(vertical1 + vertical2) / 2,
+			(vertical2 + vertical3) / 2,
+			(vertical3 + gridBottom) / 2
+		};
+		for (int i = 0; i < 4; ++i) {
+			int top = (fractionX[i] < captionRight) ? captionBottom : 0;
+			DrawVerticalGridline(image, fractionX[i], top, gridBottom, styleSet.grid, styleSet.gridDashBkColor, true);
+		}
+		for (int i = 0; i < 4; ++i) {
+			DrawHorizontalGridline(image, fractionY[i], 0, gridRight, styleSet.grid, styleSet.gridDashBkColor, true);
+		}
+	}
+}
+
+// A coverage mask the size of the image, one byte per pixel
+//
+typedef struct tag_COVERAGE_MASK {
+	int							width;
+	int							height;
+	std::vector<unsigned char>	coverage;
+} COVERAGE_MASK;
+
+// Raise the coverage of one pixel of the mask (where two segments meet, the larger one wins)
+//
+static inline void PlotCoverage(COVERAGE_MASK & mask, int x, int y, double amount) {
+	if ( x < 0 || y < 0 || x >= mask.width || y >= mask.height ) {
+		return;
+	}
+	unsigned char level = static_cast<unsigned char>(amount * 255.0 + 0.5);
+	unsigned char & pixel = mask.coverage[static_cast<size_t>(y) * mask.width + x];
+	if (level > pixel) {
+		pixel = level;
+	}
+}
+
+// Plot a pixel, swapping x and y back for steep lines
+//
+static inline void PlotWu(COVERAGE_MASK & mask, bool steep, int major, int minor, double amount) {
+	if (steep) {
+		PlotCoverage(mask, minor, major, amount);
+	} else {
+		PlotCoverage(mask, major, minor, amount);
+	}
+}
+
+// Draw an anti-aliased line into the mask (Xiaolin Wu's algorithm), pixel centers at integers
+//
+static void DrawWuLine(COVERAGE_MASK & mask, double x0, double y0, double x1, double y1) {
+	bool steep = fabs(y1 - y0) > fabs(x1 - x0);
+	double swap;
+	if (steep) {
+		swap = x0; x0 = y0; y0 = swap;
+		swap = x1; x1 = y1; y1 = swap;
+	}
+	if (x0 > x1) {
+		swap = x0; x0 = x1; x1 = swap;
+		swap = y0; y0 = y1; y1 = swap;
+	}
+	double dx = x1 - x0;
+	double gradient = (0.0 == dx) ? 1.0 : ((y1 - y0) / dx);
+
+	// First endpoint
+	//
+	double xEnd = floor(x0 + 0.5);
+	double yEnd = y0 + gradient * (xEnd - x0);
+	double xGap = 1.0 - ((x0 + 0.5) - floor(x0 + 0.5));
+	int xFirst = static_cast<int>(xEnd);
+	double yFloor = floor(yEnd);
+	double yFraction = yEnd - yFloor;
+	PlotWu(mask, steep, xFirst, static_cast<int>(yFloor), (1.0 - yFraction) * xGap);
+	PlotWu(mask, steep, xFirst, static_cast<int>(yFloor) + 1, yFraction * xGap);
+	double intersectY = yEnd + gradient;
+
+	// Second endpoint
+	//
+	xEnd = floor(x1 + 0.5);
+	yEnd = y1 + gradient * (xEnd - x1);
+	xGap = (x1 + 0.5) - floor(x1 + 0.5);
+	int xLast = static_cast<int>(xEnd);
+	yFloor = floor(yEnd);
+	yFraction = yEnd - yFloor;
+	PlotWu(mask, steep, xLast, static_cast<int>(yFloor), (1.0 - yFraction) * xGap);
+	PlotWu(mask, steep, xLast, static_cast<int>(yFloor) + 1, yFraction * xGap);
+
+	// Everything in between
+	//
+	for (int x = xFirst + 1; x < xLast; ++x) {
+		yFloor = floor(intersectY);
+		yFraction = intersectY - yFloor;
+		PlotWu(mask, steep, x, static_cast<int>(yFloor), 1.0 - yFraction);
+		PlotWu(mask, steep, x, static_cast<int>(yFloor) + 1, yFraction);
+		intersectY += gradient;
+	}
+}
+
+// Blend a color into the image wherever the mask has coverage
+//
+static void CompositeCoverage(GRAPH_IMAGE & image, const COVERAGE_MASK & mask, unsigned int color, bool merge) {
+	unsigned int sourceRed = (color >> 16) & 0xFF;
+	unsigned int sourceGreen = (color >> 8) & 0xFF;
+	unsigned int sourceBlue = color & 0xFF;
+	size_t count = image.pixels.size();
+	for (size_t i = 0; i < count; ++i) {
+		unsigned int alpha = mask.coverage[i];
+		if (0 == alpha) {
+			continue;
+		}
+		unsigned int pixel = image.pixels[i];
+		unsigned int red = (pixel >> 16) & 0xFF;
+		unsigned int green = (pixel >> 8) & 0xFF;
+		unsigned int blue = pixel & 0xFF;
+		if (merge) {
+
+			// Like R2_MERGEPEN on a dark background:  channels only get brighter
+			//
+			unsigned int addRed = (sourceRed * alpha + 127) / 255;
+			unsigned int addGreen = (sourceGreen * alpha + 127) / 255;
+			unsigned int addBlue = (sourceBlue * alpha + 127) / 255;
+			red = (addRed > red) ? addRed : red;
+			green = (addGreen > green) ? addGreen : green;
+			blue = (addBlue > blue) ? addBlue : blue;
+		} else {
+			red = (red * (255 - alpha) + sourceRed * alpha + 127) / 255;
+			green = (green * (255 - alpha) + sourceGreen * alpha + 127) / 255;
+			blue = (blue * (255 - alpha) + sourceBlue * alpha + 127) / 255;
+		}
+		image.pixels[i] = GRAPH_RGB(red, green, blue);
+	}
+}
+
+// Draw one channel of the LUT as a curve
+//
+static void DrawCurve(GRAPH_IMAGE & image, COVERAGE_MASK & mask, const unsigned short * values, unsigned int color, bool merge) {
+	double xFactor = (image.width - 2) / double(255);
+	double yFactor = (image.height - 2) / double(65535);
+	double xMin = 1.0;
+	double xMax = image.width - 1.0;
+	double yMin = 0.0;
+	double yMax = image.height - 1.0;
+
+	memset(&mask.coverage[0], 0, mask.coverage.size());
+	double previousX = 0.0;
+	double previousY = 0.0;
+	for (int i = 0; i < 256; ++i) {
+		double x = xFactor * i + 1.0;
+		if (x < xMin) {
+			x = xMin;
+		} else if (x > xMax) {
+			x = xMax;
+		}
+		double y = image.height - yFactor * values[i] - 2.0;
+		if (y < yMin) {
+			y = yMin;
+		} else if (y > yMax) {
+			y = yMax;
+		}
+		if (i) {
+			DrawWuLine(mask, previousX, previousY, x, y);
+		}
+		previousX = x;
+		previousY = y;
+	}
+	CompositeCoverage(image, mask, color, merge);
+}
+
+// Draw the whole graph:  background, gridlines, three curves and a frame
+//
+void RasterizeLutGraph(
+		GRAPH_IMAGE & image,
+		const unsigned short * red,
+		const unsigned short * green,
+		const unsigned short * blue,
+		LUT_GRAPH_DISPLAY_STYLE style,
+		int captionRight,
+		int captionBottom )
+{
+	if ( image.width < 3 || image.height < 3 ) {
+		return;
+	}
+	if (style > LGDS_GRADIENT) {
+		style = LGDS_WHITE;
+	}
+	const STYLE_SET & styleSet = styleTable[style];
+
+	// Background
+	//
+	size_t count = image.pixels.size();
+	for (size_t i = 0; i < count; ++i) {
+		image.pixels[i] = styleSet.background;
+	}
+	if ( LGDS_GRADIENT == style ) {
+		FillGradient(image);
+	}
+
+	// Gridlines
+	//
+	if (styleSet.gridlineCount) {
+		DrawGridlines(image, styleSet, captionRight, captionBottom);
+	}
+
+	// Curves
+	//
+	COVERAGE_MASK mask;
+	mask.width = image.width;
+	mask.height = image.height;
+	mask.coverage.resize(count);
+	DrawCurve(image, mask, red, styleSet.red, styleSet.mergeCurves);
+	DrawCurve(image, mask, green, styleSet.green, styleSet.mergeCurves);
+	DrawCurve(image, mask, blue, styleSet.blue, styleSet.mergeCurves);
+
+	// Frame
+	//
+	DrawHorizontalGridline(image, 0, 0, image.width, styleSet.frame, styleSet.frame, false);
+	DrawHorizontalGridline(image, image.height - 1, 0, image.width, styleSet.frame, styleSet.frame, false);
+	DrawVerticalGridline(image, 0, 0, image.height, styleSet.frame, styleSet.frame, false);
+	DrawVerticalGridline(image, image.width - 1, 0, image.height, styleSet.frame, styleSet.frame, false);
+}
+
+// Append the image as 8-bit R, G, B (no alpha), optionally with a zero byte before each row
+//
+static void AppendRgbRows(const GRAPH_IMAGE & image, std::vector<unsigned char> & bytes, bool pngFilterBytes) {
+	for (int y = 0; y < image.height; ++y) {
+		if (pngFilterBytes) {
+			bytes.push_back(0);								// Filter type 0, "None"
+		}
+		const unsigned int * row = &image.pixels[static_cast<size_t>(y) * image.width];
+		for (int x = 0; x < image.width; ++x) {
+			bytes.push_back(static_cast<unsigned char>(row[x] >> 16));
+			bytes.push_back(static_cast<unsigned char>(row[x] >> 8));
+			bytes.push_back(static_cast<unsigned char>(row[x]));
+		}
+	}
+}
+
+// Append a non-negative number as decimal text, then a separator
+//
+static void AppendDecimal(std::vector<unsigned char> & bytes, int value, char separator) {
+	char digits[16];
+	int count = 0;
+	do {
+		digits[count++] = static_cast<char>('0' + value % 10);
+		value /= 10;
+	} while ( value > 0 && count < static_cast<int>(sizeof(digits)) );
+	while (count > 0) {
+		bytes.push_back(digits[--count]);
+	}
+	bytes.push_back(separator);
+}
+
+// Encode as a binary PPM (P6), the simplest format for other tools to read
+//
+void EncodeGraphImagePPM(const GRAPH_IMAGE & image, std::vector<unsigned char> & fileBytes) {
+	fileBytes.clear();
+	fileBytes.reserve(32 + static_cast<size_t>(image.width) * image.height * 3);
+	fileBytes.push_back('P');
+	fileBytes.push_back('6');
+	fileBytes.push_back('\n');
+	AppendDecimal(fileBytes, image.width, ' ');
+	AppendDecimal(fileBytes, image.height, '\n');
+	AppendDecimal(fileBytes, 255, '\n');
+	AppendRgbRows(image, fileBytes, false);
+}
+
+// Append a 32-bit value, most significant byte first
+//
+static void AppendBigEndian32(std::vector<unsigned char> & bytes, unsigned int value) {
+	bytes.push_back(static_cast<unsigned char>(value >> 24));
+	bytes.push_back(static_cast<unsigned char>(value >> 16));
+	bytes.push_back(static_cast<unsigned char>(value >> 8));
+	bytes.push_back(static_cast<unsigned char>(value));
+}
+
+// CRC-32 as used by PNG chunks
+//
+static unsigned int PngCrc(const unsigned char * data, size_t size) {
+	static unsigned int crcTable[256];
+	static bool crcTableBuilt = false;
+	if (!crcTableBuilt) {
+		for (unsigned int n = 0; n < 256; ++n) {
+			unsigned int c = n;
+			for (int k = 0; k < 8; ++k) {
+				c = (c & 1) ? (0xEDB88320u ^ (c >> 1)) : (c >> 1);
+			}
+			crcTable[n] = c;
+		}
+		crcTableBuilt = true;
+	}
+	unsigned int crc = 0xFFFFFFFFu;
+	for (size_t i = 0; i < size; ++i) {
+		crc = crcTable[(crc ^ data[i]) & 0xFF] ^ (crc >> 8);
+	}
+	return crc ^ 0xFFFFFFFFu;
+}
+
+// Append one PNG chunk:  length, type, data, CRC of type and data
+//
+static void AppendPngChunk(std::vector<unsigned char> & fileBytes, const char * type, const std::vector<unsigned char> & data) {
+	AppendBigEndian32(fileBytes, static_cast<unsigned int>(data.size()));
+	size_t typeStart = fileBytes.size();
+	fileBytes.insert(fileBytes.end(), type, type + 4);
+	fileBytes.insert(fileBytes.end(), data.begin(), data.end());
+	AppendBigEndian32(fileBytes, PngCrc(&fileBytes[typeStart], 4 + data.size()));
+}
+
+// Encode as a PNG.  We don't carry a deflate implementation, so the image data is written in
+//  "stored" blocks; graph thumbnails are small and any PNG reader will take them.
+//
+void EncodeGraphImagePNG(const GRAPH_IMAGE & image, std::vector<unsigned char> & fileBytes) {
+	static const unsigned char pngSignature[8] = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n' };
+	fileBytes.assign(pngSignature, pngSignature + sizeof(pngSignature));
+
+	std::vector<unsigned char> chunk;
+	AppendBigEndian32(chunk, static_cast<unsigned int>(image.width));
+	AppendBigEndian32(chunk, static_cast<unsigned int>(image.height));
+	chunk.push_back(8);										// Bit depth
+	chunk.push_back(2);										// Color type 2, RGB
+	chunk.push_back(0);										// Compression method
+	chunk.push_back(0);										// Filter method
+	chunk.push_back(0);										// No interlace
+	AppendPngChunk(fileBytes, "IHDR", chunk);
+
+	std::vector<unsigned char> raw;
+	raw.reserve(static_cast<size_t>(image.width * 3 + 1) * image.height);
+	AppendRgbRows(image, raw, true);
+
+	// zlib stream:  header, stored blocks, Adler-32 of the raw data
+	//
+	chunk.clear();
+	chunk.reserve(raw.size() + (raw.size() / PNG_STORED_BLOCK_SIZE + 1) * 5 + 6);
+	chunk.push_back(0x78);
+	chunk.push_back(0x01);
+	size_t offset = 0;
+	do {
+		size_t blockSize = raw.size() - offset;
+		if (blockSize > PNG_STORED_BLOCK_SIZE) {
+			blockSize = PNG_STORED_BLOCK_SIZE;
+		}
+		bool finalBlock = (offset + blockSize == raw.size());
+		chunk.push_back(finalBlock ? 1 : 0);
+		chunk.push_back(static_cast<unsigned char>(blockSize));
+		chunk.push_back(static_cast<unsigned char>(blockSize >> 8));
+		chunk.push_back(static_cast<unsigned char>(~blockSize));
+		chunk.push_back(static_cast<unsigned char>(~blockSize >> 8));
+		chunk.insert(chunk.end(), raw.begin() + offset, raw.begin() + offset + blockSize);
+		offset += blockSize;
+	} while (offset < raw.size());
+	unsigned int adlerA = 1;
+	unsigned int adlerB = 0;
+	for (size_t i = 0; i < raw.size(); ++i) {
+		adlerA = (adlerA + raw[i]) % 65521;
+		adlerB = (adlerB + adlerA) % 65521;
+	}
+	AppendBigEndian32(chunk, (adlerB << 16) | adlerA);
+	AppendPngChunk(fileBytes, "IDAT", chunk);
+
+	chunk.clear();
+	AppendPngChunk(fileBytes, "IEND", chunk);
+}
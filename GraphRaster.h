@@ -0,0 +1,37 @@
+// GraphRaster.h -- Draw a LUT graph into an in-memory image, without GDI
+//
+// GraphRaster.cpp uses only standard C++ (no <windows.h>, and no precompiled header), so the
+//  same code can render graph thumbnails in a batch job on another platform.  LUTview blits the
+//  image to the screen and draws its caption on top; the /I switch writes images to files.
+//
+
+#pragma once
+#include <vector>
+
+typedef enum tag_LUT_GRAPH_DISPLAY_STYLE {
+	LGDS_WHITE = 0,
+	LGDS_BLACK = 1,
+	LGDS_GRADIENT = 2
+} LUT_GRAPH_DISPLAY_STYLE;
+
+// Pixels are 0xAARRGGBB, top row first.  On a little-endian machine that is B, G, R, A in
+//  memory, which is what a 32-bit top-down DIB expects.
+//
+typedef struct tag_GRAPH_IMAGE {
+	int							width;
+	int							height;
+	std::vector<unsigned int>	pixels;
+} GRAPH_IMAGE;
+
+void SetGraphImageSize(GRAPH_IMAGE & image, int width, int height);
+void RasterizeLutGraph(
+		GRAPH_IMAGE & image,
+		const unsigned short * red,						// 256 entries per channel, as in a LUT
+		const unsigned short * green,
+		const unsigned short * blue,
+		LUT_GRAPH_DISPLAY_STYLE style,
+		int captionRight = 0,							// Vertical gridlines left of captionRight start
+		int captionBottom = 0 );						//  at captionBottom, to keep clear of a caption
+unsigned int GetGraphTextColor(LUT_GRAPH_DISPLAY_STYLE style);
+void EncodeGraphImagePPM(const GRAPH_IMAGE & image, std::vector<unsigned char> & fileBytes);
+void EncodeGraphImagePNG(const GRAPH_IMAGE & image, std::vector<unsigned char> & fileBytes);
@@ -2,12 +2,19 @@
 //
 
 #include "stdafx.h"
+#include "Counters.h"
 #include "LUT.h"
+#include "Utility.h"
+#include <malloc.h>
 //#include <banned.h>
 
+// Global static symbols internal to this file
+//
+static SLIST_HEADER lutPool;						// Free SHARED_LUT blocks; see LUThandle::InitializePool()
+
 // Function to test LUT for linearity
 //
-IS_LINEAR IsLinear(LUT * pLUT) {
+IS_LINEAR IsLinear(const LUT * pLUT) {
 
 	if (!pLUT) {
 		return IL_ZERO_POINTER;
@@ -112,3 +119,138 @@ void GetSignedLUT(LUT * pLUT) {
 	pLUT->red[2] = 0x0203;
 	pLUT->red[3] = 0x0304;
 }
+
+// Compute a cheap 32-bit hash of a LUT (FNV-1a over the 1536 bytes) for change detection
+//
+// This is not a substitute for CompareLUT(); it just tells us when it is worth calling it.
+//
+DWORD HashLUT(const LUT * pLUT) {
+	return pLUT ? HashBytes(pLUT, sizeof(LUT)) : FNV_OFFSET_BASIS;
+}
+
+// LUThandle constructors and destructor
+//
+LUThandle::LUThandle() :
+		shared(0)
+{
+}
+
+LUThandle::LUThandle(const LUT & lut) :
+		shared(AllocateShared())
+{
+	shared->lut = lut;
+	shared->hash = HashLUT(&lut);
+	shared->refCount = 1;
+}
+
+LUThandle::LUThandle(const LUThandle & other) :
+		shared(other.shared)
+{
+	if (shared) {
+		InterlockedIncrement(&shared->refCount);
+	}
+}
+
+LUThandle::~LUThandle() {
+	Release();
+}
+
+// Assignment shares the other handle's LUT
+//
+LUThandle & LUThandle::operator = (const LUThandle & other) {
+	if (other.shared != shared) {
+		if (other.shared) {
+			InterlockedIncrement(&other.shared->refCount);
+		}
+		Release();
+		shared = other.shared;
+	}
+	return *this;
+}
+
+const LUT * LUThandle::Get(void) const {
+	return shared ? &shared->lut : 0;
+}
+
+DWORD LUThandle::GetHash(void) const {
+	return shared ? shared->hash : HashLUT(0);
+}
+
+bool LUThandle::IsEmpty(void) const {
+	return ( 0 == shared );
+}
+
+// Two handles match if they share a LUT, or if their LUTs are word for word the same.  The
+//  hashes settle almost every "different" case without looking at the LUTs themselves.
+//
+bool LUThandle::Matches(const LUThandle & other) const {
+	if (shared == other.shared) {
+		return true;
+	}
+	if ( (0 == shared) || (0 == other.shared) || (shared->hash != other.shared->hash) ) {
+		return false;
+	}
+	return ( 0 == memcmp(&shared->lut, &other.shared->lut, sizeof(LUT)) );
+}
+
+bool LUThandle::Matches(const LUT & lut) const {
+	return shared && ( 0 == memcmp(&shared->lut, &lut, sizeof(LUT)) );
+}
+
+void LUThandle::Reset(void) {
+	Release();
+}
+
+// Drop our reference, freeing the LUT if we were the last holder
+//
+void LUThandle::Release(void) {
+	if (shared) {
+		if ( 0 == InterlockedDecrement(&shared->refCount) ) {
+			FreeShared(shared);
+		}
+		shared = 0;
+	}
+}
+
+// Get a block for a new LUThandle, from the pool if there is one there
+//
+// A free block holds an SLIST_ENTRY where its LUT was, so blocks come from _aligned_malloc()
+//  with the alignment the interlocked list functions require.
+//
+LUThandle::SHARED_LUT * LUThandle::AllocateShared(void) {
+	SLIST_ENTRY * entry = InterlockedPopEntrySList(&lutPool);
+	if (entry) {
+		CountEvent(PC_LUT_POOL_REUSES);
+		return reinterpret_cast<SHARED_LUT *>(entry);
+	}
+	CountEvent(PC_LUT_ALLOCATIONS);
+	size_t blockSize = (sizeof(SHARED_LUT) > sizeof(SLIST_ENTRY)) ? sizeof(SHARED_LUT) : sizeof(SLIST_ENTRY);
+	SHARED_LUT * newShared = static_cast<SHARED_LUT *>(_aligned_malloc(blockSize, MEMORY_ALLOCATION_ALIGNMENT));
+	if ( 0 == newShared ) {
+		throw std::bad_alloc();
+	}
+	return newShared;
+}
+
+// Put a block back in the pool
+//
+void LUThandle::FreeShared(SHARED_LUT * oldShared) {
+	InterlockedPushEntrySList(&lutPool, reinterpret_cast<SLIST_ENTRY *>(oldShared));
+}
+
+// Set up the pool; WinMain() calls this before any LUThandle can exist or any thread is started
+//
+void LUThandle::InitializePool(void) {
+	InitializeSListHead(&lutPool);
+}
+
+// Free every block in the pool (at exit, to help see actual memory leaks)
+//
+void LUThandle::FreePool(void) {
+	SLIST_ENTRY * entry = InterlockedFlushSList(&lutPool);
+	while (entry) {
+		SLIST_ENTRY * next = entry->Next;
+		_aligned_free(entry);
+		entry = next;
+	}
+}
@@ -103,8 +103,53 @@ typedef enum tag_IS_LINEAR {
 
 // Function to test LUT for linearity
 //
-IS_LINEAR IsLinear(LUT * pLUT);
+IS_LINEAR IsLinear(const LUT * pLUT);
 
 // Write a "signed" linear LUT to a provided address (caller owns memory)
 //
 void GetSignedLUT(LUT * pLUT);
+
+// Compute a cheap 32-bit hash of a LUT (FNV-1a over the 1536 bytes) for change detection
+//
+DWORD HashLUT(const LUT * pLUT);
+
+// An immutable, reference-counted LUT with its hash computed once
+//
+// Profiles, monitors and LUTviews pass these around instead of copying 1536 bytes each time,
+//  so a LUTview showing a profile's LUT holds the profile's own allocation.  A LUT never
+//  changes once it is in a handle; to change one, build a new LUT and assign a new handle.
+//  The fixed-size blocks behind the handles are recycled through a pool, not the heap.
+//
+class LUThandle {
+
+public:
+	LUThandle();
+	explicit LUThandle(const LUT & lut);
+	LUThandle(const LUThandle & other);
+	~LUThandle();
+	LUThandle & operator = (const LUThandle & other);
+
+	const LUT * Get(void) const;					// Zero if the handle is empty
+	DWORD GetHash(void) const;						// HashLUT(Get()), without recomputing it
+	bool IsEmpty(void) const;
+	bool Matches(const LUThandle & other) const;	// Same allocation, or same hash and contents
+	bool Matches(const LUT & lut) const;
+	void Reset(void);
+
+	static void InitializePool(void);
+	static void FreePool(void);
+
+private:
+	typedef struct tag_SHARED_LUT {
+		LUT				lut;
+		DWORD			hash;
+		volatile LONG	refCount;
+	} SHARED_LUT;
+
+	void Release(void);
+
+	static SHARED_LUT * AllocateShared(void);
+	static void FreeShared(SHARED_LUT * oldShared);
+
+	SHARED_LUT *		shared;
+};
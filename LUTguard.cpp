@@ -0,0 +1,322 @@
+// LUTguard.cpp -- Resident mode that watches the LUTs and restores them when another program changes them
+//
+// We wake up every 'period' milliseconds and read back the LUT from "the screen" and from each
+//  monitor.  Reading a LUT is cheap, but comparing it properly (CompareLUT()) is not, so we keep
+//  a hash of the last LUT we accepted for each one and only do the real comparison when the hash
+//  changes.  On an idle system each check is one GetDeviceGammaRamp() and one HashLUT() per
+//  device, so the CPU cost is negligible at the default 250 ms period.
+//
+// See the notes on the "signature" in LUT.h for why we watch "the screen" separately.
+//
+// We also watch the color directory, so that a profile rewritten by a calibration program is
+//  reloaded and its LUT loaded without anyone needing to click Rescan.
+//
+
+#include "stdafx.h"
+#include "Adapter.h"
+#include "Counters.h"
+#include "LUT.h"
+#include "LUTguard.h"
+#include "Monitor.h"
+#include "ProfileWatcher.h"
+#include <strsafe.h>
+//#include <banned.h>
+
+// Symbols defined in other files
+//
+extern HINSTANCE g_hInst;
+extern void FetchMonitorInfo(void);
+extern int LoadAllLUTs(void);
+
+// What we remember about each monitor between checks
+//
+typedef struct tag_GUARDED_MONITOR {
+	Monitor *		monitor;				// The monitor we are watching
+	HDC				hdc;					// DC for this monitor, held open while we run
+	DWORD			lastGoodHash;			// Hash of the last LUT that CompareLUT() accepted
+	bool			haveGoodHash;			// 'false' until we have accepted a LUT
+} GUARDED_MONITOR;
+
+// Global static symbols internal to this file
+//
+static vector <GUARDED_MONITOR> * guardList = 0;
+static DWORD lastScreenHash = 0;
+static bool displayChanged = false;
+static wchar_t * LutGuardClassName = L"LUT Loader guard";
+
+// Return 'true' if a comparison result means "this is the LUT we loaded"
+//
+static bool IsAcceptableComparison(LUT_COMPARISON result) {
+	switch (result) {
+		case LC_EQUAL:
+		case LC_VARIATION_ON_LINEAR:
+		case LC_TRUNCATION_IN_LOW_BYTE:
+		case LC_ROUNDING_IN_LOW_BYTE:
+		case LC_TRUNCATION_OR_ROUNDING:
+		case LC_PROFILE_HAS_NO_LUT_OTHER_LINEAR:
+			return true;
+	}
+	return false;
+}
+
+// Load everything (signature to "the screen", then each monitor) and forget what we knew
+//
+static void ReloadAllAndForget(void) {
+	LoadAllLUTs();
+
+	size_t count = guardList->size();
+	for (size_t i = 0; i < count; ++i) {
+		(*guardList)[i].haveGoodHash = false;
+	}
+
+	LUT screenLUT;
+	SecureZeroMemory(&screenLUT, sizeof(screenLUT));
+	HDC hdc = GetDC(0);
+	if (hdc) {
+		CountEvent(PC_DC_CREATIONS);
+		GetDeviceGammaRamp(hdc, &screenLUT);
+		CountEvent(PC_RAMP_READS);
+		ReleaseDC(0, hdc);
+	}
+	lastScreenHash = HashLUT(&screenLUT);
+}
+
+// Check one monitor, and put its LUT back if someone else changed it
+//
+static void CheckMonitor(GUARDED_MONITOR & guarded) {
+	LUT currentLUT;
+
+	if ( 0 == guarded.hdc ) {
+		return;
+	}
+	CountEvent(PC_RAMP_READS);
+	if ( !GetDeviceGammaRamp(guarded.hdc, &currentLUT) ) {
+		return;
+	}
+	CountEvent(PC_GUARD_CHECKS);
+	DWORD hash = HashLUT(&currentLUT);
+	if ( guarded.haveGoodHash && (hash == guarded.lastGoodHash) ) {
+		CountEvent(PC_GUARD_HASH_HITS);
+		CountEvent(PC_RAMP_WRITES_ELIDED);
+		return;										// The common case:  nothing changed
+	}
+
+	// Something is different (or this is our first look), so do the real comparison
+	//
+	Profile * activeProfile = guarded.monitor->GetActiveProfile();
+	bool acceptable;
+	if (activeProfile) {
+		activeProfile->LoadFullProfile(false);
+		DWORD maxError = 0;
+		DWORD totalError = 0;
+		acceptable = IsAcceptableComparison(activeProfile->CompareLUT(&currentLUT, &maxError, &totalError));
+	} else {
+		IS_LINEAR linear = IsLinear(&currentLUT);
+		acceptable = (IL_LINEAR_8 == linear) || (IL_LINEAR_16 == linear);
+	}
+	if (acceptable) {
+		CountEvent(PC_RAMP_WRITES_ELIDED);
+		guarded.lastGoodHash = hash;
+		guarded.haveGoodHash = true;
+		return;
+	}
+
+	// Not ours ... put ours back and remember what the card gives us back (it may have rounded it)
+	//
+	LUT restoreLUT;
+	const LUT * pLUT = activeProfile ? activeProfile->GetLutPointer() : 0;
+	if (pLUT) {
+		memcpy_s(&restoreLUT, sizeof(restoreLUT), pLUT, sizeof(LUT));
+	} else {
+		GetSignedLUT(&restoreLUT);
+		restoreLUT.red[1] = 0x0101;					// Plain linear16, not the signature
+		restoreLUT.red[2] = 0x0202;
+		restoreLUT.red[3] = 0x0303;
+	}
+	guarded.monitor->WriteLutToCard(&restoreLUT);
+	guarded.haveGoodHash = false;
+	CountEvent(PC_RAMP_READS);
+	if ( GetDeviceGammaRamp(guarded.hdc, &currentLUT) ) {
+		guarded.lastGoodHash = HashLUT(&currentLUT);
+		guarded.haveGoodHash = true;
+	}
+}
+
+// Do one pass over "the screen" and all monitors
+//
+static void CheckAllLUTs(void) {
+
+	// If our signature is gone from "the screen", someone hit every monitor at once
+	//
+	LUT screenLUT;
+	HDC hdc = GetDC(0);
+	if (hdc) {
+		CountEvent(PC_DC_CREATIONS);
+		BOOL bRet = GetDeviceGammaRamp(hdc, &screenLUT);
+		CountEvent(PC_RAMP_READS);
+		ReleaseDC(0, hdc);
+		if (bRet) {
+			DWORD hash = HashLUT(&screenLUT);
+			if ( hash != lastScreenHash ) {
+				if ( IL_SIGNATURE == IsLinear(&screenLUT) ) {
+					lastScreenHash = hash;
+				} else {
+					ReloadAllAndForget();
+					return;
+				}
+			}
+		}
+	}
+
+	// Then check the monitors one at a time
+	//
+	size_t count = guardList->size();
+	for (size_t i = 0; i < count; ++i) {
+		CheckMonitor((*guardList)[i]);
+	}
+}
+
+// Open a DC for each monitor once, instead of once per check
+//
+static void BuildGuardList(void) {
+	size_t count = Monitor::GetListSize();
+	guardList = new vector <GUARDED_MONITOR>;
+	guardList->reserve(count);
+	for (size_t i = 0; i < count; ++i) {
+		GUARDED_MONITOR guarded;
+		guarded.monitor = Monitor::Get(i);
+		guarded.hdc = CreateDC(guarded.monitor->GetAdapter()->GetDeviceName().c_str(), 0, 0, 0);
+		if (guarded.hdc) {
+			CountEvent(PC_DC_CREATIONS);
+		}
+		guarded.lastGoodHash = 0;
+		guarded.haveGoodHash = false;
+		guardList->push_back(guarded);
+	}
+}
+
+// Close our DCs and free the list
+//
+static void FreeGuardList(void) {
+	if (guardList) {
+		size_t count = guardList->size();
+		for (size_t i = 0; i < count; ++i) {
+			if ( (*guardList)[i].hdc ) {
+				DeleteDC( (*guardList)[i].hdc );
+			}
+		}
+		delete guardList;
+		guardList = 0;
+	}
+}
+
+// Our hidden window exists only to hear about WM_DISPLAYCHANGE (monitors added, removed or changed)
+//
+static LRESULT CALLBACK LutGuardWindowProc(HWND hWnd, UINT uMessage, WPARAM wParam, LPARAM lParam) {
+	if ( WM_DISPLAYCHANGE == uMessage ) {
+		displayChanged = true;
+		return 0;
+	}
+	return DefWindowProc(hWnd, uMessage, wParam, lParam);
+}
+
+// Create the hidden window (message-only windows don't get broadcasts, so this is a real one)
+//
+static HWND CreateLutGuardWindow(void) {
+	WNDCLASSEX wc;
+	SecureZeroMemory(&wc, sizeof(wc));
+	wc.cbSize = sizeof(wc);
+	wc.lpfnWndProc = LutGuardWindowProc;
+	wc.hInstance = g_hInst;
+	wc.lpszClassName = LutGuardClassName;
+	RegisterClassEx(&wc);
+	return CreateWindowEx(0, LutGuardClassName, L"", WS_POPUP, 0, 0, 0, 0, NULL, NULL, g_hInst, NULL);
+}
+
+// Run until we get a WM_QUIT, checking the LUTs every 'periodInMilliseconds'
+//
+int RunLutGuard(DWORD periodInMilliseconds) {
+
+	if ( periodInMilliseconds < LUT_GUARD_MINIMUM_PERIOD ) {
+		periodInMilliseconds = LUT_GUARD_MINIMUM_PERIOD;
+	} else if ( periodInMilliseconds > LUT_GUARD_MAXIMUM_PERIOD ) {
+		periodInMilliseconds = LUT_GUARD_MAXIMUM_PERIOD;
+	}
+
+	if ( 0 == Monitor::GetListSize() ) {
+		return 0;
+	}
+	BuildGuardList();
+	HWND hwnd = CreateLutGuardWindow();
+
+	// Start from a known state, with our signature on "the screen"
+	//
+	ReloadAllAndForget();
+
+	// Watch for profiles changing on disk; if we can't, we just do without
+	//
+	ProfileWatcher watcher;
+	watcher.Start();
+	HANDLE hWatch = watcher.GetEventHandle();
+	DWORD handleCount = hWatch ? 1 : 0;
+
+	// Wait for the next check, a quiet profile file, a directory change or a message
+	//
+	DWORD nextCheck = GetTickCount() + periodInMilliseconds;
+	bool done = false;
+	while (!done) {
+
+		// If the display configuration changed, rescan (only new or changed monitors cost us anything)
+		//
+		if (displayChanged) {
+			displayChanged = false;
+			FreeGuardList();
+			FetchMonitorInfo();
+			BuildGuardList();
+			ReloadAllAndForget();
+		}
+
+		DWORD now = GetTickCount();
+		DWORD waitTime = ( static_cast<int>(nextCheck - now) > 0 ) ? (nextCheck - now) : 0;
+		DWORD settleTime = watcher.GetMillisecondsUntilSettled();
+		if ( settleTime < waitTime ) {
+			waitTime = settleTime;
+		}
+		DWORD waitResult = MsgWaitForMultipleObjects(handleCount, &hWatch, FALSE, waitTime, QS_ALLINPUT);
+		if ( handleCount && (WAIT_OBJECT_0 == waitResult) ) {
+			watcher.HandleNotification();
+			continue;
+		}
+		if ( (WAIT_OBJECT_0 + handleCount) == waitResult ) {
+			MSG msg;
+			while ( PeekMessage(&msg, 0, 0, 0, PM_REMOVE) ) {
+				if ( WM_QUIT == msg.message ) {
+					done = true;
+					break;
+				}
+				TranslateMessage(&msg);
+				DispatchMessage(&msg);
+			}
+			continue;
+		}
+		if ( watcher.ReloadSettledProfiles() ) {
+			size_t count = guardList->size();
+			for (size_t i = 0; i < count; ++i) {
+				(*guardList)[i].haveGoodHash = false;	// The profile may have changed under an old hash
+			}
+		}
+		if ( static_cast<int>(GetTickCount() - nextCheck) >= 0 ) {
+			CheckAllLUTs();
+			nextCheck = GetTickCount() + periodInMilliseconds;
+		}
+	}
+	watcher.Stop();
+
+	// Clean up
+	//
+	if (hwnd) {
+		DestroyWindow(hwnd);
+	}
+	FreeGuardList();
+	return 0;
+}
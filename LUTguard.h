@@ -0,0 +1,13 @@
+// LUTguard.h -- Resident mode that watches the LUTs and restores them when another program changes them
+//
+
+#pragma once
+#include "stdafx.h"
+
+// Some constants
+//
+#define LUT_GUARD_DEFAULT_PERIOD	250				// Milliseconds between checks (also our worst-case restore latency)
+#define LUT_GUARD_MINIMUM_PERIOD	50
+#define LUT_GUARD_MAXIMUM_PERIOD	60000
+
+int RunLutGuard(DWORD periodInMilliseconds);
@@ -4,11 +4,21 @@
 
 #include "stdafx.h"
 #include "Adapter.h"
+#include "ColorDirectoryIndex.h"
+#include "CorpusExport.h"
+#include "Counters.h"
+#include "GraphCache.h"
+#include "GraphExport.h"
+#include "LUTguard.h"
 #include "LUTview.h"
+#include "Manifest.h"
 #include "Monitor.h"
 #include "MonitorSummaryItem.h"
+#include "ProfileLoader.h"
 #include "PropertySheet.h"
 #include "Resize.h"
+#include "Snapshot.h"
+#include "Trace.h"
 #include "TreeViewItem.h"
 #include "Utility.h"
 #include "resource.h"
@@ -17,7 +27,6 @@
 
 #pragma comment(lib, "comctl32.lib")				// For PropertySheet
 #pragma comment(lib, "mscms.lib")					// For GetColorDirectory
-#pragma comment(lib, "msimg32.lib")					// For GradientFill
 
 // Optional "features"
 //
@@ -36,6 +45,7 @@ extern wchar_t * ColorDirectoryErrorString = 0;		// The error message for when G
 // Find the directory for profiles (usually "C:\Windows\system32\spool\drivers\color")
 //
 void FetchColorDirectory(void) {
+	TRACE_SCOPE(L"FetchColorDirectory");
 	wchar_t filepath[1024];
 	DWORD filepathSize = sizeof(filepath);
 	SetLastError(0);
@@ -53,12 +63,19 @@ void FetchColorDirectory(void) {
 
 // Build lists of adapters and monitors
 //
+// When called again (for a rescan), adapters and monitors that are still present keep their
+//  objects, along with their LUTs and profile lists.  Only new monitors are initialized, and only
+//  monitors that are gone are deleted.
+//
 void FetchMonitorInfo(void) {
+	TRACE_SCOPE(L"FetchMonitorInfo");
 
-	// Start with empty lists
+	// Start with empty lists, but hold on to what we had so we can reuse it
 	//
-	Monitor::ClearList(false);
-	Adapter::ClearList(false);
+	vector <Monitor *> oldMonitorList;
+	vector <Adapter *> oldAdapterList;
+	Monitor::DetachList(oldMonitorList);
+	Adapter::DetachList(oldAdapterList);
 
 	// Loop through all display adapters
 	//
@@ -68,7 +85,20 @@ void FetchMonitorInfo(void) {
 	int iAdapterNum = 0;
 	while ( EnumDisplayDevices(NULL, iAdapterNum, &displayAdapter, 0) ) {
 		if ( Adapter::IsActive(&displayAdapter) ) {
-			Adapter * adapter = Adapter::Add(new Adapter(displayAdapter));
+			Adapter * adapter = 0;
+			size_t oldAdapterCount = oldAdapterList.size();
+			for (size_t i = 0; i < oldAdapterCount; ++i) {
+				if ( oldAdapterList[i]->Matches(displayAdapter) ) {
+					adapter = oldAdapterList[i];
+					oldAdapterList.erase(oldAdapterList.begin() + i);
+					adapter->Refresh(displayAdapter);
+					break;
+				}
+			}
+			if ( 0 == adapter ) {
+				adapter = new Adapter(displayAdapter);
+			}
+			Adapter::Add(adapter);
 
 			// Loop through all monitors on this display adapter
 			//
@@ -78,25 +108,50 @@ void FetchMonitorInfo(void) {
 			int iMonitorNum = 0;
 			while ( EnumDisplayDevices(displayAdapter.DeviceName, iMonitorNum, &displayMonitor, 0) ) {
 				if ( Monitor::IsActive(displayMonitor) ) {
-					Monitor * monitor = Monitor::Add(new Monitor(adapter, displayMonitor));
-					monitor->Initialize();
+					Monitor * monitor = 0;
+					size_t oldMonitorCount = oldMonitorList.size();
+					for (size_t i = 0; i < oldMonitorCount; ++i) {
+						if ( oldMonitorList[i]->Matches(displayMonitor) ) {
+							monitor = oldMonitorList[i];
+							oldMonitorList.erase(oldMonitorList.begin() + i);
+							monitor->Refresh(adapter, displayMonitor);
+							break;
+						}
+					}
+					if ( 0 == monitor ) {
+						monitor = new Monitor(adapter, displayMonitor);
+						monitor->Initialize();
+					}
+					Monitor::Add(monitor);
 				}
 				++iMonitorNum;
 			}
 		}
 		++iAdapterNum;
 	}
+
+	// Anything left over is no longer attached
+	//
+	size_t count = oldMonitorList.size();
+	for (size_t i = 0; i < count; ++i) {
+		delete oldMonitorList[i];
+	}
+	count = oldAdapterList.size();
+	for (size_t i = 0; i < count; ++i) {
+		delete oldAdapterList[i];
+	}
 }
 
 // Load LUTs from active profiles for all monitors
 //
 int LoadAllLUTs(void) {
+	TRACE_SCOPE(L"LoadAllLUTs");
 
 	size_t count = Monitor::GetListSize();
 	LUT linearLUT;
 	Monitor * monitor;
 	Profile * activeProfile;
-	LUT * pLUT;
+	const LUT * pLUT;
 	if (count) {
 
 		// First, set the "screen" DC to linear
@@ -104,10 +159,12 @@ int LoadAllLUTs(void) {
 		GetSignedLUT(&linearLUT);
 		HDC hdc = GetDC(0);
 		if (hdc) {
+			CountEvent(PC_DC_CREATIONS);
 			++linearLUT.red[1];
 			SetDeviceGammaRamp(hdc, &linearLUT);
 			--linearLUT.red[1];
 			SetDeviceGammaRamp(hdc, &linearLUT);
+			CountEvent(PC_RAMP_WRITES, 2);
 			ReleaseDC(0, hdc);
 		}
 
@@ -140,6 +197,18 @@ int LoadLUTsAtStartup(void) {
 	return retVal;
 }
 
+// Convert a file name that follows a switch (as in /M:file) to Unicode, removing quotes; caller
+// must free() the result
+//
+bool GetPathArgument(char * argument, wchar_t * & unicodePath) {
+	size_t pathLength = strlen(argument);
+	if ( (pathLength >= 2) && ('"' == argument[0]) && ('"' == argument[pathLength - 1]) ) {
+		argument[pathLength - 1] = 0;
+		++argument;
+	}
+	return ( (0 != *argument) && AnsiToUnicode(argument, unicodePath) );
+}
+
 // Program entry point
 //
 int WINAPI WinMain(
@@ -151,6 +220,7 @@ int WINAPI WinMain(
 	UNREFERENCED_PARAMETER(hPrevInstance);
 
 	g_hInst = hInstance;
+	LUThandle::InitializePool();
 
 #ifdef DEBUG_MEMORY_LEAKS
 	//_crtBreakAlloc = 223;		// To debug memory leaks, set this to allocation number ("{nnn}")
@@ -218,6 +288,58 @@ if (GetProcessUserModeExceptionPolicy(&dwFlags)) {
 
 #endif
 
+	// Tracing (/T:tracefile) and statistics (/stats) go first and can be combined with any other
+	//  switch, as in "/T:startup.json /stats /L"
+	//
+	int retval;
+	wchar_t * unicodePath = 0;
+	bool showStatistics = false;
+	for (;;) {
+		if (0 == strncmp(lpCmdLine, "/T:", 3)) {
+			char * tracePath = &lpCmdLine[3];
+			char * pathEnd;
+			if ('"' == *tracePath) {
+				++tracePath;
+				pathEnd = strchr(tracePath, '"');
+			} else {
+				pathEnd = strchr(tracePath, ' ');
+			}
+			lpCmdLine = pathEnd ? (pathEnd + 1) : (tracePath + strlen(tracePath));
+			if (pathEnd) {
+				*pathEnd = 0;
+			}
+			if ( *tracePath && AnsiToUnicode(tracePath, unicodePath) ) {
+				StartTracing(unicodePath);
+				free(unicodePath);
+			}
+		} else if (0 == _strnicmp(lpCmdLine, "/stats", 6) && ( 0 == lpCmdLine[6] || ' ' == lpCmdLine[6] )) {
+			showStatistics = true;
+			lpCmdLine += 6;
+		} else {
+			break;
+		}
+		while (' ' == *lpCmdLine) {
+			++lpCmdLine;
+		}
+	}
+
+	// A snapshot restore (/R:snapshot) is meant to be fast, so it doesn't look at profiles or
+	//  the registry and we handle it before we build our lists
+	//
+	if (0 == strncmp(lpCmdLine, "/R:", 3)) {
+		retval = 1;
+		if ( GetPathArgument(&lpCmdLine[3], unicodePath) ) {
+			TRACE_SCOPE(L"RestoreSnapshot");
+			retval = RestoreSnapshot(unicodePath);
+			free(unicodePath);
+		}
+		StopTracing();
+		if (showStatistics) {
+			WriteToConsole(CountersString());
+		}
+		return retval;
+	}
+
 	// Find the directory for profiles (usually "C:\Windows\system32\spool\drivers\color")
 	//
 	FetchColorDirectory();
@@ -226,18 +348,61 @@ if (GetProcessUserModeExceptionPolicy(&dwFlags)) {
 	//
 	FetchMonitorInfo();
 
-	// See if we are invoked with /L or /S
+	// See if we are invoked with /L, /S, /G (/G can be /G:nnn for a period in milliseconds),
+	//  /M:manifest, /MD:manifest (dry run of /M), /X:snapshot (export), /I:folder (graph images)
+	//  /C:folder (synthetic profile corpus) or /CT:folder (load the corpus to test the parser)
 	//
-	int retval;
 	if (0 == strcmp(lpCmdLine, "/L")) {
 		retval = LoadAllLUTs();
 	} else if (0 == strcmp(lpCmdLine, "/S")) {
 		retval = LoadLUTsAtStartup();
+	} else if (0 == strncmp(lpCmdLine, "/G", 2) && ( 0 == lpCmdLine[2] || ':' == lpCmdLine[2] )) {
+		DWORD period = LUT_GUARD_DEFAULT_PERIOD;
+		if ( ':' == lpCmdLine[2] ) {
+			period = static_cast<DWORD>(atoi(&lpCmdLine[3]));
+		}
+		retval = RunLutGuard(period);
+	} else if (0 == strncmp(lpCmdLine, "/M:", 3) || 0 == strncmp(lpCmdLine, "/MD:", 4)) {
+		bool dryRun = ('D' == lpCmdLine[2]);
+		retval = 1;
+		if ( GetPathArgument(&lpCmdLine[dryRun ? 4 : 3], unicodePath) ) {
+			retval = ApplyManifest(unicodePath, dryRun);
+			free(unicodePath);
+		}
+	} else if (0 == strncmp(lpCmdLine, "/X:", 3)) {
+		retval = 1;
+		if ( GetPathArgument(&lpCmdLine[3], unicodePath) ) {
+			retval = ExportSnapshot(unicodePath);
+			free(unicodePath);
+		}
+	} else if (0 == strncmp(lpCmdLine, "/I:", 3)) {
+		retval = 1;
+		if ( GetPathArgument(&lpCmdLine[3], unicodePath) ) {
+			retval = ExportProfileGraphs(unicodePath);
+			free(unicodePath);
+		}
+	} else if (0 == strncmp(lpCmdLine, "/C:", 3)) {
+		retval = 1;
+		if ( GetPathArgument(&lpCmdLine[3], unicodePath) ) {
+			retval = WriteSyntheticCorpus(unicodePath);
+			free(unicodePath);
+		}
+	} else if (0 == strncmp(lpCmdLine, "/CT:", 4)) {
+		retval = 1;
+		if ( GetPathArgument(&lpCmdLine[4], unicodePath) ) {
+			retval = TestSyntheticCorpus(unicodePath);
+			free(unicodePath);
+		}
 	} else {
 #if GDI_BATCH_LIMIT
 		GdiSetBatchLimit(1);
 #endif
-		retval = ShowPropertySheet(nShowCmd);
+		retval = ShowPropertySheet(nShowCmd, showStatistics);
+		ProfileLoader::Stop();
+	}
+	StopTracing();
+	if (showStatistics) {
+		WriteToConsole(CountersString() + Profile::MemoryString());
 	}
 
 #ifdef DEBUG_MEMORY_LEAKS
@@ -245,9 +410,12 @@ if (GetProcessUserModeExceptionPolicy(&dwFlags)) {
 	Adapter::ClearList(true);
 	Resize::ClearResizeList(true);
 	Resize::ClearAnchorPresetList(true);
+	ColorDirectoryIndex::ClearList(true);
 	Profile::ClearList(true);
 	LUTview::ClearList(true);
+	GraphCache::ClearList(true);
 	MonitorSummaryItem::ClearList(true);
+	LUThandle::FreePool();
 
 	if (ColorDirectory) {				// Two strings we may have 'new'-ed
 		delete [] ColorDirectory;
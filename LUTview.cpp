@@ -2,6 +2,8 @@
 //
 
 #include "stdafx.h"
+#include "Counters.h"
+#include "GraphCache.h"
 #include "LUT.h"
 #include "LUTview.h"
 #include "resource.h"
@@ -20,11 +22,6 @@
 
 // Colors for the different display styles
 //
-#define RED_COLOR_NORMAL						RGB(255,  0,  0)
-#define GREEN_COLOR_NORMAL						RGB(  0,255,  0)
-#define BLUE_COLOR_NORMAL						RGB(  0,  0,255)
-#define WHITE_COLOR								RGB(255,255,255)
-#define BLACK_COLOR								RGB(  0,  0,  0)
 #define LIGHT_GRAY_COLOR						RGB(192,192,192)
 
 #if 0 // currently unused
@@ -49,60 +46,12 @@ extern double dpiScale;						// Scaling factor for dots per inch (actual versus
 //
 static wchar_t * LutViewClassName = LUTVIEW_CLASS_NAME;		// Global for register window class name of LUTview windows
 
-typedef struct tag_STYLE_SET {
-	COLORREF	background;
-	COLORREF	frame;
-	COLORREF	grid;
-	COLORREF	gridDashBkColor;
-	COLORREF	text;
-	COLORREF	red;
-	COLORREF	green;
-	COLORREF	blue;
-	DWORD		gridlineCount;
-} STYLE_SET;
-
-static STYLE_SET styleTable[3] = {
-	{		// LGDS_WHITE style
-		WHITE_COLOR,			// background
-		RGB(  0,  0,  0),		// frame
-		LIGHT_GRAY_COLOR,		// grid
-		RGB(240,240,240),		// grid dashes
-		BLACK_COLOR,			// text
-		RED_COLOR_NORMAL,		// red
-		GREEN_COLOR_NORMAL,		// green
-		BLUE_COLOR_NORMAL,		// blue
-		14						// how many grid lines to draw
-	},
-	{		// LGDS_BLACK style
-		BLACK_COLOR,			// background
-		RGB(128,128,128),		// frame
-		RGB( 96, 96, 96),		// grid
-		RGB( 64, 64, 64),		// grid dashes
-		WHITE_COLOR,			// text
-		RED_COLOR_NORMAL,		// red
-		GREEN_COLOR_NORMAL,		// green
-		BLUE_COLOR_NORMAL,		// blue
-		6						// how many grid lines to draw
-	},
-	{		// LGDS_GRADIENT style
-		WHITE_COLOR,			// background
-		RGB(128,128,128),		// frame
-		RGB(160,160,160),		// grid
-		RGB( 96, 96, 96),		// grid dashes
-		BLACK_COLOR,			// text
-		RED_COLOR_NORMAL,		// red
-		GREEN_COLOR_NORMAL,		// green
-		BLUE_COLOR_NORMAL,		// blue
-		0						// how many grid lines to draw
-	}
-};
-
 // Constructor
 //
 LUTview::LUTview(wstring text, LUT_GRAPH_DISPLAY_STYLE displayStyle, bool userControl) :
 		displayText(text),
 		hwnd(0),
-		pLUT(0),
+		textHash(HashBytes(text.c_str(), text.size() * sizeof(wchar_t))),
 		graphDisplayStyle(displayStyle),
 		userCanChangeDisplayMode(userControl),
 		offscreenDC(0),
@@ -119,23 +68,18 @@ LUTview::LUTview(wstring text, LUT_GRAPH_DISPLAY_STYLE displayStyle, bool userCo
 	outerRect.top = 0;
 	outerRect.right = 0;
 	outerRect.bottom = 0;
+	SecureZeroMemory(&cacheKey, sizeof(cacheKey));
 }
 
 // Destructor
 //
 LUTview::~LUTview() {
-	if (pLUT) {
-		delete [] pLUT;
-	}
 	if (offscreenDC) {
-		if (oldBitmap) {
-			SelectObject(offscreenDC, oldBitmap);
-		}
-		if (offscreenBitmap) {
-			DeleteObject(offscreenBitmap);
-		}
 		DeleteDC(offscreenDC);
 	}
+	if (offscreenBitmap) {
+		GraphCache::Release(offscreenBitmap);
+	}
 }
 
 // Vector of LUTviews
@@ -191,7 +135,7 @@ LRESULT CALLBACK LUTview::LUTviewWndProc(HWND hWnd, UINT uMessage, WPARAM wParam
 			thisView = reinterpret_cast<LUTview *>(static_cast<LONG_PTR>(GetWindowLongPtr(hWnd, 0)));
 			PAINTSTRUCT ps;
 			BeginPaint(hWnd, &ps);
-			if (thisView->pLUT) {
+			if (!thisView->lutHandle.IsEmpty()) {
 				++thisView->paintCount;
 				thisView->PaintGraphOnScreenDC(ps.hdc);
 			} else {
@@ -204,7 +148,7 @@ LRESULT CALLBACK LUTview::LUTviewWndProc(HWND hWnd, UINT uMessage, WPARAM wParam
 		case WM_CONTEXTMENU:
 			thisView = reinterpret_cast<LUTview *>(static_cast<LONG_PTR>(GetWindowLongPtr(hWnd, 0)));
 			if (thisView) {
-				if ( thisView->userCanChangeDisplayMode && thisView->pLUT ) {
+				if ( thisView->userCanChangeDisplayMode && !thisView->lutHandle.IsEmpty() ) {
 					POINT pt;
 					pt.x = static_cast<signed short>(LOWORD(lParam));
 					pt.y = static_cast<signed short>(HIWORD(lParam));
@@ -301,18 +245,11 @@ LUT_GRAPH_DISPLAY_STYLE LUTview::GetGraphDisplayStyle(void) {
 
 void LUTview::SetText(wstring newText) {
 	displayText = newText;
+	textHash = HashBytes(displayText.c_str(), displayText.size() * sizeof(wchar_t));
 }
 
-void LUTview::SetLUT(LUT * lutPointer) {
-	if (pLUT) {
-		delete [] pLUT;
-	}
-	if (lutPointer) {
-		pLUT = new LUT;
-		memcpy_s(pLUT, sizeof(LUT), lutPointer, sizeof(LUT));
-	} else {
-		pLUT = 0;
-	}
+void LUTview::SetLUT(const LUThandle & newLUT) {
+	lutHandle = newLUT;
 }
 
 void LUTview::SetUpdateBitmap(void) {
@@ -323,27 +260,17 @@ RECT * LUTview::GetGraphRect(void) {
 	return &innerRect;
 }
 
-// This could draw to the screen, but we use it to draw to an offscreen bitmap/DC
+// This could draw to the screen, but we use it to draw to an offscreen bitmap/DC.  The graph
+//  itself comes from GraphRaster.cpp; we only add the heading text.
 //
 void LUTview::DrawGraphOnDC(HDC hdc, RECT * targetRect) {
 	SIZE headingSize;
 	RECT headingRect;
-	int clipped;
-	wstring s;
 	wchar_t buf[1024];
 	HFONT hFont;
 	HGDIOBJ oldFont;
-	POINT pt[256];
-	HGDIOBJ oldPen = 0;
-	HGDIOBJ gridPen = 0;
-	HGDIOBJ gridPen2 = 0;
 
-	// This is just to suppress "warning C6385: Invalid data: accessing
-	// 'struct tag_COLOR_SET * styleTable', the readable size is '84' bytes, but '140' bytes might be read"
-	//
-	if (graphDisplayStyle > LGDS_GRADIENT) {	// It's an 'enum', so it really should be in range ...
-		return;
-	}
+	CountEvent(PC_GRAPH_REPAINTS);
 
 	// Fetch the heading text and compute its size and rectangle.  We wait until the
 	// end to draw it, but we want to avoid clipping it with gridlines
@@ -368,342 +295,59 @@ void LUTview::DrawGraphOnDC(HDC hdc, RECT * targetRect) {
 	headingRect.right = headingRect.left + headingSize.cx;
 	headingRect.bottom = headingRect.top + headingSize.cy;
 
-	// Draw the background
-	//
-	if ( LGDS_GRADIENT == graphDisplayStyle ) {
-		TRIVERTEX t[4];
-		t[0].x = targetRect->left + 1;		// Upper left corner
-		t[0].y = targetRect->top + 1;
-		t[0].Red = 128 << 8;
-		t[0].Green = 128 << 8;
-		t[0].Blue = 128 << 8;
-		t[0].Alpha = 255 << 8;
-
-		t[1].x = targetRect->right - 1;		// Upper right corner
-		t[1].y = targetRect->top + 1;
-		t[1].Red = 255 << 8;
-		t[1].Green = 255 << 8;
-		t[1].Blue = 255 << 8;
-		t[1].Alpha = 255 << 8;
-
-		t[2].x = targetRect->right - 1;		// Lower right corner
-		t[2].y = targetRect->bottom - 1;
-		t[2].Red = 128 << 8;
-		t[2].Green = 128 << 8;
-		t[2].Blue = 128 << 8;
-		t[2].Alpha = 255 << 8;
-
-		t[3].x = targetRect->left + 1;		// Lower left corner
-		t[3].y = targetRect->bottom - 1;
-		t[3].Red = 0 << 8;
-		t[3].Green = 0 << 8;
-		t[3].Blue = 0 << 8;
-		t[3].Alpha = 255 << 8;
-
-		GRADIENT_TRIANGLE g[2];
-		g[0].Vertex1 = 0;
-		g[0].Vertex2 = 2;
-		g[0].Vertex3 = 3;
-
-		g[1].Vertex1 = 0;
-		g[1].Vertex2 = 2;
-		g[1].Vertex3 = 1;
-
-		GradientFill(hdc, t, _countof(t), g, _countof(g), GRADIENT_FILL_TRIANGLE);
-	} else {
-		HBRUSH hBrushBackground = CreateSolidBrush(styleTable[graphDisplayStyle].background);
-		FillRect(hdc, targetRect, hBrushBackground);
-		DeleteObject(hBrushBackground);
-	}
-
-	// Maybe draw crosshatch lines
-	//
-	if ( styleTable[graphDisplayStyle].gridlineCount ) {
-		int gridLeft = targetRect->left;
-		int gridTop = targetRect->top;
-		int gridRight = targetRect->right;
-		int gridBottom = targetRect->bottom;
-		int gridVerticalMidpoint2 = (gridTop + gridBottom) / 2;
-		int gridHorizontalMidpoint2 = (gridLeft + gridRight) / 2;
-		int gridVerticalMidpoint1 = (gridTop + gridVerticalMidpoint2) / 2;
-		int gridHorizontalMidpoint1 = (gridLeft + gridHorizontalMidpoint2) / 2;
-		int gridVerticalMidpoint3 = (gridVerticalMidpoint2 + gridBottom) / 2;
-		int gridHorizontalMidpoint3 = (gridHorizontalMidpoint2 + gridRight) / 2;
-		DWORD ptIndex[8];
-
-		int edgeRight = headingRect.right + graphCaptionIndentX;
-		int edgeBottom = headingRect.bottom + graphCaptionIndentY;
-
-		clipped = gridTop;
-		if ( gridHorizontalMidpoint1 < edgeRight ) {
-			clipped = edgeBottom;
-		}
-		pt[0].x = gridHorizontalMidpoint1;
-		pt[0].y = clipped;
-		pt[1].x = gridHorizontalMidpoint1;
-		pt[1].y = gridBottom;
-		ptIndex[0] = 2;
-
-		clipped = gridTop;
-		if ( gridHorizontalMidpoint2 < edgeRight ) {
-			clipped = edgeBottom;
-		}
-		pt[2].x = gridHorizontalMidpoint2;
-		pt[2].y = clipped;
-		pt[3].x = gridHorizontalMidpoint2;
-		pt[3].y = gridBottom;
-		ptIndex[1] = 2;
-
-		clipped = gridTop;
-		if ( gridHorizontalMidpoint3 < edgeRight ) {
-			clipped = edgeBottom;
-		}
-		pt[4].x = gridHorizontalMidpoint3;
-		pt[4].y = clipped;
-		pt[5].x = gridHorizontalMidpoint3;
-		pt[5].y = gridBottom;
-		ptIndex[2] = 2;
-
-		pt[6].x = gridLeft;
-		pt[6].y = gridVerticalMidpoint1;
-		pt[7].x = gridRight;
-		pt[7].y = gridVerticalMidpoint1;
-		ptIndex[3] = 2;
-
-		pt[8].x = gridLeft;
-		pt[8].y = gridVerticalMidpoint2;
-		pt[9].x = gridRight;
-		pt[9].y = gridVerticalMidpoint2;
-		ptIndex[4] = 2;
-
-		pt[10].x = gridLeft;
-		pt[10].y = gridVerticalMidpoint3;
-		pt[11].x = gridRight;
-		pt[11].y = gridVerticalMidpoint3;
-		ptIndex[5] = 2;
-
-		gridPen = CreatePen(PS_SOLID, 0, styleTable[graphDisplayStyle].grid);
-		oldPen = SelectObject(hdc, gridPen);
-		DWORD lineCount = styleTable[graphDisplayStyle].gridlineCount;
-		if (lineCount > 6) {
-			lineCount = 6;
-		}
-		PolyPolyline(hdc, pt, ptIndex, lineCount);
-
-		if (styleTable[graphDisplayStyle].gridlineCount > 6) {
-
-			int gridVerticalFraction1   = (gridTop  + gridVerticalMidpoint1) / 2;
-			int gridHorizontalFraction1 = (gridLeft + gridHorizontalMidpoint1) / 2;
-
-			int gridVerticalFraction2   = (gridVerticalMidpoint1   + gridVerticalMidpoint2) / 2;
-			int gridHorizontalFraction2 = (gridHorizontalMidpoint1 + gridHorizontalMidpoint2) / 2;
-
-			int gridVerticalFraction3   = (gridVerticalMidpoint2   + gridVerticalMidpoint3) / 2;
-			int gridHorizontalFraction3 = (gridHorizontalMidpoint2 + gridHorizontalMidpoint3) / 2;
-
-			int gridVerticalFraction4   = (gridVerticalMidpoint3   + gridBottom) / 2;
-			int gridHorizontalFraction4 = (gridHorizontalMidpoint3 + gridRight) / 2;
-
-			clipped = gridTop;
-			if ( gridHorizontalFraction1 < edgeRight ) {
-				clipped = edgeBottom;
-			}
-			pt[0].x = gridHorizontalFraction1;
-			pt[0].y = clipped;
-			pt[1].x = gridHorizontalFraction1;
-			pt[1].y = gridBottom;
-			ptIndex[0] = 2;
-
-			clipped = gridTop;
-			if ( gridHorizontalFraction2 < edgeRight ) {
-				clipped = edgeBottom;
-			}
-			pt[2].x = gridHorizontalFraction2;
-			pt[2].y = clipped;
-			pt[3].x = gridHorizontalFraction2;
-			pt[3].y = gridBottom;
-			ptIndex[1] = 2;
-
-			clipped = gridTop;
-			if ( gridHorizontalFraction3 < edgeRight ) {
-				clipped = edgeBottom;
-			}
-			pt[4].x = gridHorizontalFraction3;
-			pt[4].y = clipped;
-			pt[5].x = gridHorizontalFraction3;
-			pt[5].y = gridBottom;
-			ptIndex[2] = 2;
-
-			clipped = gridTop;
-			if ( gridHorizontalFraction4 < edgeRight ) {
-				clipped = edgeBottom;
-			}
-			pt[6].x = gridHorizontalFraction4;
-			pt[6].y = clipped;
-			pt[7].x = gridHorizontalFraction4;
-			pt[7].y = gridBottom;
-			ptIndex[3] = 2;
-
-			pt[8].x = gridLeft;
-			pt[8].y = gridVerticalFraction1;
-			pt[9].x = gridRight;
-			pt[9].y = gridVerticalFraction1;
-			ptIndex[4] = 2;
-
-			pt[10].x = gridLeft;
-			pt[10].y = gridVerticalFraction2;
-			pt[11].x = gridRight;
-			pt[11].y = gridVerticalFraction2;
-			ptIndex[5] = 2;
-
-			pt[12].x = gridLeft;
-			pt[12].y = gridVerticalFraction3;
-			pt[13].x = gridRight;
-			pt[13].y = gridVerticalFraction3;
-			ptIndex[6] = 2;
-
-			pt[14].x = gridLeft;
-			pt[14].y = gridVerticalFraction4;
-			pt[15].x = gridRight;
-			pt[15].y = gridVerticalFraction4;
-			ptIndex[7] = 2;
-
-			gridPen2 = CreatePen(PS_DOT, 0, styleTable[graphDisplayStyle].grid);
-			SelectObject(hdc, gridPen2);
-			COLORREF oldBkColor = SetBkColor(hdc, styleTable[graphDisplayStyle].gridDashBkColor);
-			PolyPolyline(hdc, pt, ptIndex, 8);
-			SetBkColor(hdc, oldBkColor);
-		}
-	}
-
-	// Compute scaling for graph
-	//
-	double xFactor = ( (targetRect->right - targetRect->left - 2) / double(255) );
-	double yFactor = ( (targetRect->bottom - targetRect->top - 2) / double(65535) );
-
-	// Try merging colors (works best on a black background, useless on white)
+	// Draw the graph in memory, keeping gridlines clear of the heading, and copy it to the DC
 	//
-	if ( LGDS_BLACK == graphDisplayStyle ) {
-		SetROP2(hdc, R2_MERGEPEN);
-	}
-
-	// Draw red
-	//
-	HGDIOBJ redPen = CreatePen(PS_SOLID, 0, styleTable[graphDisplayStyle].red);
-	if (oldPen) {
-		SelectObject(hdc, redPen);
-	} else {
-		oldPen = SelectObject(hdc, redPen);
-	}
-	for (size_t i = 0; i < 256; ++i) {
-		pt[i].x = targetRect->left + (int)(xFactor * double(i) + 0.49) + 1;
-		if ( pt[i].x < (targetRect->left + 1) ) {
-			pt[i].x = (targetRect->left + 1);
-		} else if ( pt[i].x > (targetRect->right - 1) ) {
-			pt[i].x = (targetRect->right - 1);
-		}
-		pt[i].y = targetRect->bottom - (int)(yFactor * double(pLUT->red[i]) + 0.49) - 2;
-		if ( pt[i].y < (targetRect->top) ) {
-			pt[i].y = (targetRect->top);
-		} else if ( pt[i].y > (targetRect->bottom - 1) ) {
-			pt[i].y = (targetRect->bottom - 1);
-		}
-	}
-	Polyline(hdc, pt, 256);
-
-	// Draw green
-	//
-	HGDIOBJ greenPen = CreatePen(PS_SOLID, 0, styleTable[graphDisplayStyle].green);
-	SelectObject(hdc, greenPen);
-	for (size_t i = 0; i < 256; ++i) {
-		pt[i].x = targetRect->left + (int)(xFactor * double(i) + 0.49) + 1;
-		if ( pt[i].x < (targetRect->left + 1) ) {
-			pt[i].x = (targetRect->left + 1);
-		} else if ( pt[i].x > (targetRect->right - 1) ) {
-			pt[i].x = (targetRect->right - 1);
-		}
-		pt[i].y = targetRect->bottom - (int)(yFactor * double(pLUT->green[i]) + 0.49) - 2;
-		if ( pt[i].y < (targetRect->top) ) {
-			pt[i].y = (targetRect->top);
-		} else if ( pt[i].y > (targetRect->bottom - 1) ) {
-			pt[i].y = (targetRect->bottom - 1);
-		}
-	}
-	Polyline(hdc, pt, 256);
-
-	// Draw blue
-	//
-	HGDIOBJ bluePen = CreatePen(PS_SOLID, 0, styleTable[graphDisplayStyle].blue);
-	SelectObject(hdc, bluePen);
-	for (size_t i = 0; i < 256; ++i) {
-		pt[i].x = targetRect->left + (int)(xFactor * double(i) + 0.49) + 1;
-		if ( pt[i].x < (targetRect->left + 1) ) {
-			pt[i].x = (targetRect->left + 1);
-		} else if ( pt[i].x > (targetRect->right - 1) ) {
-			pt[i].x = (targetRect->right - 1);
-		}
-		pt[i].y = targetRect->bottom - (int)(yFactor * double(pLUT->blue[i]) + 0.49) - 2;
-		if ( pt[i].y < (targetRect->top) ) {
-			pt[i].y = (targetRect->top);
-		} else if ( pt[i].y > (targetRect->bottom - 1) ) {
-			pt[i].y = (targetRect->bottom - 1);
-		}
+	GRAPH_IMAGE image;
+	SetGraphImageSize(image, targetRect->right - targetRect->left, targetRect->bottom - targetRect->top);
+	if ( 0 == image.width || 0 == image.height ) {
+		SelectObject(hdc, oldFont);
+		return;
 	}
-	Polyline(hdc, pt, 256);
-
-	// We need to restore overwrite mode to draw the solid frame
-	//
-	SetROP2(hdc, R2_COPYPEN);
-
-	// Draw a frame
-	//
-	pt[0].x = targetRect->left;
-	pt[0].y = targetRect->top;
-
-	pt[1].x = targetRect->left;
-	pt[1].y = targetRect->bottom - 1;
-
-	pt[2].x = targetRect->right - 1;
-	pt[2].y = targetRect->bottom - 1;
-
-	pt[3].x = targetRect->right - 1;
-	pt[3].y = targetRect->top;
-
-	pt[4].x = targetRect->left;
-	pt[4].y = targetRect->top;
-
-	HGDIOBJ framePen = CreatePen(PS_SOLID, 0, styleTable[graphDisplayStyle].frame);
-	SelectObject(hdc, framePen);
-	Polyline(hdc, pt, 5);
+	RasterizeLutGraph(
+			image,
+			lutHandle.Get()->red,
+			lutHandle.Get()->green,
+			lutHandle.Get()->blue,
+			graphDisplayStyle,
+			headingRect.right - targetRect->left + graphCaptionIndentX,
+			headingRect.bottom - targetRect->top + graphCaptionIndentY );
+
+	BITMAPINFO bmi;
+	SecureZeroMemory(&bmi, sizeof(bmi));
+	bmi.bmiHeader.biSize = sizeof(bmi.bmiHeader);
+	bmi.bmiHeader.biWidth = image.width;
+	bmi.bmiHeader.biHeight = -image.height;					// Negative for top-down
+	bmi.bmiHeader.biPlanes = 1;
+	bmi.bmiHeader.biBitCount = 32;
+	bmi.bmiHeader.biCompression = BI_RGB;
+	SetDIBitsToDevice(
+			hdc,
+			targetRect->left,
+			targetRect->top,
+			image.width,
+			image.height,
+			0,
+			0,
+			0,
+			image.height,
+			&image.pixels[0],
+			&bmi,
+			DIB_RGB_COLORS );
 
 	// Draw the heading text, if any
 	//
 	if (buf[0]) {
+		unsigned int textColor = GetGraphTextColor(graphDisplayStyle);
 		int oldMode = SetBkMode(hdc, TRANSPARENT);
-		SetTextColor(hdc, styleTable[graphDisplayStyle].text);
+		SetTextColor(hdc, RGB((textColor >> 16) & 0xFF, (textColor >> 8) & 0xFF, textColor & 0xFF));
 		DrawText(hdc, buf, -1, &headingRect, 0);
 		SetBkMode(hdc, oldMode);
 	}
-
-	// Restore original pen, delete the ones we created
-	//
-	SelectObject(hdc, oldPen);
-	if (gridPen) {
-		DeleteObject(gridPen);
-	}
-	if (gridPen2) {
-		DeleteObject(gridPen2);
-	}
-	DeleteObject(redPen);
-	DeleteObject(greenPen);
-	DeleteObject(bluePen);
-	DeleteObject(framePen);
+	SelectObject(hdc, oldFont);
 }
 
 void LUTview::PaintGraphOnScreenDC(HDC hdc) {
 
-	RECT oldInnerRect = innerRect;
-
 	// Compute the largest square that fits within our rect, centered
 	//
 	GetClientRect(hwnd, &outerRect);
@@ -752,55 +396,61 @@ void LUTview::PaintGraphOnScreenDC(HDC hdc) {
 		innerRect = outerRect;
 	}
 
-	// Do we need a new bitmap, or can we just BitBlt the old one?
+	// First time here, create the offscreen DC, remembering its original 1x1 monochrome bitmap
+	//
+	if ( 0 == offscreenDC ) {
+		offscreenDC = CreateCompatibleDC(hdc);
+		oldBitmap = reinterpret_cast<HBITMAP>(GetCurrentObject(offscreenDC, OBJ_BITMAP));
+	}
+
+	// Describe the graph we need.  If it isn't the one we have, get it from the cache, or
+	//  draw it and give it to the cache so that other LUTviews can use it.
 	//
 	SIZE newSize;
 	newSize.cx = innerRect.right - innerRect.left;
 	newSize.cy = innerRect.bottom - innerRect.top;
-	if ( !updateBitmap ) {
-		SIZE oldSize;
-		oldSize.cx = oldInnerRect.right - oldInnerRect.left;
-		oldSize.cy = oldInnerRect.bottom - oldInnerRect.top;
-		if ( (oldSize.cx != newSize.cx) || (oldSize.cy != newSize.cy) ) {
-			updateBitmap = true;
+	GRAPH_CACHE_KEY key;
+	SecureZeroMemory(&key, sizeof(key));
+	key.lutHash = lutHandle.GetHash();
+	key.textHash = textHash;
+	key.width = newSize.cx;
+	key.height = newSize.cy;
+	key.style = graphDisplayStyle;
+	key.dpiScale = dpiScale;
+	if ( updateBitmap || (0 == offscreenBitmap) || !GraphCache::KeysMatch(key, cacheKey) ) {
+		HBITMAP newBitmap = GraphCache::Acquire(key);
+		if ( 0 == newBitmap ) {
+			newBitmap = CreateCompatibleBitmap(hdc, newSize.cx, newSize.cy);
+			if (newBitmap) {
+				RECT targetRect;
+				targetRect.left = 0;
+				targetRect.top = 0;
+				targetRect.right = newSize.cx;
+				targetRect.bottom = newSize.cy;
+				SelectObject(offscreenDC, newBitmap);
+				DrawGraphOnDC(offscreenDC, &targetRect);
+				SelectObject(offscreenDC, oldBitmap);
+				GraphCache::Add(key, newBitmap);
+			}
 		}
-	}
-	if ( updateBitmap ) {
-
-		if (offscreenDC) {
-
-			// We have an existing DC and bitmap.  Make a new bitmap, select it into
-			//  the DC, then delete the previous bitmap.
-			//
-			HBITMAP previousBitmap = offscreenBitmap;
-			offscreenBitmap = CreateCompatibleBitmap(hdc, newSize.cx, newSize.cy);
-			SelectObject(offscreenDC, offscreenBitmap);
-			DeleteObject(previousBitmap);
-		} else {
-
-			// First time here, create the offscreen DC and a new bitmap,
-			//  then select the bitmap, remembering the original 1x1 monochrome one.
-			//
-			offscreenDC = CreateCompatibleDC(hdc);
-			offscreenBitmap = CreateCompatibleBitmap(hdc, newSize.cx, newSize.cy);
-			oldBitmap = reinterpret_cast<HBITMAP>(SelectObject(offscreenDC, offscreenBitmap));
+		if (offscreenBitmap) {
+			GraphCache::Release(offscreenBitmap);
 		}
-
-		// Draw the graph into the offscreen DC
-		//
-		RECT targetRect;
-		targetRect.left = 0;
-		targetRect.top = 0;
-		targetRect.right = newSize.cx;
-		targetRect.bottom = newSize.cy;
-		DrawGraphOnDC(offscreenDC, &targetRect);
+		offscreenBitmap = newBitmap;
+		cacheKey = key;
 		updateBitmap = false;
 	}
+	if ( 0 == offscreenBitmap ) {
+		return;
+	}
 
-	// Paint the bitmap on the screen
+	// Paint the bitmap on the screen.  Other LUTviews may be showing the same bitmap, and a
+	//  bitmap can only be selected into one DC at a time, so we only hold it while we copy it.
 	//
+	SelectObject(offscreenDC, offscreenBitmap);
 	BOOL bRetVal;
 	bRetVal = BitBlt(hdc, innerRect.left, innerRect.top, newSize.cx, newSize.cy, offscreenDC, 0, 0, SRCCOPY);
+	SelectObject(offscreenDC, oldBitmap);
 	if (!bRetVal) {
 		DebugBreak();
 	}
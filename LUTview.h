@@ -3,16 +3,12 @@
 
 #pragma once
 #include "stdafx.h"
+#include "GraphCache.h"
+#include "GraphRaster.h"
 #include "LUT.h"
 
 #define LUTVIEW_CLASS_NAME (L"LUT Viewer")
 
-typedef enum tag_LUT_GRAPH_DISPLAY_STYLE {
-	LGDS_WHITE = 0,
-	LGDS_BLACK = 1,
-	LGDS_GRADIENT = 2
-} LUT_GRAPH_DISPLAY_STYLE;
-
 class LUTview {
 
 public:
@@ -32,7 +28,7 @@ public:
 	void SetGraphDisplayStyle(LUT_GRAPH_DISPLAY_STYLE style);
 	LUT_GRAPH_DISPLAY_STYLE GetGraphDisplayStyle(void);
 	void SetText(wstring newText);
-	void SetLUT(LUT * lutPointer);
+	void SetLUT(const LUThandle & newLUT);
 	void SetUpdateBitmap(void);
 	RECT * GetGraphRect(void);
 
@@ -50,11 +46,13 @@ private:
 	LUT_GRAPH_DISPLAY_STYLE		graphDisplayStyle;
 	bool						userCanChangeDisplayMode;
 	HWND						hwnd;
-	LUT *						pLUT;
+	LUThandle					lutHandle;				// Shared with the Profile or Monitor it came from
+	DWORD						textHash;				// Hash of displayText, for the GraphCache key
+	GRAPH_CACHE_KEY				cacheKey;				// Describes offscreenBitmap
 	RECT						outerRect;
 	RECT						innerRect;
 	HDC							offscreenDC;
-	HBITMAP						offscreenBitmap;
+	HBITMAP						offscreenBitmap;		// Acquired from the GraphCache
 	HBITMAP						oldBitmap;
 	bool						updateBitmap;
 	UINT						paintCount;
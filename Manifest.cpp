@@ -0,0 +1,365 @@
+// Manifest.cpp -- Apply profile associations from a manifest file, for setting up many machines at once
+//
+// A manifest is a text file (ANSI, UTF-8 or UTF-16) with one setting per line:
+//
+//   # Dell U2410s get the calibrated profile, and use the per-user setting
+//   MONITOR\DEL40A3\*      system = U2410 calibrated.icm
+//   MONITOR\DEL40A3\*      user = U2410 calibrated.icm
+//   MONITOR\DEL40A3\*      active = user
+//
+// The first field is a pattern for the monitor's DeviceID, with '*' and '?' wildcards and not
+//  case-sensitive.  Later lines win over earlier ones for the same monitor and setting.  Setting
+//  a profile associates it if needed and makes it the default, with one registry write per list,
+//  and once every monitor has been done we load all LUTs.  A dry run only reports what would
+//  change, as a diff.
+//
+
+#include "stdafx.h"
+#include "Manifest.h"
+#include "Monitor.h"
+#include "RegistryMultiStringStore.h"
+#include "Utility.h"
+#include <strsafe.h>
+//#include <banned.h>
+
+// Symbols defined in other files
+//
+extern int LoadAllLUTs(void);
+
+// What a line in the manifest sets
+//
+typedef enum tag_MANIFEST_SETTING {
+	MS_USER_PROFILE = 0,							// Default profile on the user list (Vista and higher)
+	MS_SYSTEM_PROFILE = 1,							// Default profile on the system list
+	MS_ACTIVE = 2									// Which list is active, "user" or "system" (Vista and higher)
+} MANIFEST_SETTING;
+
+typedef struct tag_MANIFEST_LINE {
+	DWORD				lineNumber;					// For error messages
+	wstring				pattern;					// DeviceID pattern
+	MANIFEST_SETTING	setting;
+	wstring				value;
+} MANIFEST_LINE;
+
+// Profile list edits are collected per registry key and written once every monitor has been
+//  done, so each key gets one read and one write however many changes land on it
+//
+typedef struct tag_ASSOCIATION_UPDATE {
+	Monitor *			monitor;
+	bool				userList;
+	Profile *			profile;
+} ASSOCIATION_UPDATE;
+
+typedef struct tag_ASSOCIATION_BATCH {
+	wstring							keyPath;		// From RegistryKeyPath()
+	MultiStringEdit					edit;
+	vector <ASSOCIATION_UPDATE>		updateList;
+} ASSOCIATION_BATCH;
+
+// Read the whole manifest file as Unicode text
+//
+static bool ReadManifestFile(const wchar_t * manifestPath, wstring & text, wstring & errorString) {
+	HANDLE hFile = CreateFile(manifestPath, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, 0, NULL);
+	if ( INVALID_HANDLE_VALUE == hFile ) {
+		errorString = ShowError(L"CreateFile", 0, L"Cannot open manifest\r\n");
+		return false;
+	}
+	LARGE_INTEGER fileSize;
+	if ( !GetFileSizeEx(hFile, &fileSize) || (fileSize.QuadPart > MANIFEST_MAXIMUM_FILE_SIZE) ) {
+		CloseHandle(hFile);
+		errorString = L"Manifest is too large\r\n";
+		return false;
+	}
+	DWORD size = fileSize.LowPart;
+	BYTE * data = new BYTE[size + sizeof(wchar_t)];
+	DWORD cb = 0;
+	BOOL bRet = ReadFile(hFile, data, size, &cb, NULL);
+	CloseHandle(hFile);
+	if ( !bRet || (cb != size) ) {
+		delete [] data;
+		errorString = ShowError(L"ReadFile", 0, L"Cannot read manifest\r\n");
+		return false;
+	}
+	data[size] = 0;
+	data[size + 1] = 0;
+
+	// UTF-16 if it has a byte order mark, else UTF-8 with a byte order mark, else ANSI
+	//
+	if ( (size >= 2) && (0xFF == data[0]) && (0xFE == data[1]) ) {
+		text.assign(reinterpret_cast<wchar_t *>(data + 2), (size - 2) / sizeof(wchar_t));
+	} else {
+		char * ansiText = reinterpret_cast<char *>(data);
+		DWORD codePage = CP_ACP;
+		if ( (size >= 3) && (0xEF == data[0]) && (0xBB == data[1]) && (0xBF == data[2]) ) {
+			ansiText += 3;
+			codePage = CP_UTF8;
+		}
+		wchar_t * unicodeText = 0;
+		if ( AnsiToUnicode(ansiText, unicodeText, codePage) ) {
+			text = unicodeText;
+			free(unicodeText);
+		}
+	}
+	delete [] data;
+	return true;
+}
+
+// Trim spaces and tabs from both ends of a string
+//
+static wstring Trim(const wstring & s) {
+	size_t first = s.find_first_not_of(L" \t");
+	if ( wstring::npos == first ) {
+		return wstring();
+	}
+	size_t last = s.find_last_not_of(L" \t");
+	return s.substr(first, last - first + 1);
+}
+
+// Split the manifest into settings, reporting lines we don't understand
+//
+static void ParseManifest(const wstring & text, vector <MANIFEST_LINE> & lineList, wstring & errorString) {
+	wchar_t buf[1024];
+	size_t start = 0;
+	DWORD lineNumber = 0;
+	while ( start < text.size() ) {
+		size_t end = text.find(L'\n', start);
+		if ( wstring::npos == end ) {
+			end = text.size();
+		}
+		wstring line = Trim(text.substr(start, end - start));
+		if ( !line.empty() && (L'\r' == line[line.size() - 1]) ) {
+			line = Trim(line.substr(0, line.size() - 1));
+		}
+		start = end + 1;
+		++lineNumber;
+		if ( line.empty() || (L'#' == line[0]) || (L';' == line[0]) ) {
+			continue;
+		}
+
+		// Pattern, then whitespace, then "setting = value"
+		//
+		size_t patternEnd = line.find_first_of(L" \t");
+		size_t equals = line.find(L'=');
+		if ( (wstring::npos == patternEnd) || (wstring::npos == equals) || (equals < patternEnd) ) {
+			StringCbPrintf(buf, sizeof(buf), L"Line %u: expected \"<DeviceID pattern> <setting> = <value>\"\r\n", lineNumber);
+			errorString += buf;
+			continue;
+		}
+		MANIFEST_LINE manifestLine;
+		manifestLine.lineNumber = lineNumber;
+		manifestLine.pattern = line.substr(0, patternEnd);
+		manifestLine.value = Trim(line.substr(equals + 1));
+		wstring settingName = Trim(line.substr(patternEnd, equals - patternEnd));
+		if ( 0 == _wcsicmp(settingName.c_str(), L"user") ) {
+			manifestLine.setting = MS_USER_PROFILE;
+		} else if ( 0 == _wcsicmp(settingName.c_str(), L"system") ) {
+			manifestLine.setting = MS_SYSTEM_PROFILE;
+		} else if ( 0 == _wcsicmp(settingName.c_str(), L"active") ) {
+			manifestLine.setting = MS_ACTIVE;
+			if ( (0 != _wcsicmp(manifestLine.value.c_str(), L"user")) && (0 != _wcsicmp(manifestLine.value.c_str(), L"system")) ) {
+				StringCbPrintf(buf, sizeof(buf), L"Line %u: \"active\" must be \"user\" or \"system\"\r\n", lineNumber);
+				errorString += buf;
+				continue;
+			}
+		} else {
+			StringCbPrintf(buf, sizeof(buf), L"Line %u: unknown setting \"%s\"\r\n", lineNumber, settingName.c_str());
+			errorString += buf;
+			continue;
+		}
+		if ( manifestLine.value.empty() ) {
+			StringCbPrintf(buf, sizeof(buf), L"Line %u: missing value\r\n", lineNumber);
+			errorString += buf;
+			continue;
+		}
+		lineList.push_back(manifestLine);
+	}
+}
+
+// Make a profile the default on one of a monitor's lists, if it isn't already; the registry
+//  edit is added to the batch for the list's key
+//
+static bool ApplyDefaultProfile(
+		Monitor * monitor,
+		bool userList,
+		const wstring & profileName,
+		bool dryRun,
+		vector <ASSOCIATION_BATCH> & batchList,
+		wstring & diff,
+		wstring & errorString
+) {
+	const wchar_t * listName = userList ? L"user" : L"system";
+	Profile * current = userList ? monitor->GetUserProfile() : monitor->GetSystemProfile();
+	if ( current && (0 == _wcsicmp(current->GetName().c_str(), profileName.c_str())) ) {
+		return true;
+	}
+	diff += L"  - ";
+	diff += listName;
+	diff += L" default: ";
+	diff += current ? current->GetName() : L"<none>";
+	diff += L"\r\n  + ";
+	diff += listName;
+	diff += L" default: ";
+	diff += profileName;
+	diff += L"\r\n";
+
+	// Don't associate a profile that we can't load, even on a dry run
+	//
+	Profile * profile = Profile::Add(new Profile(profileName.c_str()));
+	wstring loadError = profile->LoadFullProfile(false);
+	if ( profile->IsBadProfile() ) {
+		errorString += profileName;
+		errorString += L": cannot be loaded\r\n";
+		errorString += loadError;
+		return false;
+	}
+	if (dryRun) {
+		return true;
+	}
+	HKEY hKeyBase;
+	wstring registryKey;
+	monitor->GetProfileListKey(userList, hKeyBase, registryKey);
+	wstring keyPath = RegistryKeyPath(hKeyBase, registryKey.c_str());
+	ASSOCIATION_BATCH * batch = 0;
+	size_t batchCount = batchList.size();
+	for (size_t i = 0; i < batchCount; ++i) {
+		if ( 0 == _wcsicmp(keyPath.c_str(), batchList[i].keyPath.c_str()) ) {
+			batch = &batchList[i];
+			break;
+		}
+	}
+	if ( 0 == batch ) {
+		batchList.push_back(ASSOCIATION_BATCH());
+		batch = &batchList.back();
+		batch->keyPath = keyPath;
+	}
+	batch->edit.MoveToEnd(profileName.c_str());
+	ASSOCIATION_UPDATE update;
+	update.monitor = monitor;
+	update.userList = userList;
+	update.profile = profile;
+	batch->updateList.push_back(update);
+	return true;
+}
+
+// Write each batch of profile list edits to the registry, then bring our copies of the lists
+//  up to date
+//
+static bool ApplyAssociationBatches(const vector <ASSOCIATION_BATCH> & batchList, wstring & errorString) {
+	RegistryMultiStringStore store;
+	bool success = true;
+	size_t batchCount = batchList.size();
+	for (size_t i = 0; i < batchCount; ++i) {
+		const ASSOCIATION_BATCH & batch = batchList[i];
+		bool updated = store.Update(batch.keyPath, L"ICMProfile", batch.edit);
+		size_t updateCount = batch.updateList.size();
+		for (size_t j = 0; j < updateCount; ++j) {
+			const ASSOCIATION_UPDATE & update = batch.updateList[j];
+			if (updated) {
+				update.monitor->SetInternalDefaultProfile(update.userList, update.profile);
+			} else {
+				errorString += update.monitor->GetDeviceString();
+				errorString += L": cannot set ";
+				errorString += update.userList ? L"user" : L"system";
+				errorString += L" default to ";
+				errorString += update.profile->GetName();
+				errorString += L"\r\n";
+			}
+		}
+		if ( !updated ) {
+			success = false;
+		}
+	}
+	return success;
+}
+
+// Apply a manifest to all monitors and load their LUTs (or, for a dry run, just report)
+//
+int ApplyManifest(const wchar_t * manifestPath, bool dryRun) {
+	wstring text;
+	wstring errorString;
+	wstring report;
+	vector <MANIFEST_LINE> lineList;
+
+	if ( !ReadManifestFile(manifestPath, text, errorString) ) {
+		WriteToConsole(errorString);
+		return 1;
+	}
+	ParseManifest(text, lineList, errorString);
+
+	// Work out what each monitor should have, then change only what differs
+	//
+	bool success = errorString.empty();
+	bool changedAnything = false;
+	vector <ASSOCIATION_BATCH> batchList;
+	size_t lineCount = lineList.size();
+	size_t monitorCount = Monitor::GetListSize();
+	for (size_t i = 0; i < monitorCount; ++i) {
+		Monitor * monitor = Monitor::Get(i);
+		wstring deviceID = monitor->GetDeviceID();
+		const MANIFEST_LINE * userLine = 0;
+		const MANIFEST_LINE * systemLine = 0;
+		const MANIFEST_LINE * activeLine = 0;
+		for (size_t j = 0; j < lineCount; ++j) {
+			if ( WildcardMatch(lineList[j].pattern.c_str(), deviceID.c_str()) ) {
+				switch (lineList[j].setting) {
+					case MS_USER_PROFILE:
+						userLine = &lineList[j];
+						break;
+					case MS_SYSTEM_PROFILE:
+						systemLine = &lineList[j];
+						break;
+					case MS_ACTIVE:
+						activeLine = &lineList[j];
+						break;
+				}
+			}
+		}
+
+		wstring diff;
+		if ( systemLine && !ApplyDefaultProfile(monitor, false, systemLine->value, dryRun, batchList, diff, errorString) ) {
+			success = false;
+		}
+		if ( VistaOrHigher() ) {
+			if ( userLine && !ApplyDefaultProfile(monitor, true, userLine->value, dryRun, batchList, diff, errorString) ) {
+				success = false;
+			}
+			if ( activeLine ) {
+				bool wantUser = ( 0 == _wcsicmp(activeLine->value.c_str(), L"user") );
+				if ( wantUser != monitor->GetActiveProfileIsUserProfile() ) {
+					diff += wantUser ? L"  - active: system\r\n  + active: user\r\n" : L"  - active: user\r\n  + active: system\r\n";
+					if ( !dryRun && !monitor->SetActiveProfileIsUserProfile(wantUser) ) {
+						errorString += monitor->GetDeviceString();
+						errorString += L": cannot set the active profile list\r\n";
+						success = false;
+					}
+				}
+			}
+		} else if ( userLine || activeLine ) {
+			diff += L"  (user profile settings ignored; this version of Windows has only system profiles)\r\n";
+		}
+		if ( !diff.empty() ) {
+			changedAnything = true;
+			report += monitor->GetDeviceString();
+			report += L" [";
+			report += deviceID;
+			report += L"]\r\n";
+			report += diff;
+		}
+	}
+
+	if ( !changedAnything ) {
+		report += L"No changes\r\n";
+	}
+	if ( !dryRun ) {
+		if ( !ApplyAssociationBatches(batchList, errorString) ) {
+			success = false;
+		}
+		LoadAllLUTs();
+	}
+	if ( !errorString.empty() ) {
+		report += L"\r\nErrors:\r\n";
+		report += errorString;
+	}
+	WriteToConsole(report);
+	return success ? 0 : 1;
+}
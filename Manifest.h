@@ -0,0 +1,11 @@
+// Manifest.h -- Apply profile associations from a manifest file, for setting up many machines at once
+//
+
+#pragma once
+#include "stdafx.h"
+
+// Some constants
+//
+#define MANIFEST_MAXIMUM_FILE_SIZE	(1024 * 1024)	// A manifest is a short text file; refuse anything huge
+
+int ApplyManifest(const wchar_t * manifestPath, bool dryRun);
@@ -4,9 +4,12 @@
 #include "stdafx.h"
 #include <winreg.h>
 #include "Adapter.h"
+#include "Counters.h"
 #include "Monitor.h"
 #include "MonitorPage.h"
 #include "MonitorSummaryItem.h"
+#include "ProfileLoader.h"
+#include "Trace.h"
 #include "Utility.h"
 #include <strsafe.h>
 //#include <banned.h>
@@ -30,7 +33,6 @@ Monitor::Monitor(Adapter * hostAdapter, const DISPLAY_DEVICEW & displayMonitor)
 		adapter(hostAdapter),
 		monitorPage(0),
 		monitorSummaryItem(0),
-		pLUT(0),
 		UserProfile(0),
 		SystemProfile(0),
 		activeProfileIsUserProfile(false)
@@ -40,43 +42,52 @@ Monitor::Monitor(Adapter * hostAdapter, const DISPLAY_DEVICEW & displayMonitor)
 // Destructor
 //
 Monitor::~Monitor() {
-	if (pLUT) {
-		delete [] pLUT;
-	}
 }
 
 // Read the LUT from the adapter
 //
+// If the adapter's LUT has not changed, we keep the handle we already have, so anything
+//  sharing it (a LUTview, the GraphCache key) sees the same LUT and does no work.
+//
 bool Monitor::ReadLutFromCard(void) {
-	if (pLUT) {
-		delete [] pLUT;
-		pLUT = 0;
-	}
+	TRACE_SCOPE_DETAIL(L"ReadLutFromCard", DeviceString.c_str());
 	BOOL bRet = 0;
+	LUT cardLUT;
+	SecureZeroMemory(&cardLUT, sizeof(cardLUT));
 	HDC hDC = CreateDC(adapter->GetDeviceName().c_str(), 0, 0, 0);
 	if (hDC) {
-		pLUT = new LUT;
-		SecureZeroMemory(pLUT, sizeof(LUT));
-		bRet = GetDeviceGammaRamp(hDC, pLUT);
+		CountEvent(PC_DC_CREATIONS);
+		bRet = GetDeviceGammaRamp(hDC, &cardLUT);
+		CountEvent(PC_RAMP_READS);
 		DeleteDC(hDC);
+		if ( !lutHandle.Matches(cardLUT) ) {
+			lutHandle = LUThandle(cardLUT);
+		}
+	} else {
+		lutHandle.Reset();
 	}
 	return ( 0 != bRet );
 }
 
 // Write a LUT (from any source) to the adapter
 //
-bool Monitor::WriteLutToCard(LUT * lutToWriteToAdapter) const {
+bool Monitor::WriteLutToCard(const LUT * lutToWriteToAdapter) const {
+	TRACE_SCOPE_DETAIL(L"WriteLutToCard", DeviceString.c_str());
 	if (lutToWriteToAdapter) {
 		BOOL bRet = 0;
 		HDC hDC = CreateDC(adapter->GetDeviceName().c_str(), 0, 0, 0);
 		if (hDC) {
+			CountEvent(PC_DC_CREATIONS);
 
-			// Try doing it twice with slightly different ramps ...
+			// Try doing it twice with slightly different ramps ... the caller's LUT may be
+			//  shared through a LUThandle, so nudge a copy rather than the original
 			//
-			++lutToWriteToAdapter->red[0];
-			bRet = SetDeviceGammaRamp(hDC, lutToWriteToAdapter);
-			--lutToWriteToAdapter->red[0];
-			bRet = SetDeviceGammaRamp(hDC, lutToWriteToAdapter);
+			LUT writeLUT = *lutToWriteToAdapter;
+			++writeLUT.red[0];
+			bRet = SetDeviceGammaRamp(hDC, &writeLUT);
+			--writeLUT.red[0];
+			bRet = SetDeviceGammaRamp(hDC, &writeLUT);
+			CountEvent(PC_RAMP_WRITES, 2);
 			DeleteDC(hDC);
 		}
 		return ( 0 != bRet );
@@ -88,6 +99,7 @@ bool Monitor::WriteLutToCard(LUT * lutToWriteToAdapter) const {
 // Initialize
 //
 void Monitor::Initialize(void) {
+	TRACE_SCOPE_DETAIL(L"Monitor::Initialize", DeviceString.c_str());
 
 	ReadLutFromCard();
 
@@ -158,43 +170,60 @@ void Monitor::RemoveProfileFromInternalSystemList(Profile * profile) {
 }
 
 bool Monitor::SetDefaultUserProfile(Profile * profile) {
-	wchar_t registryKey[1024];
-	int len = StringLength(L"\\Registry\\Machine\\System\\CurrentControlSet\\Control\\Class");
-	StringCbCopy( registryKey, sizeof(registryKey),
-		L"Software\\Microsoft\\Windows NT\\CurrentVersion\\ICM\\ProfileAssociations\\Display");
-	StringCbCat(registryKey, sizeof(registryKey), &DeviceKey.c_str()[len]);
-	bool success = profile->EditRegistryProfileList(HKEY_CURRENT_USER, registryKey, true);
+	HKEY hKeyBase;
+	wstring registryKey;
+	GetProfileListKey(true, hKeyBase, registryKey);
+	bool success = profile->EditRegistryProfileList(hKeyBase, registryKey.c_str(), true);
 	if (success) {
-		ProfileList::iterator itEnd = UserProfileList.end();
-		for (ProfileList::iterator it = UserProfileList.begin(); it != itEnd; ++it) {
-			if ( *it == profile ) {
-				UserProfileList.erase(it);
-				break;
-			}
-		}
-		UserProfileList.push_back(profile);
-		UserProfile = profile;
+		SetInternalDefaultProfile(true, profile);
 	}
 	return success;
 }
 
 bool Monitor::SetDefaultSystemProfile(Profile * profile) {
-	wchar_t registryKey[1024];
-	int len = StringLength(L"\\Registry\\Machine\\");
-	StringCbCopy(registryKey, sizeof(registryKey), &DeviceKey.c_str()[len]);
-	bool success = profile->EditRegistryProfileList(HKEY_LOCAL_MACHINE, registryKey, true);
+	HKEY hKeyBase;
+	wstring registryKey;
+	GetProfileListKey(false, hKeyBase, registryKey);
+	bool success = profile->EditRegistryProfileList(hKeyBase, registryKey.c_str(), true);
 	if (success) {
-		ProfileList::iterator itEnd = SystemProfileList.end();
-		for (ProfileList::iterator it = SystemProfileList.begin(); it != itEnd; ++it) {
-			if ( *it == profile ) {
-				SystemProfileList.erase(it);
-				break;
-			}
+		SetInternalDefaultProfile(false, profile);
+	}
+	return success;
+}
+
+// Return the registry key holding the user or system profile list, for callers that edit
+//  several lists and want to batch the registry writes themselves
+//
+void Monitor::GetProfileListKey(bool userList, HKEY & hKeyBase, wstring & registryKey) const {
+	if (userList) {
+		int len = StringLength(L"\\Registry\\Machine\\System\\CurrentControlSet\\Control\\Class");
+		hKeyBase = HKEY_CURRENT_USER;
+		registryKey = L"Software\\Microsoft\\Windows NT\\CurrentVersion\\ICM\\ProfileAssociations\\Display";
+		registryKey += &DeviceKey.c_str()[len];
+	} else {
+		int len = StringLength(L"\\Registry\\Machine\\");
+		hKeyBase = HKEY_LOCAL_MACHINE;
+		registryKey = &DeviceKey.c_str()[len];
+	}
+}
+
+// Make a profile the default (last) entry on our copy of a list, once the registry has been updated
+//
+void Monitor::SetInternalDefaultProfile(bool userList, Profile * profile) {
+	ProfileList & profileList = userList ? UserProfileList : SystemProfileList;
+	ProfileList::iterator itEnd = profileList.end();
+	for (ProfileList::iterator it = profileList.begin(); it != itEnd; ++it) {
+		if ( *it == profile ) {
+			profileList.erase(it);
+			break;
 		}
-		SystemProfileList.push_back(profile);
+	}
+	profileList.push_back(profile);
+	if (userList) {
+		UserProfile = profile;
+	} else {
 		SystemProfile = profile;
 	}
-	return success;
 }
 
 bool Monitor::AddUserProfileAssociation(Profile * profile) {
@@ -295,6 +324,36 @@ void Monitor::ClearList(bool freeAllMemory) {
 	}
 }
 
+// Move all monitors to a caller's list without deleting them (used when rescanning)
+//
+void Monitor::DetachList(vector <Monitor *> & detachedList) {
+	detachedList.clear();
+	if (monitorList) {
+		detachedList.swap(*monitorList);
+	}
+}
+
+// Return 'true' if this is the monitor described by an EnumDisplayDevices() result
+//
+bool Monitor::Matches(const DISPLAY_DEVICEW & displayMonitor) const {
+	return (DeviceKey == displayMonitor.DeviceKey) && (DeviceID == displayMonitor.DeviceID);
+}
+
+// Update a monitor we found again on a rescan; its profile associations are keyed on DeviceKey,
+//  so they can't have changed, but the path to it and its LUT can.  Return 'true' if it changed.
+//
+bool Monitor::Refresh(Adapter * hostAdapter, const DISPLAY_DEVICEW & displayMonitor) {
+	bool changed = (hostAdapter != adapter) || (DeviceName != displayMonitor.DeviceName) || (StateFlags != displayMonitor.StateFlags);
+	if (changed) {
+		adapter = hostAdapter;
+		DeviceName = displayMonitor.DeviceName;
+		DeviceString = displayMonitor.DeviceString;
+		StateFlags = displayMonitor.StateFlags;
+		ReadLutFromCard();
+	}
+	return changed;
+}
+
 // Return 'true' if this monitor is active and part of the desktop
 //
 bool Monitor::IsActive(const DISPLAY_DEVICEW & displayMonitor) {
@@ -341,12 +400,20 @@ wstring Monitor::GetDeviceString(void) const {
 	return DeviceString;
 }
 
+wstring Monitor::GetDeviceID(void) const {
+	return DeviceID;
+}
+
 Adapter * Monitor::GetAdapter(void) const {
 	return adapter;
 }
 
-LUT * Monitor::GetLutPointer(void) const {
-	return pLUT;
+const LUT * Monitor::GetLutPointer(void) const {
+	return lutHandle.Get();
+}
+
+LUThandle Monitor::GetLutHandle(void) const {
+	return lutHandle;
 }
 
 size_t Monitor::GetListSize(void) {
@@ -363,9 +430,10 @@ Monitor * Monitor::Get(size_t index) {
 	return (*monitorList)[index];
 }
 
-// Return a summary string
+// Return a summary string; if the active profile isn't loaded yet, 'notifyWindow' gets
+//  WM_PROFILE_LOADED when it is, and can ask again
 //
-wstring Monitor::SummaryString(void) const {
+wstring Monitor::SummaryString(HWND notifyWindow) const {
 	wstring s;
 
 	// Build a display string for this monitor
@@ -406,12 +474,15 @@ wstring Monitor::SummaryString(void) const {
 	// See if the loaded LUT is correct
 	//
 	Profile * activeProfile = GetActiveProfile();
-	if (activeProfile) {
+	if ( activeProfile && !ProfileLoader::RequestLoad(activeProfile, notifyWindow) ) {
+		s += L"\r\nLoading ";
+		s += activeProfile->GetName();
+		s += L" to compare it with the current LUT ...\r\n";
+	} else if (activeProfile) {
 		s += L"\r\n";
-		activeProfile->LoadFullProfile(false);
 		DWORD maxError = 0;
 		DWORD totalError = 0;
-		LUT_COMPARISON result = activeProfile->CompareLUT(pLUT, &maxError, &totalError);
+		LUT_COMPARISON result = activeProfile->CompareLUT(lutHandle.Get(), &maxError, &totalError);
 		switch (result) {
 
 			// LUTs match word for word
@@ -469,19 +540,19 @@ wstring Monitor::SummaryString(void) const {
 	s += L"\r\nStart of gamma ramp (first 10 entries):\r\n\tRed \t= ";
 	for (int i = 0; i < COUNT_OF_GAMMA_VALUES_TO_SHOW; ++i) {
 		wchar_t buf[10];
-		StringCbPrintf(buf, sizeof(buf), L" %04X", pLUT->red[i]);
+		StringCbPrintf(buf, sizeof(buf), L" %04X", lutHandle.Get()->red[i]);
 		s += buf;
 	}
 	s += L" \r\n\tGreen\t= ";
 	for (int i = 0; i < COUNT_OF_GAMMA_VALUES_TO_SHOW; ++i) {
 		wchar_t buf[10];
-		StringCbPrintf(buf, sizeof(buf), L" %04X", pLUT->green[i]);
+		StringCbPrintf(buf, sizeof(buf), L" %04X", lutHandle.Get()->green[i]);
 		s += buf;
 	}
 	s += L"\r\n\tBlue\t= ";
 	for (int i = 0; i < COUNT_OF_GAMMA_VALUES_TO_SHOW; ++i) {
 		wchar_t buf[10];
-		StringCbPrintf(buf, sizeof(buf), L" %04X", pLUT->blue[i]);
+		StringCbPrintf(buf, sizeof(buf), L" %04X", lutHandle.Get()->blue[i]);
 		s += buf;
 	}
 	s += L"\r\n";
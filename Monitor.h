@@ -21,9 +21,15 @@ public:
 
 	static Monitor * Add(Monitor * monitor);
 	static void ClearList(bool freeAllMemory);
+	static void DetachList(vector <Monitor *> & detachedList);
+
+	bool Matches(const DISPLAY_DEVICEW & displayMonitor) const;
+	bool Refresh(Adapter * hostAdapter, const DISPLAY_DEVICEW & displayMonitor);
 
 	bool SetDefaultUserProfile(Profile * profile);
 	bool SetDefaultSystemProfile(Profile * profile);
+	void GetProfileListKey(bool userList, HKEY & hKeyBase, wstring & registryKey) const;
+	void SetInternalDefaultProfile(bool userList, Profile * profile);
 
 	bool AddUserProfileAssociation(Profile * profile);
 	bool AddSystemProfileAssociation(Profile * profile);
@@ -38,16 +44,18 @@ public:
 	MonitorPage * GetMonitorPage(void) const;
 	void SetMonitorSummaryItem(MonitorSummaryItem * itemPtr);
 	MonitorSummaryItem * GetMonitorSummaryItem(void) const;
-	wstring SummaryString(void) const;
+	wstring SummaryString(HWND notifyWindow) const;
 	bool GetActiveProfileIsUserProfile(void) const;
 	bool SetActiveProfileIsUserProfile(bool userActive);
 	Profile * GetActiveProfile(void) const;
 	ProfileList & GetProfileList(bool userProfiles);
 	wstring GetDeviceString(void) const;
+	wstring GetDeviceID(void) const;
 	Adapter * GetAdapter(void) const;
-	LUT * GetLutPointer(void) const;
+	const LUT * GetLutPointer(void) const;
+	LUThandle GetLutHandle(void) const;
 	bool ReadLutFromCard(void);
-	bool WriteLutToCard(LUT * lutToWriteToAdapter) const;
+	bool WriteLutToCard(const LUT * lutToWriteToAdapter) const;
 
 	static bool IsActive(const DISPLAY_DEVICEW & displayMonitor);
 	static size_t GetListSize(void);
@@ -67,7 +75,7 @@ private:
 	Adapter *				adapter;
 	MonitorPage *			monitorPage;
 	MonitorSummaryItem *	monitorSummaryItem;
-	LUT *					pLUT;
+	LUThandle				lutHandle;
 	Profile *				UserProfile;
 	ProfileList				UserProfileList;
 	Profile *				SystemProfile;
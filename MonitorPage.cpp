@@ -3,8 +3,11 @@
 
 #include "stdafx.h"
 #include <commctrl.h>
+#include <algorithm>
+#include "ColorDirectoryIndex.h"
 #include "Monitor.h"
 #include "MonitorPage.h"
+#include "ProfileLoader.h"
 #include "PropertySheet.h"
 #include "Resize.h"
 #include "TreeViewItem.h"
@@ -28,15 +31,10 @@
 
 #define SHELL32_FOLDER_ICON		5					// The icon we use for folders from shell32.dll
 
-// Global externs defined in this file
-//
-extern WNDPROC oldEditWindowProc = 0;				// The original Edit control's window procedure
-
 // Symbols defined in other files
 //
 extern HINSTANCE g_hInst;							// Instance handle
 extern double dpiScale;								// Scaling factor for dots per inch (actual versus standard 96 DPI)
-extern wchar_t * ColorDirectory;
 
 // Global static symbols internal to this file
 //
@@ -44,6 +42,17 @@ static HIMAGELIST hImageList = 0;
 static int imageWCSprofile = IMAGE_ICC_PROFILE;
 static int overlayImage= 0;;
 
+// Put the profiles on both of a monitor's lists into a set
+//
+static void GetMonitorProfileSet(Monitor * monitor, PROFILE_SET & monitorProfiles) {
+	if (VistaOrHigher()) {
+		ProfileList & userList = monitor->GetProfileList(true);
+		monitorProfiles.insert(userList.begin(), userList.end());
+	}
+	ProfileList & systemList = monitor->GetProfileList(false);
+	monitorProfiles.insert(systemList.begin(), systemList.end());
+}
+
 // Constructor
 //
 MonitorPage::MonitorPage(Monitor * hostMonitor) :
@@ -60,7 +69,7 @@ MonitorPage::MonitorPage(Monitor * hostMonitor) :
 		requestedUserProfilesExpansion(false),
 		requestedSystemProfilesExpansion(false),
 		requestedOtherProfilesExpansion(false),
-		resetting(false)
+		otherProfilesPopulated(false)
 {
 }
 
@@ -74,6 +83,12 @@ void MonitorPage::SetEditControlText(wstring newText) {
 	SetDlgItemText(hwnd, IDC_MONITOR_TEXT, newText.c_str());
 }
 
+// Show a document in the details pane, leaving 'document' empty
+//
+void MonitorPage::SetDetailsDocument(DetailsDocument & document) {
+	SendDlgItemMessage(hwnd, IDC_MONITOR_TEXT, DVM_SETDOCUMENT, 0, reinterpret_cast<LPARAM>(&document));
+}
+
 HWND MonitorPage::GetHwnd(void) const {
 	return hwnd;
 }
@@ -180,108 +195,98 @@ void MonitorPage::ClearTreeViewItemList(bool freeAllMemory) {
 	}
 }
 
-// A Reset() call tells us that our UI should be reset to starting condition,
-// assuming that we have had our WM_INITDIALOG call and so have something to reset
+// ProfileLoader has finished loading a profile we asked for: give it its real icon and LUT
+//  overlay in the TreeView, and replace the placeholder text if it is the selected item.  The
+//  "other" subtree was filled from file headers alone, so a profile there that turns out to be
+//  bad is removed, as it would never have been listed if we had parsed it first.
 //
-void MonitorPage::Reset(void) {
-	if (hwnd) {
-		HTREEITEM hTvItem;
-		TVITEMEX itemEx;
-		TREEVIEW_ITEM_TYPE oldItemType = TREEVIEW_ITEM_TYPE_NONE;
-		Profile * oldProfilePtr = 0;
-		bool userProfilesExpanded = false;
-
-		HTREEITEM hSelection = reinterpret_cast<HTREEITEM>(
-				SendMessage( hwndTreeView, TVM_GETNEXTITEM, TVGN_CARET, 0 ) );
-
-		SecureZeroMemory(&itemEx, sizeof(itemEx));
-		itemEx.mask = TVIF_HANDLE | TVIF_PARAM;
-		itemEx.hItem = hSelection;
-		SendMessage(hwndTreeView, TVM_GETITEM, 0, reinterpret_cast<LPARAM>(&itemEx));
-
-		TreeViewItem * oldSelection = reinterpret_cast<TreeViewItem *>(itemEx.lParam);
-		if (oldSelection) {
-			oldItemType = oldSelection->GetItemType();
-			oldProfilePtr = oldSelection->GetProfilePtr();
+void MonitorPage::ProfileLoaded(Profile * profile) {
+	if ( 0 == hwndTreeView ) {
+		return;
+	}
+	TVITEMEX itemEx;
+	HTREEITEM subTrees[3] = { tvUserProfiles, tvSystemProfiles, tvOtherProfiles };
+	for (size_t i = 0; i < _countof(subTrees); ++i) {
+		if (subTrees[i]) {
+			HTREEITEM hItem = TreeViewItem::Get_HTREEITEM_ForProfile(hwndTreeView, subTrees[i], profile);
+			if ( hItem && (tvOtherProfiles == subTrees[i]) && profile->IsBadProfile() ) {
+				SecureZeroMemory(&itemEx, sizeof(itemEx));
+				itemEx.hItem = hItem;
+				itemEx.mask = TVIF_PARAM;
+				SendMessage(hwndTreeView, TVM_GETITEM, 0, reinterpret_cast<LPARAM>(&itemEx));
+				DeleteTreeViewItem(hItem, reinterpret_cast<TreeViewItem *>(itemEx.lParam));
+			} else if (hItem) {
+				SecureZeroMemory(&itemEx, sizeof(itemEx));
+				itemEx.hItem = hItem;
+				itemEx.mask = TVIF_STATE | TVIF_IMAGE | TVIF_SELECTEDIMAGE;
+				itemEx.iImage = profile->HasEmbeddedWcsProfile() ? imageWCSprofile : IMAGE_ICC_PROFILE;
+				itemEx.iSelectedImage = itemEx.iImage;
+				itemEx.state = profile->GetLutPointer() ? INDEXTOOVERLAYMASK(1) : 0;
+				itemEx.stateMask = TVIS_OVERLAYMASK;
+				SendMessage(hwndTreeView, TVM_SETITEM, 0, reinterpret_cast<LPARAM>(&itemEx));
+			}
 		}
+	}
 
-		itemEx.mask = TVIF_HANDLE | TVIF_STATE;
-		itemEx.stateMask = TVIS_EXPANDED;
-		itemEx.hItem = tvRoot;
+	SecureZeroMemory(&itemEx, sizeof(itemEx));
+	itemEx.hItem = reinterpret_cast<HTREEITEM>(SendMessage(hwndTreeView, TVM_GETNEXTITEM, TVGN_CARET, 0));
+	if (itemEx.hItem) {
+		itemEx.mask = TVIF_PARAM;
 		SendMessage(hwndTreeView, TVM_GETITEM, 0, reinterpret_cast<LPARAM>(&itemEx));
-		bool rootExpanded = (0 != (itemEx.state & TVIS_EXPANDED));
-
-		if (tvUserProfiles) {
-			itemEx.hItem = tvUserProfiles;
-			SendMessage(hwndTreeView, TVM_GETITEM, 0, reinterpret_cast<LPARAM>(&itemEx));
-			userProfilesExpanded = (0 != (itemEx.state & TVIS_EXPANDED));
+		TreeViewItem * tvItem = reinterpret_cast<TreeViewItem *>(itemEx.lParam);
+		bool summaryWaiting = (itemEx.hItem == tvRoot) && (monitor->GetActiveProfile() == profile);
+		if ( tvItem && ((tvItem->GetProfilePtr() == profile) || summaryWaiting) ) {
+			tvItem->Handle_TVN_SELCHANGEDW(this, 0);
 		}
+	}
+}
+
+// A Reset() call tells us that the monitor's profile lists may have changed.  Rather than rebuild
+//  the TreeView, we compare it with the lists and insert, delete or update only the items that
+//  differ, so the selection, expansion and scroll position stay where they were.  This assumes that
+//  we have had our WM_INITDIALOG call and so have something to reset.
+//
+void MonitorPage::Reset(void) {
+	if ( 0 == hwnd ) {
+		return;
+	}
+	TVITEMEX itemEx;
+	wchar_t buf[1024];
 
+	// The monitor's name, and which of the user and system lists is in charge
+	//
+	SecureZeroMemory(&itemEx, sizeof(itemEx));
+	StringCbCopy(buf, sizeof(buf), monitor->GetDeviceString().c_str());
+	itemEx.mask = TVIF_TEXT;
+	itemEx.hItem = tvRoot;
+	itemEx.pszText = buf;
+	SendMessage(hwndTreeView, TVM_SETITEM, 0, reinterpret_cast<LPARAM>(&itemEx));
+	if (tvUserProfiles) {
+		bool hiliteUser = monitor->GetActiveProfileIsUserProfile();
+		itemEx.mask = TVIF_STATE;
+		itemEx.stateMask = TVIS_BOLD;
+		itemEx.hItem = tvUserProfiles;
+		itemEx.state = hiliteUser ? TVIS_BOLD : 0;
+		SendMessage(hwndTreeView, TVM_SETITEM, 0, reinterpret_cast<LPARAM>(&itemEx));
 		itemEx.hItem = tvSystemProfiles;
-		SendMessage(hwndTreeView, TVM_GETITEM, 0, reinterpret_cast<LPARAM>(&itemEx));
-		bool systemProfilesExpanded = (0 != (itemEx.state & TVIS_EXPANDED));
+		itemEx.state = hiliteUser ? 0 : TVIS_BOLD;
+		SendMessage(hwndTreeView, TVM_SETITEM, 0, reinterpret_cast<LPARAM>(&itemEx));
+		RefreshProfileSubtree(tvUserProfiles, true);
+	}
+	RefreshProfileSubtree(tvSystemProfiles, false);
+	RefreshOtherProfiles();
 
-		itemEx.hItem = tvOtherProfiles;
+	// The selected item's details may describe what just changed, so show them again
+	//
+	SecureZeroMemory(&itemEx, sizeof(itemEx));
+	itemEx.hItem = reinterpret_cast<HTREEITEM>(SendMessage(hwndTreeView, TVM_GETNEXTITEM, TVGN_CARET, 0));
+	if (itemEx.hItem) {
+		itemEx.mask = TVIF_PARAM;
 		SendMessage(hwndTreeView, TVM_GETITEM, 0, reinterpret_cast<LPARAM>(&itemEx));
-		bool otherProfilesExpanded = (0 != (itemEx.state & TVIS_EXPANDED));
-
-		resetting = true;
-		SendMessage(hwndTreeView, TVM_DELETEITEM, 0, reinterpret_cast<LPARAM>(TVI_ROOT));
-		ClearTreeViewItemList(false);
-
-		BuildTreeView();
-
-		if (rootExpanded) {
-			SendMessage(hwndTreeView, TVM_EXPAND, TVE_EXPAND, reinterpret_cast<LPARAM>(tvRoot));
-		}
-		if (userProfilesExpanded) {
-			SendMessage(hwndTreeView, TVM_EXPAND, TVE_EXPAND, reinterpret_cast<LPARAM>(tvUserProfiles));
+		TreeViewItem * tvItem = reinterpret_cast<TreeViewItem *>(itemEx.lParam);
+		if (tvItem) {
+			tvItem->Handle_TVN_SELCHANGEDW(this, 0);
 		}
-		if (systemProfilesExpanded) {
-			SendMessage(hwndTreeView, TVM_EXPAND, TVE_EXPAND, reinterpret_cast<LPARAM>(tvSystemProfiles));
-		}
-		if (otherProfilesExpanded) {
-			SendMessage(hwndTreeView, TVM_EXPAND, TVE_EXPAND, reinterpret_cast<LPARAM>(tvOtherProfiles));
-		}
-
-		switch (oldItemType) {
-			case TREEVIEW_ITEM_TYPE_MONITOR:
-				SendMessage(hwndTreeView, TVM_SELECTITEM, TVGN_CARET, reinterpret_cast<LPARAM>(tvRoot));
-				break;
-
-			case TREEVIEW_ITEM_TYPE_USER_PROFILES:
-				SendMessage(hwndTreeView, TVM_SELECTITEM, TVGN_CARET, reinterpret_cast<LPARAM>(tvUserProfiles));
-				break;
-
-			case TREEVIEW_ITEM_TYPE_SYSTEM_PROFILES:
-				SendMessage(hwndTreeView, TVM_SELECTITEM, TVGN_CARET, reinterpret_cast<LPARAM>(tvSystemProfiles));
-				break;
-
-			case TREEVIEW_ITEM_TYPE_PROFILES:
-				SendMessage(hwndTreeView, TVM_SELECTITEM, TVGN_CARET, reinterpret_cast<LPARAM>(tvSystemProfiles));
-				break;
-
-			case TREEVIEW_ITEM_TYPE_OTHER_PROFILES:
-				SendMessage(hwndTreeView, TVM_SELECTITEM, TVGN_CARET, reinterpret_cast<LPARAM>(tvOtherProfiles));
-				break;
-
-			case TREEVIEW_ITEM_TYPE_USER_PROFILE:
-				hTvItem = TreeViewItem::Get_HTREEITEM_ForProfile( hwndTreeView, tvUserProfiles, oldProfilePtr );
-				SendMessage( hwndTreeView, TVM_SELECTITEM, TVGN_CARET, reinterpret_cast<LPARAM>(hTvItem ? hTvItem : tvUserProfiles) );
-				break;
-
-			case TREEVIEW_ITEM_TYPE_SYSTEM_PROFILE:
-				hTvItem = TreeViewItem::Get_HTREEITEM_ForProfile( hwndTreeView, tvSystemProfiles, oldProfilePtr );
-				SendMessage( hwndTreeView, TVM_SELECTITEM, TVGN_CARET, reinterpret_cast<LPARAM>(hTvItem ? hTvItem : tvSystemProfiles) );
-				break;
-
-			case TREEVIEW_ITEM_TYPE_OTHER_PROFILE:
-				hTvItem = TreeViewItem::Get_HTREEITEM_ForProfile( hwndTreeView, tvOtherProfiles, oldProfilePtr );
-				SendMessage( hwndTreeView, TVM_SELECTITEM, TVGN_CARET, reinterpret_cast<LPARAM>(hTvItem ? hTvItem : tvOtherProfiles) );
-				break;
-
-		}
-		resetting = false;
 	}
 }
 
@@ -428,8 +433,6 @@ void CreateImageList(void) {
 //
 void MonitorPage::BuildTreeView(void) {
 
-	ProfileList profileList;
-	HTREEITEM tvItem;
 	size_t count;
 	wchar_t buf[1024];
 	TreeViewItem * tiObject = 0;
@@ -487,39 +490,11 @@ void MonitorPage::BuildTreeView(void) {
 		tvInsertStruct.itemex.lParam = reinterpret_cast<LPARAM>(tiObject);
 		tvUserProfiles = reinterpret_cast<HTREEITEM>( SendMessage(hwndTreeView, TVM_INSERTITEM, 0, reinterpret_cast<LPARAM>(&tvInsertStruct)) );
 		tiObject->SetHTREEITEM(tvUserProfiles);
-		tvInsertStruct.hParent = tvUserProfiles;
 
-		profileList = monitor->GetProfileList(true);
-		count = profileList.size();
+		ProfileList & userList = monitor->GetProfileList(true);
+		count = userList.size();
 		for (size_t i = 0; i < count; ++i) {
-			profileList[i]->LoadFullProfile(false);
- 			if (profileList[i]->HasEmbeddedWcsProfile()) {
-				tvInsertStruct.itemex.iImage = imageWCSprofile;
-			} else {
-				tvInsertStruct.itemex.iImage = IMAGE_ICC_PROFILE;
-			}
-			if (profileList[i]->GetLutPointer()) {
-				tvInsertStruct.itemex.mask = TVIF_TEXT | TVIF_PARAM | TVIF_STATE | TVIF_IMAGE | TVIF_SELECTEDIMAGE;
-				tvInsertStruct.itemex.state = INDEXTOOVERLAYMASK(1);
-				tvInsertStruct.itemex.stateMask = TVIS_OVERLAYMASK;
-			} else {
-				tvInsertStruct.itemex.mask = TVIF_TEXT | TVIF_PARAM | TVIF_IMAGE | TVIF_SELECTEDIMAGE;
-				tvInsertStruct.itemex.state = 0;
-				tvInsertStruct.itemex.stateMask = 0;
-			}
-			tvInsertStruct.itemex.iSelectedImage = tvInsertStruct.itemex.iImage;
-			if ( profileList[i] == monitor->GetUserProfile() ) {
-				tvInsertStruct.itemex.mask = TVIF_TEXT | TVIF_PARAM | TVIF_STATE | TVIF_IMAGE | TVIF_SELECTEDIMAGE;
-				tvInsertStruct.itemex.state |= TVIS_BOLD;
-				tvInsertStruct.itemex.stateMask |= TVIS_BOLD;
-			}
-			StringCbCopy(buf, sizeof(buf), profileList[i]->GetName().c_str());
-			tvInsertStruct.itemex.pszText = buf;
-			tiObject = AddTreeViewItem(new TreeViewItem(TREEVIEW_ITEM_TYPE_USER_PROFILE));
-			tvInsertStruct.itemex.lParam = reinterpret_cast<LPARAM>(tiObject);
-			tvItem = reinterpret_cast<HTREEITEM>( SendMessage(hwndTreeView, TVM_INSERTITEM, 0, reinterpret_cast<LPARAM>(&tvInsertStruct)) );
-			tiObject->SetHTREEITEM(tvItem);
-			tiObject->SetProfile(profileList[i]);
+			InsertProfileItem(tvUserProfiles, userList[i], true);
 		}
 		SendMessage(hwndTreeView, TVM_SORTCHILDREN, FALSE, reinterpret_cast<LPARAM>(tvUserProfiles));
 
@@ -554,179 +529,284 @@ void MonitorPage::BuildTreeView(void) {
 	tvInsertStruct.itemex.lParam = reinterpret_cast<LPARAM>(tiObject);
 	tvSystemProfiles = reinterpret_cast<HTREEITEM>( SendMessage(hwndTreeView, TVM_INSERTITEM, 0, reinterpret_cast<LPARAM>(&tvInsertStruct)) );
 	tiObject->SetHTREEITEM(tvSystemProfiles);
-	tvInsertStruct.hParent = tvSystemProfiles;
 
-	profileList = monitor->GetProfileList(false);
-	count = profileList.size();
+	ProfileList & systemList = monitor->GetProfileList(false);
+	count = systemList.size();
 	for (size_t i = 0; i < count; ++i) {
-		profileList[i]->LoadFullProfile(false);
-		if (profileList[i]->HasEmbeddedWcsProfile()) {
-			tvInsertStruct.itemex.iImage = imageWCSprofile;
-		} else {
-			tvInsertStruct.itemex.iImage = IMAGE_ICC_PROFILE;
-		}
-		if (profileList[i]->GetLutPointer()) {
-			tvInsertStruct.itemex.mask = TVIF_TEXT | TVIF_PARAM | TVIF_STATE | TVIF_IMAGE | TVIF_SELECTEDIMAGE;
-			tvInsertStruct.itemex.state = INDEXTOOVERLAYMASK(1);
-			tvInsertStruct.itemex.stateMask = TVIS_OVERLAYMASK;
-		} else {
-			tvInsertStruct.itemex.mask = TVIF_TEXT | TVIF_PARAM | TVIF_IMAGE | TVIF_SELECTEDIMAGE;
-			tvInsertStruct.itemex.state = 0;
-			tvInsertStruct.itemex.stateMask = 0;
-		}
-		tvInsertStruct.itemex.iSelectedImage = tvInsertStruct.itemex.iImage;
-		if ( profileList[i] == monitor->GetSystemProfile() ) {
-			tvInsertStruct.itemex.mask = TVIF_TEXT | TVIF_PARAM | TVIF_STATE | TVIF_IMAGE | TVIF_SELECTEDIMAGE;
-			tvInsertStruct.itemex.state |= TVIS_BOLD;
-			tvInsertStruct.itemex.stateMask |= TVIS_BOLD;
-		}
-		StringCbCopy(buf, sizeof(buf), profileList[i]->GetName().c_str());
-		tvInsertStruct.itemex.pszText = buf;
-		tiObject = AddTreeViewItem(new TreeViewItem(TREEVIEW_ITEM_TYPE_SYSTEM_PROFILE));
-		tvInsertStruct.itemex.lParam = reinterpret_cast<LPARAM>(tiObject);
-		tvItem = reinterpret_cast<HTREEITEM>( SendMessage(hwndTreeView, TVM_INSERTITEM, 0, reinterpret_cast<LPARAM>(&tvInsertStruct)) );
-		tiObject->SetHTREEITEM(tvItem);
-		tiObject->SetProfile(profileList[i]);
+		InsertProfileItem(tvSystemProfiles, systemList[i], false);
 	}
 	SendMessage(hwndTreeView, TVM_SORTCHILDREN, FALSE, reinterpret_cast<LPARAM>(tvSystemProfiles));
 
-	// Add other display profiles -- everything in the color directory that is a display profile
-	// and isn't already on one of the lists
+	// Add a node for other display profiles -- everything in the color directory that is a display
+	// profile and isn't already on one of the lists.  PopulateOtherProfiles() fills it in when it is
+	// first expanded, so until then we tell the TreeView it has children without inserting any.
 	//
 	tvInsertStruct.hParent = tvRoot;
 	tvInsertStruct.hInsertAfter = TVI_LAST;
-	tvInsertStruct.itemex.mask = TVIF_TEXT | TVIF_PARAM | TVIF_IMAGE | TVIF_SELECTEDIMAGE;
+	tvInsertStruct.itemex.mask = TVIF_TEXT | TVIF_PARAM | TVIF_IMAGE | TVIF_SELECTEDIMAGE | TVIF_CHILDREN;
 	tvInsertStruct.itemex.state = 0;
 	tvInsertStruct.itemex.stateMask = 0;
 	tvInsertStruct.itemex.iImage = IMAGE_PROFILES;
 	tvInsertStruct.itemex.iSelectedImage = IMAGE_PROFILES;
+	tvInsertStruct.itemex.cChildren = I_CHILDRENCALLBACK;
 	tvInsertStruct.itemex.pszText = L"Other installed display profiles";
 	tiObject = AddTreeViewItem(new TreeViewItem(TREEVIEW_ITEM_TYPE_OTHER_PROFILES));
 	tvInsertStruct.itemex.lParam = reinterpret_cast<LPARAM>(tiObject);
 	tvOtherProfiles = reinterpret_cast<HTREEITEM>( SendMessage(hwndTreeView, TVM_INSERTITEM, 0, reinterpret_cast<LPARAM>(&tvInsertStruct)) );
 	tiObject->SetHTREEITEM(tvOtherProfiles);
-	tvInsertStruct.hParent = tvOtherProfiles;
+	otherProfilesPopulated = false;
 
-	if (ColorDirectory) {
-		wchar_t filepath[1024];
-		StringCbCopy(filepath, sizeof(filepath), ColorDirectory);
-		StringCbCat(filepath, sizeof(filepath), L"\\*");
-		WIN32_FIND_DATA findData;
-		SecureZeroMemory(&findData, sizeof(findData));
-		bool keepGoing = true;
-		Profile * profile = 0;
-		HANDLE findHandle = FindFirstFile(filepath, &findData);
-		if (INVALID_HANDLE_VALUE != findHandle) {
-			while (keepGoing) {
-#define SKIP_BITS (FILE_ATTRIBUTE_DIRECTORY | FILE_ATTRIBUTE_DEVICE | FILE_ATTRIBUTE_REPARSE_POINT | FILE_ATTRIBUTE_OFFLINE | FILE_ATTRIBUTE_VIRTUAL)
-				if ( 0 == (SKIP_BITS & findData.dwFileAttributes) ) {
-					profile = Profile::Add(new Profile(findData.cFileName));
-
-					// Filter out profiles that are on another list already
-					//
-					bool foundIt = false;
-					if (VistaOrHigher()) {
-						profileList = monitor->GetProfileList(true);
-						count = profileList.size();
-						for (size_t i = 0; i < count; ++i) {
-							if (profile == profileList[i]) {
-								foundIt = true;
-								break;
-							}
-						}
-					}
-					if ( false == foundIt ) {
-						profileList = monitor->GetProfileList(false);
-						count = profileList.size();
-						for (size_t i = 0; i < count; ++i) {
-							if (profile == profileList[i]) {
-								foundIt = true;
-								break;
-							}
-						}
-					}
+	if (requestedRootExpansion) {
+		SendMessage(hwndTreeView, TVM_EXPAND, TVE_EXPAND, reinterpret_cast<LPARAM>(tvRoot));
+	}
+	if (requestedUserProfilesExpansion) {
+		SendMessage(hwndTreeView, TVM_EXPAND, TVE_EXPAND, reinterpret_cast<LPARAM>(tvUserProfiles));
+	}
+	if (requestedSystemProfilesExpansion) {
+		SendMessage(hwndTreeView, TVM_EXPAND, TVE_EXPAND, reinterpret_cast<LPARAM>(tvSystemProfiles));
+	}
+	if (requestedOtherProfilesExpansion) {
+		PopulateOtherProfiles();
+		SendMessage(hwndTreeView, TVM_EXPAND, TVE_EXPAND, reinterpret_cast<LPARAM>(tvOtherProfiles));
+	}
+}
 
-					// It's not already on a list for this monitor, so if its a valid display profile,
-					// add it to the "other" list
-					//
-					if ( false == foundIt ) {
-						profile->LoadFullProfile(false);
-						if ( (false == profile->IsBadProfile()) && (CLASS_MONITOR == profile->GetProfileClass()) ) {
-							if (profile->HasEmbeddedWcsProfile()) {
-								tvInsertStruct.itemex.iImage = imageWCSprofile;
-							} else {
-								tvInsertStruct.itemex.iImage = IMAGE_ICC_PROFILE;
-							}
-							if (profile->GetLutPointer()) {
-								tvInsertStruct.itemex.mask = TVIF_TEXT | TVIF_PARAM | TVIF_STATE | TVIF_IMAGE | TVIF_SELECTEDIMAGE;
-								tvInsertStruct.itemex.state = INDEXTOOVERLAYMASK(1);
-								tvInsertStruct.itemex.stateMask = TVIS_OVERLAYMASK;
-							} else {
-								tvInsertStruct.itemex.mask = TVIF_TEXT | TVIF_PARAM | TVIF_IMAGE | TVIF_SELECTEDIMAGE;
-								tvInsertStruct.itemex.state = 0;
-								tvInsertStruct.itemex.stateMask = 0;
-							}
-							tvInsertStruct.itemex.iSelectedImage = tvInsertStruct.itemex.iImage;
-							StringCbCopy(buf, sizeof(buf), profile->GetName().c_str());
-							tvInsertStruct.itemex.pszText = buf;
-							tiObject = AddTreeViewItem(new TreeViewItem(TREEVIEW_ITEM_TYPE_OTHER_PROFILE));
-							tvInsertStruct.itemex.lParam = reinterpret_cast<LPARAM>(tiObject);
-							tvItem = reinterpret_cast<HTREEITEM>( SendMessage(hwndTreeView, TVM_INSERTITEM, 0, reinterpret_cast<LPARAM>(&tvInsertStruct)) );
-							tiObject->SetHTREEITEM(tvItem);
-							tiObject->SetProfile(profile);
-						}
-					}
-				}
-				keepGoing = (0 != FindNextFile(findHandle, &findData));
-			}
-			FindClose(findHandle);
-		}
-		SendMessage(hwndTreeView, TVM_SORTCHILDREN, FALSE, reinterpret_cast<LPARAM>(tvOtherProfiles));
+// Fill in the "other" subtree from the shared color directory index.  The index is already sorted
+//  by name, and the items get their text through TVN_GETDISPINFO, so we neither sort nor copy names.
+//
+void MonitorPage::PopulateOtherProfiles(void) {
+	if (otherProfilesPopulated) {
+		return;
 	}
+	otherProfilesPopulated = true;
 
-	if ( !resetting ) {
-		if (requestedRootExpansion) {
-			SendMessage(hwndTreeView, TVM_EXPAND, TVE_EXPAND, reinterpret_cast<LPARAM>(tvRoot));
-		}
-		if (requestedUserProfilesExpansion) {
-			SendMessage(hwndTreeView, TVM_EXPAND, TVE_EXPAND, reinterpret_cast<LPARAM>(tvUserProfiles));
-		}
-		if (requestedSystemProfilesExpansion) {
-			SendMessage(hwndTreeView, TVM_EXPAND, TVE_EXPAND, reinterpret_cast<LPARAM>(tvSystemProfiles));
+	PROFILE_SET monitorProfiles;
+	GetMonitorProfileSet(monitor, monitorProfiles);
+	const vector <COLOR_DIRECTORY_ENTRY> & displayProfiles = ColorDirectoryIndex::GetDisplayProfiles();
+	size_t count = displayProfiles.size();
+	for (size_t i = 0; i < count; ++i) {
+		if ( monitorProfiles.end() == monitorProfiles.find(displayProfiles[i].profile) ) {
+			InsertOtherProfileItem(displayProfiles[i], TVI_LAST);
 		}
-		if (requestedOtherProfilesExpansion) {
-			SendMessage(hwndTreeView, TVM_EXPAND, TVE_EXPAND, reinterpret_cast<LPARAM>(tvOtherProfiles));
+	}
+}
+
+// Insert an item for a profile on the "other" subtree, using what the index knows about it until
+//  ProfileLoader has parsed it; a profile already known to be bad is left out
+//
+void MonitorPage::InsertOtherProfileItem(const COLOR_DIRECTORY_ENTRY & entry, HTREEITEM insertAfter) {
+	bool profileReady = ProfileLoader::RequestLoad(entry.profile, hwnd);
+	if ( profileReady && entry.profile->IsBadProfile() ) {
+		return;
+	}
+	TVINSERTSTRUCT tvInsertStruct;
+	SecureZeroMemory(&tvInsertStruct, sizeof(tvInsertStruct));
+	tvInsertStruct.hParent = tvOtherProfiles;
+	tvInsertStruct.hInsertAfter = insertAfter;
+	tvInsertStruct.itemex.mask = TVIF_TEXT | TVIF_PARAM | TVIF_STATE | TVIF_IMAGE | TVIF_SELECTEDIMAGE;
+	tvInsertStruct.itemex.pszText = LPSTR_TEXTCALLBACK;
+	tvInsertStruct.itemex.iImage = entry.hasWCS ? imageWCSprofile : IMAGE_ICC_PROFILE;
+	tvInsertStruct.itemex.iSelectedImage = tvInsertStruct.itemex.iImage;
+	if (profileReady) {
+		tvInsertStruct.itemex.state = entry.profile->GetLutPointer() ? INDEXTOOVERLAYMASK(1) : 0;
+	} else {
+		tvInsertStruct.itemex.state = entry.hasVCGT ? INDEXTOOVERLAYMASK(1) : 0;
+	}
+	tvInsertStruct.itemex.stateMask = TVIS_OVERLAYMASK;
+	TreeViewItem * tiObject = AddTreeViewItem(new TreeViewItem(TREEVIEW_ITEM_TYPE_OTHER_PROFILE));
+	tvInsertStruct.itemex.lParam = reinterpret_cast<LPARAM>(tiObject);
+	HTREEITEM tvItem = reinterpret_cast<HTREEITEM>( SendMessage(hwndTreeView, TVM_INSERTITEM, 0, reinterpret_cast<LPARAM>(&tvInsertStruct)) );
+	tiObject->SetHTREEITEM(tvItem);
+	tiObject->SetProfile(entry.profile);
+}
+
+// Insert an item for a profile on the user or system subtree (the caller sorts the subtree)
+//
+void MonitorPage::InsertProfileItem(HTREEITEM subTree, Profile * profile, bool userProfile) {
+	wchar_t buf[1024];
+	TVINSERTSTRUCT tvInsertStruct;
+	SecureZeroMemory(&tvInsertStruct, sizeof(tvInsertStruct));
+	tvInsertStruct.hParent = subTree;
+	tvInsertStruct.hInsertAfter = TVI_LAST;
+	tvInsertStruct.itemex.mask = TVIF_TEXT | TVIF_PARAM;
+	SetProfileItemAppearance(tvInsertStruct.itemex, profile, userProfile);
+	StringCbCopy(buf, sizeof(buf), profile->GetName().c_str());
+	tvInsertStruct.itemex.pszText = buf;
+	TreeViewItem * tiObject = AddTreeViewItem(new TreeViewItem(userProfile ? TREEVIEW_ITEM_TYPE_USER_PROFILE : TREEVIEW_ITEM_TYPE_SYSTEM_PROFILE));
+	tvInsertStruct.itemex.lParam = reinterpret_cast<LPARAM>(tiObject);
+	HTREEITEM tvItem = reinterpret_cast<HTREEITEM>( SendMessage(hwndTreeView, TVM_INSERTITEM, 0, reinterpret_cast<LPARAM>(&tvInsertStruct)) );
+	tiObject->SetHTREEITEM(tvItem);
+	tiObject->SetProfile(profile);
+}
+
+// Fill in the icon, LUT overlay and boldness (for the default profile) of a user or system profile
+//  item.  Profiles still being loaded get a plain icon for now; ProfileLoaded() fixes it.
+//
+void MonitorPage::SetProfileItemAppearance(TVITEMEX & itemEx, Profile * profile, bool userProfile) {
+	bool profileReady = ProfileLoader::RequestLoad(profile, hwnd);
+	Profile * defaultProfile = userProfile ? monitor->GetUserProfile() : monitor->GetSystemProfile();
+	itemEx.mask |= TVIF_STATE | TVIF_IMAGE | TVIF_SELECTEDIMAGE;
+	if ( profileReady && profile->HasEmbeddedWcsProfile() ) {
+		itemEx.iImage = imageWCSprofile;
+	} else {
+		itemEx.iImage = IMAGE_ICC_PROFILE;
+	}
+	itemEx.iSelectedImage = itemEx.iImage;
+	itemEx.state = ( profileReady && profile->GetLutPointer() ) ? INDEXTOOVERLAYMASK(1) : 0;
+	if ( profile == defaultProfile ) {
+		itemEx.state |= TVIS_BOLD;
+	}
+	itemEx.stateMask = TVIS_OVERLAYMASK | TVIS_BOLD;
+}
+
+// Delete an item from the TreeView along with its TreeViewItem
+//
+void MonitorPage::DeleteTreeViewItem(HTREEITEM hItem, TreeViewItem * treeViewItem) {
+	SendMessage(hwndTreeView, TVM_DELETEITEM, 0, reinterpret_cast<LPARAM>(hItem));
+	vector <TreeViewItem *>::iterator it = find(treeviewitemList.begin(), treeviewitemList.end(), treeViewItem);
+	if ( it != treeviewitemList.end() ) {
+		treeviewitemList.erase(it);
+		delete treeViewItem;
+	}
+}
+
+// Make a subtree's items match a set of profiles: delete items for profiles that are not in the
+//  set (or that are duplicates), and fill 'present' with the profiles that keep their items
+//
+void MonitorPage::PruneSubtree(HTREEITEM subTree, const PROFILE_SET & wanted, PROFILE_SET & present) {
+	TVITEMEX itemEx;
+	SecureZeroMemory(&itemEx, sizeof(itemEx));
+	itemEx.mask = TVIF_PARAM;
+	HTREEITEM hChild = reinterpret_cast<HTREEITEM>(
+			SendMessage(hwndTreeView, TVM_GETNEXTITEM, TVGN_CHILD, reinterpret_cast<LPARAM>(subTree)) );
+	while (hChild) {
+		HTREEITEM hNext = reinterpret_cast<HTREEITEM>(
+				SendMessage(hwndTreeView, TVM_GETNEXTITEM, TVGN_NEXT, reinterpret_cast<LPARAM>(hChild)) );
+		itemEx.hItem = hChild;
+		SendMessage(hwndTreeView, TVM_GETITEM, 0, reinterpret_cast<LPARAM>(&itemEx));
+		TreeViewItem * tiObject = reinterpret_cast<TreeViewItem *>(itemEx.lParam);
+		Profile * profile = tiObject ? tiObject->GetProfilePtr() : 0;
+		if ( (wanted.end() == wanted.find(profile)) || (present.end() != present.find(profile)) ) {
+			DeleteTreeViewItem(hChild, tiObject);
+		} else {
+			present.insert(profile);
 		}
+		hChild = hNext;
 	}
 }
 
-// Subclass procedure for edit control
+// Bring the user or system subtree up to date with the monitor's list, touching only what changed
 //
-INT_PTR CALLBACK EditSubclassProc(HWND hWnd, UINT uMessage, WPARAM wParam, LPARAM lParam) {
+void MonitorPage::RefreshProfileSubtree(HTREEITEM subTree, bool userProfiles) {
+	ProfileList & profileList = monitor->GetProfileList(userProfiles);
+	PROFILE_SET wanted(profileList.begin(), profileList.end());
+	PROFILE_SET present;
+	PruneSubtree(subTree, wanted, present);
 
-	switch (uMessage) {
+	// Profiles that kept their items may have become (or stopped being) the default
+	//
+	TVITEMEX itemEx;
+	SecureZeroMemory(&itemEx, sizeof(itemEx));
+	HTREEITEM hChild = reinterpret_cast<HTREEITEM>(
+			SendMessage(hwndTreeView, TVM_GETNEXTITEM, TVGN_CHILD, reinterpret_cast<LPARAM>(subTree)) );
+	while (hChild) {
+		itemEx.mask = TVIF_PARAM;
+		itemEx.hItem = hChild;
+		SendMessage(hwndTreeView, TVM_GETITEM, 0, reinterpret_cast<LPARAM>(&itemEx));
+		TreeViewItem * tiObject = reinterpret_cast<TreeViewItem *>(itemEx.lParam);
+		itemEx.mask = 0;
+		SetProfileItemAppearance(itemEx, tiObject->GetProfilePtr(), userProfiles);
+		SendMessage(hwndTreeView, TVM_SETITEM, 0, reinterpret_cast<LPARAM>(&itemEx));
+		hChild = reinterpret_cast<HTREEITEM>(
+				SendMessage(hwndTreeView, TVM_GETNEXTITEM, TVGN_NEXT, reinterpret_cast<LPARAM>(hChild)) );
+	}
 
-		// This prevents us from auto-selecting all text when we get the focus
-		//
-		case WM_GETDLGCODE:
-			INT_PTR temp;
-			temp = CallWindowProcW(oldEditWindowProc, hWnd, uMessage, wParam, lParam);
-			return temp & ~DLGC_HASSETSEL;
-			break;
+	bool inserted = false;
+	size_t count = profileList.size();
+	for (size_t i = 0; i < count; ++i) {
+		if ( present.end() == present.find(profileList[i]) ) {
+			InsertProfileItem(subTree, profileList[i], userProfiles);
+			present.insert(profileList[i]);
+			inserted = true;
+		}
+	}
+	if (inserted) {
+		SendMessage(hwndTreeView, TVM_SORTCHILDREN, FALSE, reinterpret_cast<LPARAM>(subTree));
+	}
+}
 
-		// This enables control-A as a hotkey for Select All
-		//
-		case WM_CHAR:
-			if (1 == wParam) {
-				uMessage = EM_SETSEL;
-				wParam = 0;
-				lParam = -1;
-			}
-			return CallWindowProc(oldEditWindowProc, hWnd, uMessage, wParam, lParam);
+// Bring the "other" subtree (if it has been populated) up to date with the index and the
+//  monitor's lists, inserting new items at their sorted positions
+//
+void MonitorPage::RefreshOtherProfiles(void) {
+	if ( !otherProfilesPopulated ) {
+		return;
+	}
+	PROFILE_SET monitorProfiles;
+	GetMonitorProfileSet(monitor, monitorProfiles);
+	const vector <COLOR_DIRECTORY_ENTRY> & displayProfiles = ColorDirectoryIndex::GetDisplayProfiles();
+	size_t count = displayProfiles.size();
+	PROFILE_SET wanted;
+	for (size_t i = 0; i < count; ++i) {
+		if ( monitorProfiles.end() == monitorProfiles.find(displayProfiles[i].profile) ) {
+			wanted.insert(displayProfiles[i].profile);
+		}
+	}
+	PROFILE_SET present;
+	PruneSubtree(tvOtherProfiles, wanted, present);
+	for (size_t i = 0; i < count; ++i) {
+		Profile * profile = displayProfiles[i].profile;
+		if ( (wanted.end() != wanted.find(profile)) && (present.end() == present.find(profile)) ) {
+			InsertOtherProfileItem(displayProfiles[i], GetOtherProfileInsertAfter(profile));
+		}
+	}
+}
+
+// Return the item to insert 'profile' after to keep the "other" subtree sorted, or zero if the
+//  subtree has not been populated yet (it will pick the profile up when it is)
+//
+HTREEITEM MonitorPage::GetOtherProfileInsertAfter(Profile * profile) const {
+	if ( !otherProfilesPopulated ) {
+		return 0;
+	}
+	wstring name = profile->GetName();
+	HTREEITEM insertAfter = TVI_FIRST;
+	TVITEMEX itemEx;
+	SecureZeroMemory(&itemEx, sizeof(itemEx));
+	itemEx.mask = TVIF_PARAM;
+	HTREEITEM hChild = reinterpret_cast<HTREEITEM>(
+			SendMessage(hwndTreeView, TVM_GETNEXTITEM, TVGN_CHILD, reinterpret_cast<LPARAM>(tvOtherProfiles)) );
+	while (hChild) {
+		itemEx.hItem = hChild;
+		SendMessage(hwndTreeView, TVM_GETITEM, 0, reinterpret_cast<LPARAM>(&itemEx));
+		TreeViewItem * tvItem = reinterpret_cast<TreeViewItem *>(itemEx.lParam);
+		if ( tvItem && tvItem->GetProfilePtr() && (lstrcmpi(tvItem->GetProfilePtr()->GetName().c_str(), name.c_str()) > 0) ) {
 			break;
+		}
+		insertAfter = hChild;
+		hChild = reinterpret_cast<HTREEITEM>(
+				SendMessage(hwndTreeView, TVM_GETNEXTITEM, TVGN_NEXT, reinterpret_cast<LPARAM>(hChild)) );
+	}
+	return insertAfter;
+}
 
+// Supply the text of "other" profiles and say whether the "other" node has any children
+//
+void MonitorPage::Handle_TVN_GETDISPINFOW(NMTVDISPINFOW * pNMTVDISPINFOW) {
+	TVITEMW & item = pNMTVDISPINFOW->item;
+	if ( (TVIF_CHILDREN & item.mask) && (item.hItem == tvOtherProfiles) ) {
+		if (otherProfilesPopulated) {
+			item.cChildren = ( 0 != SendMessage(hwndTreeView, TVM_GETNEXTITEM, TVGN_CHILD, reinterpret_cast<LPARAM>(tvOtherProfiles)) ) ? 1 : 0;
+		} else {
+			item.cChildren = 1;
+		}
+	}
+	if ( (TVIF_TEXT & item.mask) && item.pszText && item.cchTextMax ) {
+		TreeViewItem * tvItem = reinterpret_cast<TreeViewItem *>(item.lParam);
+		if ( tvItem && tvItem->GetProfilePtr() ) {
+			StringCchCopy(item.pszText, item.cchTextMax, tvItem->GetProfilePtr()->GetName().c_str());
+		}
 	}
-	return CallWindowProc(oldEditWindowProc, hWnd, uMessage, wParam, lParam);
 }
 
 // Monitor page dialog proc
@@ -761,10 +841,6 @@ INT_PTR CALLBACK MonitorPage::MonitorPageProc(HWND hWnd, UINT uMessage, WPARAM w
 			thisPage->hwndTreeView = GetDlgItem(hWnd, IDC_TREE1);
 			thisPage->hwndEdit = GetDlgItem(hWnd, IDC_MONITOR_TEXT);
 
-			// Subclass the edit control
-			//
-			oldEditWindowProc = (WNDPROC)(INT_PTR)SetWindowLongPtr(thisPage->hwndEdit, GWLP_WNDPROC, (__int3264)(LONG_PTR)EditSubclassProc);
-
 			// This page and its subwindows should grow with resizing
 			//
 			ANCHOR_PRESET anchorPreset;
@@ -815,41 +891,14 @@ INT_PTR CALLBACK MonitorPage::MonitorPageProc(HWND hWnd, UINT uMessage, WPARAM w
 			// Fix up the size of the controls in case the Summary tab was resized
 			// before this tab was created.
 			//
-			if ( 0 != hwnd_IDC_ORIGINAL_SIZE && 0 != hwnd_IDC_RESIZED ) {
-				RECT originalSize;
-				RECT newSize;
-				SecureZeroMemory(&originalSize, sizeof(originalSize));
-				GetClientRect(hwnd_IDC_ORIGINAL_SIZE, &originalSize);
-				SecureZeroMemory(&newSize, sizeof(newSize));
-				GetClientRect(hwnd_IDC_RESIZED, &newSize);
-				SIZE sizeDelta;
-				sizeDelta.cx = newSize.right - originalSize.right;
-				sizeDelta.cy = newSize.bottom - originalSize.bottom;
-				if ( (0 != sizeDelta.cx) || (0 != sizeDelta.cy) ) {
-					GetWindowRect(thisPage->hwndEdit, &rect);
-					rect.left -= wiParent.rcClient.left;
-					rect.top -= wiParent.rcClient.top;
-					rect.right -= wiParent.rcClient.left;
-					rect.bottom -= wiParent.rcClient.top;
-					rect.right += sizeDelta.cx;
-					rect.bottom += sizeDelta.cy;
-					MoveWindow(thisPage->hwndEdit, rect.left, rect.top, rect.right - rect.left, rect.bottom - rect.top, FALSE);
-
-					GetWindowRect(thisPage->hwndTreeView, &rect);
-					rect.left -= wiParent.rcClient.left;
-					rect.top -= wiParent.rcClient.top;
-					rect.right -= wiParent.rcClient.left;
-					rect.bottom -= wiParent.rcClient.top;
-					rect.bottom += sizeDelta.cy;
-					MoveWindow(thisPage->hwndTreeView, rect.left, rect.top, rect.right - rect.left, rect.bottom - rect.top, FALSE);
-				}
-			}
+			Resize::GrowForEarlierResize(hWnd, thisPage->hwndEdit, true);
+			Resize::GrowForEarlierResize(hWnd, thisPage->hwndTreeView, false);
 
 			// Tell the resizing system that its window list is out of date
 			//
 			Resize::SetNeedRebuild(true);
 
-			// Try setting the fonts in the TreeView and Edit controls, overriding the dialog template
+			// Try setting the fonts in the TreeView and details view, overriding the dialog template
 			//
 			HDC hdc = GetDC(hWnd);
 			HFONT hFont = GetFont(hdc, FC_DIALOG, true);
@@ -866,15 +915,18 @@ INT_PTR CALLBACK MonitorPage::MonitorPageProc(HWND hWnd, UINT uMessage, WPARAM w
 			break;
 		}
 
-		// Force the page to be white (instead of COLOR_BTNFACE)
+		// The worker thread has loaded a profile we asked for
 		//
-		case WM_CTLCOLORDLG:
-			return reinterpret_cast<INT_PTR>(GetStockObject(WHITE_BRUSH));
+		case WM_PROFILE_LOADED:
+			thisPage = reinterpret_cast<MonitorPage *>(static_cast<LONG_PTR>(GetWindowLongPtr(hWnd, DWLP_USER)));
+			if (thisPage) {
+				thisPage->ProfileLoaded(reinterpret_cast<Profile *>(lParam));
+			}
 			break;
 
-		// Force the read-only edit control to be white (instead of COLOR_BTNFACE)
+		// Force the page to be white (instead of COLOR_BTNFACE)
 		//
-		case WM_CTLCOLORSTATIC:
+		case WM_CTLCOLORDLG:
 			return reinterpret_cast<INT_PTR>(GetStockObject(WHITE_BRUSH));
 			break;
 
@@ -969,13 +1021,17 @@ INT_PTR CALLBACK MonitorPage::MonitorPageProc(HWND hWnd, UINT uMessage, WPARAM w
 					//pPSHNOTIFY = reinterpret_cast<PSHNOTIFY *>(lParam);
 					//MessageBox(NULL, L"PSN_SETACTIVE", L"PropertySheet notification", MB_ICONINFORMATION | MB_OK);
 
+					// Profiles this page is waiting for should be loaded first
+					//
+					ProfileLoader::SetVisibleWindow(hWnd);
+
 					// If showing the text for the monitor, refresh it in case the Load LUT button has been pressed
 					//
 					if (thisPage->hwndTreeView) {
 						hSelection = reinterpret_cast<HTREEITEM>(
 								SendMessage( thisPage->hwndTreeView, TVM_GETNEXTITEM, TVGN_CARET, 0 ) );
 						if (hSelection && (hSelection == thisPage->tvRoot) ) {
-							thisPage->SetEditControlText(thisPage->monitor->SummaryString());
+							thisPage->SetEditControlText(thisPage->monitor->SummaryString(hWnd));
 						}
 					}
 					break;
@@ -1009,6 +1065,21 @@ INT_PTR CALLBACK MonitorPage::MonitorPageProc(HWND hWnd, UINT uMessage, WPARAM w
 					tiObject->Handle_TVN_SELCHANGEDW(thisPage, pNMTREEVIEWW);
 					break;
 
+				// The "other" subtree is filled in the first time it is opened
+				//
+				case TVN_ITEMEXPANDINGW:
+					pNMTREEVIEWW = reinterpret_cast<NMTREEVIEWW *>(lParam);
+					if ( (TVE_EXPAND == (TVE_ACTIONMASK & pNMTREEVIEWW->action)) && (pNMTREEVIEWW->itemNew.hItem == thisPage->tvOtherProfiles) ) {
+						thisPage->PopulateOtherProfiles();
+					}
+					break;
+
+				// TreeView needs text or a child count that we supply on demand
+				//
+				case TVN_GETDISPINFOW:
+					thisPage->Handle_TVN_GETDISPINFOW(reinterpret_cast<NMTVDISPINFOW *>(lParam));
+					break;
+
 				// Convert a right-click in the TreeView into a WM_CONTEXTMENU message
 				//
 				case NM_RCLICK:
@@ -4,12 +4,18 @@
 #pragma once
 #include "stdafx.h"
 #include <commctrl.h>		// For HTREEITEM
+#include <hash_set>
+#include "ColorDirectoryIndex.h"
+#include "DetailsView.h"
 
 // Forward references
 //
 class Monitor;
+class Profile;
 class TreeViewItem;
 
+typedef stdext::hash_set <Profile *> PROFILE_SET;
+
 class MonitorPage {
 
 public:
@@ -21,18 +27,30 @@ public:
 	HTREEITEM GetUserHTREEITEM(void) const;
 	HTREEITEM GetSystemHTREEITEM(void) const;
 	HTREEITEM GetOtherHTREEITEM(void) const;
+	HTREEITEM GetOtherProfileInsertAfter(Profile * profile) const;
 	void RequestTreeViewWidth(int);
 	void GetTreeViewNodeExpansionString(wchar_t * str, __in_bcount(str) size_t strSize);
 	void SetTreeViewNodeExpansionString(wchar_t * str);
 	void SetEditControlText(wstring newText);
+	void SetDetailsDocument(DetailsDocument & document);
 	Monitor * GetMonitor(void) const;
 	void Reset(void);
+	void ProfileLoaded(Profile * profile);
 	TreeViewItem * AddTreeViewItem(TreeViewItem * treeViewItem);
 
 	static INT_PTR CALLBACK MonitorPageProc(HWND hWnd, UINT uMessage, WPARAM wParam, LPARAM lParam);
 
 private:
 	void BuildTreeView(void);
+	void PopulateOtherProfiles(void);
+	void InsertOtherProfileItem(const COLOR_DIRECTORY_ENTRY & entry, HTREEITEM insertAfter);
+	void InsertProfileItem(HTREEITEM subTree, Profile * profile, bool userProfile);
+	void SetProfileItemAppearance(TVITEMEX & itemEx, Profile * profile, bool userProfile);
+	void DeleteTreeViewItem(HTREEITEM hItem, TreeViewItem * treeViewItem);
+	void PruneSubtree(HTREEITEM subTree, const PROFILE_SET & wanted, PROFILE_SET & present);
+	void RefreshProfileSubtree(HTREEITEM subTree, bool userProfiles);
+	void RefreshOtherProfiles(void);
+	void Handle_TVN_GETDISPINFOW(NMTVDISPINFOW * pNMTVDISPINFOW);
 	void ClearTreeViewItemList(bool freeAllMemory);
 
 	Monitor *					monitor;
@@ -49,5 +67,5 @@ private:
 	bool						requestedUserProfilesExpansion;
 	bool						requestedSystemProfilesExpansion;
 	bool						requestedOtherProfilesExpansion;
-	bool						resetting;
+	bool						otherProfilesPopulated;			// "Other" subtree is filled in on first expansion
 };
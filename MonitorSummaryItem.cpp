@@ -3,9 +3,11 @@
 
 #include "stdafx.h"
 #include "Adapter.h"
+#include "ColorDirectoryIndex.h"
 #include "LUT.h"
 #include "LUTview.h"
 #include "MonitorSummaryItem.h"
+#include "ProfileLoader.h"
 #include "Resize.h"
 #include "resource.h"
 #include "Utility.h"
@@ -55,6 +57,11 @@ extern HWND hwndSummaryLUT;					// HWND for LUTview we created
 //
 static wchar_t * MonitorSummaryItemClassName = L"Monitor Summary Item";
 
+// The shared LUTview shows the last item to call Update; if that item's profile was still loading,
+//  remember it so WM_PROFILE_LOADED can replace the placeholder without stealing the LUTview
+//
+static MonitorSummaryItem * itemWaitingForProfile = 0;
+
 // Constructor
 //
 MonitorSummaryItem::MonitorSummaryItem(Monitor * hostMonitor) :
@@ -84,6 +91,7 @@ MonitorSummaryItem * MonitorSummaryItem::Add(MonitorSummaryItem * newItem) {
 // Clear the list of MonitorSummaryItems
 //
 void MonitorSummaryItem::ClearList(bool freeAllMemory) {
+	itemWaitingForProfile = 0;
 	if (monitorSummaryItemList) {
 		size_t count = monitorSummaryItemList->size();
 		for (size_t i = 0; i < count; ++i) {
@@ -105,7 +113,7 @@ LRESULT CALLBACK MonitorSummaryItem::MonitorSummaryItemProc(HWND hWnd, UINT uMes
 	MonitorSummaryItem * thisView;
 	Monitor * myMonitor;
 	Profile * activeProfile;
-	LUT * pProfileLUT;
+	const LUT * pProfileLUT;
 	RECT rect;
 	RECT * r;
 
@@ -160,6 +168,7 @@ LRESULT CALLBACK MonitorSummaryItem::MonitorSummaryItemProc(HWND hWnd, UINT uMes
 						//
 						myMonitor = thisView->monitor;
 						myMonitor->Initialize();
+						ColorDirectoryIndex::Refresh();
 						MonitorPage * page = myMonitor->GetMonitorPage();
 						if (page) {
 							page->Reset();
@@ -301,6 +310,23 @@ LRESULT CALLBACK MonitorSummaryItem::MonitorSummaryItemProc(HWND hWnd, UINT uMes
 		case WM_ERASEBKGND:
 			return 1;
 
+		// The worker thread has loaded a profile we asked for; show it
+		//
+		case WM_PROFILE_LOADED:
+			thisView = reinterpret_cast<MonitorSummaryItem *>(static_cast<LONG_PTR>(GetWindowLongPtr(hWnd, DLGWINDOWEXTRA)));
+			if ( thisView && thisView->monitor ) {
+				if ( thisView->monitor->GetActiveProfile() == reinterpret_cast<Profile *>(lParam) ) {
+					if ( thisView == itemWaitingForProfile ) {
+						thisView->Update();
+					} else {
+						thisView->UpdateLoadLutButton(true);
+					}
+					InvalidateRect(thisView->hwnd, NULL, FALSE);
+				}
+			}
+			return 0;
+			break;
+
 		case WM_PAINT:
 			thisView = reinterpret_cast<MonitorSummaryItem *>(static_cast<LONG_PTR>(GetWindowLongPtr(hWnd, DLGWINDOWEXTRA)));
 			PAINTSTRUCT ps;
@@ -383,8 +409,9 @@ HWND MonitorSummaryItem::CreateMonitorSummaryItemWindow(
 	if (monitor) {
 
 		Profile * activeProfile = monitor->GetActiveProfile();
+		bool profileReady = true;
 		if (activeProfile) {
-			activeProfile->LoadFullProfile(false);
+			profileReady = ProfileLoader::RequestLoad(activeProfile, hwnd);
 		}
 
 		RECT buttonRect;
@@ -394,7 +421,7 @@ HWND MonitorSummaryItem::CreateMonitorSummaryItemWindow(
 		buttonRect.bottom = buttonRect.top + baseButtonRect.bottom - baseButtonRect.top;
 
 		wchar_t * buttonText = L"Set linear";
-		if (activeProfile) {
+		if ( activeProfile && profileReady ) {
 			if (activeProfile->GetLutPointer()) {
 				buttonText = L"Load LUT";
 			}
@@ -413,6 +440,7 @@ HWND MonitorSummaryItem::CreateMonitorSummaryItemWindow(
 				g_hInst,
 				this );
 		SetWindowLongPtr(hwndLoadLutButton, GWLP_ID, IDC_LOAD_BUTTON);
+		EnableWindow(hwndLoadLutButton, profileReady);
 
 		HDC hdc = GetDC(hwndLoadLutButton);
 		HFONT hFont = GetFont(hdc, FC_DIALOG, true);
@@ -448,37 +476,54 @@ HWND MonitorSummaryItem::CreateMonitorSummaryItemWindow(
 	return hwnd;
 }
 
+// Bring the LUTview and the Load LUT button up to date.  If the active profile is still being
+//  loaded, we show a placeholder and do this again when WM_PROFILE_LOADED arrives.
+//
 void MonitorSummaryItem::Update(void) {
 	Profile * activeProfile = monitor->GetActiveProfile();
+	bool profileReady = true;
 	if (activeProfile) {
-		activeProfile->LoadFullProfile(false);
+		profileReady = ProfileLoader::RequestLoad(activeProfile, hwnd);
 	}
+	itemWaitingForProfile = 0;
 	if (lutViewShowsProfile) {
-		if (activeProfile) {
+		if ( activeProfile && profileReady ) {
 			summaryLutView->SetText(activeProfile->GetName());
-			summaryLutView->SetLUT(activeProfile->GetLutPointer());
+			summaryLutView->SetLUT(activeProfile->GetLutHandle());
+		} else if (activeProfile) {
+			summaryLutView->SetText(activeProfile->GetName() + L" (loading)");
+			summaryLutView->SetLUT(LUThandle());
+			itemWaitingForProfile = this;
 		} else {
 			summaryLutView->SetText(L"No profile");
-			summaryLutView->SetLUT(0);
+			summaryLutView->SetLUT(LUThandle());
 		}
 	} else {
 		summaryLutView->SetText(monitor->GetDeviceString());
-		summaryLutView->SetLUT(monitor->GetLutPointer());
+		summaryLutView->SetLUT(monitor->GetLutHandle());
 	}
 	summaryLutView->SetUpdateBitmap();
+	UpdateLoadLutButton(profileReady);
+	InvalidateRect(hwndSummaryLUT, summaryLutView->GetGraphRect(), FALSE);
+}
+
+// Set the Load LUT button's text and enable it only when the active profile has been loaded
+//
+void MonitorSummaryItem::UpdateLoadLutButton(bool profileReady) {
+	Profile * activeProfile = monitor->GetActiveProfile();
 	wchar_t * buttonText = L"Set linear";
-	if (activeProfile) {
+	if ( activeProfile && profileReady ) {
 		if (activeProfile->GetLutPointer()) {
 			buttonText = L"Load LUT";
 		}
 	}
+	EnableWindow(hwndLoadLutButton, profileReady);
 	SendMessage(
 			hwndLoadLutButton,
 			WM_SETTEXT,
 			0,
 			reinterpret_cast<LPARAM>( buttonText )
 	);
-	InvalidateRect(hwndSummaryLUT, summaryLutView->GetGraphRect(), FALSE);
 }
 
 int MonitorSummaryItem::GetDesiredHeight(HDC hdc) {
@@ -630,9 +675,10 @@ void MonitorSummaryItem::DrawTextOnDC(HDC hdc) {
 	}
 	s += L"profile:  ";
 	Profile * activeProfile = monitor->GetActiveProfile();
+	bool profileReady = true;
 	if (activeProfile) {
 		s += activeProfile->GetName();
-		activeProfile->LoadFullProfile(false);
+		profileReady = ProfileLoader::RequestLoad(activeProfile, hwnd);
 	} else {
 		s += L"No profile";
 	}
@@ -652,7 +698,10 @@ void MonitorSummaryItem::DrawTextOnDC(HDC hdc) {
 	//
 	s.clear();
 	COLORREF color;
-	if (activeProfile) {
+	if ( activeProfile && !profileReady ) {
+		s += L"Loading profile ...";
+		color = normalColor;
+	} else if (activeProfile) {
 		DWORD maxError = 0;
 		DWORD totalError = 0;
 		LUT_COMPARISON result = activeProfile->CompareLUT(monitor->GetLutPointer(), &maxError, &totalError);
@@ -28,6 +28,7 @@ public:
 
 private:
 	void DrawTextOnDC(HDC hdc);
+	void UpdateLoadLutButton(bool profileReady);
 
 	static LRESULT CALLBACK MonitorSummaryItemProc(HWND hWnd, UINT uMessage, WPARAM wParam, LPARAM lParam);
 
@@ -0,0 +1,184 @@
+// MultiStringList.cpp -- Batched edits to REG_MULTI_SZ lists (profile associations), and where they are stored
+//
+
+#include <wctype.h>
+#include "MultiStringList.h"
+
+// Compare two strings without regard to case, as Windows compares file and registry key names
+//
+bool SameTextIgnoringCase(const wchar_t * text1, const wchar_t * text2) {
+	while ( *text1 && (towlower(*text1) == towlower(*text2)) ) {
+		++text1;
+		++text2;
+	}
+	return ( towlower(*text1) == towlower(*text2) );
+}
+
+// Add a string at the start of the list
+//
+void MultiStringEdit::InsertAtStart(const wchar_t * text) {
+	MULTI_STRING_EDIT_ITEM item;
+	item.editType = MSE_INSERT_AT_START;
+	item.text = text;
+	editList.push_back(item);
+}
+
+// Remove a string from the list
+//
+void MultiStringEdit::Remove(const wchar_t * text) {
+	MULTI_STRING_EDIT_ITEM item;
+	item.editType = MSE_REMOVE;
+	item.text = text;
+	editList.push_back(item);
+}
+
+// Move a string to the end of the list (adding it if it wasn't there)
+//
+void MultiStringEdit::MoveToEnd(const wchar_t * text) {
+	MULTI_STRING_EDIT_ITEM item;
+	item.editType = MSE_MOVE_TO_END;
+	item.text = text;
+	editList.push_back(item);
+}
+
+// Return 'true' if there is nothing to do
+//
+bool MultiStringEdit::IsEmpty(void) const {
+	return editList.empty();
+}
+
+// Apply all of our edits, in order, to a list of strings; profile names are file names, so
+//  matching is not case-sensitive
+//
+void MultiStringEdit::ApplyTo(std::vector<std::wstring> & strings) const {
+	size_t editCount = editList.size();
+	for (size_t i = 0; i < editCount; ++i) {
+		const MULTI_STRING_EDIT_ITEM & item = editList[i];
+		if ( MSE_INSERT_AT_START == item.editType ) {
+			strings.insert(strings.begin(), item.text);
+			continue;
+		}
+		for (size_t j = strings.size(); j > 0; --j) {
+			if ( SameTextIgnoringCase(strings[j - 1].c_str(), item.text.c_str()) ) {
+				strings.erase(strings.begin() + (j - 1));
+			}
+		}
+		if ( MSE_MOVE_TO_END == item.editType ) {
+			strings.push_back(item.text);
+		}
+	}
+}
+
+// Split a double-NUL-terminated REG_MULTI_SZ into strings
+//
+void ParseMultiString(const wchar_t * data, std::vector<std::wstring> & strings) {
+	strings.clear();
+	while (*data) {
+		std::wstring s(data);
+		data += s.size() + 1;
+		strings.push_back(s);
+	}
+}
+
+// Build a REG_MULTI_SZ from strings; the wstring holds the embedded NULs, including the final one
+//
+std::wstring BuildMultiString(const std::vector<std::wstring> & strings) {
+	std::wstring data;
+	size_t count = strings.size();
+	for (size_t i = 0; i < count; ++i) {
+		data += strings[i];
+		data.push_back(0);
+	}
+	data.push_back(0);
+	return data;
+}
+
+// Constructor
+//
+MemoryMultiStringStore::MemoryMultiStringStore() :
+		readCount(0),
+		writeCount(0)
+{
+}
+
+// Find a key (registry keys are not case-sensitive), optionally creating it
+//
+MEMORY_KEY * MemoryMultiStringStore::FindKey(const std::wstring & keyPath, bool create) {
+	size_t count = keyList.size();
+	for (size_t i = 0; i < count; ++i) {
+		if ( SameTextIgnoringCase(keyPath.c_str(), keyList[i].keyPath.c_str()) ) {
+			return &keyList[i];
+		}
+	}
+	if (!create) {
+		return 0;
+	}
+	MEMORY_KEY key;
+	key.keyPath = keyPath;
+	keyList.push_back(key);
+	return &keyList.back();
+}
+
+// Find a value in a key, optionally creating it
+//
+MEMORY_VALUE * MemoryMultiStringStore::FindValue(MEMORY_KEY * key, const wchar_t * valueName, bool create) {
+	size_t count = key->valueList.size();
+	for (size_t i = 0; i < count; ++i) {
+		if ( SameTextIgnoringCase(valueName, key->valueList[i].valueName.c_str()) ) {
+			return &key->valueList[i];
+		}
+	}
+	if (!create) {
+		return 0;
+	}
+	MEMORY_VALUE value;
+	value.valueName = valueName;
+	key->valueList.push_back(value);
+	return &key->valueList.back();
+}
+
+// Same rules as the real registry:  the key must exist, the value need not
+//
+bool MemoryMultiStringStore::Update(const std::wstring & keyPath, const wchar_t * valueName, const MultiStringEdit & edit) {
+	MEMORY_KEY * key = FindKey(keyPath, false);
+	if ( 0 == key ) {
+		return false;
+	}
+	++readCount;
+	MEMORY_VALUE * value = FindValue(key, valueName, true);
+	edit.ApplyTo(value->strings);
+	++writeCount;
+	return true;
+}
+
+// Create a key and value with the given contents
+//
+void MemoryMultiStringStore::SetValue(const std::wstring & keyPath, const wchar_t * valueName, const std::vector<std::wstring> & strings) {
+	FindValue(FindKey(keyPath, true), valueName, true)->strings = strings;
+}
+
+// Fetch a value's contents, returning 'false' if there is no such key or value
+//
+bool MemoryMultiStringStore::GetValue(const std::wstring & keyPath, const wchar_t * valueName, std::vector<std::wstring> & strings) {
+	MEMORY_KEY * key = FindKey(keyPath, false);
+	if (key) {
+		MEMORY_VALUE * value = FindValue(key, valueName, false);
+		if (value) {
+			strings = value->strings;
+			return true;
+		}
+	}
+	return false;
+}
+
+// Number of value reads done by Update()
+//
+unsigned int MemoryMultiStringStore::GetReadCount(void) const {
+	return readCount;
+}
+
+// Number of value writes done by Update()
+//
+unsigned int MemoryMultiStringStore::GetWriteCount(void) const {
+	return writeCount;
+}
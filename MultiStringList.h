@@ -0,0 +1,85 @@
+// MultiStringList.h -- Batched edits to REG_MULTI_SZ lists (profile associations), and where they are stored
+//
+// MultiStringList.cpp uses only standard C++ (no <windows.h>, and no precompiled header), like
+//  GraphRaster.cpp, so the batching logic and the in-memory store can be built and tested on
+//  another platform.  The real registry is in RegistryMultiStringStore.cpp.  Keys are named by
+//  their full path, root included ("HKEY_CURRENT_USER\Software\..."), rather than by an HKEY.
+//
+
+#pragma once
+#include <string>
+#include <vector>
+
+// Kinds of edit we can make to a list of strings
+//
+typedef enum tag_MULTI_STRING_EDIT_TYPE {
+	MSE_INSERT_AT_START = 0,						// Add at the head of the list (does not change the default)
+	MSE_REMOVE = 1,									// Remove every copy from the list
+	MSE_MOVE_TO_END = 2								// Remove, then add at the end (makes it the default)
+} MULTI_STRING_EDIT_TYPE;
+
+typedef struct tag_MULTI_STRING_EDIT_ITEM {
+	MULTI_STRING_EDIT_TYPE	editType;
+	std::wstring			text;
+} MULTI_STRING_EDIT_ITEM;
+
+// A batch of edits to be applied, in order, to one list
+//
+class MultiStringEdit {
+
+public:
+	void InsertAtStart(const wchar_t * text);
+	void Remove(const wchar_t * text);
+	void MoveToEnd(const wchar_t * text);
+	bool IsEmpty(void) const;
+	void ApplyTo(std::vector<std::wstring> & strings) const;
+
+private:
+	std::vector<MULTI_STRING_EDIT_ITEM> editList;
+};
+
+// Somewhere to keep REG_MULTI_SZ values; Update() does one read and one write no matter how many
+//  edits are in the batch
+//
+class MultiStringStore {
+
+public:
+	virtual ~MultiStringStore() {}
+	virtual bool Update(const std::wstring & keyPath, const wchar_t * valueName, const MultiStringEdit & edit) = 0;
+};
+
+// A stand-in for the registry, so that association logic can be exercised without touching it
+//
+typedef struct tag_MEMORY_VALUE {
+	std::wstring				valueName;
+	std::vector<std::wstring>	strings;
+} MEMORY_VALUE;
+
+typedef struct tag_MEMORY_KEY {
+	std::wstring				keyPath;
+	std::vector<MEMORY_VALUE>	valueList;
+} MEMORY_KEY;
+
+class MemoryMultiStringStore : public MultiStringStore {
+
+public:
+	MemoryMultiStringStore();
+
+	bool Update(const std::wstring & keyPath, const wchar_t * valueName, const MultiStringEdit & edit);
+	void SetValue(const std::wstring & keyPath, const wchar_t * valueName, const std::vector<std::wstring> & strings);
+	bool GetValue(const std::wstring & keyPath, const wchar_t * valueName, std::vector<std::wstring> & strings);
+	unsigned int GetReadCount(void) const;
+	unsigned int GetWriteCount(void) const;
+
+private:
+	MEMORY_KEY * FindKey(const std::wstring & keyPath, bool create);
+	MEMORY_VALUE * FindValue(MEMORY_KEY * key, const wchar_t * valueName, bool create);
+
+	std::vector<MEMORY_KEY>		keyList;
+	unsigned int				readCount;
+	unsigned int				writeCount;
+};
+
+bool SameTextIgnoringCase(const wchar_t * text1, const wchar_t * text2);
+void ParseMultiString(const wchar_t * data, std::vector<std::wstring> & strings);
+std::wstring BuildMultiString(const std::vector<std::wstring> & strings);
@@ -2,10 +2,16 @@
 //
 
 #include "stdafx.h"
+#include <hash_map>
 #include <math.h>
+#include "Counters.h"
+#include "DetailsView.h"
 #include "LUT.h"
 #include "Profile.h"
+#include "RegistryMultiStringStore.h"
+#include "Trace.h"
 #include "Utility.h"
+#include "VcgtDecoder.h"
 #include <strsafe.h>
 //#include <banned.h>
 
@@ -17,6 +23,15 @@
 #define DISPLAY_EMBEDDED_WCS_PROFILE_IN_SHOW_DETAILS 0
 #endif
 
+// Some constants
+//
+#if COMPACT_PROFILES
+#define PROFILE_ARENA_CHUNK_SIZE	1024		// Header, tag table and sorted tags for about 30 tags
+#define VCGT_STACK_BUFFER_SIZE		2048		// Holds a standard 'vcgt' (18 + 3 * 256 * 2 bytes)
+#else
+#define PROFILE_ARENA_CHUNK_SIZE	ARENA_CHUNK_SIZE
+#endif
+
 // Symbols defined in other files
 //
 extern wchar_t * ColorDirectory;
@@ -42,87 +57,90 @@ typedef struct tag_WCS_IN_ICC_HEADER {
 
 // ICC encoding of date and time of profile creation
 //
+// These structures are laid over bytes read from the file, so every number in them is big-endian
+//  and is read with Get()
+//
 typedef struct tag_dateTimeNumber {
-	unsigned short		year;
-	unsigned short		month;
-	unsigned short		day;
-	unsigned short		hour;
-	unsigned short		minute;
-	unsigned short		second;
+	BigEndian <WORD>	year;
+	BigEndian <WORD>	month;
+	BigEndian <WORD>	day;
+	BigEndian <WORD>	hour;
+	BigEndian <WORD>	minute;
+	BigEndian <WORD>	second;
 } dateTimeNumber;
 
 typedef struct tag_textType {
-	DWORD				Type;
-	DWORD				Reserved;
+	BigEndian <DWORD>	Type;
+	BigEndian <DWORD>	Reserved;
 	char				Text[1];
 } textType;
 
 typedef struct tag_descType {
-	DWORD				Type;
-	DWORD				Reserved;
-	DWORD				AsciiLength;
+	BigEndian <DWORD>	Type;
+	BigEndian <DWORD>	Reserved;
+	BigEndian <DWORD>	AsciiLength;
 	char				Text[1];
 } descType;
 
 typedef struct tag_mlucEntryType {
-	DWORD				LocaleID;		// e.g. 'enUS'
+	DWORD				LocaleID;		// e.g. 'enUS', compared as stored
 	//BYTE				Language[2];
 	//BYTE				Country[2];
-	DWORD				LengthInBytes;
-	DWORD				Offset;
+	BigEndian <DWORD>	LengthInBytes;
+	BigEndian <DWORD>	Offset;
 } mlucEntryType;
 
 typedef struct tag_mlucType {
-	DWORD				Type;
-	DWORD				Reserved;
-	DWORD				EntryCount;
-	DWORD				EntrySize;
+	BigEndian <DWORD>	Type;
+	BigEndian <DWORD>	Reserved;
+	BigEndian <DWORD>	EntryCount;
+	BigEndian <DWORD>	EntrySize;
 	mlucEntryType		Entries[1];
 } mlucType;
 
 typedef struct tag_curvType {
-	DWORD				Type;
-	DWORD				Reserved;
-	DWORD				EntryCount;
-	unsigned short		Entries[1];
+	BigEndian <DWORD>	Type;
+	BigEndian <DWORD>	Reserved;
+	BigEndian <DWORD>	EntryCount;
+	BigEndian <WORD>	Entries[1];
 } curvType;
 
 typedef struct tag_measType {
-	DWORD				Type;
-	DWORD				Reserved;
-	DWORD				Observer;
-	CIEXYZ				Backing;
-	DWORD				Geometry;
-	DWORD				Flare;
-	DWORD				Illuminant;
+	BigEndian <DWORD>	Type;
+	BigEndian <DWORD>	Reserved;
+	BigEndian <DWORD>	Observer;
+	BIG_ENDIAN_XYZ		Backing;
+	BigEndian <DWORD>	Geometry;
+	BigEndian <DWORD>	Flare;
+	BigEndian <DWORD>	Illuminant;
 } measType;
 
 typedef struct tag_viewType {
-	DWORD				Type;
-	DWORD				Reserved;
-	CIEXYZ				IlluminantXYZ;
-	CIEXYZ				SurroundXYZ;
-	DWORD				Illuminant;
+	BigEndian <DWORD>	Type;
+	BigEndian <DWORD>	Reserved;
+	BIG_ENDIAN_XYZ		IlluminantXYZ;
+	BIG_ENDIAN_XYZ		SurroundXYZ;
+	BigEndian <DWORD>	Illuminant;
 } viewType;
 
 typedef struct tag_signatureType {
-	DWORD				Type;
-	DWORD				Reserved;
-	DWORD				Signature;
+	BigEndian <DWORD>	Type;
+	BigEndian <DWORD>	Reserved;
+	BigEndian <DWORD>	Signature;
 } signatureType;
 
 typedef struct tag_chadsf32Type {
-	DWORD				Type;
-	DWORD				Reserved;
-	DWORD				a0;
-	DWORD				a1;
-	DWORD				a2;
-	DWORD				a3;
-	DWORD				a4;
-	DWORD				a5;
-	DWORD				a6;
-	DWORD				a7;
-	DWORD				a8;
+	BigEndian <DWORD>	Type;
+	BigEndian <DWORD>	Reserved;
+	BigEndian <long>	a0;
+	BigEndian <long>	a1;
+	BigEndian <long>	a2;
+	BigEndian <long>	a3;
+	BigEndian <long>	a4;
+	BigEndian <long>	a5;
+	BigEndian <long>	a6;
+	BigEndian <long>	a7;
+	BigEndian <long>	a8;
 } chadsf32Type;
 
 // List of CMMs
@@ -385,63 +403,87 @@ const NAME_LOOKUP knownTechnologies[] = {
 //
 Profile::Profile(const wchar_t * profileName) :
 		ProfileName(profileName),
+		arena(PROFILE_ARENA_CHUNK_SIZE),
 		loaded(false),
+		reloadNeeded(false),
 		failed(false),
 		ProfileHeader(0),
 		TagCount(0),
 		TagTable(0),
 		sortedTags(0),
 		pVCGT(0),
-		pLUT(0),
 		vcgtIndex(-1),
-		wcsProfileIndex(-1)
+		wcsProfileIndex(-1),
+		loadComplete(0)
 {
 	ProfileSize.QuadPart = 0;
 	SecureZeroMemory(&vcgtHeader, sizeof(vcgtHeader));
+#if READ_EMBEDDED_WCS_PROFILE
+	SecureZeroMemory(&WCS_ColorDeviceModel, sizeof(WCS_SECTION));
+	SecureZeroMemory(&WCS_ColorAppearanceModel, sizeof(WCS_SECTION));
+	SecureZeroMemory(&WCS_GamutMapModel, sizeof(WCS_SECTION));
+#endif
+	InitializeCriticalSection(&loadLock);
 }
 
 // Destructor
 //
+// Everything LoadFullProfile() parsed lives in 'arena', which frees itself
+//
 Profile::~Profile() {
-	if (pLUT) {
-		delete [] pLUT;
-	}
-	if (pVCGT) {
-		delete [] pVCGT;
-	}
-	if (TagTable) {
-		delete [] TagTable;
-	}
-	if (sortedTags) {
-		delete [] sortedTags;
-	}
-	if (ProfileHeader) {
-		delete [] ProfileHeader;
-	}
+	DeleteCriticalSection(&loadLock);
 }
 
-// Vector of profiles
+// Vector of profiles, in the order they were added
 //
 static vector <Profile *> * mainProfileList = 0;
 
+// Index into the list by lowercased name, so that Add() and Find() don't have to walk the list
+//
+typedef stdext::hash_map <wstring, Profile *> PROFILE_INDEX;
+static PROFILE_INDEX * mainProfileIndex = 0;
+
+// Build the key for a profile name; file names are not case-sensitive, so neither are we
+//
+static wstring ProfileIndexKey(const wchar_t * profileName) {
+	wstring key(profileName);
+	if ( !key.empty() ) {
+		CharLowerBuff(&key[0], static_cast<DWORD>(key.size()));
+	}
+	return key;
+}
+
 // Add a profile to the list if it isn't already on it -- if it is already on the list,
 // delete the profile we were passed, and return a pointer to the one we found on the list.
 //
 Profile * Profile::Add(Profile * profile) {
 	if ( 0 == mainProfileList ) {
 		mainProfileList = new vector <Profile *>;
+		mainProfileIndex = new PROFILE_INDEX;
 	}
-	size_t index = mainProfileList->size();
-	for (size_t i = 0; i < index; ++i) {
-		if ( profile->ProfileName == (*mainProfileList)[i]->ProfileName ) {
-			delete profile;
-			return (*mainProfileList)[i];
-		}
+	wstring key = ProfileIndexKey(profile->ProfileName.c_str());
+	PROFILE_INDEX::iterator it = mainProfileIndex->find(key);
+	if ( it != mainProfileIndex->end() ) {
+		delete profile;
+		return it->second;
 	}
 	mainProfileList->push_back(profile);
+	(*mainProfileIndex)[key] = profile;
 	return profile;
 }
 
+// Find a profile on the list by name (file names are not case-sensitive), or return zero
+//
+Profile * Profile::Find(const wchar_t * profileName) {
+	if (mainProfileIndex) {
+		PROFILE_INDEX::iterator it = mainProfileIndex->find(ProfileIndexKey(profileName));
+		if ( it != mainProfileIndex->end() ) {
+			return it->second;
+		}
+	}
+	return 0;
+}
+
 // Clear the list of profiles
 //
 void Profile::ClearList(bool freeAllMemory) {
@@ -453,12 +495,36 @@ void Profile::ClearList(bool freeAllMemory) {
 		if (freeAllMemory) {
 			delete mainProfileList;
 			mainProfileList = 0;
+			delete mainProfileIndex;
+			mainProfileIndex = 0;
 		} else {
 			mainProfileList->clear();
+			mainProfileIndex->clear();
 		}
 	}
 }
 
+// Report how much memory the profiles on the list are using
+//
+wstring Profile::MemoryString(void) {
+	wstring s;
+	wchar_t buf[256];
+	size_t count = mainProfileList ? mainProfileList->size() : 0;
+	size_t total = 0;
+	for (size_t i = 0; i < count; ++i) {
+		total += (*mainProfileList)[i]->GetMemoryFootprint();
+	}
+	StringCbPrintf(buf, sizeof(buf), L"\r\n%-28s%12Iu\r\n", L"Profiles in memory", count);
+	s += buf;
+	StringCbPrintf(buf, sizeof(buf), L"%-28s%12Iu\r\n", L"Profile memory (bytes)", total);
+	s += buf;
+	if (count) {
+		StringCbPrintf(buf, sizeof(buf), L"%-28s%12Iu\r\n", L"Bytes per profile", total / count);
+		s += buf;
+	}
+	return s;
+}
+
 // Get profile name
 //
 wstring Profile::GetName(void) const {
@@ -477,8 +543,14 @@ DWORD Profile::GetProfileClass(void) const {
 
 // Get profile's LUT pointer (may be zero)
 //
-LUT * Profile::GetLutPointer(void) const {
-	return pLUT;
+const LUT * Profile::GetLutPointer(void) const {
+	return lutHandle.Get();
+}
+
+// Get a shared handle to profile's LUT (may be empty)
+//
+LUThandle Profile::GetLutHandle(void) const {
+	return lutHandle;
 }
 
 // Return 'true' for profiles that are unusable
@@ -496,6 +568,7 @@ bool Profile::HasEmbeddedWcsProfile(void) const {
 // Return a list of all profiles associated with a given registry key, indicating the 'default' profile from the list
 //
 Profile * Profile::GetAllProfiles(HKEY hKeyBase, const wchar_t * registryKey, bool * perUser, ProfileList & pList) {
+	TRACE_SCOPE(L"GetAllProfiles");
 	HKEY hKey;
 	int len = 0;
 	Profile * profile = 0;
@@ -549,153 +622,23 @@ Profile * Profile::GetAllProfiles(HKEY hKeyBase, const wchar_t * registryKey, bo
 // the name is then reinserted at the end of the list.
 //
 bool Profile::EditRegistryProfileList(HKEY hKeyBase, const wchar_t * registryKey, bool moveToEnd) {
-	wchar_t profileName[1024];
-	HKEY hKey = 0;
-	DWORD dataSizeFrom = 0;
-	DWORD dataSizeTo = 0;
-	DWORD dataType = REG_MULTI_SZ;
-	bool success = false;
-	StringCbCopy(profileName, sizeof(profileName), ProfileName.c_str());
-	int profileNameLength = StringLength(profileName);
-	if (ERROR_SUCCESS == RegOpenKeyEx(hKeyBase, registryKey, 0, KEY_QUERY_VALUE | KEY_SET_VALUE, &hKey)) {
-		LONG returnValue = RegQueryValueEx(hKey, L"ICMProfile", NULL, NULL, NULL, &dataSizeFrom);
-		if (ERROR_FILE_NOT_FOUND == returnValue) {	// If value does not exist, try to create it
-			BYTE noData[4] = {0, 0, 0, 0};
-			returnValue = RegSetValueEx(hKey, L"ICMProfile", NULL, REG_MULTI_SZ, noData, 0);
-		}
-		if (ERROR_SUCCESS == returnValue) {
-			dataSizeFrom += 2 * sizeof(wchar_t);
-			dataSizeTo = dataSizeFrom + (sizeof(wchar_t) * (1 + profileNameLength));
-			BYTE * fromList = reinterpret_cast<BYTE *>(malloc(dataSizeFrom));
-			if (fromList) {
-				BYTE * toList = reinterpret_cast<BYTE *>(malloc(dataSizeTo));
-				if (toList) {
-					SecureZeroMemory(fromList, dataSizeFrom);
-					RegQueryValueEx(hKey, L"ICMProfile", NULL, &dataType, fromList, &dataSizeFrom);
-					wchar_t * fromPtr = reinterpret_cast<wchar_t *>(fromList);
-					wchar_t * toPtr = reinterpret_cast<wchar_t *>(toList);
-					wchar_t * fp;
-					wchar_t * pn;
-
-					// Copy profiles that do not match the given profile name
-					//
-					while (*fromPtr) {
-						fp = fromPtr;
-						pn = profileName;
-
-						// Compare strings until we hit a difference or a NUL in either string
-						//
-						while ( *fp && *pn && (*fp == *pn) ) {
-							++pn;
-							++fp;
-						}
-						if ( *fp == *pn ) {
-
-							// The strings matched, so just skip over the source string
-							//
-							fromPtr = fp + 1;
-						} else {
-
-							// The strings did not match, so copy this one
-							//
-							while (*fromPtr) {
-								*toPtr++ = *fromPtr++;
-							}
-							++fromPtr;
-							*toPtr++ = 0;		// NUL-terminate the copied string
-						}
-					}
-
-					// If moveToEnd is false, we just removed a profile association.  If moveToEnd is true,
-					// we reinsert it at the end of the list and it becomes the new default profile.
-					//
-					if (moveToEnd) {
-
-						// We are done reading and skipping, now copy the profile name to the end
-						//
-						pn = profileName;
-						while (*pn) {
-							*toPtr++ = *pn++;
-						}
-						*toPtr++ = 0;			// NUL-terminate the copied string
-					}
-					*toPtr++ = 0;				// End string with an extra NUL
-
-					// Write the modified profile list to the registry
-					//
-					dataSizeTo = static_cast<DWORD>(reinterpret_cast<BYTE *>(toPtr) - toList);
-					success = (ERROR_SUCCESS == RegSetValueEx(hKey, L"ICMProfile", NULL, dataType, toList, dataSizeTo));
-					free(toList);
-				}
-				free(fromList);
-			}
-		}
-		RegCloseKey(hKey);
+	MultiStringEdit edit;
+	if (moveToEnd) {
+		edit.MoveToEnd(ProfileName.c_str());
+	} else {
+		edit.Remove(ProfileName.c_str());
 	}
-	return success;
+	RegistryMultiStringStore store;
+	return store.Update(RegistryKeyPath(hKeyBase, registryKey), L"ICMProfile", edit);
 }
 
 // Insert a profile name at the head of a REG_MULTI_SZ profile list in the registry
 //
 bool Profile::InsertIntoRegistryProfileList(HKEY hKeyBase, const wchar_t * registryKey) {
-	wchar_t profileName[1024];
-	HKEY hKey = 0;
-	DWORD dataSizeFrom = 0;
-	DWORD dataSizeTo = 0;
-	DWORD dataType = REG_MULTI_SZ;
-	bool success = false;
-	StringCbCopy(profileName, sizeof(profileName), ProfileName.c_str());
-	int profileNameLength = StringLength(profileName);
-	if (ERROR_SUCCESS == RegOpenKeyEx(hKeyBase, registryKey, 0, KEY_QUERY_VALUE | KEY_SET_VALUE, &hKey)) {
-		LONG returnValue = RegQueryValueEx(hKey, L"ICMProfile", NULL, NULL, NULL, &dataSizeFrom);
-		if (ERROR_FILE_NOT_FOUND == returnValue) {	// If value does not exist, try to create it
-			BYTE noData[4] = {0, 0, 0, 0};
-			returnValue = RegSetValueEx(hKey, L"ICMProfile", NULL, REG_MULTI_SZ, noData, 0);
-		}
-		if (ERROR_SUCCESS == returnValue) {
-			dataSizeFrom += 2 * sizeof(wchar_t);
-			dataSizeTo = dataSizeFrom + (sizeof(wchar_t) * (1 + profileNameLength));
-			BYTE * fromList = reinterpret_cast<BYTE *>(malloc(dataSizeFrom));
-			if (fromList) {
-				BYTE * toList = reinterpret_cast<BYTE *>(malloc(dataSizeTo));
-				if (toList) {
-					SecureZeroMemory(fromList, dataSizeFrom);
-					RegQueryValueEx(hKey, L"ICMProfile", NULL, &dataType, fromList, &dataSizeFrom);
-					wchar_t * fromPtr = reinterpret_cast<wchar_t *>(fromList);
-					wchar_t * toPtr = reinterpret_cast<wchar_t *>(toList);
-					wchar_t * pn;
-
-					// Put the given profile name at the start of the list
-					//
-					pn = profileName;
-					while (*pn) {
-						*toPtr++ = *pn++;
-					}
-					*toPtr++ = 0;			// NUL-terminate the added string
-
-					// Copy all of the original profile names
-					//
-					while (*fromPtr) {
-						while (*fromPtr) {
-							*toPtr++ = *fromPtr++;
-						}
-						++fromPtr;
-						*toPtr++ = 0;		// NUL-terminate the copied string
-					}
-					*toPtr++ = 0;			// End string with an extra NUL
-
-					// Write the modified profile list to the registry
-					//
-					dataSizeTo = static_cast<DWORD>(reinterpret_cast<BYTE *>(toPtr) - toList);
-					success = (ERROR_SUCCESS == RegSetValueEx(hKey, L"ICMProfile", NULL, dataType, toList, dataSizeTo));
-					free(toList);
-				}
-				free(fromList);
-			}
-		}
-		RegCloseKey(hKey);
-	}
-	return success;
+	MultiStringEdit edit;
+	edit.InsertAtStart(ProfileName.c_str());
+	RegistryMultiStringStore store;
+	return store.Update(RegistryKeyPath(hKeyBase, registryKey), L"ICMProfile", edit);
 }
 
 // Try to make one of the many four "character" entries in an ICC profile display well.
@@ -751,6 +694,33 @@ int ComparePtrToDWORD(const void * elem1, const void * elem2) {
 		}
 	}
 
+// Estimate the heap memory this profile is holding: the object, its parsed structures, its
+//  strings and its LUT (counted here even when a LUTview is sharing it)
+//
+size_t Profile::GetMemoryFootprint(void) const {
+	size_t bytes = sizeof(Profile) + arena.GetBytesReserved();
+	bytes += (ProfileName.capacity() + ErrorString.capacity() + ValidationFailures.capacity()) * sizeof(wchar_t);
+	if ( !lutHandle.IsEmpty() ) {
+		bytes += sizeof(LUT);
+	}
+	return bytes;
+}
+
+// Fetch the raw bytes of a tag, from memory if we kept them or from the file if we did not; a
+//  DetailsView calls this when a tag's hex dump is first expanded
+//
+bool Profile::GetRawTagBytes(int tagIndex, vector <BYTE> & tagBytes) {
+	if ( !IsLoaded() || (tagIndex < 0) || (static_cast<DWORD>(tagIndex) >= TagCount) || (0 == TagTable[tagIndex].Size) ) {
+		return false;
+	}
+	tagBytes.resize(TagTable[tagIndex].Size);
+	if ( pVCGT && (tagIndex == vcgtIndex) ) {
+		memcpy_s(&tagBytes[0], tagBytes.size(), pVCGT, TagTable[tagIndex].Size);
+		return true;
+	}
+	return ReadProfileBytes(TagTable[tagIndex].Offset, TagTable[tagIndex].Size, &tagBytes[0]);
+}
+
 // Read raw data from the profile file, return a pointer to the buffer we allocated (malloc)
 //
 bool Profile::ReadProfileBytes(DWORD offset, DWORD byteCount, BYTE * returnedBytePtr) {
@@ -765,6 +735,7 @@ bool Profile::ReadProfileBytes(DWORD offset, DWORD byteCount, BYTE * returnedByt
 	StringCbCat(filepath, sizeof(filepath), ProfileName.c_str());
 	HANDLE hFile = CreateFileW(filepath, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, 0, NULL);
 	if (INVALID_HANDLE_VALUE != hFile) {
+		CountEvent(PC_FILE_OPENS);
 		LARGE_INTEGER moveTo;
 		moveTo.LowPart = offset;
 		moveTo.HighPart = 0;
@@ -772,6 +743,7 @@ bool Profile::ReadProfileBytes(DWORD offset, DWORD byteCount, BYTE * returnedByt
 		if (bRet) {
 			DWORD cb;
 			bRet = ReadFile(hFile, returnedBytePtr, byteCount, &cb, NULL);
+			CountEvent(PC_PROFILE_BYTES_READ, cb);
 			success = (0 != bRet) && (cb == byteCount);
 		}
 		CloseHandle(hFile);
@@ -792,14 +764,208 @@ bool Profile::ReadProfileBytesFromOpenFile(HANDLE hFile, DWORD offset, DWORD byt
 	if (bRet) {
 		DWORD cb;
 		bRet = ReadFile(hFile, returnedBytePtr, byteCount, &cb, NULL);
+		CountEvent(PC_PROFILE_BYTES_READ, cb);
 		success = (0 != bRet) && (cb == byteCount);
 	}
 	return success;
 }
 
-// Load profile info from disk
+#if READ_EMBEDDED_WCS_PROFILE
+// Step to the next start tag at or after 'position' in some XML, returning its name without any
+//  namespace prefix and leaving 'position' just past the tag.  We skip end tags, comments and
+//  processing instructions and never build a tree, so finding a few values costs one pass.
+//
+static bool NextXmlStartTag(const wstring & xml, size_t & position, wstring & localName, bool & isEmptyElement) {
+	for (;;) {
+		size_t open = xml.find(L'<', position);
+		if ( wstring::npos == open ) {
+			return false;
+		}
+		if ( 0 == xml.compare(open, 4, L"<!--") ) {
+			size_t endComment = xml.find(L"-->", open + 4);
+			if ( wstring::npos == endComment ) {
+				return false;
+			}
+			position = endComment + 3;
+			continue;
+		}
+		size_t close = xml.find(L'>', open);
+		if ( wstring::npos == close ) {
+			return false;
+		}
+		position = close + 1;
+		wchar_t first = ( (open + 1) < close ) ? xml[open + 1] : L'/';
+		if ( (L'/' == first) || (L'?' == first) || (L'!' == first) ) {
+			continue;
+		}
+		size_t nameEnd = xml.find_first_of(L" \t\r\n/>", open + 1);
+		size_t colon = xml.find(L':', open + 1);
+		size_t nameStart = ( colon < nameEnd ) ? (colon + 1) : (open + 1);
+		localName = xml.substr(nameStart, nameEnd - nameStart);
+		isEmptyElement = ( L'/' == xml[close - 1] );
+		return true;
+	}
+}
+
+// Find the next element named 'localName' and return its text, up to its first child or end tag
+//
+static bool FindXmlElementText(const wstring & xml, const wchar_t * localName, size_t & position, wstring & text) {
+	wstring name;
+	bool isEmptyElement;
+	while ( NextXmlStartTag(xml, position, name, isEmptyElement) ) {
+		if ( name == localName ) {
+			text.clear();
+			if ( !isEmptyElement ) {
+				size_t end = xml.find(L'<', position);
+				text = xml.substr(position, (wstring::npos == end) ? wstring::npos : (end - position));
+			}
+			return true;
+		}
+	}
+	return false;
+}
+
+// Return the kind of device a Color Device Model describes, which is the name of its device
+//  element ("LCDDevice", "CRTDevice", "RGBVirtualDevice" and so on)
+//
+static bool FindWcsDeviceType(const wstring & xml, wstring & deviceType) {
+	const wchar_t suffix[] = L"Device";
+	const size_t suffixLength = _countof(suffix) - 1;
+	size_t position = 0;
+	wstring name;
+	bool isEmptyElement;
+	while ( NextXmlStartTag(xml, position, name, isEmptyElement) ) {
+		if ( (name.size() > suffixLength) && (0 == name.compare(name.size() - suffixLength, suffixLength, suffix)) ) {
+			deviceType = name;
+			return true;
+		}
+	}
+	return false;
+}
+
+// Read one section of the embedded WCS profile from the file, straight into 'xml'
+//
+bool Profile::ReadWcsSection(const WCS_SECTION & section, wstring & xml) {
+	xml.clear();
+	DWORD characterCount = section.Size / sizeof(wchar_t);
+	if ( 0 == characterCount ) {
+		return false;
+	}
+	xml.resize(characterCount);
+	if ( !ReadProfileBytes(section.Offset, characterCount * sizeof(wchar_t), reinterpret_cast<BYTE *>(&xml[0])) ) {
+		xml.clear();
+		return false;
+	}
+	size_t nul = xml.find(L'\0');
+	if ( wstring::npos != nul ) {
+		xml.resize(nul);
+	}
+	if ( !xml.empty() && (0xFEFF == xml[0]) ) {
+		xml.erase(0, 1);
+	}
+	return !xml.empty();
+}
+#endif
+
+// Load profile info from disk, unless it is already loaded
+//
+// ProfileLoader calls this on its worker thread, so the parse runs under 'loadLock'.  Until
+//  IsLoaded() says 'true', other threads must not look at anything the parse sets up.
 //
 wstring Profile::LoadFullProfile(bool forceReload) {
+	EnterCriticalSection(&loadLock);
+	if (reloadNeeded) {
+		forceReload = true;
+		reloadNeeded = false;
+	}
+	if (forceReload) {
+		InterlockedExchange(&loadComplete, 0);
+	}
+	wstring s = ParseProfile(forceReload);
+	InterlockedExchange(&loadComplete, 1);
+	LeaveCriticalSection(&loadLock);
+	return s;
+}
+
+// Note that the file has changed on disk, so the next LoadFullProfile() parses it again
+//
+void Profile::Invalidate(void) {
+	EnterCriticalSection(&loadLock);
+	if (loaded) {
+		reloadNeeded = true;
+		InterlockedExchange(&loadComplete, 0);
+	}
+	LeaveCriticalSection(&loadLock);
+}
+
+// Read just the header and tag table, for an index of the color directory:  the profile class,
+//  and whether there are 'vcgt' and 'MS00' tags.  Nothing is kept.  We check the 'acsp' signature
+//  and that the header's size fits in the file, so that files that are not profiles at all stay
+//  out of the index; LoadFullProfile() does the real parse and validation later.
+//
+bool Profile::ReadTagSummary(DWORD & profileClass, bool & hasVCGT, bool & hasWCS) {
+	profileClass = 0;
+	hasVCGT = false;
+	hasWCS = false;
+	if ( (0 == ColorDirectory) || ProfileName.empty() ) {
+		return false;
+	}
+	wchar_t filepath[1024];
+	StringCbCopy(filepath, sizeof(filepath), ColorDirectory);
+	StringCbCat(filepath, sizeof(filepath), L"\\");
+	StringCbCat(filepath, sizeof(filepath), ProfileName.c_str());
+	HANDLE hFile = CreateFileW(filepath, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, 0, NULL);
+	if (INVALID_HANDLE_VALUE == hFile) {
+		return false;
+	}
+	CountEvent(PC_FILE_OPENS);
+
+	bool success = false;
+	LARGE_INTEGER fileSize;
+	PROFILEHEADER header;
+	BigEndian <DWORD> diskTagCount;
+	if ( GetFileSizeEx(hFile, &fileSize)
+			&& (fileSize.QuadPart >= static_cast<LONGLONG>(sizeof(PROFILEHEADER) + sizeof(DWORD)))
+			&& ReadProfileBytesFromOpenFile(hFile, 0, sizeof(header), reinterpret_cast<BYTE *>(&header))
+			&& ReadProfileBytesFromOpenFile(hFile, sizeof(header), sizeof(diskTagCount), reinterpret_cast<BYTE *>(&diskTagCount)) ) {
+		DWORD tagCount = diskTagCount.Get();
+		DWORD tableSize = tagCount * sizeof(EXTERNAL_TAG_TABLE_ENTRY);
+		DWORD claimedSize = swap32(header.phSize);
+		if ( ('acsp' == swap32(header.phSignature))
+				&& (claimedSize >= sizeof(PROFILEHEADER) + sizeof(DWORD))
+				&& (static_cast<LONGLONG>(claimedSize) <= fileSize.QuadPart)
+				&& (tagCount <= 1024)
+				&& (static_cast<LONGLONG>(sizeof(PROFILEHEADER) + sizeof(DWORD) + tableSize) <= fileSize.QuadPart) ) {
+			vector <EXTERNAL_TAG_TABLE_ENTRY> tagTable(tagCount);
+			if ( (0 == tagCount)
+					|| ReadProfileBytesFromOpenFile(hFile, sizeof(header) + sizeof(DWORD), tableSize, reinterpret_cast<BYTE *>(&tagTable[0])) ) {
+				profileClass = swap32(header.phClass);
+				for (DWORD i = 0; i < tagCount; ++i) {
+					DWORD signature = tagTable[i].Signature.Get();
+					if ('vcgt' == signature) {
+						hasVCGT = true;
+					}
+					if ('MS00' == signature) {
+						hasWCS = true;
+					}
+				}
+				success = true;
+			}
+		}
+	}
+	CloseHandle(hFile);
+	return success;
+}
+
+// Return 'true' once LoadFullProfile() has finished with this profile
+//
+bool Profile::IsLoaded(void) const {
+	return ( 0 != loadComplete );
+}
+
+// Parse the profile file (called by LoadFullProfile(), holding 'loadLock')
+//
+wstring Profile::ParseProfile(bool forceReload) {
 
 	wstring s;
 	wchar_t buf[1024];
@@ -817,13 +983,16 @@ wstring Profile::LoadFullProfile(bool forceReload) {
 	// Don't load twice unless requested to do so
 	//
 	if (loaded && !forceReload) {
+		CountEvent(PC_PROFILE_LOADS_CACHED);
 		return ErrorString;
 	}
+	TRACE_SCOPE_DETAIL(L"LoadFullProfile", ProfileName.c_str());
 
 	// If we got this far, we'll set the 'loaded' flag ... its purpose is to
 	// prevent duplicate work, not as a 'success' indication
 	//
 	loaded = true;
+	CountEvent(PC_PROFILES_PARSED);
 
 	// Also, if this is not the first time here (i.e. 'forceReload' is true),
 	// then we need to clean up from prior passes ... releasing memory, for example
@@ -833,34 +1002,20 @@ wstring Profile::LoadFullProfile(bool forceReload) {
 		ErrorString.clear();
 		ValidationFailures.clear();
 		ProfileSize.QuadPart = 0;
-		if (ProfileHeader) {
-			delete [] ProfileHeader;
-			ProfileHeader = 0;
-		}
+		ProfileHeader = 0;
 		TagCount = 0;
-		if (TagTable) {
-			delete [] TagTable;
-			TagTable = 0;
-		}
-		if (sortedTags) {
-			delete [] sortedTags;
-			sortedTags = 0;
-		}
+		TagTable = 0;
+		sortedTags = 0;
 		vcgtIndex = -1;
-		if (pVCGT) {
-			delete [] pVCGT;
-			pVCGT = 0;
-		}
+		pVCGT = 0;
+		arena.Reset();
 		SecureZeroMemory(&vcgtHeader, sizeof(VCGT_HEADER));
-		if (pLUT) {
-			delete [] pLUT;
-			pLUT = 0;
-		}
+		lutHandle.Reset();
 		wcsProfileIndex = -1;
 #if READ_EMBEDDED_WCS_PROFILE
-		WCS_ColorDeviceModel.clear();
-		WCS_ColorAppearanceModel.clear();
-		WCS_GamutMapModel.clear();
+		SecureZeroMemory(&WCS_ColorDeviceModel, sizeof(WCS_SECTION));
+		SecureZeroMemory(&WCS_ColorAppearanceModel, sizeof(WCS_SECTION));
+		SecureZeroMemory(&WCS_GamutMapModel, sizeof(WCS_SECTION));
 #endif
 	}
 
@@ -897,6 +1052,7 @@ wstring Profile::LoadFullProfile(bool forceReload) {
 		ErrorString += ShowError(L"CreateFile", 0, message.c_str());
 		return ErrorString;
 	}
+	CountEvent(PC_FILE_OPENS);
 
 	// Get file size
 	//
@@ -931,10 +1087,10 @@ wstring Profile::LoadFullProfile(bool forceReload) {
 
 	// Read the profile header
 	//
-	ProfileHeader = new PROFILEHEADER;
-	SecureZeroMemory(ProfileHeader, sizeof(PROFILEHEADER));
+	ProfileHeader = arena.AllocateArray<PROFILEHEADER>(1);
 	DWORD cb = 0;
 	bRet = ReadFile(hFile, ProfileHeader, sizeof(PROFILEHEADER), &cb, NULL);
+	CountEvent(PC_PROFILE_BYTES_READ, cb);
 	if ( 0 == bRet ) {
 		failed = true;
 		wstring message = L"Cannot read header of profile file \"";
@@ -1042,32 +1198,25 @@ wstring Profile::LoadFullProfile(bool forceReload) {
 
 	// The timestamp should pass a few tests
 	//
-	dateTimeNumber * dt = reinterpret_cast<dateTimeNumber *>(&ProfileHeader->phDateTime[0]);
-	dateTimeNumber dateTime;
-	dateTime.year   = swap16(dt->year);
-	dateTime.month  = swap16(dt->month);
-	dateTime.day    = swap16(dt->day);
-	dateTime.hour   = swap16(dt->hour);
-	dateTime.minute = swap16(dt->minute);
-	dateTime.second = swap16(dt->second);
-	if ( (dateTime.year < 1990) || (dateTime.year > 2111) ||
-		 (dateTime.month > 12) ||
-		 (dateTime.day > 31) ||
-		 (dateTime.hour > 24) ||
-		 (dateTime.minute > 60) ||
-		 (dateTime.second > 60)
+	const dateTimeNumber * dt = reinterpret_cast<const dateTimeNumber *>(&ProfileHeader->phDateTime[0]);
+	if ( (dt->year.Get() < 1990) || (dt->year.Get() > 2111) ||
+		 (dt->month.Get() > 12) ||
+		 (dt->day.Get() > 31) ||
+		 (dt->hour.Get() > 24) ||
+		 (dt->minute.Get() > 60) ||
+		 (dt->second.Get() > 60)
 	) {
 		StringCchPrintf(
 			buf,
 			_countof(buf),
 			L"The profile's date and time of first creation are unreasonable.\r\n"
 			L"The timestamp is reported as %04d-%02d-%02d %02d:%02d:%02dZ.\r\n\r\n", // RFC3389, NOTE: in 5.6
-			dateTime.year,
-			dateTime.month,
-			dateTime.day,
-			dateTime.hour,
-			dateTime.minute,
-			dateTime.second );
+			dt->year.Get(),
+			dt->month.Get(),
+			dt->day.Get(),
+			dt->hour.Get(),
+			dt->minute.Get(),
+			dt->second.Get() );
 		ValidationFailures += buf;
 	}
 
@@ -1149,9 +1298,10 @@ wstring Profile::LoadFullProfile(bool forceReload) {
 	// format used by the CIEXYZ fields.  I also allow some fudge factor since they only need to
 	// be right to four digits (1 part in 10000, not 1 in 65536).
 	//
-	long X = swap32(ProfileHeader->phIlluminant.ciexyzX);
-	long Y = swap32(ProfileHeader->phIlluminant.ciexyzY);
-	long Z = swap32(ProfileHeader->phIlluminant.ciexyzZ);
+	const BIG_ENDIAN_XYZ * illuminant = reinterpret_cast<const BIG_ENDIAN_XYZ *>(&ProfileHeader->phIlluminant);
+	long X = illuminant->X.Get();
+	long Y = illuminant->Y.Get();
+	long Z = illuminant->Z.Get();
 	if ( (X < 0x0F6D3) || (X > 0x0F6D9) ||
 		 (Y < 0x0FFFC) || (Y > 0x10003) ||
 		 (Z < 0x0D329) || (Z > 0x0D32F) ) {
@@ -1203,9 +1353,11 @@ wstring Profile::LoadFullProfile(bool forceReload) {
 
 	// Read the tag count
 	//
-	DWORD testTagCount = 0;
-	bRet = ReadFile(hFile, &testTagCount, sizeof(testTagCount), &cb, NULL);
-	if ( (0 == bRet) || (cb != sizeof(testTagCount) ) ) {
+	BigEndian <DWORD> diskTagCount;
+	diskTagCount.Set(0);
+	bRet = ReadFile(hFile, &diskTagCount, sizeof(diskTagCount), &cb, NULL);
+	CountEvent(PC_PROFILE_BYTES_READ, cb);
+	if ( (0 == bRet) || (cb != sizeof(diskTagCount) ) ) {
 		failed = true;
 		wstring message = L"Cannot read tag count from profile file \"";
 		message += filepath;
@@ -1218,7 +1370,7 @@ wstring Profile::LoadFullProfile(bool forceReload) {
 
 	// Do a little sanity checking on the proposed tag count.  Be generous.
 	//
-	testTagCount = swap32(testTagCount);
+	DWORD testTagCount = diskTagCount.Get();
 	if (testTagCount > 1024) {
 		failed = true;
 		wstring message = L"The tag count in profile file \"";
@@ -1257,12 +1409,11 @@ wstring Profile::LoadFullProfile(bool forceReload) {
 	// The tag count seems reasonable, so read the tag table (directory)
 	//
 	TagCount = testTagCount;
-	EXTERNAL_TAG_TABLE_ENTRY * diskTagTable = new EXTERNAL_TAG_TABLE_ENTRY[TagCount];
+	EXTERNAL_TAG_TABLE_ENTRY * diskTagTable = arena.AllocateArray<EXTERNAL_TAG_TABLE_ENTRY>(TagCount);
 	DWORD tagTableByteCount = TagCount * sizeof(EXTERNAL_TAG_TABLE_ENTRY);
-	SecureZeroMemory(diskTagTable, tagTableByteCount);
 	bRet = ReadFile(hFile, diskTagTable, tagTableByteCount, &cb, NULL);
+	CountEvent(PC_PROFILE_BYTES_READ, cb);
 	if ( (0 == bRet) || (cb != tagTableByteCount ) ) {
-		delete [] diskTagTable;
 		failed = true;
 		wstring message = L"Cannot read tag table (directory) from profile file \"";
 		message += filepath;
@@ -1275,18 +1426,18 @@ wstring Profile::LoadFullProfile(bool forceReload) {
 
 	// Store our version of the tag table in little-endian format
 	//
-	TagTable = new TAG_TABLE_ENTRY[TagCount];
+	TagTable = arena.AllocateArray<TAG_TABLE_ENTRY>(TagCount);
 	tagTableByteCount = TagCount * sizeof(TAG_TABLE_ENTRY);
 	for (size_t i = 0; i < TagCount; ++i) {
-		TagTable[i].Signature = swap32(diskTagTable[i].Signature);
-		TagTable[i].Offset = swap32(diskTagTable[i].Offset);
-		TagTable[i].Size = swap32(diskTagTable[i].Size);
+		TagTable[i].Signature = diskTagTable[i].Signature.Get();
+		TagTable[i].Offset = diskTagTable[i].Offset.Get();
+		TagTable[i].Size = diskTagTable[i].Size.Get();
 		TagTable[i].Type = 0;
 	}
 
-	// Free the memory used by the copy of the external tag table
+	// The copy of the external tag table stays in the arena until the next reload; it is
+	//  smaller than the allocation it would cost to free it separately
 	//
-	delete [] diskTagTable;
 	diskTagTable = 0;
 
 	// Sanity test every tag table entry
@@ -1327,14 +1478,15 @@ wstring Profile::LoadFullProfile(bool forceReload) {
 	// Every tag fits inside the profile (no bad offsets or sizes), so fetch the tag types
 	//
 	for (size_t i = 0; i < TagCount; ++i) {
-		DWORD tagType;
+		BigEndian <DWORD> tagType;
+		tagType.Set(0);
 		ReadProfileBytesFromOpenFile(hFile, TagTable[i].Offset, sizeof(tagType), reinterpret_cast<BYTE *>(&tagType));
-		TagTable[i].Type = swap32(tagType);
+		TagTable[i].Type = tagType.Get();
 	}
 
 	// Generate a sort order for the tags
 	//
-	sortedTags = new DWORD * [TagCount];
+	sortedTags = arena.AllocateArray<DWORD *>(TagCount);
 	for (size_t i = 0; i < TagCount; ++i) {
 		sortedTags[i] = &TagTable[i].Signature;
 	}
@@ -1357,8 +1509,29 @@ wstring Profile::LoadFullProfile(bool forceReload) {
 			ErrorString += ValidationFailures;
 			return ErrorString;
 		}
-		pVCGT = reinterpret_cast<VCGT_HEADER *>(new BYTE[TagTable[vcgtIndex].Size]);
-		bRet = ReadFile(hFile, pVCGT, TagTable[vcgtIndex].Size, &cb, NULL);
+
+		// In a compact build, the raw tag is read into a buffer that goes away once we have
+		//  decoded it; GetRawTagBytes() reads it again from the file if it ever needs it.  A
+		//  standard table fits in a buffer on the stack, so only odd, oversized tags cost a heap
+		//  allocation on top of the arena's.
+		//
+#if COMPACT_PROFILES
+		ULONGLONG vcgtStackBuffer[VCGT_STACK_BUFFER_SIZE / sizeof(ULONGLONG)];
+		vector <BYTE> vcgtHeapBuffer;
+		VCGT_HEADER * rawVCGT = reinterpret_cast<VCGT_HEADER *>(vcgtStackBuffer);
+		if ( TagTable[vcgtIndex].Size > sizeof(vcgtStackBuffer) ) {
+			vcgtHeapBuffer.resize(TagTable[vcgtIndex].Size);
+			rawVCGT = reinterpret_cast<VCGT_HEADER *>(&vcgtHeapBuffer[0]);
+			CountEvent(PC_PARSE_HEAP_BUFFERS);
+		} else {
+			SecureZeroMemory(rawVCGT, sizeof(VCGT_HEADER));		// In case the tag is too small for one
+		}
+#else
+		pVCGT = reinterpret_cast<VCGT_HEADER *>(arena.Allocate(TagTable[vcgtIndex].Size));
+		VCGT_HEADER * rawVCGT = pVCGT;
+#endif
+		bRet = ReadFile(hFile, rawVCGT, TagTable[vcgtIndex].Size, &cb, NULL);
+		CountEvent(PC_PROFILE_BYTES_READ, cb);
 		if ( 0 == bRet ) {
 			failed = true;
 			wstring message = L"Cannot read 'vcgt' tag from profile file \"";
@@ -1369,13 +1542,13 @@ wstring Profile::LoadFullProfile(bool forceReload) {
 			ErrorString += ValidationFailures;
 			return ErrorString;
 		}
-		vcgtHeader.vcgtSignature = swap32(pVCGT->vcgtSignature);
-		vcgtHeader.vcgtReserved = swap32(pVCGT->vcgtReserved);
-		vcgtHeader.vcgtType = static_cast<VCGT_TYPE>(swap32(pVCGT->vcgtType));
+		vcgtHeader.vcgtSignature = swap32(rawVCGT->vcgtSignature);
+		vcgtHeader.vcgtReserved = swap32(rawVCGT->vcgtReserved);
+		vcgtHeader.vcgtType = static_cast<VCGT_TYPE>(swap32(rawVCGT->vcgtType));
 		if (VCGT_TYPE_TABLE == vcgtHeader.vcgtType) {
-			vcgtHeader.vcgtContents.t.vcgtChannels = swap16(pVCGT->vcgtContents.t.vcgtChannels);
-			vcgtHeader.vcgtContents.t.vcgtCount = swap16(pVCGT->vcgtContents.t.vcgtCount);
-			vcgtHeader.vcgtContents.t.vcgtItemSize = swap16(pVCGT->vcgtContents.t.vcgtItemSize);
+			vcgtHeader.vcgtContents.t.vcgtChannels = swap16(rawVCGT->vcgtContents.t.vcgtChannels);
+			vcgtHeader.vcgtContents.t.vcgtCount = swap16(rawVCGT->vcgtContents.t.vcgtCount);
+			vcgtHeader.vcgtContents.t.vcgtItemSize = swap16(rawVCGT->vcgtContents.t.vcgtItemSize);
 
 			// Sanity test the vcgt table
 			//
@@ -1427,9 +1600,13 @@ wstring Profile::LoadFullProfile(bool forceReload) {
 				ErrorString += ValidationFailures;
 				return ErrorString;
 			}
+			// The table data starts after the 18 byte header (signature, reserved, type, channels,
+			//  count and item size), so that is what has to fit in the tag along with the data
+			//
+			const DWORD tableHeaderSize = static_cast<DWORD>(offsetof(VCGT_HEADER, vcgtContents.t.vcgtData));
 			DWORD testSize = vcgtHeader.vcgtContents.t.vcgtChannels *
 							vcgtHeader.vcgtContents.t.vcgtCount *
-							vcgtHeader.vcgtContents.t.vcgtItemSize + 12;
+							vcgtHeader.vcgtContents.t.vcgtItemSize + tableHeaderSize;
 			if ( testSize > TagTable[vcgtIndex].Size ) {
 				failed = true;
 				wstring message = L"File \"";
@@ -1461,37 +1638,26 @@ wstring Profile::LoadFullProfile(bool forceReload) {
 			// per-entry table it really is.  Sigh ...
 			//
 
-			// Start out assuming that the header is correct ... tables that say they are
-			// 1 byte-per-entry really are.
+			// Create a byte-swapped copy of the profile's LUT.  Start out assuming that the header is
+			// correct ... tables that say they are 1 byte-per-entry really are.
 			//
+			LUT newLUT;
+			const BYTE * tableItems = &rawVCGT->vcgtContents.t.vcgtData[0];
 			bool treatAsTwoByteTable = (2 == vcgtHeader.vcgtContents.t.vcgtItemSize);
-
-			if ( !treatAsTwoByteTable ) {
+			if (treatAsTwoByteTable) {
+				VcgtDecoder<2>::Decode(tableItems, newLUT.red);
+			} else {
 
 				// Detect bad Adobe Gamma-style 'vcgt' table.  Is the size on disk twice what it needs to be?
 				//
-				DWORD testSize2 = vcgtHeader.vcgtContents.t.vcgtChannels * vcgtHeader.vcgtContents.t.vcgtCount * 2 + 12;
+				DWORD testSize2 = vcgtHeader.vcgtContents.t.vcgtChannels * vcgtHeader.vcgtContents.t.vcgtCount * 2 + tableHeaderSize;
 				if ( testSize2 <= TagTable[vcgtIndex].Size ) {
 
-					// Yes, there is room in the 'vcgt' for a 2 byte-per-entry table.  Is every other entry zero?
+					// Yes, there is room in the 'vcgt' for a 2 byte-per-entry table.  Decode it that way,
+					// and see if every other byte (the low byte of every entry) was zero.
 					//
-					foundNonZero = false;
-					LUT * testLUT = reinterpret_cast<LUT *>(&pVCGT->vcgtContents.t.vcgtData[0]);
-					for (size_t i = 0; i < 256; ++i) {
-						if ( 0 != (testLUT->red[i] & 0xFF00) ) {
-							foundNonZero = true;
-							break;
-						}
-						if ( 0 != (testLUT->green[i] & 0xFF00) ) {
-							foundNonZero = true;
-							break;
-						}
-						if ( 0 != (testLUT->blue[i] & 0xFF00) ) {
-							foundNonZero = true;
-							break;
-						}
-					}
-					if ( false == foundNonZero ) {
+					WORD allBits = VcgtDecoder<2>::Decode(tableItems, newLUT.red);
+					if ( 0 == (allBits & 0x00FF) ) {
 
 						// We have a winner!  This is really a 2 byte table mislabeled as a 1 byte table.
 						//
@@ -1504,60 +1670,30 @@ wstring Profile::LoadFullProfile(bool forceReload) {
 								L"problems with other LUT loaders.\r\n\r\n";
 					}
 				}
-			}
-
-			// Create a byte-swapped copy of the profile's LUT
-			//
-			pLUT = new LUT;
-			SecureZeroMemory(pLUT, sizeof(LUT));
-			if (treatAsTwoByteTable) {
-
-				// This is the normal case, matching LUT formats except for byte order
-				//
-				LUT * profileLUT = reinterpret_cast<LUT *>(&pVCGT->vcgtContents.t.vcgtData[0]);
-				for (size_t i = 0; i < 256; ++i) {
-					pLUT->red[i] = swap16(profileLUT->red[i]);
-					pLUT->green[i] = swap16(profileLUT->green[i]);
-					pLUT->blue[i] = swap16(profileLUT->blue[i]);
-				}
-			} else {
 
-				// This is the odd case, where we create a 2-byte LUT entry from a 1-byte entry.  We could either
-				//  just stuff the byte into the high-order byte (e.g. 0x56 => 0x5600) or we could distribute
-				//  the values better by putting the byte into both halves (e.g. 0x56 => 0x5656).
+				// This is the odd case, where we create a 2-byte LUT entry from a 1-byte entry
 				//
-				LUT_1_BYTE * profileLUT = reinterpret_cast<LUT_1_BYTE *>(&pVCGT->vcgtContents.t.vcgtData[0]);
-				for (size_t i = 0; i < 256; ++i) {
-
-#define USE_BOTH_HALVES 1
-#if USE_BOTH_HALVES
-					pLUT->red[i] = (static_cast<WORD>(profileLUT->red[i]) << 8) + profileLUT->red[i];
-					pLUT->green[i] = (static_cast<WORD>(profileLUT->green[i]) << 8) + profileLUT->green[i];
-					pLUT->blue[i] = (static_cast<WORD>(profileLUT->blue[i]) << 8) + profileLUT->blue[i];
-#else
-					pLUT->red[i] = (static_cast<WORD>(profileLUT->red[i]) << 8);
-					pLUT->green[i] = (static_cast<WORD>(profileLUT->green[i]) << 8);
-					pLUT->blue[i] = (static_cast<WORD>(profileLUT->blue[i]) << 8);
-#endif
-
+				if ( !treatAsTwoByteTable ) {
+					VcgtDecoder<1>::Decode(tableItems, newLUT.red);
 				}
 			}
+			lutHandle = LUThandle(newLUT);
 		} else {
 
 			// We have a formula type of 'vcgt', but we work mainly with tables, so store whatever
 			// is there, then see if we can generate a table from it
 			//
-			vcgtHeader.vcgtContents.f.vcgtRedGamma = swap32(pVCGT->vcgtContents.f.vcgtRedGamma);
-			vcgtHeader.vcgtContents.f.vcgtRedMin = swap32(pVCGT->vcgtContents.f.vcgtRedMin);
-			vcgtHeader.vcgtContents.f.vcgtRedMax = swap32(pVCGT->vcgtContents.f.vcgtRedMax);
+			vcgtHeader.vcgtContents.f.vcgtRedGamma = swap32(rawVCGT->vcgtContents.f.vcgtRedGamma);
+			vcgtHeader.vcgtContents.f.vcgtRedMin = swap32(rawVCGT->vcgtContents.f.vcgtRedMin);
+			vcgtHeader.vcgtContents.f.vcgtRedMax = swap32(rawVCGT->vcgtContents.f.vcgtRedMax);
 
-			vcgtHeader.vcgtContents.f.vcgtGreenGamma = swap32(pVCGT->vcgtContents.f.vcgtGreenGamma);
-			vcgtHeader.vcgtContents.f.vcgtGreenMin = swap32(pVCGT->vcgtContents.f.vcgtGreenMin);
-			vcgtHeader.vcgtContents.f.vcgtGreenMax = swap32(pVCGT->vcgtContents.f.vcgtGreenMax);
+			vcgtHeader.vcgtContents.f.vcgtGreenGamma = swap32(rawVCGT->vcgtContents.f.vcgtGreenGamma);
+			vcgtHeader.vcgtContents.f.vcgtGreenMin = swap32(rawVCGT->vcgtContents.f.vcgtGreenMin);
+			vcgtHeader.vcgtContents.f.vcgtGreenMax = swap32(rawVCGT->vcgtContents.f.vcgtGreenMax);
 
-			vcgtHeader.vcgtContents.f.vcgtBlueGamma = swap32(pVCGT->vcgtContents.f.vcgtBlueGamma);
-			vcgtHeader.vcgtContents.f.vcgtBlueMin = swap32(pVCGT->vcgtContents.f.vcgtBlueMin);
-			vcgtHeader.vcgtContents.f.vcgtBlueMax = swap32(pVCGT->vcgtContents.f.vcgtBlueMax);
+			vcgtHeader.vcgtContents.f.vcgtBlueGamma = swap32(rawVCGT->vcgtContents.f.vcgtBlueGamma);
+			vcgtHeader.vcgtContents.f.vcgtBlueMin = swap32(rawVCGT->vcgtContents.f.vcgtBlueMin);
+			vcgtHeader.vcgtContents.f.vcgtBlueMax = swap32(rawVCGT->vcgtContents.f.vcgtBlueMax);
 
 			// If the values look good, generate a LUT from the gamma formula
 			//
@@ -1595,8 +1731,8 @@ wstring Profile::LoadFullProfile(bool forceReload) {
 					blueMax <= 1.0			&& blueMax >= MIN_FINISH	&&
 					blueMin < blueMax
 			) {
-				pLUT = new LUT;
-				SecureZeroMemory(pLUT, sizeof(LUT));
+				LUT newLUT;
+				SecureZeroMemory(&newLUT, sizeof(newLUT));
 				double redScale = redMax - redMin;
 				double greenScale = greenMax - greenMin;
 				double blueScale = blueMax - blueMin;
@@ -1607,90 +1743,76 @@ wstring Profile::LoadFullProfile(bool forceReload) {
 				for ( size_t i = 0; i < 256; ++i ) {
 					result = static_cast<int>( double(65536) * (redMin + redScale * pow( (double(i)/double(255)), redGamma)) );
 					if ( result < 0x0000 ) {
-						pLUT->red[i] = 0x0000;
+						newLUT.red[i] = 0x0000;
 					} else if ( result > 0xFFFF ) {
-						pLUT->red[i] = 0xFFFF;
+						newLUT.red[i] = 0xFFFF;
 					} else {
-						pLUT->red[i] = static_cast<WORD>(result);
+						newLUT.red[i] = static_cast<WORD>(result);
 					}
 
 					result = static_cast<int>( double(65536) * (greenMin + greenScale * pow( (double(i)/double(255)), greenGamma)) );
 					if ( result < 0x0000 ) {
-						pLUT->green[i] = 0;
+						newLUT.green[i] = 0;
 					} else if ( result > 0xFFFF ) {
-						pLUT->green[i] = 0xFFFF;
+						newLUT.green[i] = 0xFFFF;
 					} else {
-						pLUT->green[i] = static_cast<WORD>(result);
+						newLUT.green[i] = static_cast<WORD>(result);
 					}
 
 					result = static_cast<int>( double(65536) * (blueMin + blueScale * pow( (double(i)/double(255)), blueGamma)) );
 					if ( result < 0x0000 ) {
-						pLUT->blue[i] = 0;
+						newLUT.blue[i] = 0;
 					} else if ( result > 0xFFFF ) {
-						pLUT->blue[i] = 0xFFFF;
+						newLUT.blue[i] = 0xFFFF;
 					} else {
-						pLUT->blue[i] = static_cast<WORD>(result);
+						newLUT.blue[i] = static_cast<WORD>(result);
 					}
 				}
+				lutHandle = LUThandle(newLUT);
 			}
 		}
 	}
 
 #if READ_EMBEDDED_WCS_PROFILE
-	if (-1 != wcsProfileIndex) {
-		moveTo.LowPart = TagTable[wcsProfileIndex].Offset;
-		moveTo.HighPart = 0;
-		bRet = SetFilePointerEx(hFile, moveTo, NULL, FILE_BEGIN);
-		if ( 0 == bRet ) {
-			failed = true;
-			wstring message = L"Cannot read 'MS00' tag from profile file \"";
-			message += filepath;
-			message += L"\".\r\n\r\n";
-			ErrorString += ShowError(L"SetFilePointerEx", 0, message.c_str());
-			CloseHandle(hFile);
-			ErrorString += ValidationFailures;
-			return ErrorString;
-		}
-		BYTE * bigBuffer = new BYTE[TagTable[wcsProfileIndex].Size];
-		bRet = ReadFile(hFile, bigBuffer, TagTable[wcsProfileIndex].Size, &cb, NULL);
-		if (bRet) {
-			WCS_IN_ICC_HEADER * wiPtr = reinterpret_cast<WCS_IN_ICC_HEADER *>(bigBuffer);
-			DWORD siz;
-
-			// A WCS profile embedded in an ICC profile is a set of three little-endian Unicode (UCS2)
-			// XML "files" strung together, with a header that says how to find individual sections.
-			// The three sections are:
-			//   1) Color Device Model;
-			//   2) Color Appearance Model;
-			//   3) Gamut Map Model
-			//
-			wchar_t * cString;
-
-			siz = swap32(wiPtr->wcshdrCDMsize) / 2;
-			cString = new wchar_t[siz + 1];
-			memcpy_s(cString, 2 * siz + sizeof(wchar_t), &bigBuffer[swap32(wiPtr->wcshdrCDMoffset)], 2 * siz + sizeof(wchar_t));
-			cString[siz] = 0;
-			WCS_ColorDeviceModel = cString;
-			delete [] cString;
-
-			siz = swap32(wiPtr->wcshdrCAMsize) / 2;
-			cString = new wchar_t[siz + 1];
-			memcpy_s(cString, 2 * siz + sizeof(wchar_t), &bigBuffer[swap32(wiPtr->wcshdrCAMoffset)], 2 * siz + sizeof(wchar_t));
-			cString[siz] = 0;
-			WCS_ColorAppearanceModel = cString;
-			delete [] cString;
-
-			siz = swap32(wiPtr->wcshdrGMMsize) / 2;
-			cString = new wchar_t[siz + 1];
-			memcpy_s(cString, 2 * siz + sizeof(wchar_t), &bigBuffer[swap32(wiPtr->wcshdrGMMoffset)], 2 * siz + sizeof(wchar_t));
-			cString[siz] = 0;
-			WCS_GamutMapModel = cString;
-			delete [] cString;
-
+	// A WCS profile embedded in an ICC profile is a set of three little-endian Unicode (UCS2)
+	// XML "files" strung together, with a header that says how to find individual sections.
+	// The three sections are:
+	//   1) Color Device Model;
+	//   2) Color Appearance Model;
+	//   3) Gamut Map Model
+	//
+	// We read only the header here and note where each section is; DetailsString() reads a
+	//  section from the file when it is shown, so a hybrid profile loads as fast as any other.
+	//
+	if ( (-1 != wcsProfileIndex) && (TagTable[wcsProfileIndex].Size >= sizeof(WCS_IN_ICC_HEADER)) ) {
+		WCS_IN_ICC_HEADER wcsHeader;
+		if ( ReadProfileBytesFromOpenFile(hFile, TagTable[wcsProfileIndex].Offset, sizeof(wcsHeader), reinterpret_cast<BYTE *>(&wcsHeader)) ) {
+			const DWORD tagOffset = TagTable[wcsProfileIndex].Offset;
+			const DWORD tagSize = TagTable[wcsProfileIndex].Size;
+			const DWORD sectionOffsets[3] = {
+				swap32(wcsHeader.wcshdrCDMoffset),
+				swap32(wcsHeader.wcshdrCAMoffset),
+				swap32(wcsHeader.wcshdrGMMoffset)
+			};
+			const DWORD sectionSizes[3] = {
+				swap32(wcsHeader.wcshdrCDMsize),
+				swap32(wcsHeader.wcshdrCAMsize),
+				swap32(wcsHeader.wcshdrGMMsize)
+			};
+			WCS_SECTION * sections[3] = {
+				&WCS_ColorDeviceModel,
+				&WCS_ColorAppearanceModel,
+				&WCS_GamutMapModel
+			};
+			for (size_t i = 0; i < _countof(sections); ++i) {
+				if ( (sectionOffsets[i] <= tagSize) && (sectionSizes[i] <= (tagSize - sectionOffsets[i])) ) {
+					sections[i]->Offset = tagOffset + sectionOffsets[i];
+					sections[i]->Size = sectionSizes[i];
+				}
+			}
 		} else {
 			s += ShowError(L"ReadFile");
 		}
-		delete [] bigBuffer;
 	}
 #endif
 
@@ -1788,7 +1910,7 @@ bool Profile::ShowShortTagContents(TAG_TABLE_ENTRY * tagEntry, wstring & outputT
 					descTagStruct = reinterpret_cast<descType *>(bytePtr);
 #define INCLUDE_VALIDATION_COMPLAINT 0
 #if INCLUDE_VALIDATION_COMPLAINT
-					DWORD asciiCount = swap32(descTagStruct->AsciiLength);
+					DWORD asciiCount = descTagStruct->AsciiLength.Get();
 #endif
 					wchar_t * wideString;
 					if (AnsiToUnicode(descTagStruct->Text, wideString)) {
@@ -1839,8 +1961,8 @@ bool Profile::ShowShortTagContents(TAG_TABLE_ENTRY * tagEntry, wstring & outputT
 					// Walk through the list (probably just one entry, but we'll try anyway) and see if we can find
 					// our current language and country in the table
 					//
-					size_t entryCount = swap32(mlucTagStruct->EntryCount);
-					size_t entrySize = swap32(mlucTagStruct->EntrySize);
+					size_t entryCount = mlucTagStruct->EntryCount.Get();
+					size_t entrySize = mlucTagStruct->EntrySize.Get();
 					mlucEntryPtr = &mlucTagStruct->Entries[0];
 					bool foundIt = false;
 					for (size_t i = 0; i < entryCount; ++i ) {
@@ -1882,8 +2004,8 @@ bool Profile::ShowShortTagContents(TAG_TABLE_ENTRY * tagEntry, wstring & outputT
 						mlucEntryPtr = &mlucTagStruct->Entries[0];
 					}
 
-					size_t stringOffset = swap32(mlucEntryPtr->Offset);
-					size_t stringSizeInCharacters = swap32(mlucEntryPtr->LengthInBytes) / sizeof(wchar_t);
+					size_t stringOffset = mlucEntryPtr->Offset.Get();
+					size_t stringSizeInCharacters = mlucEntryPtr->LengthInBytes.Get() / sizeof(wchar_t);
 					wchar_t * wideString;
 					if (ByteSwapUnicode(reinterpret_cast<wchar_t *>(bytePtr + stringOffset), wideString, stringSizeInCharacters)) {
 						outputText += L":  \"";
@@ -1899,15 +2021,15 @@ bool Profile::ShowShortTagContents(TAG_TABLE_ENTRY * tagEntry, wstring & outputT
 
 		case 'XYZ ':
 			if ( 20 == tagEntry->Size ) {
-				CIEXYZ cie;
+				BIG_ENDIAN_XYZ cie;
 				if (ReadProfileBytes(tagEntry->Offset + 8, sizeof(cie), reinterpret_cast<BYTE *>(&cie))) {
 					StringCbPrintf(
 							buf,
 							sizeof(buf),
 							L":  X=%6.4f, Y=%6.4f, Z=%6.4f",
-							double(swap32(cie.ciexyzX)) / double(65536),
-							double(swap32(cie.ciexyzY)) / double(65536),
-							double(swap32(cie.ciexyzZ)) / double(65536) );
+							double(cie.X.Get()) / double(65536),
+							double(cie.Y.Get()) / double(65536),
+							double(cie.Z.Get()) / double(65536) );
 					outputText = buf;
 					haveText = true;
 				}
@@ -1924,7 +2046,7 @@ bool Profile::ShowShortTagContents(TAG_TABLE_ENTRY * tagEntry, wstring & outputT
 							buf,
 							sizeof(buf),
 							L":  gamma=%6.4f",
-							double(swap16(curve.Entries[0])) / double(256) );
+							double(curve.Entries[0].Get()) / double(256) );
 					outputText = buf;
 					haveText = true;
 				}
@@ -1937,19 +2059,19 @@ bool Profile::ShowShortTagContents(TAG_TABLE_ENTRY * tagEntry, wstring & outputT
 			if ( sizeof(measType) == tagEntry->Size ) {
 				measType measurements;
 				if (ReadProfileBytes(tagEntry->Offset, sizeof(measurements), reinterpret_cast<BYTE *>(&measurements))) {
-					const wchar_t * observer = LookupName( knownObservers, _countof(knownObservers), swap32(measurements.Observer) );
-					const wchar_t * geometry = LookupName( knownGeometry, _countof(knownGeometry), swap32(measurements.Geometry) );
-					const wchar_t * illuminant = LookupName( knownIlluminants, _countof(knownIlluminants), swap32(measurements.Illuminant) );
+					const wchar_t * observer = LookupName( knownObservers, _countof(knownObservers), measurements.Observer.Get() );
+					const wchar_t * geometry = LookupName( knownGeometry, _countof(knownGeometry), measurements.Geometry.Get() );
+					const wchar_t * illuminant = LookupName( knownIlluminants, _countof(knownIlluminants), measurements.Illuminant.Get() );
 					StringCbPrintf(
 							buf,
 							sizeof(buf),
 							L":  observer=%s, backing X=%6.4f, Y=%6.4f, Z=%6.4f, geometry=%s, flare=%.2f%%, illuminant=%s",
 							observer,
-							double(swap32(measurements.Backing.ciexyzX)) / double(65536),
-							double(swap32(measurements.Backing.ciexyzY)) / double(65536),
-							double(swap32(measurements.Backing.ciexyzZ)) / double(65536),
+							double(measurements.Backing.X.Get()) / double(65536),
+							double(measurements.Backing.Y.Get()) / double(65536),
+							double(measurements.Backing.Z.Get()) / double(65536),
 							geometry,
-							double(100 * swap32(measurements.Flare)) / double(65536),
+							double(100 * measurements.Flare.Get()) / double(65536),
 							illuminant );
 					outputText = buf;
 					haveText = true;
@@ -1963,17 +2085,17 @@ bool Profile::ShowShortTagContents(TAG_TABLE_ENTRY * tagEntry, wstring & outputT
 			if ( sizeof(viewType) == tagEntry->Size ) {
 				viewType view;
 				if (ReadProfileBytes(tagEntry->Offset, sizeof(view), reinterpret_cast<BYTE *>(&view))) {
-					const wchar_t * illuminant = LookupName( knownIlluminants, _countof(knownIlluminants), swap32(view.Illuminant) );
+					const wchar_t * illuminant = LookupName( knownIlluminants, _countof(knownIlluminants), view.Illuminant.Get() );
 					StringCbPrintf(
 							buf,
 							sizeof(buf),
 							L":  illuminant X=%6.4f, Y=%6.4f, Z=%6.4f, surround X=%6.4f, Y=%6.4f, Z=%6.4f, illuminant=%s",
-							double(swap32(view.IlluminantXYZ.ciexyzX)) / double(65536),
-							double(swap32(view.IlluminantXYZ.ciexyzY)) / double(65536),
-							double(swap32(view.IlluminantXYZ.ciexyzZ)) / double(65536),
-							double(swap32(view.SurroundXYZ.ciexyzX)) / double(65536),
-							double(swap32(view.SurroundXYZ.ciexyzY)) / double(65536),
-							double(swap32(view.SurroundXYZ.ciexyzZ)) / double(65536),
+							double(view.IlluminantXYZ.X.Get()) / double(65536),
+							double(view.IlluminantXYZ.Y.Get()) / double(65536),
+							double(view.IlluminantXYZ.Z.Get()) / double(65536),
+							double(view.SurroundXYZ.X.Get()) / double(65536),
+							double(view.SurroundXYZ.Y.Get()) / double(65536),
+							double(view.SurroundXYZ.Z.Get()) / double(65536),
 							illuminant );
 					outputText = buf;
 					haveText = true;
@@ -1988,10 +2110,10 @@ bool Profile::ShowShortTagContents(TAG_TABLE_ENTRY * tagEntry, wstring & outputT
 				signatureType signature;
 				if (ReadProfileBytes(tagEntry->Offset, sizeof(signature), reinterpret_cast<BYTE *>(&signature))) {
 					if ( 'tech' == tagEntry->Signature ) {
-						const wchar_t * technology = LookupName( knownTechnologies, _countof(knownTechnologies), swap32(signature.Signature) );
+						const wchar_t * technology = LookupName( knownTechnologies, _countof(knownTechnologies), signature.Signature.Get() );
 						StringCbPrintf(buf, sizeof(buf), L":  %s", technology);
 					} else {
-						ConvertFourBytesForDisplay(signature.Signature, displayChars, sizeof(displayChars));
+						ConvertFourBytesForDisplay(swap32(signature.Signature.Get()), displayChars, sizeof(displayChars));
 						StringCbPrintf(buf, sizeof(buf), L":  Signature='%s'", displayChars);
 					}
 					outputText = buf;
@@ -2010,17 +2132,17 @@ bool Profile::ShowShortTagContents(TAG_TABLE_ENTRY * tagEntry, wstring & outputT
 							buf,
 							sizeof(buf),
 							L":  { {%6.4f, %6.4f, %6.4f}, {%6.4f, %6.4f, %6.4f}, {%6.4f, %6.4f, %6.4f} }",
-							double(static_cast<signed int>(swap32(chad.a0))) / double(65536),
-							double(static_cast<signed int>(swap32(chad.a1))) / double(65536),
-							double(static_cast<signed int>(swap32(chad.a2))) / double(65536),
+							double(chad.a0.Get()) / double(65536),
+							double(chad.a1.Get()) / double(65536),
+							double(chad.a2.Get()) / double(65536),
 
-							double(static_cast<signed int>(swap32(chad.a3))) / double(65536),
-							double(static_cast<signed int>(swap32(chad.a4))) / double(65536),
-							double(static_cast<signed int>(swap32(chad.a5))) / double(65536),
+							double(chad.a3.Get()) / double(65536),
+							double(chad.a4.Get()) / double(65536),
+							double(chad.a5.Get()) / double(65536),
 
-							double(static_cast<signed int>(swap32(chad.a6))) / double(65536),
-							double(static_cast<signed int>(swap32(chad.a7))) / double(65536),
-							double(static_cast<signed int>(swap32(chad.a8))) / double(65536) );
+							double(chad.a6.Get()) / double(65536),
+							double(chad.a7.Get()) / double(65536),
+							double(chad.a8.Get()) / double(65536) );
 					outputText = buf;
 					haveText = true;
 				}
@@ -2037,12 +2159,12 @@ bool Profile::ShowShortTagContents(TAG_TABLE_ENTRY * tagEntry, wstring & outputT
 							buf,
 							sizeof(buf),
 							L":  %04d-%02d-%02d %02d:%02d:%02dZ", // RFC3389, NOTE: in 5.6
-							swap16(dateTime.year),
-							swap16(dateTime.month),
-							swap16(dateTime.day),
-							swap16(dateTime.hour),
-							swap16(dateTime.minute),
-							swap16(dateTime.second) );
+							dateTime.year.Get(),
+							dateTime.month.Get(),
+							dateTime.day.Get(),
+							dateTime.hour.Get(),
+							dateTime.minute.Get(),
+							dateTime.second.Get() );
 					outputText = buf;
 					haveText = true;
 				}
@@ -2059,12 +2181,86 @@ bool Profile::ShowShortTagContents(TAG_TABLE_ENTRY * tagEntry, wstring & outputT
 	return haveText;
 }
 
-// Return a string for the per-monitor panel
+// Format line 'lineNumber' of the tag list for a DetailsView; 'context' is the Profile
 //
-wstring Profile::DetailsString(void) {
+wstring Profile::FormatTagListLine(void * context, size_t lineNumber) {
+	return reinterpret_cast<Profile *>(context)->TagListLine(lineNumber);
+}
 
+// Return one line of the tag list:  the tag's signature and name, and for some tags a short
+//  version of its contents, which may mean reading the tag from the file
+//
+wstring Profile::TagListLine(size_t tagNumber) {
 	wstring s;
+	if ( !IsLoaded() || (tagNumber >= TagCount) ) {
+		return s;
+	}
 	wstring moreText;
+	wchar_t buf[1024];
+	wchar_t displayChars[5];
+	bool additionalText;
+	DWORD tagSignature = *sortedTags[tagNumber];
+	ConvertFourBytesForDisplay(swap32(tagSignature), displayChars, sizeof(displayChars));
+	const wchar_t * lookupString = LookupName( knownTags, _countof(knownTags), tagSignature );
+	if (*reinterpret_cast<BYTE *>(&ProfileHeader->phVersion) < 4) {
+
+		// See if there is an older name for this tag in the pre-version 4.0 spec
+		//
+		const wchar_t * lookupString2 = LookupName( knownTagsOldNames, _countof(knownTagsOldNames), tagSignature );
+		if (*lookupString2) {
+			lookupString = lookupString2;
+		}
+	}
+	StringCbPrintf(buf, sizeof(buf), L"  %s:  %s", displayChars, lookupString);
+	s += buf;
+
+	// GretagMacbeth/X-Rite likes to use the 'text' type for some of their private tags, so don't
+	// fill the screen with stuff that isn't useful ... only display 'text' for certain known tags
+	//
+	TAG_TABLE_ENTRY * tagEntry = reinterpret_cast<TAG_TABLE_ENTRY *>(sortedTags[tagNumber]);
+	if ( 'text' == tagEntry->Type ) {
+		switch (tagSignature) {
+			case 'cprt':
+			case 'targ':
+			case 'dmdd':
+			case 'dmnd':
+				additionalText = ShowShortTagContents(tagEntry, moreText);
+				break;
+
+			default:
+				additionalText = ShowTagTypeDescription(tagEntry, moreText);
+				break;
+		}
+	} else {
+		additionalText = ShowShortTagContents(tagEntry, moreText);
+	}
+	if (additionalText) {
+		s += moreText;
+	}
+
+	// A DetailsView line is one line, so keep any line breaks in tag text from splitting it
+	//
+	for (size_t i = 0; i < s.size(); ++i) {
+		if ( (L'\r' == s[i]) || (L'\n' == s[i]) ) {
+			s[i] = L' ';
+		}
+	}
+	return s;
+}
+
+// Fill a document for the per-monitor panel
+//
+void Profile::GetDetails(DetailsDocument & document) {
+	document.AddText(DetailsString(document));
+}
+
+// Return the text for the per-monitor panel; each hex dump, and the tag list (formatted a line at
+//  a time as the view needs it), is added to 'document' along with the text that comes before
+//  it, and the text after the last one is returned
+//
+wstring Profile::DetailsString(DetailsDocument & document) {
+
+	wstring s;
 	wchar_t displayChars[5];
 
 	// Quit early if no profile
@@ -2168,17 +2364,17 @@ wstring Profile::DetailsString(void) {
 	} else {
 		s += L"\r\n";
 	}
-	dateTimeNumber * dt = reinterpret_cast<dateTimeNumber *>(&ProfileHeader->phDateTime[0]);
+	const dateTimeNumber * dt = reinterpret_cast<const dateTimeNumber *>(&ProfileHeader->phDateTime[0]);
 	StringCchPrintf(
 		buf,
 		_countof(buf),
 		L"  Date and time this profile was first created:  %04d-%02d-%02d %02d:%02d:%02dZ\r\n", // RFC3389, NOTE: in 5.6
-		swap16(dt->year),
-		swap16(dt->month),
-		swap16(dt->day),
-		swap16(dt->hour),
-		swap16(dt->minute),
-		swap16(dt->second) );
+		dt->year.Get(),
+		dt->month.Get(),
+		dt->day.Get(),
+		dt->hour.Get(),
+		dt->minute.Get(),
+		dt->second.Get() );
 	s += buf;
 	ConvertFourBytesForDisplay(ProfileHeader->phSignature, displayChars, sizeof(displayChars));
 	StringCbPrintf(buf, sizeof(buf), L"  Signature (must be 'acsp'):  %s\r\n", displayChars);
@@ -2239,13 +2435,14 @@ wstring Profile::DetailsString(void) {
 		StringCbPrintf(buf, sizeof(buf), L"Unknown value: 0x%08x\r\n", swap32(ProfileHeader->phRenderingIntent));
 		s += buf;
 	}
+	const BIG_ENDIAN_XYZ * pcsIlluminant = reinterpret_cast<const BIG_ENDIAN_XYZ *>(&ProfileHeader->phIlluminant);
 	StringCbPrintf(
 			buf,
 			sizeof(buf),
 			L"  Illuminant:  X=%6.4f, Y=%6.4f, Z=%6.4f\r\n",
-			double(swap32(ProfileHeader->phIlluminant.ciexyzX)) / double(65536),
-			double(swap32(ProfileHeader->phIlluminant.ciexyzY)) / double(65536),
-			double(swap32(ProfileHeader->phIlluminant.ciexyzZ)) / double(65536) );
+			double(pcsIlluminant->X.Get()) / double(65536),
+			double(pcsIlluminant->Y.Get()) / double(65536),
+			double(pcsIlluminant->Z.Get()) / double(65536) );
 	s += buf;
 	s += L"  Profile Creator:  ";
 	ConvertFourBytesForDisplay(ProfileHeader->phCreator, displayChars, sizeof(displayChars));
@@ -2268,57 +2465,19 @@ wstring Profile::DetailsString(void) {
 		s += L"\r\n";
 	}
 
-#if 0
-	StringCbPrintf(buf, sizeof(buf), L"\r\nProfile header (%d bytes):\r\n", sizeof(PROFILEHEADER));
-	s += buf;
-	s += HexDump(reinterpret_cast<unsigned char *>(ProfileHeader), sizeof(PROFILEHEADER), 16);
-#endif
+	s += L"\r\n";
+	document.AddText(s);
+	s.clear();
+	StringCbPrintf(buf, sizeof(buf), L"Profile header (%d bytes)", sizeof(PROFILEHEADER));
+	document.AddHexDump(buf, reinterpret_cast<BYTE *>(ProfileHeader), sizeof(PROFILEHEADER));
 
 	// Display the tag table's list of tags, and the data for some tags
 	//
 	StringCbPrintf(buf, sizeof(buf), L"\r\nProfile contains %d tags:\r\n", TagCount);
 	s += buf;
-	bool additionalText;
-	for (size_t i = 0; i < TagCount; ++i) {
-		DWORD tagSignature = *sortedTags[i];
-		ConvertFourBytesForDisplay(swap32(tagSignature), displayChars, sizeof(displayChars));
-		lookupString = LookupName( knownTags, _countof(knownTags), tagSignature );
-		if (*reinterpret_cast<BYTE *>(&ProfileHeader->phVersion) < 4) {
-
-			// See if there is an older name for this tag in the pre-version 4.0 spec
-			//
-			const wchar_t * lookupString2 = LookupName( knownTagsOldNames, _countof(knownTagsOldNames), tagSignature );
-			if (*lookupString2) {
-				lookupString = lookupString2;
-			}
-		}
-		StringCbPrintf(buf, sizeof(buf), L"  %s:  %s", displayChars, lookupString);
-		s += buf;
-
-		// GretagMacbeth/X-Rite likes to use the 'text' type for some of their private tags, so don't
-		// fill the screen with stuff that isn't useful ... only display 'text' for certain known tags
-		//
-		if ( 'text' == reinterpret_cast<TAG_TABLE_ENTRY *>(sortedTags[i])->Type ) {
-			switch (tagSignature) {
-				case 'cprt':
-				case 'targ':
-				case 'dmdd':
-				case 'dmnd':
-					additionalText = ShowShortTagContents(reinterpret_cast<TAG_TABLE_ENTRY *>(sortedTags[i]), moreText);
-					break;
-
-				default:
-					additionalText = ShowTagTypeDescription(reinterpret_cast<TAG_TABLE_ENTRY *>(sortedTags[i]), moreText);
-					break;
-			}
-		} else {
-			additionalText = ShowShortTagContents(reinterpret_cast<TAG_TABLE_ENTRY *>(sortedTags[i]), moreText);
-		}
-		if (additionalText) {
-			s += moreText;
-		}
-		s += L"\r\n";
-	}
+	document.AddText(s);
+	s.clear();
+	document.AddFormattedLines(FormatTagListLine, this, TagCount);
 
 	if (-1 != vcgtIndex) {
 		s += L"\r\nProfile includes a video card gamma tag:\r\n  Type: ";
@@ -2360,11 +2519,13 @@ wstring Profile::DetailsString(void) {
 			StringCbPrintf(buf, sizeof(buf), L"\r\n  Blue max: %6.4f", double(vcgtHeader.vcgtContents.f.vcgtBlueMax) / double(65536));
 			s += buf;
 		}
-#if 0
-		StringCbPrintf(buf, sizeof(buf), L"\r\n\r\nDump of Video Card Gamma Tag (%d bytes):\r\n", TagTable[vcgtIndex].Size);
-		s += buf;
-		s += HexDump(reinterpret_cast<unsigned char *>(pVCGT), TagTable[vcgtIndex].Size, 16);
-#endif
+		if ( 0 != TagTable[vcgtIndex].Size ) {
+			s += L"\r\n\r\n";
+			document.AddText(s);
+			s.clear();
+			StringCbPrintf(buf, sizeof(buf), L"Dump of Video Card Gamma Tag (%d bytes)", TagTable[vcgtIndex].Size);
+			document.AddTagHexDump(buf, this, vcgtIndex);
+		}
 	}
 
 #if DISPLAY_EMBEDDED_WCS_PROFILE_IN_SHOW_DETAILS
@@ -2378,17 +2539,41 @@ wstring Profile::DetailsString(void) {
 		//   2) Color Appearance Model;
 		//   3) Gamut Map Model
 		//
-		if (!WCS_ColorDeviceModel.empty()) {
+		// LoadFullProfile() only noted where they are, so we read each one now.
+		//
+		wstring xml;
+		if ( ReadWcsSection(WCS_ColorDeviceModel, xml) ) {
+			wstring deviceType;
+			if ( FindWcsDeviceType(xml, deviceType) ) {
+				s += L"\r\n  Device type:  ";
+				s += deviceType;
+				s += L"\r\n";
+			}
 			s += L"\r\n  Color Device Model:\r\n";
-			s += WCS_ColorDeviceModel;
+			s += xml;
 		}
-		if (!WCS_ColorAppearanceModel.empty()) {
+		if ( ReadWcsSection(WCS_ColorAppearanceModel, xml) ) {
+			size_t position = 0;
+			wstring whitePoint;
+			wstring x, y, z;
+			if (	FindXmlElementText(xml, L"WhitePoint", position, whitePoint)
+				 &&	FindXmlElementText(xml, L"X", position, x)
+				 &&	FindXmlElementText(xml, L"Y", position, y)
+				 &&	FindXmlElementText(xml, L"Z", position, z) ) {
+				s += L"\r\n  White point:  X = ";
+				s += x;
+				s += L", Y = ";
+				s += y;
+				s += L", Z = ";
+				s += z;
+				s += L"\r\n";
+			}
 			s += L"\r\n  Color Appearance Model:\r\n";
-			s += WCS_ColorAppearanceModel;
+			s += xml;
 		}
-		if (!WCS_GamutMapModel.empty()) {
+		if ( ReadWcsSection(WCS_GamutMapModel, xml) ) {
 			s += L"\r\n  Gamut Map Model:\r\n";
-			s += WCS_GamutMapModel;
+			s += xml;
 		}
 	}
 #endif
@@ -2398,12 +2583,25 @@ wstring Profile::DetailsString(void) {
 
 // Compare the LUT for this profile with another LUT, and return the result
 //
-LUT_COMPARISON Profile::CompareLUT(LUT * otherLUT, DWORD * maxError, DWORD * totalError) {
+LUT_COMPARISON Profile::CompareLUT(const LUT * otherLUT, DWORD * maxError, DWORD * totalError) {
 
 	if (!otherLUT) {
 		return LC_ERROR_NO_LUT_PROVIDED;
 	}
 
+	// An identical LUT (the usual answer once a LUT is loaded) needs no per-entry scan
+	//
+	const LUT * pLUT = lutHandle.Get();
+	if ( pLUT && ( (pLUT == otherLUT) || lutHandle.Matches(*otherLUT) ) ) {
+		if (maxError) {
+			*maxError = 0;
+		}
+		if (totalError) {
+			*totalError = 0;
+		}
+		return LC_EQUAL;
+	}
+
 	bool thisLutIsLinear = true;
 	bool otherLutIsLinear = true;
 	bool lutsMatchExactly = true;
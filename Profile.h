@@ -5,11 +5,15 @@
 #include "stdafx.h"
 #include <icm.h>
 #include "LUT.h"
+#include "Arena.h"
+#include "BigEndian.h"
+#include "DetailsView.h"
 #include "VideoCardGammaTag.h"
 
 // Optional "features"
 //
 #define READ_EMBEDDED_WCS_PROFILE 0
+#define COMPACT_PROFILES 1						// Drop the raw 'vcgt' bytes once they are decoded
 
 // Forward references
 //
@@ -20,9 +24,9 @@ typedef vector <Profile *> ProfileList;
 // An entry in the tag table
 //
 typedef struct tag_EXTERNAL_TAG_TABLE_ENTRY {		// As stored in a profile file
-	DWORD		Signature;
-	DWORD		Offset;
-	DWORD		Size;
+	BigEndian <DWORD>	Signature;
+	BigEndian <DWORD>	Offset;
+	BigEndian <DWORD>	Size;
 } EXTERNAL_TAG_TABLE_ENTRY;
 
 typedef struct tag_TAG_TABLE_ENTRY {				// As maintained in memory
@@ -32,6 +36,15 @@ typedef struct tag_TAG_TABLE_ENTRY {				// As maintained in memory
 	DWORD		Type;
 } TAG_TABLE_ENTRY;
 
+#if READ_EMBEDDED_WCS_PROFILE
+// One of the three XML sections of an embedded WCS profile, left in the file until it is shown
+//
+typedef struct tag_WCS_SECTION {
+	DWORD		Offset;									// From the start of the profile file
+	DWORD		Size;									// In bytes, zero if the section is missing
+} WCS_SECTION;
+#endif
+
 class Profile {
 
 public:
@@ -39,29 +52,46 @@ public:
 	~Profile();
 
 	static Profile * Add(Profile * profile);
+	static Profile * Find(const wchar_t * profileName);
 	static void ClearList(bool freeAllMemory);
+	static wstring MemoryString(void);
 
 	wstring GetName(void) const;
 	wstring LoadFullProfile(bool forceReload);
+	void Invalidate(void);
+	bool IsLoaded(void) const;
+	bool ReadTagSummary(DWORD & profileClass, bool & hasVCGT, bool & hasWCS);
 	bool IsBadProfile(void) const;
 	DWORD GetProfileClass(void) const;
-	LUT * GetLutPointer(void) const;
-	wstring DetailsString(void);
-	LUT_COMPARISON CompareLUT(LUT * otherLUT, DWORD * maxError, DWORD * totalError);
+	const LUT * GetLutPointer(void) const;
+	LUThandle GetLutHandle(void) const;
+	void GetDetails(DetailsDocument & document);
+	bool GetRawTagBytes(int tagIndex, vector <BYTE> & tagBytes);
+	LUT_COMPARISON CompareLUT(const LUT * otherLUT, DWORD * maxError, DWORD * totalError);
 	bool HasEmbeddedWcsProfile(void) const;
+	size_t GetMemoryFootprint(void) const;
 	bool EditRegistryProfileList(HKEY hKeyBase, const wchar_t * registryKey, bool moveToEnd);
 	bool InsertIntoRegistryProfileList(HKEY hKeyBase, const wchar_t * registryKey);
 
 	static Profile * GetAllProfiles(HKEY hKeyBase, const wchar_t * registryKey, bool * perUser, ProfileList & profileList);
 
 private:
+	wstring ParseProfile(bool forceReload);
+	wstring DetailsString(DetailsDocument & document);
+	wstring TagListLine(size_t tagNumber);
+	static wstring FormatTagListLine(void * context, size_t lineNumber);
 	bool ShowTagTypeDescription(TAG_TABLE_ENTRY * tagEntry, wstring & outputText);
 	bool ShowShortTagContents(TAG_TABLE_ENTRY * tagEntry, wstring & outputText);
 	bool ReadProfileBytes(DWORD offset, DWORD byteCount, BYTE * returnedBytePtr);
 	bool ReadProfileBytesFromOpenFile(HANDLE hFile, DWORD offset, DWORD byteCount, BYTE * returnedBytePtr);
+#if READ_EMBEDDED_WCS_PROFILE
+	bool ReadWcsSection(const WCS_SECTION & section, wstring & xml);
+#endif
 
 	wstring				ProfileName;					// Name of profile file without path
+	Arena				arena;							// Holds everything below that LoadFullProfile() parses
 	bool				loaded;							// 'true' if already loaded from disk
+	bool				reloadNeeded;					// The file has changed since it was loaded
 	bool				failed;							// Should align with ErrorString, means bad profile
 	wstring				ErrorString;					// If LoadFullProfile() fails, record error here
 	wstring				ValidationFailures;				// Profile issues that don't prevent loading
@@ -71,13 +101,15 @@ private:
 	TAG_TABLE_ENTRY *	TagTable;						// Table of tags
 	DWORD * *			sortedTags;						// Pointers into tags table in a sorted order
 	int					vcgtIndex;						// Location of VCGT tag in TagTable, or -1
-	VCGT_HEADER *		pVCGT;							// Video Card Gamma Tag structure as on disk
+	VCGT_HEADER *		pVCGT;							// Video Card Gamma Tag structure as on disk (or zero)
 	VCGT_HEADER			vcgtHeader;						// A byte-swapped version for us to use
-	LUT *				pLUT;							// A byte-swapped copy of the LUT from the vcgt
+	LUThandle			lutHandle;						// A byte-swapped copy of the LUT from the vcgt
 	int					wcsProfileIndex;				// Location of WCS tag in TagTable, or -1
+	volatile LONG		loadComplete;					// Nonzero once LoadFullProfile() has finished
+	CRITICAL_SECTION	loadLock;						// Held while parsing, which may be on another thread
 #if READ_EMBEDDED_WCS_PROFILE
-	wstring				WCS_ColorDeviceModel;			// XML copied from WCS profile
-	wstring				WCS_ColorAppearanceModel;
-	wstring				WCS_GamutMapModel;
+	WCS_SECTION			WCS_ColorDeviceModel;			// Where the WCS profile's XML is in the file
+	WCS_SECTION			WCS_ColorAppearanceModel;
+	WCS_SECTION			WCS_GamutMapModel;
 #endif
 };
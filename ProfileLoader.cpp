@@ -0,0 +1,148 @@
+// ProfileLoader.cpp -- Load profiles on a worker thread so the property sheet never waits for them
+//
+
+#include "stdafx.h"
+#include "Profile.h"
+#include "ProfileLoader.h"
+#include "Trace.h"
+#include <strsafe.h>
+//#include <banned.h>
+
+// Global static symbols internal to this file
+//
+static bool loaderRunning = false;						// Only the UI thread starts and stops us
+static HANDLE workerThread = 0;
+static HANDLE workEvent = 0;							// Auto-reset, set when a request is queued
+static CRITICAL_SECTION queueLock;						// Protects everything below
+static vector <PROFILE_LOAD_REQUEST> requestQueue;
+static HWND visibleWindow = 0;
+static bool stopRequested = false;
+
+// Create the worker thread (on first use)
+//
+bool ProfileLoader::Start(void) {
+	if (loaderRunning) {
+		return true;
+	}
+	InitializeCriticalSection(&queueLock);
+	workEvent = CreateEvent(NULL, FALSE, FALSE, NULL);
+	if (workEvent) {
+		stopRequested = false;
+		workerThread = CreateThread(NULL, 0, WorkerThreadProc, 0, 0, NULL);
+		if (workerThread) {
+			loaderRunning = true;
+			return true;
+		}
+		CloseHandle(workEvent);
+		workEvent = 0;
+	}
+	DeleteCriticalSection(&queueLock);
+	return false;
+}
+
+// Ask for a profile to be loaded.  Returns 'true' if it is loaded already, and otherwise queues
+//  it and returns 'false'; 'notifyWindow' will get WM_PROFILE_LOADED when it is ready.
+//
+bool ProfileLoader::RequestLoad(Profile * profile, HWND notifyWindow) {
+	if ( profile->IsLoaded() ) {
+		return true;
+	}
+
+	// If we can't run a thread, do it the old way
+	//
+	if ( !Start() ) {
+		profile->LoadFullProfile(false);
+		return true;
+	}
+
+	EnterCriticalSection(&queueLock);
+	bool alreadyQueued = false;
+	size_t count = requestQueue.size();
+	for (size_t i = 0; i < count; ++i) {
+		if ( (requestQueue[i].profile == profile) && (requestQueue[i].notifyWindow == notifyWindow) ) {
+			alreadyQueued = true;
+			break;
+		}
+	}
+	if ( !alreadyQueued ) {
+		PROFILE_LOAD_REQUEST request;
+		request.profile = profile;
+		request.notifyWindow = notifyWindow;
+		requestQueue.push_back(request);
+	}
+	LeaveCriticalSection(&queueLock);
+	SetEvent(workEvent);
+	return false;
+}
+
+// Note which property sheet page is showing, so its requests can go to the front of the queue
+//
+void ProfileLoader::SetVisibleWindow(HWND pageWindow) {
+	if (loaderRunning) {
+		EnterCriticalSection(&queueLock);
+		visibleWindow = pageWindow;
+		LeaveCriticalSection(&queueLock);
+	} else {
+		visibleWindow = pageWindow;
+	}
+}
+
+// Throw away anything still queued, wait for the profile being loaded (if any), and end the thread
+//
+void ProfileLoader::Stop(void) {
+	if ( !loaderRunning ) {
+		return;
+	}
+	EnterCriticalSection(&queueLock);
+	stopRequested = true;
+	requestQueue.clear();
+	LeaveCriticalSection(&queueLock);
+	SetEvent(workEvent);
+	WaitForSingleObject(workerThread, INFINITE);
+	CloseHandle(workerThread);
+	workerThread = 0;
+	CloseHandle(workEvent);
+	workEvent = 0;
+	DeleteCriticalSection(&queueLock);
+	vector <PROFILE_LOAD_REQUEST>().swap(requestQueue);
+	loaderRunning = false;
+}
+
+// The worker thread: load queued profiles, visible page first, until told to stop
+//
+DWORD WINAPI ProfileLoader::WorkerThreadProc(LPVOID lpParameter) {
+	UNREFERENCED_PARAMETER(lpParameter);
+
+	for (;;) {
+		WaitForSingleObject(workEvent, INFINITE);
+		for (;;) {
+			EnterCriticalSection(&queueLock);
+			if ( stopRequested || requestQueue.empty() ) {
+				bool stopping = stopRequested;
+				LeaveCriticalSection(&queueLock);
+				if (stopping) {
+					return 0;
+				}
+				break;
+			}
+			size_t pick = 0;
+			size_t count = requestQueue.size();
+			for (size_t i = 0; i < count; ++i) {
+				HWND notifyWindow = requestQueue[i].notifyWindow;
+				if ( visibleWindow && ( (notifyWindow == visibleWindow) || IsChild(visibleWindow, notifyWindow) ) ) {
+					pick = i;
+					break;
+				}
+			}
+			PROFILE_LOAD_REQUEST request = requestQueue[pick];
+			requestQueue.erase(requestQueue.begin() + pick);
+			LeaveCriticalSection(&queueLock);
+
+			{
+				TRACE_SCOPE_DETAIL(L"ProfileLoader", request.profile->GetName().c_str());
+				request.profile->LoadFullProfile(false);
+			}
+			PostMessage(request.notifyWindow, WM_PROFILE_LOADED, 0, reinterpret_cast<LPARAM>(request.profile));
+		}
+	}
+}
@@ -0,0 +1,34 @@
+// ProfileLoader.h -- Load profiles on a worker thread so the property sheet never waits for them
+//
+// A window that wants a profile calls RequestLoad().  If the profile is already loaded, it can
+//  use it right away; if not, it shows a placeholder and gets a WM_PROFILE_LOADED message when
+//  the worker thread has parsed it.  Requests from the page the user is looking at go first.
+//
+
+#pragma once
+#include "stdafx.h"
+
+// Posted to the requesting window when a profile has been loaded; lParam is the Profile *
+//
+#define WM_PROFILE_LOADED			(WM_APP + 1)
+
+// Forward references
+//
+class Profile;
+
+typedef struct tag_PROFILE_LOAD_REQUEST {
+	Profile *			profile;
+	HWND				notifyWindow;
+} PROFILE_LOAD_REQUEST;
+
+class ProfileLoader {
+
+public:
+	static bool RequestLoad(Profile * profile, HWND notifyWindow);
+	static void SetVisibleWindow(HWND pageWindow);
+	static void Stop(void);
+
+private:
+	static bool Start(void);
+	static DWORD WINAPI WorkerThreadProc(LPVOID lpParameter);
+};
@@ -0,0 +1,268 @@
+// ProfileWatcher.cpp -- Watch the color directory and reload profiles that are changed on disk
+//
+// A calibration program usually writes a profile in several pieces, so we never load a file as
+//  soon as we hear about it.  Each notification restarts a quiet-time clock for that file, and
+//  when the clock runs out we also check that nobody still has the file open for writing.  Only
+//  then do we reload the Profile object and push its LUT to the monitors that are using it.
+//
+
+#include "stdafx.h"
+#include "LUT.h"
+#include "Monitor.h"
+#include "Profile.h"
+#include "ProfileWatcher.h"
+#include <strsafe.h>
+//#include <banned.h>
+
+// Symbols defined in other files
+//
+extern wchar_t * ColorDirectory;
+
+// Constructor
+//
+ProfileWatcher::ProfileWatcher() :
+		hDirectory(INVALID_HANDLE_VALUE),
+		notifyBuffer(0),
+		readPending(false),
+		overflowed(false),
+		overflowTick(0)
+{
+	SecureZeroMemory(&overlapped, sizeof(overlapped));
+}
+
+// Destructor
+//
+ProfileWatcher::~ProfileWatcher() {
+	Stop();
+}
+
+// Open the color directory and ask to be told about changes
+//
+bool ProfileWatcher::Start(void) {
+	if ( 0 == ColorDirectory ) {
+		return false;
+	}
+	hDirectory = CreateFile(
+			ColorDirectory,
+			FILE_LIST_DIRECTORY,
+			FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE,
+			NULL,
+			OPEN_EXISTING,
+			FILE_FLAG_BACKUP_SEMANTICS | FILE_FLAG_OVERLAPPED,
+			NULL );
+	if ( INVALID_HANDLE_VALUE == hDirectory ) {
+		return false;
+	}
+	overlapped.hEvent = CreateEvent(NULL, TRUE, FALSE, NULL);
+	notifyBuffer = new DWORD[PROFILE_WATCHER_BUFFER_SIZE / sizeof(DWORD)];
+	if ( 0 == overlapped.hEvent || !Rearm() ) {
+		Stop();
+		return false;
+	}
+	return true;
+}
+
+// Stop watching and release everything.  A cancelled read is not finished until Windows says
+//  so; until then it can still write into notifyBuffer and 'overlapped', so we wait for it (it
+//  completes with ERROR_OPERATION_ABORTED) before closing handles and freeing the buffer.
+//
+void ProfileWatcher::Stop(void) {
+	if ( INVALID_HANDLE_VALUE != hDirectory ) {
+		if (readPending) {
+			DWORD byteCount = 0;
+			CancelIo(hDirectory);
+			GetOverlappedResult(hDirectory, &overlapped, &byteCount, TRUE);
+			readPending = false;
+		}
+		CloseHandle(hDirectory);
+		hDirectory = INVALID_HANDLE_VALUE;
+	}
+	if (overlapped.hEvent) {
+		CloseHandle(overlapped.hEvent);
+		overlapped.hEvent = 0;
+	}
+	if (notifyBuffer) {
+		delete [] notifyBuffer;
+		notifyBuffer = 0;
+	}
+	pendingList.clear();
+	overflowed = false;
+}
+
+// The event handle is signaled when there are notifications for HandleNotification() to read
+//
+HANDLE ProfileWatcher::GetEventHandle(void) const {
+	return overlapped.hEvent;
+}
+
+// Start the next asynchronous read of directory changes
+//
+bool ProfileWatcher::Rearm(void) {
+	ResetEvent(overlapped.hEvent);
+	readPending = ( 0 != ReadDirectoryChangesW(
+			hDirectory,
+			notifyBuffer,
+			PROFILE_WATCHER_BUFFER_SIZE,
+			FALSE,
+			FILE_NOTIFY_CHANGE_FILE_NAME | FILE_NOTIFY_CHANGE_LAST_WRITE | FILE_NOTIFY_CHANGE_SIZE,
+			NULL,
+			&overlapped,
+			NULL ) );
+	return readPending;
+}
+
+// Remember that a file changed, restarting its quiet-time clock if we already knew about it
+//
+void ProfileWatcher::NoteChange(const wstring & fileName, DWORD now) {
+	size_t count = pendingList.size();
+	for (size_t i = 0; i < count; ++i) {
+		if ( 0 == _wcsicmp(fileName.c_str(), pendingList[i].fileName.c_str()) ) {
+			pendingList[i].lastChange = now;
+			return;
+		}
+	}
+	PENDING_CHANGE change;
+	change.fileName = fileName;
+	change.lastChange = now;
+	pendingList.push_back(change);
+}
+
+// Read the notifications that signaled our event, then ask for more
+//
+void ProfileWatcher::HandleNotification(void) {
+	DWORD byteCount = 0;
+	if ( !GetOverlappedResult(hDirectory, &overlapped, &byteCount, FALSE) ) {
+		if ( ERROR_IO_INCOMPLETE == GetLastError() ) {
+			return;										// Still running; leave it alone
+		}
+		byteCount = 0;
+	}
+	readPending = false;
+	DWORD now = GetTickCount();
+
+	// Zero bytes means that too much happened to fit in our buffer
+	//
+	if ( 0 == byteCount ) {
+		overflowed = true;
+		overflowTick = now;
+	} else {
+		FILE_NOTIFY_INFORMATION * info = reinterpret_cast<FILE_NOTIFY_INFORMATION *>(notifyBuffer);
+		for (;;) {
+			if ( (FILE_ACTION_REMOVED != info->Action) && (FILE_ACTION_RENAMED_OLD_NAME != info->Action) ) {
+				NoteChange(wstring(info->FileName, info->FileNameLength / sizeof(wchar_t)), now);
+			}
+			if ( 0 == info->NextEntryOffset ) {
+				break;
+			}
+			info = reinterpret_cast<FILE_NOTIFY_INFORMATION *>(reinterpret_cast<BYTE *>(info) + info->NextEntryOffset);
+		}
+	}
+	if ( !Rearm() ) {
+		CloseHandle(hDirectory);						// The event stays reset, so we just go quiet
+		hDirectory = INVALID_HANDLE_VALUE;
+	}
+}
+
+// How long until the first pending file has been quiet long enough (INFINITE if nothing is pending)
+//
+DWORD ProfileWatcher::GetMillisecondsUntilSettled(void) const {
+	DWORD now = GetTickCount();
+	DWORD waitTime = INFINITE;
+	size_t count = pendingList.size();
+	for (size_t i = 0; i <= count; ++i) {
+		DWORD lastChange;
+		if ( i < count ) {
+			lastChange = pendingList[i].lastChange;
+		} else if (overflowed) {
+			lastChange = overflowTick;
+		} else {
+			break;
+		}
+		DWORD elapsed = now - lastChange;
+		DWORD remaining = ( elapsed < PROFILE_WATCHER_QUIET_TIME ) ? (PROFILE_WATCHER_QUIET_TIME - elapsed) : 0;
+		if ( remaining < waitTime ) {
+			waitTime = remaining;
+		}
+	}
+	return waitTime;
+}
+
+// Return 'false' if someone still has the file open for writing
+//
+bool ProfileWatcher::IsFileQuiet(const wstring & fileName) const {
+	wstring filePath = ColorDirectory;
+	filePath += L"\\";
+	filePath += fileName;
+	HANDLE hFile = CreateFile(filePath.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+	if ( INVALID_HANDLE_VALUE == hFile ) {
+		return ( ERROR_SHARING_VIOLATION != GetLastError() );
+	}
+	CloseHandle(hFile);
+	return true;
+}
+
+// Reload every profile that has been quiet long enough and push its LUT to monitors that use it;
+//  return the number of profiles reloaded
+//
+size_t ProfileWatcher::ReloadSettledProfiles(void) {
+	DWORD now = GetTickCount();
+	vector <wstring> readyList;
+
+	// Collect the files that are ready, leaving the rest for later
+	//
+	for (size_t i = pendingList.size(); i > 0; --i) {
+		PENDING_CHANGE & change = pendingList[i - 1];
+		if ( (now - change.lastChange) < PROFILE_WATCHER_QUIET_TIME ) {
+			continue;
+		}
+		if ( !IsFileQuiet(change.fileName) ) {
+			change.lastChange = now;					// Still being written, give it more time
+			continue;
+		}
+		readyList.push_back(change.fileName);
+		pendingList.erase(pendingList.begin() + (i - 1));
+	}
+
+	// If Windows lost track of what changed, reload every profile that is active on a monitor
+	//
+	size_t monitorCount = Monitor::GetListSize();
+	if ( overflowed && (now - overflowTick) >= PROFILE_WATCHER_QUIET_TIME ) {
+		overflowed = false;
+		for (size_t i = 0; i < monitorCount; ++i) {
+			Profile * activeProfile = Monitor::Get(i)->GetActiveProfile();
+			if (activeProfile) {
+				readyList.push_back(activeProfile->GetName());
+			}
+		}
+	}
+
+	// Reload the profiles we have objects for; we don't care about the others
+	//
+	size_t reloadCount = 0;
+	size_t readyCount = readyList.size();
+	for (size_t i = 0; i < readyCount; ++i) {
+		Profile * profile = Profile::Find(readyList[i].c_str());
+		if ( 0 == profile ) {
+			continue;
+		}
+		profile->LoadFullProfile(true);
+		++reloadCount;
+		if ( profile->IsBadProfile() ) {
+			continue;									// Don't load a LUT from a broken profile
+		}
+		LUT linearLUT;
+		const LUT * pLUT = profile->GetLutPointer();
+		if ( 0 == pLUT ) {
+			GetSignedLUT(&linearLUT);
+			pLUT = &linearLUT;
+		}
+		for (size_t j = 0; j < monitorCount; ++j) {
+			Monitor * monitor = Monitor::Get(j);
+			if ( profile == monitor->GetActiveProfile() ) {
+				monitor->WriteLutToCard(pLUT);
+				monitor->ReadLutFromCard();
+			}
+		}
+	}
+	return reloadCount;
+}
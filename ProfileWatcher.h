@@ -0,0 +1,44 @@
+// ProfileWatcher.h -- Watch the color directory and reload profiles that are changed on disk
+//
+
+#pragma once
+#include "stdafx.h"
+
+// Some constants
+//
+#define PROFILE_WATCHER_QUIET_TIME		500			// Milliseconds a file must be left alone before we load it
+#define PROFILE_WATCHER_BUFFER_SIZE		4096		// Bytes for ReadDirectoryChangesW() results
+
+// A file we have been told about, but have not reloaded yet
+//
+typedef struct tag_PENDING_CHANGE {
+	wstring			fileName;						// Name of profile file without path
+	DWORD			lastChange;						// GetTickCount() of the most recent notification
+} PENDING_CHANGE;
+
+class ProfileWatcher {
+
+public:
+	ProfileWatcher();
+	~ProfileWatcher();
+
+	bool Start(void);
+	void Stop(void);
+	HANDLE GetEventHandle(void) const;
+	void HandleNotification(void);
+	DWORD GetMillisecondsUntilSettled(void) const;
+	size_t ReloadSettledProfiles(void);
+
+private:
+	bool Rearm(void);
+	void NoteChange(const wstring & fileName, DWORD now);
+	bool IsFileQuiet(const wstring & fileName) const;
+
+	HANDLE					hDirectory;				// Handle to the color directory
+	OVERLAPPED				overlapped;				// For asynchronous ReadDirectoryChangesW()
+	DWORD *					notifyBuffer;			// DWORD-aligned buffer of FILE_NOTIFY_INFORMATION
+	bool					readPending;			// A ReadDirectoryChangesW() may still write to the above
+	vector <PENDING_CHANGE>	pendingList;			// Files changed but not yet quiet
+	bool					overflowed;				// Windows lost track; reload every active profile
+	DWORD					overflowTick;			// GetTickCount() when we saw the overflow
+};
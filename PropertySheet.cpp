@@ -3,10 +3,13 @@
 
 #include "stdafx.h"
 #include <commctrl.h>
+#include "Counters.h"
+#include "DetailsView.h"
 #include "LUTview.h"
 #include "Monitor.h"
 #include "MonitorPage.h"
 #include "MonitorSummaryItem.h"
+#include "ProfileLoader.h"
 #include "PropertySheet.h"
 #include "Resize.h"
 #include "resource.h"
@@ -365,7 +368,7 @@ INT_PTR CALLBACK SummaryPageProc(HWND hWnd, UINT uMessage, WPARAM wParam, LPARAM
 
 				// Tell the LUT viewer to display the LUT for the first monitor
 				//
-				summaryLutView->SetLUT(Monitor::Get(0)->GetLutPointer());
+				summaryLutView->SetLUT(Monitor::Get(0)->GetLutHandle());
 			} else {
 
 				// If there are no monitors, use a MonitorSummaryItem to display this fact
@@ -467,12 +470,11 @@ INT_PTR CALLBACK SummaryPageProc(HWND hWnd, UINT uMessage, WPARAM wParam, LPARAM
 					//MessageBox(NULL, L"PSN_RESET", L"PropertySheet notification", MB_ICONINFORMATION | MB_OK);
 					break;
 
-				//// Page activated (switched to)
-				////
-				//case PSN_SETACTIVE:
-				//	pPSHNOTIFY = reinterpret_cast<PSHNOTIFY *>(lParam);
-				//	MessageBox(NULL, L"PSN_SETACTIVE", L"PropertySheet notification", MB_ICONINFORMATION | MB_OK);
-				//	break;
+				// Page activated (switched to) -- our MonitorSummaryItems' profiles should load first
+				//
+				case PSN_SETACTIVE:
+					ProfileLoader::SetVisibleWindow(hWnd);
+					break;
 
 				//// Leaving page
 				////
@@ -495,6 +497,60 @@ INT_PTR CALLBACK SummaryPageProc(HWND hWnd, UINT uMessage, WPARAM wParam, LPARAM
 	return 0;
 }
 
+// Dialog procedure for the Diagnostics page, which is only shown with /stats
+//
+INT_PTR CALLBACK DiagnosticsPageProc(HWND hWnd, UINT uMessage, WPARAM wParam, LPARAM lParam) {
+	UNREFERENCED_PARAMETER(wParam);
+
+	switch (uMessage) {
+		case WM_INITDIALOG:
+		{
+			HWND hwndText = GetDlgItem(hWnd, IDC_DIAGNOSTICS_TEXT);
+
+			// This page and its text should grow with resizing
+			//
+			ANCHOR_PRESET anchorPreset;
+			anchorPreset.hwnd = hWnd;
+			anchorPreset.anchorLeft = true;
+			anchorPreset.anchorTop = true;
+			anchorPreset.anchorRight = true;
+			anchorPreset.anchorBottom = true;
+			Resize::AddAnchorPreset(anchorPreset);
+
+			anchorPreset.hwnd = hwndText;
+			Resize::AddAnchorPreset(anchorPreset);
+
+			// Fix up the size of the text in case the Summary tab was resized before this tab was created
+			//
+			Resize::GrowForEarlierResize(hWnd, hwndText, true);
+			Resize::SetNeedRebuild(true);
+
+			// The counters are laid out in columns, so they need a fixed-pitch font
+			//
+			SendMessage(hwndText, WM_SETFONT, reinterpret_cast<WPARAM>(GetStockObject(ANSI_FIXED_FONT)), FALSE);
+			return FALSE;
+			break;
+		}
+
+		// Force the page and the read-only edit control to be white
+		//
+		case WM_CTLCOLORDLG:
+		case WM_CTLCOLORSTATIC:
+			return reinterpret_cast<INT_PTR>(GetStockObject(WHITE_BRUSH));
+			break;
+
+		// Show fresh numbers each time the page is activated
+		//
+		case WM_NOTIFY:
+			if ( PSN_SETACTIVE == reinterpret_cast<NMHDR *>(lParam)->code ) {
+				SetDlgItemText(hWnd, IDC_DIAGNOSTICS_TEXT, (CountersString() + Profile::MemoryString()).c_str());
+			}
+			break;
+
+	}
+	return 0;
+}
+
 // Subclass procedure for the main PropertySheet
 //
 INT_PTR CALLBACK PropSheetSubclassProc(HWND hWnd, UINT uMessage, WPARAM wParam, LPARAM lParam) {
@@ -596,7 +652,7 @@ int CALLBACK PropSheetCallback(HWND hWnd, UINT uMsg, LPARAM lParam) {
 
 // Show a property sheet
 //
-int ShowPropertySheet(int nShowCmd) {
+int ShowPropertySheet(int nShowCmd, bool showDiagnostics) {
 
 	UNREFERENCED_PARAMETER(nShowCmd);
 
@@ -611,6 +667,7 @@ int ShowPropertySheet(int nShowCmd) {
 	//
 	MonitorSummaryItem::RegisterWindowClass();
 	LUTview::RegisterWindowClass();
+	DetailsView::RegisterWindowClass();
 
 	// Set up property sheet
 	//
@@ -619,7 +676,7 @@ int ShowPropertySheet(int nShowCmd) {
 	wchar_t (* headers)[128] = NULL;
 	try {
 		size_t listSize = Monitor::GetListSize();
-		size_t pageCount = 1 + listSize;
+		size_t pageCount = 1 + listSize + (showDiagnostics ? 1 : 0);
 		pages = new PROPSHEETPAGE[pageCount];
 		headers = (wchar_t (*)[128])new wchar_t[listSize * 128];
 		SecureZeroMemory(&psh, sizeof(psh));
@@ -657,6 +714,19 @@ int ShowPropertySheet(int nShowCmd) {
 			pages[i+1].dwFlags = PSP_USETITLE;
 		}
 
+		// Set up the Diagnostics page, last
+		//
+		if (showDiagnostics) {
+			pages[pageCount-1].dwSize = sizeof(pages[0]);
+			pages[pageCount-1].hInstance = g_hInst;
+			pages[pageCount-1].pszTemplate = VistaOrHigher() ?
+					MAKEINTRESOURCE(IDD_DIAGNOSTICS_PAGE_VISTA) :
+					MAKEINTRESOURCE(IDD_DIAGNOSTICS_PAGE_XP);
+			pages[pageCount-1].pszIcon = NULL;
+			pages[pageCount-1].pfnDlgProc = DiagnosticsPageProc;
+			pages[pageCount-1].lParam = 0;
+		}
+
 		// Show the PropertySheet window
 		//
 		psh.dwSize = sizeof(psh);
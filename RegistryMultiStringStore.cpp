@@ -0,0 +1,99 @@
+// RegistryMultiStringStore.cpp -- The real registry as a MultiStringStore
+//
+
+#include "stdafx.h"
+#include "RegistryMultiStringStore.h"
+#include <strsafe.h>
+//#include <banned.h>
+
+// The root keys we can name in a key path
+//
+typedef struct tag_REGISTRY_ROOT {
+	HKEY				hKey;
+	const wchar_t *		name;
+} REGISTRY_ROOT;
+
+// Global static symbols internal to this file
+//
+static const REGISTRY_ROOT registryRoots[] = {
+	{ HKEY_CURRENT_USER,	L"HKEY_CURRENT_USER" },
+	{ HKEY_LOCAL_MACHINE,	L"HKEY_LOCAL_MACHINE" },
+	{ HKEY_USERS,			L"HKEY_USERS" },
+	{ HKEY_CLASSES_ROOT,	L"HKEY_CLASSES_ROOT" },
+	{ HKEY_CURRENT_CONFIG,	L"HKEY_CURRENT_CONFIG" }
+};
+
+// Name a key by its full path, root included
+//
+wstring RegistryKeyPath(HKEY hKeyBase, const wchar_t * registryKey) {
+	wstring keyPath;
+	for (size_t i = 0; i < _countof(registryRoots); ++i) {
+		if ( hKeyBase == registryRoots[i].hKey ) {
+			keyPath = registryRoots[i].name;
+			break;
+		}
+	}
+	keyPath += L"\\";
+	keyPath += registryKey;
+	return keyPath;
+}
+
+// Split a key path back into a root key and the path below it
+//
+static bool SplitKeyPath(const wstring & keyPath, HKEY & hKeyBase, wstring & registryKey) {
+	size_t separator = keyPath.find(L'\\');
+	if ( wstring::npos == separator ) {
+		return false;
+	}
+	wstring rootName = keyPath.substr(0, separator);
+	for (size_t i = 0; i < _countof(registryRoots); ++i) {
+		if ( 0 == _wcsicmp(rootName.c_str(), registryRoots[i].name) ) {
+			hKeyBase = registryRoots[i].hKey;
+			registryKey = keyPath.substr(separator + 1);
+			return true;
+		}
+	}
+	return false;
+}
+
+// Read the value, apply the edits, write it back; a missing value is treated as an empty list
+//
+bool RegistryMultiStringStore::Update(const wstring & keyPath, const wchar_t * valueName, const MultiStringEdit & edit) {
+	HKEY hKeyBase;
+	wstring registryKey;
+	if ( !SplitKeyPath(keyPath, hKeyBase, registryKey) ) {
+		return false;
+	}
+	HKEY hKey = 0;
+	bool success = false;
+	if (ERROR_SUCCESS == RegOpenKeyEx(hKeyBase, registryKey.c_str(), 0, KEY_QUERY_VALUE | KEY_SET_VALUE, &hKey)) {
+		vector <wstring> strings;
+		DWORD dataSize = 0;
+		LONG returnValue = RegQueryValueEx(hKey, valueName, NULL, NULL, NULL, &dataSize);
+		if (ERROR_SUCCESS == returnValue) {
+			dataSize += 2 * sizeof(wchar_t);			// Room for terminators the registry may not have
+			BYTE * data = new BYTE[dataSize];
+			SecureZeroMemory(data, dataSize);
+			returnValue = RegQueryValueEx(hKey, valueName, NULL, NULL, data, &dataSize);
+			if (ERROR_SUCCESS == returnValue) {
+				ParseMultiString(reinterpret_cast<wchar_t *>(data), strings);
+			}
+			delete [] data;
+		} else if (ERROR_FILE_NOT_FOUND == returnValue) {
+			returnValue = ERROR_SUCCESS;
+		}
+		if (ERROR_SUCCESS == returnValue) {
+			edit.ApplyTo(strings);
+			wstring data = BuildMultiString(strings);
+			success = (ERROR_SUCCESS == RegSetValueEx(
+					hKey,
+					valueName,
+					NULL,
+					REG_MULTI_SZ,
+					reinterpret_cast<const BYTE *>(data.c_str()),
+					static_cast<DWORD>(data.size() * sizeof(wchar_t)) ));
+		}
+		RegCloseKey(hKey);
+	}
+	return success;
+}
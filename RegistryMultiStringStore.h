@@ -0,0 +1,16 @@
+// RegistryMultiStringStore.h -- The real registry as a MultiStringStore
+//
+
+#pragma once
+#include "stdafx.h"
+#include "MultiStringList.h"
+
+wstring RegistryKeyPath(HKEY hKeyBase, const wchar_t * registryKey);
+
+// Keys are named "HKEY_LOCAL_MACHINE\Software\...", as RegistryKeyPath() builds them
+//
+class RegistryMultiStringStore : public MultiStringStore {
+
+public:
+	bool Update(const wstring & keyPath, const wchar_t * valueName, const MultiStringEdit & edit);
+};
@@ -3,6 +3,7 @@
 
 #pragma once
 #include "stdafx.h"
+#include "PropertySheet.h"
 #include "Resize.h"
 #include "Utility.h"
 #include "resource.h"
@@ -239,6 +240,39 @@ void Resize::MainWindowHasResized(const WINDOWPOS & windowPos) {
 	}
 }
 
+// Grow a control on a page created after the Summary tab was resized, by the amount the hidden
+//  IDC_RESIZED control has grown beyond IDC_ORIGINAL_SIZE; height always, width if asked
+//
+void Resize::GrowForEarlierResize(HWND hwndPage, HWND hwndChild, bool growWidth) {
+	if ( 0 == hwnd_IDC_ORIGINAL_SIZE || 0 == hwnd_IDC_RESIZED ) {
+		return;
+	}
+	RECT originalSize;
+	RECT newSize;
+	SecureZeroMemory(&originalSize, sizeof(originalSize));
+	GetClientRect(hwnd_IDC_ORIGINAL_SIZE, &originalSize);
+	SecureZeroMemory(&newSize, sizeof(newSize));
+	GetClientRect(hwnd_IDC_RESIZED, &newSize);
+	SIZE sizeDelta;
+	sizeDelta.cx = growWidth ? (newSize.right - originalSize.right) : 0;
+	sizeDelta.cy = newSize.bottom - originalSize.bottom;
+	if ( (0 != sizeDelta.cx) || (0 != sizeDelta.cy) ) {
+		WINDOWINFO wiParent;
+		SecureZeroMemory(&wiParent, sizeof(wiParent));
+		wiParent.cbSize = sizeof(wiParent);
+		GetWindowInfo(hwndPage, &wiParent);
+		RECT rect;
+		GetWindowRect(hwndChild, &rect);
+		rect.left -= wiParent.rcClient.left;
+		rect.top -= wiParent.rcClient.top;
+		rect.right -= wiParent.rcClient.left;
+		rect.bottom -= wiParent.rcClient.top;
+		rect.right += sizeDelta.cx;
+		rect.bottom += sizeDelta.cy;
+		MoveWindow(hwndChild, rect.left, rect.top, rect.right - rect.left, rect.bottom - rect.top, FALSE);
+	}
+}
+
 // Clear the list of Resize objects
 //
 void Resize::ClearResizeList(bool freeAllMemory) {
@@ -35,6 +35,7 @@ public:
 	static void AddAnchorPreset(const ANCHOR_PRESET & anchorPreset);
 	static void SetupForResizing(HWND parentBase);
 	static void MainWindowHasResized(const WINDOWPOS & windowPos);
+	static void GrowForEarlierResize(HWND hwndPage, HWND hwndChild, bool growWidth);
 	static void ClearResizeList(bool freeAllMemory);
 	static void ClearAnchorPresetList(bool freeAllMemory);
 
@@ -0,0 +1,231 @@
+// Snapshot.cpp -- Save the LUT state of all monitors to a file, and put it back quickly from that file
+//
+// Restoring does not look at profiles or the registry at all:  we map the file, check that each
+//  monitor is still where it was, and write the saved LUT.  This makes it a fast way to recover
+//  after a driver reset, and the file is also a compact record of what a machine was set to.
+//
+
+#include "stdafx.h"
+#include "Adapter.h"
+#include "Counters.h"
+#include "Monitor.h"
+#include "Snapshot.h"
+#include "Utility.h"
+#include <strsafe.h>
+//#include <banned.h>
+
+// Symbols defined in other files
+//
+extern wchar_t * ColorDirectory;
+
+// Some constants
+//
+#define HASH_BUFFER_SIZE			65536
+
+// Hash a profile file's contents, so that a snapshot records which version of a profile it came from
+//
+static DWORD HashProfileFile(const wstring & profileName) {
+	DWORD hash = FNV_OFFSET_BASIS;
+	if ( 0 == ColorDirectory ) {
+		return hash;
+	}
+	wstring filePath = ColorDirectory;
+	filePath += L"\\";
+	filePath += profileName;
+	HANDLE hFile = CreateFile(filePath.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+	if ( INVALID_HANDLE_VALUE != hFile ) {
+		BYTE * buffer = new BYTE[HASH_BUFFER_SIZE];
+		DWORD cb = 0;
+		while ( ReadFile(hFile, buffer, HASH_BUFFER_SIZE, &cb, NULL) && cb ) {
+			hash = HashBytes(buffer, cb, hash);
+		}
+		delete [] buffer;
+		CloseHandle(hFile);
+	}
+	return hash;
+}
+
+// Write a snapshot of every monitor's active profile and LUTs
+//
+int ExportSnapshot(const wchar_t * snapshotPath) {
+	size_t count = Monitor::GetListSize();
+
+	SNAPSHOT_HEADER header;
+	SecureZeroMemory(&header, sizeof(header));
+	header.signature = SNAPSHOT_SIGNATURE;
+	header.version = SNAPSHOT_VERSION;
+	header.headerSize = sizeof(SNAPSHOT_HEADER);
+	header.recordSize = sizeof(SNAPSHOT_MONITOR);
+	header.monitorCount = static_cast<DWORD>(count);
+	GetSystemTimeAsFileTime(&header.created);
+
+	SNAPSHOT_MONITOR * records = new SNAPSHOT_MONITOR[count ? count : 1];
+	SecureZeroMemory(records, sizeof(SNAPSHOT_MONITOR) * (count ? count : 1));
+	for (size_t i = 0; i < count; ++i) {
+		Monitor * monitor = Monitor::Get(i);
+		SNAPSHOT_MONITOR & record = records[i];
+		StringCbCopy(record.adapterName, sizeof(record.adapterName), monitor->GetAdapter()->GetDeviceName().c_str());
+		StringCbCopy(record.deviceID, sizeof(record.deviceID), monitor->GetDeviceID().c_str());
+
+		// What the profile says we should have, or linear if it has no 'vcgt'
+		//
+		GetSignedLUT(&record.profileLUT);
+		Profile * activeProfile = monitor->GetActiveProfile();
+		if (activeProfile) {
+			activeProfile->LoadFullProfile(false);
+			record.flags |= SMF_HAS_PROFILE;
+			StringCbCopy(record.profileName, sizeof(record.profileName), activeProfile->GetName().c_str());
+			record.profileHash = HashProfileFile(activeProfile->GetName());
+			const LUT * pLUT = activeProfile->GetLutPointer();
+			if (pLUT) {
+				memcpy_s(&record.profileLUT, sizeof(record.profileLUT), pLUT, sizeof(LUT));
+				record.flags |= SMF_HAS_PROFILE_LUT;
+			}
+		}
+
+		// What is on the card
+		//
+		const LUT * cardLUT = monitor->GetLutPointer();
+		if (cardLUT) {
+			memcpy_s(&record.cardLUT, sizeof(record.cardLUT), cardLUT, sizeof(LUT));
+			record.flags |= SMF_HAS_CARD_LUT;
+		}
+	}
+
+	// Write it all in one go
+	//
+	bool success = false;
+	HANDLE hFile = CreateFile(snapshotPath, GENERIC_WRITE, 0, NULL, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, NULL);
+	if ( INVALID_HANDLE_VALUE != hFile ) {
+		DWORD cb = 0;
+		DWORD recordBytes = static_cast<DWORD>(sizeof(SNAPSHOT_MONITOR) * count);
+		success = WriteFile(hFile, &header, sizeof(header), &cb, NULL) && (sizeof(header) == cb);
+		if ( success && recordBytes ) {
+			success = WriteFile(hFile, records, recordBytes, &cb, NULL) && (recordBytes == cb);
+		}
+		CloseHandle(hFile);
+	}
+	delete [] records;
+	if ( !success ) {
+		WriteToConsole(ShowError(L"WriteFile", 0, L"Cannot write snapshot\r\n"));
+	}
+	return success ? 0 : 1;
+}
+
+// Return 'true' if a record's strings end within their fields; a snapshot is only a file, and a
+//  corrupt one must not send us reading past the record
+//
+static bool RecordIsTerminated(const SNAPSHOT_MONITOR & record) {
+	return ( (wcsnlen(record.adapterName, _countof(record.adapterName)) < _countof(record.adapterName))
+			&& (wcsnlen(record.deviceID, _countof(record.deviceID)) < _countof(record.deviceID)) );
+}
+
+// Return 'true' if the adapter still has a monitor with this DeviceID
+//
+static bool MonitorIsStillThere(const SNAPSHOT_MONITOR & record) {
+	DISPLAY_DEVICE displayMonitor;
+	SecureZeroMemory(&displayMonitor, sizeof(displayMonitor));
+	displayMonitor.cb = sizeof(displayMonitor);
+	for ( DWORD i = 0; EnumDisplayDevices(record.adapterName, i, &displayMonitor, 0); ++i ) {
+		if ( Monitor::IsActive(displayMonitor) && (0 == _wcsicmp(displayMonitor.DeviceID, record.deviceID)) ) {
+			return true;
+		}
+	}
+	return false;
+}
+
+// Map a snapshot and load its LUTs, without looking at profiles or the registry
+//
+int RestoreSnapshot(const wchar_t * snapshotPath) {
+	HANDLE hFile = CreateFile(snapshotPath, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, 0, NULL);
+	if ( INVALID_HANDLE_VALUE == hFile ) {
+		WriteToConsole(ShowError(L"CreateFile", 0, L"Cannot open snapshot\r\n"));
+		return 1;
+	}
+	LARGE_INTEGER fileSize;
+	fileSize.QuadPart = 0;
+	GetFileSizeEx(hFile, &fileSize);
+	HANDLE hMapping = 0;
+	const BYTE * view = 0;
+	if ( fileSize.QuadPart >= static_cast<LONGLONG>(sizeof(SNAPSHOT_HEADER)) ) {
+		hMapping = CreateFileMapping(hFile, NULL, PAGE_READONLY, 0, 0, NULL);
+		if (hMapping) {
+			view = reinterpret_cast<const BYTE *>(MapViewOfFile(hMapping, FILE_MAP_READ, 0, 0, 0));
+		}
+	}
+
+	// Check the header against what we expect and against the file size
+	//
+	int retVal = 1;
+	const SNAPSHOT_HEADER * header = reinterpret_cast<const SNAPSHOT_HEADER *>(view);
+	if ( header
+			&& (SNAPSHOT_SIGNATURE == header->signature)
+			&& (SNAPSHOT_VERSION == header->version)
+			&& (sizeof(SNAPSHOT_HEADER) == header->headerSize)
+			&& (sizeof(SNAPSHOT_MONITOR) == header->recordSize)
+			&& (fileSize.QuadPart >= sizeof(SNAPSHOT_HEADER) + static_cast<LONGLONG>(header->monitorCount) * sizeof(SNAPSHOT_MONITOR)) ) {
+
+		// Signature to "the screen" first, as in LoadAllLUTs() (see LUT.h)
+		//
+		LUT signedLUT;
+		GetSignedLUT(&signedLUT);
+		HDC hdc = GetDC(0);
+		if (hdc) {
+			CountEvent(PC_DC_CREATIONS);
+			++signedLUT.red[1];
+			SetDeviceGammaRamp(hdc, &signedLUT);
+			--signedLUT.red[1];
+			SetDeviceGammaRamp(hdc, &signedLUT);
+			CountEvent(PC_RAMP_WRITES, 2);
+			ReleaseDC(0, hdc);
+		}
+
+		// Then each monitor that is still where it was
+		//
+		retVal = 0;
+		const SNAPSHOT_MONITOR * records = reinterpret_cast<const SNAPSHOT_MONITOR *>(view + sizeof(SNAPSHOT_HEADER));
+		for (DWORD i = 0; i < header->monitorCount; ++i) {
+			if ( !RecordIsTerminated(records[i]) ) {
+				wchar_t buf[128];
+				StringCbPrintf(buf, sizeof(buf), L"Monitor record %u is corrupt, LUT not loaded\r\n", i);
+				WriteToConsole(buf);
+				retVal = 1;
+				continue;
+			}
+			if ( !MonitorIsStillThere(records[i]) ) {
+				wstring s = records[i].deviceID;
+				s += L": monitor not found, LUT not loaded\r\n";
+				WriteToConsole(s);
+				retVal = 1;
+				continue;
+			}
+			BOOL bRet = 0;
+			hdc = CreateDC(records[i].adapterName, 0, 0, 0);
+			if (hdc) {
+				CountEvent(PC_DC_CREATIONS);
+				LUT restoreLUT;
+				memcpy_s(&restoreLUT, sizeof(restoreLUT), &records[i].profileLUT, sizeof(LUT));
+				++restoreLUT.red[0];						// Same double write as Monitor::WriteLutToCard()
+				SetDeviceGammaRamp(hdc, &restoreLUT);
+				--restoreLUT.red[0];
+				bRet = SetDeviceGammaRamp(hdc, &restoreLUT);
+				CountEvent(PC_RAMP_WRITES, 2);
+				DeleteDC(hdc);
+			}
+			if ( !bRet ) {
+				retVal = 1;
+			}
+		}
+	} else {
+		WriteToConsole(L"Not a valid LUT Loader snapshot file\r\n");
+	}
+
+	if (view) {
+		UnmapViewOfFile(view);
+	}
+	if (hMapping) {
+		CloseHandle(hMapping);
+	}
+	CloseHandle(hFile);
+	return retVal;
+}
@@ -0,0 +1,42 @@
+// Snapshot.h -- Save the LUT state of all monitors to a file, and put it back quickly from that file
+//
+
+#pragma once
+#include "stdafx.h"
+#include "LUT.h"
+
+// Some constants
+//
+#define SNAPSHOT_SIGNATURE			0x5354554C		// "LUTS" as bytes in the file
+#define SNAPSHOT_VERSION			1
+
+// Flags in SNAPSHOT_MONITOR
+//
+#define SMF_HAS_PROFILE				0x00000001		// An active profile was found
+#define SMF_HAS_PROFILE_LUT			0x00000002		// ... and it had a 'vcgt' (else we restore linear)
+#define SMF_HAS_CARD_LUT			0x00000004		// We were able to read the LUT from the card
+
+// Snapshot file layout:  a header followed by 'monitorCount' fixed-size records; all little-endian,
+//  no pointers, so a mapped view of the file can be used as it is
+//
+typedef struct tag_SNAPSHOT_HEADER {
+	DWORD			signature;						// SNAPSHOT_SIGNATURE
+	DWORD			version;						// SNAPSHOT_VERSION
+	DWORD			headerSize;						// sizeof(SNAPSHOT_HEADER)
+	DWORD			recordSize;						// sizeof(SNAPSHOT_MONITOR)
+	DWORD			monitorCount;					// Number of records that follow
+	FILETIME		created;						// When the snapshot was taken (UTC)
+} SNAPSHOT_HEADER;
+
+typedef struct tag_SNAPSHOT_MONITOR {
+	wchar_t			adapterName[32];				// DISPLAY_DEVICE.DeviceName of the adapter, for CreateDC()
+	wchar_t			deviceID[128];					// DISPLAY_DEVICE.DeviceID of the monitor
+	wchar_t			profileName[MAX_PATH];			// Active profile file name, without path
+	DWORD			profileHash;					// HashBytes() of the profile file
+	DWORD			flags;							// SMF_xxx
+	LUT				profileLUT;						// The LUT we should load
+	LUT				cardLUT;						// The LUT that was on the card when we took the snapshot
+} SNAPSHOT_MONITOR;
+
+int ExportSnapshot(const wchar_t * snapshotPath);
+int RestoreSnapshot(const wchar_t * snapshotPath);
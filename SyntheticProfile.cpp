@@ -0,0 +1,531 @@
+// SyntheticProfile.cpp -- Build made-up display profiles for benchmarks and parser testing
+//
+// A profile is a 128-byte header, a tag count, a tag table and the tag data, all big-endian.  We
+//  build each tag's data separately, then lay them out (4-byte aligned, with the three TRC tags
+//  sharing one copy of their data as real profiles do) and fill in the header and tag table.
+//  Damage, if any, is done last, to the finished bytes.
+//
+
+#include <math.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <string.h>
+#include "SyntheticProfile.h"
+
+// Some constants
+//
+#define ICC_HEADER_SIZE			128
+#define ICC_TAG_ENTRY_SIZE		12
+#define OVERSIZED_TAG_COUNT		5000				// Well beyond the 1024 tags we are willing to read
+#define MAX_EXTRA_TAG_COUNT		100
+#define WCS_SAMPLE_COUNT		64					// Measurement samples in the Color Device Model
+
+typedef std::vector<unsigned char> BYTE_VECTOR;
+
+// A deterministic random number generator (xorshift32), so a corpus doesn't depend on the
+//  C library's rand()
+//
+typedef struct tag_SYNTHETIC_RANDOM {
+	unsigned int		state;
+} SYNTHETIC_RANDOM;
+
+typedef struct tag_SYNTHETIC_TAG {
+	unsigned int		signature;
+	BYTE_VECTOR			data;
+	int					sharedWith;					// Index of an earlier tag whose data we use, or -1
+} SYNTHETIC_TAG;
+
+// Seed a generator, scrambling the seed so nearby seeds give unrelated sequences
+//
+static void SeedRandom(SYNTHETIC_RANDOM & random, unsigned int seed) {
+	seed ^= seed >> 16;
+	seed *= 0x7FEB352Du;
+	seed ^= seed >> 15;
+	seed *= 0x846CA68Bu;
+	seed ^= seed >> 16;
+	random.state = seed ? seed : 0x9E3779B9u;
+}
+
+static unsigned int NextRandom(SYNTHETIC_RANDOM & random) {
+	unsigned int x = random.state;
+	x ^= x << 13;
+	x ^= x >> 17;
+	x ^= x << 5;
+	random.state = x;
+	return x;
+}
+
+// Return a number from 0 to limit - 1
+//
+static unsigned int RandomBelow(SYNTHETIC_RANDOM & random, unsigned int limit) {
+	return limit ? (NextRandom(random) % limit) : 0;
+}
+
+// Return 'true' about 'percent' times in a hundred
+//
+static bool RandomPercent(SYNTHETIC_RANDOM & random, unsigned int percent) {
+	return RandomBelow(random, 100) < percent;
+}
+
+static double RandomBetween(SYNTHETIC_RANDOM & random, double low, double high) {
+	return low + (high - low) * (double(NextRandom(random)) / 4294967295.0);
+}
+
+// Format text into a fixed buffer, truncating rather than overrunning it.  Visual C++ wants the
+//  checked version; everyone else gets vsnprintf().
+//
+static void FormatText(char * buf, size_t size, const char * format, ...) {
+	va_list args;
+	va_start(args, format);
+#if defined(_MSC_VER)
+	vsnprintf_s(buf, size, _TRUNCATE, format, args);
+#else
+	vsnprintf(buf, size, format, args);
+#endif
+	va_end(args);
+}
+
+// Append numbers big-endian, as ICC profiles store them
+//
+static void Append16(BYTE_VECTOR & bytes, unsigned int value) {
+	bytes.push_back(static_cast<unsigned char>(value >> 8));
+	bytes.push_back(static_cast<unsigned char>(value));
+}
+
+static void Append32(BYTE_VECTOR & bytes, unsigned int value) {
+	bytes.push_back(static_cast<unsigned char>(value >> 24));
+	bytes.push_back(static_cast<unsigned char>(value >> 16));
+	bytes.push_back(static_cast<unsigned char>(value >> 8));
+	bytes.push_back(static_cast<unsigned char>(value));
+}
+
+static void AppendS15Fixed16(BYTE_VECTOR & bytes, double value) {
+	Append32(bytes, static_cast<unsigned int>(static_cast<int>(floor(value * 65536.0 + 0.5))));
+}
+
+static void Store32(BYTE_VECTOR & bytes, size_t offset, unsigned int value) {
+	bytes[offset] = static_cast<unsigned char>(value >> 24);
+	bytes[offset + 1] = static_cast<unsigned char>(value >> 16);
+	bytes[offset + 2] = static_cast<unsigned char>(value >> 8);
+	bytes[offset + 3] = static_cast<unsigned char>(value);
+}
+
+// Append ASCII text as little-endian UTF-16, as the XML in an 'MS00' tag is stored
+//
+static void AppendUtf16LE(BYTE_VECTOR & bytes, const char * text) {
+	for (const char * p = text; *p; ++p) {
+		bytes.push_back(static_cast<unsigned char>(*p));
+		bytes.push_back(0);
+	}
+}
+
+static void AppendTagHeader(BYTE_VECTOR & bytes, unsigned int tagType) {
+	Append32(bytes, tagType);
+	Append32(bytes, 0);								// Reserved
+}
+
+// Build a 'desc' (v2 textDescriptionType), 'text' or 'mluc' tag
+//
+static void BuildDescTag(BYTE_VECTOR & bytes, const char * text) {
+	size_t length = strlen(text);
+	AppendTagHeader(bytes, 'desc');
+	Append32(bytes, static_cast<unsigned int>(length + 1));
+	bytes.insert(bytes.end(), text, text + length + 1);
+	Append32(bytes, 0);								// Unicode language code
+	Append32(bytes, 0);								// Unicode count
+	Append16(bytes, 0);								// ScriptCode code
+	bytes.push_back(0);								// ScriptCode count
+	bytes.insert(bytes.end(), 67, 0);				// ScriptCode string
+}
+
+static void BuildTextTag(BYTE_VECTOR & bytes, const char * text) {
+	AppendTagHeader(bytes, 'text');
+	bytes.insert(bytes.end(), text, text + strlen(text) + 1);
+}
+
+static void BuildMlucTag(BYTE_VECTOR & bytes, const char * text) {
+	size_t length = strlen(text);
+	AppendTagHeader(bytes, 'mluc');
+	Append32(bytes, 1);								// Record count
+	Append32(bytes, 12);							// Record size
+	Append32(bytes, 'enUS');
+	Append32(bytes, static_cast<unsigned int>(2 * length));
+	Append32(bytes, 28);							// Offset of the string from the start of the tag
+	for (size_t i = 0; i < length; ++i) {
+		Append16(bytes, static_cast<unsigned char>(text[i]));
+	}
+}
+
+static void BuildXyzTag(BYTE_VECTOR & bytes, double x, double y, double z) {
+	AppendTagHeader(bytes, 'XYZ ');
+	AppendS15Fixed16(bytes, x);
+	AppendS15Fixed16(bytes, y);
+	AppendS15Fixed16(bytes, z);
+}
+
+static void BuildCurveTag(BYTE_VECTOR & bytes, SYNTHETIC_CURVE curves, double gamma) {
+	switch (curves) {
+		case SCURVE_GAMMA:
+			AppendTagHeader(bytes, 'curv');
+			Append32(bytes, 1);
+			Append16(bytes, static_cast<unsigned int>(gamma * 256.0 + 0.5));	// u8Fixed8Number
+			break;
+
+		case SCURVE_TABLE:
+			AppendTagHeader(bytes, 'curv');
+			Append32(bytes, 256);
+			for (unsigned int i = 0; i < 256; ++i) {
+				Append16(bytes, static_cast<unsigned int>(pow(i / 255.0, gamma) * 65535.0 + 0.5));
+			}
+			break;
+
+		case SCURVE_PARAMETRIC:
+			AppendTagHeader(bytes, 'para');
+			Append16(bytes, 0);							// Function type 0:  Y = X ^ gamma
+			Append16(bytes, 0);							// Reserved
+			AppendS15Fixed16(bytes, gamma);
+			break;
+	}
+}
+
+// Build a 'vcgt' tag:  a per-channel gamma, min and max, either as a formula or as a table
+//
+static void BuildVcgtTag(BYTE_VECTOR & bytes, const SYNTHETIC_PROFILE_OPTIONS & options, SYNTHETIC_RANDOM & random) {
+	double gamma[3];
+	double minimum[3];
+	double maximum[3];
+	for (int c = 0; c < 3; ++c) {
+		gamma[c] = RandomBetween(random, 0.8, 1.25);
+		minimum[c] = RandomBetween(random, 0.0, 0.04);
+		maximum[c] = RandomBetween(random, 0.92, 1.0);
+	}
+	AppendTagHeader(bytes, 'vcgt');
+	if (SVCGT_FORMULA == options.vcgt) {
+		Append32(bytes, 1);
+		for (int c = 0; c < 3; ++c) {
+			AppendS15Fixed16(bytes, gamma[c]);
+			AppendS15Fixed16(bytes, minimum[c]);
+			AppendS15Fixed16(bytes, maximum[c]);
+		}
+		return;
+	}
+
+	// Adobe Gamma writes a 2-byte table that uses only the high byte, and labels it 1-byte
+	//
+	unsigned int entryCount = options.adobeMislabeledVcgt ? 256 : options.vcgtEntryCount;
+	unsigned int itemSize = options.adobeMislabeledVcgt ? 2 : options.vcgtItemSize;
+	Append32(bytes, 0);
+	Append16(bytes, 3);
+	Append16(bytes, entryCount);
+	Append16(bytes, options.adobeMislabeledVcgt ? 1 : itemSize);
+	for (int c = 0; c < 3; ++c) {
+		for (unsigned int i = 0; i < entryCount; ++i) {
+			double level = minimum[c] + (maximum[c] - minimum[c]) * pow(double(i) / (entryCount - 1), gamma[c]);
+			if (1 == itemSize) {
+				bytes.push_back(static_cast<unsigned char>(level * 255.0 + 0.5));
+			} else if (options.adobeMislabeledVcgt) {
+				bytes.push_back(static_cast<unsigned char>(level * 255.0 + 0.5));
+				bytes.push_back(0);
+			} else {
+				Append16(bytes, static_cast<unsigned int>(level * 65535.0 + 0.5));
+			}
+		}
+	}
+}
+
+// Build an 'MS00' tag:  a header giving the offset and size of three UTF-16 XML documents
+//
+static void BuildWcsTag(BYTE_VECTOR & bytes, SYNTHETIC_RANDOM & random) {
+	char buf[256];
+	BYTE_VECTOR sections[3];
+
+	AppendUtf16LE(sections[0],
+			"<?xml version=\"1.0\" encoding=\"UTF-16\"?>\r\n"
+			"<cdm:ColorDeviceModel xmlns:cdm=\"http://schemas.microsoft.com/windows/2005/02/color/ColorDeviceModel\" "
+			"xmlns:wcs=\"http://schemas.microsoft.com/windows/2005/02/color/WcsCommonProfileTypes\" ID=\"1\">\r\n"
+			"  <cdm:ProfileName><wcs:Text xml:lang=\"en-US\">Synthetic display</wcs:Text></cdm:ProfileName>\r\n"
+			"  <cdm:LCDDevice>\r\n"
+			"    <cdm:MeasurementConditions><cdm:ColorSpace>CIEXYZ</cdm:ColorSpace></cdm:MeasurementConditions>\r\n"
+			"    <cdm:Calibration>\r\n" );
+	for (unsigned int i = 0; i < WCS_SAMPLE_COUNT; ++i) {
+		unsigned int red = RandomBelow(random, 256);
+		unsigned int green = RandomBelow(random, 256);
+		unsigned int blue = RandomBelow(random, 256);
+		double x = RandomBetween(random, 0.0, 95.0);
+		double y = RandomBetween(random, 0.0, 100.0);
+		double z = RandomBetween(random, 0.0, 108.0);
+		FormatText(buf, sizeof(buf),
+				"      <cdm:Sample R=\"%u\" G=\"%u\" B=\"%u\" X=\"%.4f\" Y=\"%.4f\" Z=\"%.4f\"/>\r\n",
+				red, green, blue, x, y, z );
+		AppendUtf16LE(sections[0], buf);
+	}
+	AppendUtf16LE(sections[0],
+			"    </cdm:Calibration>\r\n"
+			"  </cdm:LCDDevice>\r\n"
+			"</cdm:ColorDeviceModel>\r\n" );
+
+	double whiteX = RandomBetween(random, 94.0, 96.5);
+	double whiteZ = RandomBetween(random, 105.0, 110.0);
+	FormatText(buf, sizeof(buf),
+			"    <cam:WhitePoint><wcs:X>%.2f</wcs:X><wcs:Y>100.00</wcs:Y><wcs:Z>%.2f</wcs:Z></cam:WhitePoint>\r\n",
+			whiteX, whiteZ );
+	AppendUtf16LE(sections[1],
+			"<?xml version=\"1.0\" encoding=\"UTF-16\"?>\r\n"
+			"<cam:ColorAppearanceModel xmlns:cam=\"http://schemas.microsoft.com/windows/2005/02/color/ColorAppearanceModel\" "
+			"xmlns:wcs=\"http://schemas.microsoft.com/windows/2005/02/color/WcsCommonProfileTypes\" ID=\"1\">\r\n"
+			"  <cam:ViewingConditions>\r\n" );
+	AppendUtf16LE(sections[1], buf);
+	AppendUtf16LE(sections[1],
+			"    <cam:Background>20</cam:Background>\r\n"
+			"    <cam:Surround>Average</cam:Surround>\r\n"
+			"  </cam:ViewingConditions>\r\n"
+			"</cam:ColorAppearanceModel>\r\n" );
+
+	AppendUtf16LE(sections[2],
+			"<?xml version=\"1.0\" encoding=\"UTF-16\"?>\r\n"
+			"<gmm:GamutMapModel xmlns:gmm=\"http://schemas.microsoft.com/windows/2005/02/color/GamutMapModel\" ID=\"1\">\r\n"
+			"  <gmm:DefaultBaselineGamutMapModel>HueMapping</gmm:DefaultBaselineGamutMapModel>\r\n"
+			"</gmm:GamutMapModel>\r\n" );
+
+	size_t offset = 32;								// Sections follow the 32-byte header
+	Append32(bytes, 'MS10');
+	Append32(bytes, 0);
+	for (int i = 0; i < 3; ++i) {
+		Append32(bytes, static_cast<unsigned int>(offset));
+		Append32(bytes, static_cast<unsigned int>(sections[i].size()));
+		offset += sections[i].size();
+	}
+	for (int i = 0; i < 3; ++i) {
+		bytes.insert(bytes.end(), sections[i].begin(), sections[i].end());
+	}
+}
+
+// Add a tag to the list, returning its index
+//
+static int AddTag(std::vector<SYNTHETIC_TAG> & tags, unsigned int signature, int sharedWith = -1) {
+	tags.push_back(SYNTHETIC_TAG());
+	tags.back().signature = signature;
+	tags.back().sharedWith = sharedWith;
+	return static_cast<int>(tags.size()) - 1;
+}
+
+// Pick a mix of options that roughly matches what turns up in real color directories, with
+//  enough of the unusual cases to exercise every path in the parser
+//
+void ChooseSyntheticProfileOptions(unsigned int seed, SYNTHETIC_PROFILE_OPTIONS & options) {
+	SYNTHETIC_RANDOM random;
+	SeedRandom(random, seed ^ 0x4F505453u);
+
+	options.version4 = RandomPercent(random, 30);
+	options.extraTagCount = RandomPercent(random, 80) ? RandomBelow(random, 4) : RandomBelow(random, MAX_EXTRA_TAG_COUNT + 1);
+
+	unsigned int vcgtRoll = RandomBelow(random, 100);
+	options.vcgt = (vcgtRoll < 15) ? SVCGT_NONE : ( (vcgtRoll < 25) ? SVCGT_FORMULA : SVCGT_TABLE );
+	options.vcgtItemSize = RandomPercent(random, 80) ? 2 : 1;
+	unsigned int entryRoll = RandomBelow(random, 100);
+	options.vcgtEntryCount = (entryRoll < 90) ? 256 : ( (entryRoll < 95) ? 1024 : 4096 );
+	options.adobeMislabeledVcgt = (SVCGT_TABLE == options.vcgt) && RandomPercent(random, 3);
+
+	options.embeddedWcs = RandomPercent(random, 5);
+	options.curves = static_cast<SYNTHETIC_CURVE>(RandomBelow(random, 3));
+
+	// A short 'vcgt' tag only means something for a correctly labeled table; undamaged tables are
+	//  exactly as big as they need to be, so between them they test both sides of the size check
+	//
+	unsigned int damageRoll = RandomBelow(random, 100);
+	options.damage = (damageRoll < 88) ? SDAMAGE_NONE : static_cast<SYNTHETIC_DAMAGE>(1 + (damageRoll - 88) / 3);
+	if ( (SDAMAGE_SHORT_VCGT_TAG == options.damage) && ( (SVCGT_TABLE != options.vcgt) || options.adobeMislabeledVcgt ) ) {
+		options.damage = SDAMAGE_TRUNCATED;
+	}
+}
+
+// Return the largest tag count whose tag table fits in a file of 'size' bytes
+//
+static size_t MaxTagCount(size_t size) {
+	return (size - ICC_HEADER_SIZE - 4) / ICC_TAG_ENTRY_SIZE;
+}
+
+// Build a complete profile file from a seed and a set of options
+//
+void BuildSyntheticProfile(unsigned int seed, const SYNTHETIC_PROFILE_OPTIONS & options, BYTE_VECTOR & fileBytes) {
+	static const unsigned int cmmTypes[] = { 'lcms', 'ADBE', 'appl', 'argl', 'KCMS', 0 };
+	static const unsigned int manufacturers[] = { 'SAM ', 'DELL', 'ACR ', 'LEN ', 'NEC ', 'EIZO' };
+	char text[128];
+
+	SYNTHETIC_RANDOM random;
+	SeedRandom(random, seed);
+
+	// Build the tags
+	//
+	std::vector<SYNTHETIC_TAG> tags;
+	unsigned int model = 0x4D000000u | RandomBelow(random, 0x1000000);
+	FormatText(text, sizeof(text), "Synthetic display %u", seed);
+	int index = AddTag(tags, 'desc');
+	if (options.version4) {
+		BuildMlucTag(tags[index].data, text);
+	} else {
+		BuildDescTag(tags[index].data, text);
+	}
+	index = AddTag(tags, 'cprt');
+	if (options.version4) {
+		BuildMlucTag(tags[index].data, "No copyright, use freely");
+	} else {
+		BuildTextTag(tags[index].data, "No copyright, use freely");
+	}
+	// Draw the colorant values one at a time, in order:  the order in which function arguments are
+	//  evaluated is unspecified, and the same seed has to give the same bytes with any compiler
+	//
+	double whiteX = RandomBetween(random, 0.94, 0.97);
+	double whiteZ = RandomBetween(random, 0.80, 1.10);
+	index = AddTag(tags, 'wtpt');
+	BuildXyzTag(tags[index].data, whiteX, 1.0, whiteZ);
+	double redX = RandomBetween(random, 0.42, 0.46);
+	double redY = RandomBetween(random, 0.21, 0.24);
+	double redZ = RandomBetween(random, 0.01, 0.02);
+	index = AddTag(tags, 'rXYZ');
+	BuildXyzTag(tags[index].data, redX, redY, redZ);
+	double greenX = RandomBetween(random, 0.37, 0.40);
+	double greenY = RandomBetween(random, 0.70, 0.73);
+	double greenZ = RandomBetween(random, 0.09, 0.10);
+	index = AddTag(tags, 'gXYZ');
+	BuildXyzTag(tags[index].data, greenX, greenY, greenZ);
+	double blueX = RandomBetween(random, 0.14, 0.15);
+	double blueY = RandomBetween(random, 0.06, 0.07);
+	double blueZ = RandomBetween(random, 0.70, 0.72);
+	index = AddTag(tags, 'bXYZ');
+	BuildXyzTag(tags[index].data, blueX, blueY, blueZ);
+	double trcGamma = RandomBetween(random, 1.8, 2.6);
+	int trcIndex = AddTag(tags, 'rTRC');
+	BuildCurveTag(tags[trcIndex].data, options.curves, trcGamma);
+	AddTag(tags, 'gTRC', trcIndex);
+	AddTag(tags, 'bTRC', trcIndex);
+	index = AddTag(tags, 'tech');
+	AppendTagHeader(tags[index].data, 'sig ');
+	Append32(tags[index].data, 'vidm');
+	if (options.version4) {
+		index = AddTag(tags, 'chad');				// Bradford D65 to D50
+		AppendTagHeader(tags[index].data, 'sf32');
+		static const double bradford[9] = { 1.0479, 0.0229, -0.0502, 0.0296, 0.9904, -0.0171, -0.0092, 0.0151, 0.7519 };
+		for (int i = 0; i < 9; ++i) {
+			AppendS15Fixed16(tags[index].data, bradford[i]);
+		}
+	}
+	int vcgtIndex = -1;
+	if (SVCGT_NONE != options.vcgt) {
+		vcgtIndex = AddTag(tags, 'vcgt');
+		BuildVcgtTag(tags[vcgtIndex].data, options, random);
+	}
+	if (options.embeddedWcs) {
+		index = AddTag(tags, 'MS00');
+		BuildWcsTag(tags[index].data, random);
+	}
+	unsigned int extraTagCount = (options.extraTagCount > MAX_EXTRA_TAG_COUNT) ? MAX_EXTRA_TAG_COUNT : options.extraTagCount;
+	for (unsigned int i = 0; i < extraTagCount; ++i) {
+		index = AddTag(tags, 'Zx00' + ((i / 10) << 8) + (i % 10));
+		FormatText(text, sizeof(text), "Private tag %u", i);
+		BuildTextTag(tags[index].data, text);
+	}
+
+	// Lay out the file:  header, tag count, tag table, then each tag's data on a 4-byte boundary
+	//
+	size_t tagCount = tags.size();
+	std::vector<size_t> offsets(tagCount);
+	size_t size = ICC_HEADER_SIZE + 4 + (tagCount * ICC_TAG_ENTRY_SIZE);
+	for (size_t i = 0; i < tagCount; ++i) {
+		if (tags[i].sharedWith >= 0) {
+			offsets[i] = offsets[tags[i].sharedWith];
+			continue;
+		}
+		size = (size + 3) & ~static_cast<size_t>(3);
+		offsets[i] = size;
+		size += tags[i].data.size();
+	}
+	size_t dataEnd = size;							// End of the last tag, before padding
+	size = (size + 3) & ~static_cast<size_t>(3);
+	fileBytes.assign(size, 0);
+
+	// The header
+	//
+	Store32(fileBytes, 0, static_cast<unsigned int>(size));
+	Store32(fileBytes, 4, cmmTypes[RandomBelow(random, sizeof(cmmTypes) / sizeof(cmmTypes[0]))]);
+	Store32(fileBytes, 8, options.version4 ? 0x04300000u : 0x02100000u);
+	Store32(fileBytes, 12, 'mntr');
+	Store32(fileBytes, 16, 'RGB ');
+	Store32(fileBytes, 20, 'XYZ ');
+	unsigned int dateTime[6];
+	dateTime[0] = 1998 + RandomBelow(random, 27);	// Year, month, day, hours, minutes, seconds
+	dateTime[1] = 1 + RandomBelow(random, 12);
+	dateTime[2] = 1 + RandomBelow(random, 28);
+	dateTime[3] = RandomBelow(random, 24);
+	dateTime[4] = RandomBelow(random, 60);
+	dateTime[5] = RandomBelow(random, 60);
+	for (int i = 0; i < 6; ++i) {
+		fileBytes[24 + 2 * i] = static_cast<unsigned char>(dateTime[i] >> 8);
+		fileBytes[25 + 2 * i] = static_cast<unsigned char>(dateTime[i]);
+	}
+	Store32(fileBytes, 36, 'acsp');
+	Store32(fileBytes, 40, RandomPercent(random, 70) ? 'MSFT' : 'APPL');
+	Store32(fileBytes, 48, manufacturers[RandomBelow(random, sizeof(manufacturers) / sizeof(manufacturers[0]))]);
+	Store32(fileBytes, 52, model);
+	Store32(fileBytes, 68, 0x0000F6D6);				// D50 illuminant, as the ICC requires
+	Store32(fileBytes, 72, 0x00010000);
+	Store32(fileBytes, 76, 0x0000D32D);
+	Store32(fileBytes, 80, 'SYNT');
+
+	// The tag table and tag data
+	//
+	Store32(fileBytes, ICC_HEADER_SIZE, static_cast<unsigned int>(tagCount));
+	for (size_t i = 0; i < tagCount; ++i) {
+		size_t entry = ICC_HEADER_SIZE + 4 + (i * ICC_TAG_ENTRY_SIZE);
+		const SYNTHETIC_TAG & dataTag = tags[(tags[i].sharedWith >= 0) ? tags[i].sharedWith : i];
+		Store32(fileBytes, entry, tags[i].signature);
+		Store32(fileBytes, entry + 4, static_cast<unsigned int>(offsets[i]));
+		Store32(fileBytes, entry + 8, static_cast<unsigned int>(dataTag.data.size()));
+		if (tags[i].sharedWith < 0) {
+			memcpy(&fileBytes[offsets[i]], &tags[i].data[0], tags[i].data.size());
+		}
+	}
+
+	// Do any damage we were asked for.  Each kind is sure to make LoadFullProfile() fail:  a bad
+	//  offset points past the end, a bad tag count needs a tag table bigger than the file, and a
+	//  cut always takes off part of the last tag, not just padding.
+	//
+	switch (options.damage) {
+		case SDAMAGE_NONE:
+			break;
+
+		case SDAMAGE_BAD_TAG_OFFSET:
+			{
+				unsigned int badTag = RandomBelow(random, static_cast<unsigned int>(tagCount));
+				unsigned int badOffset = static_cast<unsigned int>(size + 1 + RandomBelow(random, 4096));
+				Store32(fileBytes, ICC_HEADER_SIZE + 4 + (badTag * ICC_TAG_ENTRY_SIZE) + 4, badOffset);
+			}
+			break;
+
+		case SDAMAGE_OVERSIZED_TAG_COUNT:
+			Store32(fileBytes, ICC_HEADER_SIZE,
+					RandomPercent(random, 50) ? OVERSIZED_TAG_COUNT : static_cast<unsigned int>(MaxTagCount(size) + 1 + RandomBelow(random, 200)));
+			break;
+
+		case SDAMAGE_TRUNCATED:
+			fileBytes.resize(1 + RandomBelow(random, static_cast<unsigned int>(dataEnd - 1)));
+			break;
+
+		case SDAMAGE_SHORT_VCGT_TAG:
+			if (vcgtIndex >= 0) {
+				Store32(fileBytes, ICC_HEADER_SIZE + 4 + (vcgtIndex * ICC_TAG_ENTRY_SIZE) + 8,
+						static_cast<unsigned int>(tags[vcgtIndex].data.size() - 1 - RandomBelow(random, 6)));
+			}
+			break;
+	}
+}
+
+// Return 'true' if LoadFullProfile() should accept a profile built with these options:  every
+//  kind of damage is fatal, and so is a 'vcgt' table without 256 entries per channel
+//
+bool SyntheticProfileShouldLoad(const SYNTHETIC_PROFILE_OPTIONS & options) {
+	if ( SDAMAGE_NONE != options.damage ) {
+		return false;
+	}
+	return ( (SVCGT_TABLE != options.vcgt) || options.adobeMislabeledVcgt || (256 == options.vcgtEntryCount) );
+}
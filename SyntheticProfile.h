@@ -0,0 +1,46 @@
+// SyntheticProfile.h -- Build made-up display profiles for benchmarks and parser testing
+//
+// SyntheticProfile.cpp uses only standard C++ (no <windows.h>, and no precompiled header), like
+//  GraphRaster.cpp, so the same profiles can be generated on another platform.  Everything is
+//  derived from a seed:  the same seed always gives the same options and the same bytes.  The
+//  /C switch writes a corpus of these profiles to a folder.
+//
+
+#pragma once
+#include <vector>
+
+typedef enum tag_SYNTHETIC_VCGT {
+	SVCGT_NONE = 0,
+	SVCGT_TABLE = 1,
+	SVCGT_FORMULA = 2
+} SYNTHETIC_VCGT;
+
+typedef enum tag_SYNTHETIC_CURVE {
+	SCURVE_GAMMA = 0,							// 'curv' with a single gamma value
+	SCURVE_TABLE = 1,							// 'curv' with 256 entries
+	SCURVE_PARAMETRIC = 2						// 'para', function type 0
+} SYNTHETIC_CURVE;
+
+typedef enum tag_SYNTHETIC_DAMAGE {
+	SDAMAGE_NONE = 0,
+	SDAMAGE_BAD_TAG_OFFSET = 1,					// One tag points past the end of the file
+	SDAMAGE_OVERSIZED_TAG_COUNT = 2,			// The tag count is more than the file can hold
+	SDAMAGE_TRUNCATED = 3,						// The file is cut short
+	SDAMAGE_SHORT_VCGT_TAG = 4					// The 'vcgt' tag is a few bytes too small for its table
+} SYNTHETIC_DAMAGE;
+
+typedef struct tag_SYNTHETIC_PROFILE_OPTIONS {
+	bool				version4;				// ICC v4 with 'mluc' text, else v2 with 'desc' and 'text'
+	unsigned int		extraTagCount;			// Private tags added after the usual ones (up to 100)
+	SYNTHETIC_VCGT		vcgt;
+	unsigned int		vcgtItemSize;			// 1 or 2
+	unsigned int		vcgtEntryCount;			// 256, 1024 or 4096; only 256 loads as a LUT
+	bool				adobeMislabeledVcgt;	// A 2-byte table labeled as 1-byte, as Adobe Gamma writes
+	bool				embeddedWcs;			// Add an 'MS00' tag holding a WCS profile
+	SYNTHETIC_CURVE		curves;					// Type of the rTRC, gTRC and bTRC tags
+	SYNTHETIC_DAMAGE	damage;
+} SYNTHETIC_PROFILE_OPTIONS;
+
+void ChooseSyntheticProfileOptions(unsigned int seed, SYNTHETIC_PROFILE_OPTIONS & options);
+void BuildSyntheticProfile(unsigned int seed, const SYNTHETIC_PROFILE_OPTIONS & options, std::vector<unsigned char> & fileBytes);
+bool SyntheticProfileShouldLoad(const SYNTHETIC_PROFILE_OPTIONS & options);
@@ -0,0 +1,212 @@
+// MultiStringListTest.cpp -- Tests and a benchmark for batched profile list edits
+//
+// Drives MultiStringEdit::ApplyTo() directly, and MemoryMultiStringStore::Update() the way
+//  Profile and the /M manifest code drive the registry store:  a batch of insert, remove and
+//  move-to-end edits per key, applied with one read and one write.
+//
+
+#include <string>
+#include <vector>
+#include <wchar.h>
+#include <wctype.h>
+#include "MultiStringList.h"
+#include "TestHarness.h"
+
+using std::vector;
+using std::wstring;
+
+// Some constants
+//
+#define USER_KEY		L"HKEY_CURRENT_USER\\Software\\Microsoft\\Windows NT\\CurrentVersion\\ICM\\ProfileAssociations\\Display\\0000"
+#define SYSTEM_KEY		L"HKEY_LOCAL_MACHINE\\SYSTEM\\CurrentControlSet\\Control\\Class\\{4d36e96e}\\0000"
+#define BENCHMARK_LIST_SIZE		2000
+#define BENCHMARK_EDIT_COUNT	500
+
+// Build a list from up to four names
+//
+static vector<wstring> MakeList(const wchar_t * a = 0, const wchar_t * b = 0, const wchar_t * c = 0, const wchar_t * d = 0) {
+	vector<wstring> strings;
+	const wchar_t * names[4] = { a, b, c, d };
+	for (int i = 0; i < 4; ++i) {
+		if (names[i]) {
+			strings.push_back(names[i]);
+		}
+	}
+	return strings;
+}
+
+static void TestInsertAtStart(void) {
+	vector<wstring> strings = MakeList(L"a.icm", L"b.icm");
+	MultiStringEdit edit;
+	CHECK(edit.IsEmpty());
+	edit.InsertAtStart(L"c.icm");
+	CHECK(!edit.IsEmpty());
+	edit.ApplyTo(strings);
+	CHECK(strings == MakeList(L"c.icm", L"a.icm", L"b.icm"));
+}
+
+// Remove takes out every copy, whatever its case, and leaves other names alone
+//
+static void TestRemove(void) {
+	vector<wstring> strings = MakeList(L"Calibrated.ICM", L"b.icm", L"calibrated.icm", L"d.icm");
+	MultiStringEdit edit;
+	edit.Remove(L"CALIBRATED.icm");
+	edit.ApplyTo(strings);
+	CHECK(strings == MakeList(L"b.icm", L"d.icm"));
+
+	MultiStringEdit missing;
+	missing.Remove(L"nothere.icm");
+	missing.ApplyTo(strings);
+	CHECK(strings == MakeList(L"b.icm", L"d.icm"));
+}
+
+// Move-to-end makes a name the last (default) entry, spelled as the edit spells it, and adds it
+//  if it was not on the list
+//
+static void TestMoveToEnd(void) {
+	vector<wstring> strings = MakeList(L"a.icm", L"B.ICM", L"c.icm");
+	MultiStringEdit edit;
+	edit.MoveToEnd(L"b.icm");
+	edit.ApplyTo(strings);
+	CHECK(strings == MakeList(L"a.icm", L"c.icm", L"b.icm"));
+
+	MultiStringEdit add;
+	add.MoveToEnd(L"new.icm");
+	add.ApplyTo(strings);
+	CHECK(strings == MakeList(L"a.icm", L"c.icm", L"b.icm", L"new.icm"));
+}
+
+// Edits in a batch apply in order, each one seeing the result of the last
+//
+static void TestBatchOrder(void) {
+	vector<wstring> strings = MakeList(L"a.icm", L"b.icm", L"c.icm");
+	MultiStringEdit edit;
+	edit.InsertAtStart(L"x.icm");
+	edit.MoveToEnd(L"A.icm");
+	edit.Remove(L"b.icm");
+	edit.MoveToEnd(L"X.ICM");
+	edit.ApplyTo(strings);
+	CHECK(strings == MakeList(L"c.icm", L"A.icm", L"X.ICM"));
+}
+
+static void TestMultiStringFormat(void) {
+	vector<wstring> strings = MakeList(L"a.icm", L"b c.icm");
+	wstring data = BuildMultiString(strings);
+	CHECK(data.size() == 15);
+	CHECK(0 == data[5]);
+	CHECK(0 == data[13]);
+	CHECK(0 == data[14]);
+	vector<wstring> parsed;
+	ParseMultiString(data.c_str(), parsed);
+	CHECK(parsed == strings);
+
+	CHECK(BuildMultiString(vector<wstring>()) == wstring(1, 0));
+	ParseMultiString(L"\0", parsed);
+	CHECK(parsed.empty());
+}
+
+// The store follows the registry's rules:  the key must exist, the value need not, and key and
+//  value names are not case-sensitive.  Each Update() is one read and one write.
+//
+static void TestMemoryStore(void) {
+	MemoryMultiStringStore store;
+	MultiStringEdit edit;
+	edit.MoveToEnd(L"a.icm");
+	CHECK(!store.Update(USER_KEY, L"ICMProfile", edit));
+	CHECK(0 == store.GetReadCount());
+	CHECK(0 == store.GetWriteCount());
+
+	store.SetValue(USER_KEY, L"ICMProfile", MakeList(L"a.icm", L"b.icm", L"c.icm"));
+	store.SetValue(SYSTEM_KEY, L"OtherValue", MakeList(L"z.icm"));
+
+	MultiStringEdit batch;
+	batch.InsertAtStart(L"d.icm");
+	batch.Remove(L"B.ICM");
+	batch.MoveToEnd(L"A.icm");
+	wstring lowerCaseKey(USER_KEY);
+	for (size_t i = 0; i < lowerCaseKey.size(); ++i) {
+		lowerCaseKey[i] = towlower(lowerCaseKey[i]);
+	}
+	CHECK(store.Update(lowerCaseKey, L"icmprofile", batch));
+	CHECK(1 == store.GetReadCount());
+	CHECK(1 == store.GetWriteCount());
+	vector<wstring> strings;
+	CHECK(store.GetValue(USER_KEY, L"ICMProfile", strings));
+	CHECK(strings == MakeList(L"d.icm", L"c.icm", L"A.icm"));
+
+	// A missing value is an empty list
+	//
+	CHECK(!store.GetValue(SYSTEM_KEY, L"ICMProfile", strings));
+	CHECK(store.Update(SYSTEM_KEY, L"ICMProfile", edit));
+	CHECK(store.GetValue(SYSTEM_KEY, L"ICMProfile", strings));
+	CHECK(strings == MakeList(L"a.icm"));
+	CHECK(store.GetValue(SYSTEM_KEY, L"OtherValue", strings));
+	CHECK(strings == MakeList(L"z.icm"));
+	CHECK(2 == store.GetReadCount());
+	CHECK(2 == store.GetWriteCount());
+}
+
+// Compare one batched Update() with one Update() per edit, as the code did before batching
+//
+static void BenchmarkBatching(void) {
+	vector<wstring> names;
+	for (int i = 0; i < BENCHMARK_LIST_SIZE; ++i) {
+		wchar_t buf[64];
+		swprintf(buf, 64, L"Display profile %04d.icm", i);
+		names.push_back(buf);
+	}
+	MultiStringEdit batch;
+	vector<MultiStringEdit> singles(BENCHMARK_EDIT_COUNT);
+	for (int i = 0; i < BENCHMARK_EDIT_COUNT; ++i) {
+		const wchar_t * name = names[(i * 7) % BENCHMARK_LIST_SIZE].c_str();
+		if (i % 2) {
+			batch.MoveToEnd(name);
+			singles[i].MoveToEnd(name);
+		} else {
+			batch.Remove(name);
+			singles[i].Remove(name);
+		}
+	}
+
+	MemoryMultiStringStore batchedStore;
+	batchedStore.SetValue(USER_KEY, L"ICMProfile", names);
+	double start = TestSeconds();
+	batchedStore.Update(USER_KEY, L"ICMProfile", batch);
+	double batchedTime = TestSeconds() - start;
+
+	MemoryMultiStringStore singleStore;
+	singleStore.SetValue(USER_KEY, L"ICMProfile", names);
+	start = TestSeconds();
+	for (int i = 0; i < BENCHMARK_EDIT_COUNT; ++i) {
+		singleStore.Update(USER_KEY, L"ICMProfile", singles[i]);
+	}
+	double singleTime = TestSeconds() - start;
+
+	vector<wstring> batchedResult;
+	vector<wstring> singleResult;
+	batchedStore.GetValue(USER_KEY, L"ICMProfile", batchedResult);
+	singleStore.GetValue(USER_KEY, L"ICMProfile", singleResult);
+	CHECK(batchedResult == singleResult);
+	CHECK(1 == batchedStore.GetWriteCount());
+	CHECK(BENCHMARK_EDIT_COUNT == singleStore.GetWriteCount());
+	printf("%d edits to a %d-name list:  batched %u read(s) and %u write(s) in %.4f s, one at a time %u and %u in %.4f s\n",
+			BENCHMARK_EDIT_COUNT,
+			BENCHMARK_LIST_SIZE,
+			batchedStore.GetReadCount(),
+			batchedStore.GetWriteCount(),
+			batchedTime,
+			singleStore.GetReadCount(),
+			singleStore.GetWriteCount(),
+			singleTime );
+}
+
+int main() {
+	TestInsertAtStart();
+	TestRemove();
+	TestMoveToEnd();
+	TestBatchOrder();
+	TestMultiStringFormat();
+	TestMemoryStore();
+	BenchmarkBatching();
+	return TestSummary("MultiStringListTest");
+}
@@ -0,0 +1,129 @@
+// SyntheticProfileTest.cpp -- Tests and a benchmark for the synthetic profile generator
+//
+// The /CT switch checks the corpus against Profile::LoadFullProfile() itself, on Windows.  Here
+//  we check what can be checked anywhere:  that a seed always gives the same bytes, and that the
+//  structural checks LoadFullProfile() makes before decoding anything (header, tag count, tag
+//  table, tag bounds, 'vcgt' table shape) reject exactly the profiles SyntheticProfileShouldLoad()
+//  says should fail, for every profile of the /C corpus.
+//
+
+#include <vector>
+#include "SyntheticProfile.h"
+#include "TestHarness.h"
+
+using std::vector;
+
+// Some constants, matching CorpusExport.h and Profile.cpp
+//
+#define CORPUS_SIZE				10000
+#define CORPUS_SEED				1
+#define ICC_HEADER_SIZE			128
+#define ICC_TAG_ENTRY_SIZE		12
+#define MAX_TAG_COUNT			1024
+#define VCGT_TABLE_HEADER_SIZE	18
+#define DAMAGE_KIND_COUNT		5
+
+static unsigned int Load32(const vector<unsigned char> & bytes, size_t offset) {
+	return (bytes[offset] << 24) | (bytes[offset + 1] << 16) | (bytes[offset + 2] << 8) | bytes[offset + 3];
+}
+
+static unsigned int Load16(const vector<unsigned char> & bytes, size_t offset) {
+	return (bytes[offset] << 8) | bytes[offset + 1];
+}
+
+// Make the checks ParseProfile() makes, in the same order, returning 'false' where it would fail
+//
+static bool PassesParseChecks(const vector<unsigned char> & bytes) {
+	size_t size = bytes.size();
+	if ( size < (ICC_HEADER_SIZE + 4) ) {
+		return false;
+	}
+	unsigned long long tagCount = Load32(bytes, ICC_HEADER_SIZE);
+	if ( tagCount > MAX_TAG_COUNT ) {
+		return false;
+	}
+	if ( ((tagCount * ICC_TAG_ENTRY_SIZE) + ICC_HEADER_SIZE + 4 + 4) > size ) {
+		return false;
+	}
+	long long vcgtOffset = -1;
+	unsigned int vcgtSize = 0;
+	for (size_t i = 0; i < tagCount; ++i) {
+		size_t entry = ICC_HEADER_SIZE + 4 + (i * ICC_TAG_ENTRY_SIZE);
+		unsigned long long offset = Load32(bytes, entry + 4);
+		unsigned long long tagSize = Load32(bytes, entry + 8);
+		if ( (offset + tagSize) > size ) {
+			return false;
+		}
+		if ( 'vcgt' == Load32(bytes, entry) ) {
+			vcgtOffset = static_cast<long long>(offset);
+			vcgtSize = static_cast<unsigned int>(tagSize);
+		}
+	}
+	if ( (vcgtOffset >= 0) && (vcgtSize >= VCGT_TABLE_HEADER_SIZE) && (0 == Load32(bytes, static_cast<size_t>(vcgtOffset) + 8)) ) {
+		unsigned int channels = Load16(bytes, static_cast<size_t>(vcgtOffset) + 12);
+		unsigned int count = Load16(bytes, static_cast<size_t>(vcgtOffset) + 14);
+		unsigned int itemSize = Load16(bytes, static_cast<size_t>(vcgtOffset) + 16);
+		if ( (3 != channels) || (256 != count) || ((1 != itemSize) && (2 != itemSize)) ) {
+			return false;
+		}
+		if ( ((channels * count * itemSize) + VCGT_TABLE_HEADER_SIZE) > vcgtSize ) {
+			return false;
+		}
+	}
+	return true;
+}
+
+static void TestSameSeedSameBytes(void) {
+	SYNTHETIC_PROFILE_OPTIONS options;
+	vector<unsigned char> first;
+	vector<unsigned char> second;
+	for (unsigned int seed = CORPUS_SEED; seed < (CORPUS_SEED + 200); ++seed) {
+		ChooseSyntheticProfileOptions(seed, options);
+		BuildSyntheticProfile(seed, options, first);
+		BuildSyntheticProfile(seed, options, second);
+		CHECK(first == second);
+	}
+}
+
+// Every damaged profile in the corpus must fail, and every clean one must load unless its
+//  'vcgt' table is a size Windows can't use; also time building the corpus
+//
+static void TestCorpus(void) {
+	int kindCount[DAMAGE_KIND_COUNT] = { 0 };
+	int kindMismatch[DAMAGE_KIND_COUNT] = { 0 };
+	SYNTHETIC_PROFILE_OPTIONS options;
+	vector<unsigned char> fileBytes;
+	double buildTime = 0;
+	for (unsigned int i = 0; i < CORPUS_SIZE; ++i) {
+		unsigned int seed = CORPUS_SEED + i;
+		double start = TestSeconds();
+		ChooseSyntheticProfileOptions(seed, options);
+		BuildSyntheticProfile(seed, options, fileBytes);
+		buildTime += TestSeconds() - start;
+		++kindCount[options.damage];
+		if ( PassesParseChecks(fileBytes) != SyntheticProfileShouldLoad(options) ) {
+			++kindMismatch[options.damage];
+		}
+	}
+	for (int kind = 0; kind < DAMAGE_KIND_COUNT; ++kind) {
+		CHECK(0 != kindCount[kind]);
+		CHECK(0 == kindMismatch[kind]);
+		if (kindMismatch[kind]) {
+			printf("Damage kind %d:  %d of %d profiles had the wrong outcome\n", kind, kindMismatch[kind], kindCount[kind]);
+		}
+	}
+	printf("%d synthetic profiles built in %.4f s (%d clean, %d bad tag offset, %d oversized tag count, %d truncated, %d short 'vcgt')\n",
+			CORPUS_SIZE,
+			buildTime,
+			kindCount[0],
+			kindCount[1],
+			kindCount[2],
+			kindCount[3],
+			kindCount[4] );
+}
+
+int main() {
+	TestSameSeedSameBytes();
+	TestCorpus();
+	return TestSummary("SyntheticProfileTest");
+}
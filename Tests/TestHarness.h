@@ -0,0 +1,38 @@
+// TestHarness.h -- Checks and timing for the portable tests and benchmarks
+//
+// The programs in this folder build with any standard C++ compiler (see Makefile), from the
+//  modules of LUT Loader that use only standard C++.  Each one runs its checks, prints a line
+//  for each failure and a summary, and returns nonzero if anything failed.
+//
+
+#pragma once
+#include <stdio.h>
+#include <time.h>
+
+// Global static symbols internal to each test program
+//
+static int testCheckCount = 0;
+static int testFailureCount = 0;
+
+#define CHECK(condition)		TestCheck((condition), #condition, __FILE__, __LINE__)
+
+static void TestCheck(bool passed, const char * conditionText, const char * fileName, int lineNumber) {
+	++testCheckCount;
+	if ( !passed ) {
+		++testFailureCount;
+		printf("%s(%d): check failed: %s\n", fileName, lineNumber, conditionText);
+	}
+}
+
+// Print the summary line and return the program's exit code
+//
+static int TestSummary(const char * testName) {
+	printf("%s: %d checks, %d failed\n", testName, testCheckCount, testFailureCount);
+	return testFailureCount ? 1 : 0;
+}
+
+// Processor time in seconds, for benchmarks
+//
+static double TestSeconds(void) {
+	return static_cast<double>(clock()) / CLOCKS_PER_SEC;
+}
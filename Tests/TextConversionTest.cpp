@@ -0,0 +1,271 @@
+// TextConversionTest.cpp -- Tests and benchmarks for hex dumps and UTF-16 conversion
+//
+// Checks the scalar and SSE2 hex dump rows against rows built with sprintf(), the way Utility.cpp
+//  built them before it formatted from a digit table, for every byte value and for full and
+//  partial rows of several widths, and times all three.  Checks the scalar and SSE2 UTF-16 byte
+//  swap, ASCII scan and ASCII widen against one-unit-at-a-time loops, at every alignment and
+//  length near the block sizes, and times them on tag-sized strings.
+//
+
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+#include <vector>
+#include "TextConversion.h"
+#include "TestHarness.h"
+
+using std::string;
+using std::vector;
+
+// Some constants
+//
+#define BENCHMARK_DUMP_SIZE			(1024 * 1024)
+#define BENCHMARK_ROW_WIDTH			16
+#define BENCHMARK_TEXT_LENGTH		64				// About the size of a profile description
+#define BENCHMARK_TEXT_COUNT		1000000
+
+typedef UTF16_UNIT * (* FORMAT_ROW_FUNCTION)(UTF16_UNIT * p, const unsigned char * data, size_t size, size_t offset, size_t rowWidth);
+typedef void (* BYTE_SWAP_FUNCTION)(const UTF16_UNIT * input, UTF16_UNIT * output, size_t count);
+typedef size_t (* ASCII_LENGTH_FUNCTION)(const char * text);
+typedef void (* WIDEN_FUNCTION)(const char * text, UTF16_UNIT * output, size_t count);
+
+// Format a row with sprintf()
+//
+static string ReferenceRow(const unsigned char * data, size_t size, size_t offset, size_t rowWidth) {
+	char buf[16];
+	sprintf(buf, "0x%04x | ", static_cast<unsigned int>(offset & 0x0FFFF));
+	string s(buf);
+	for (size_t k = offset; k < (offset + rowWidth); ++k) {
+		if ( k < size ) {
+			sprintf(buf, "%02x ", data[k]);
+			s += buf;
+		} else {
+			s += "   ";
+		}
+	}
+	for (size_t k = offset; (k < (offset + rowWidth)) && (k < size); ++k) {
+		int ch = data[k];
+		s += static_cast<char>( ( (ch < 32) || ( (ch > 126) && (ch < 161) ) ) ? '.' : ch );
+	}
+	return s;
+}
+
+// Format every row of 'data' and compare it with the reference, checking that the formatter
+//  writes exactly HexDumpRowLength() units
+//
+static void CheckRows(FORMAT_ROW_FUNCTION formatRow, const unsigned char * data, size_t size, size_t rowWidth) {
+	for (size_t offset = 0; offset < size; offset += rowWidth) {
+		string expected = ReferenceRow(data, size, offset, rowWidth);
+		size_t length = HexDumpRowLength(size, offset, rowWidth);
+		CHECK(expected.size() == length);
+		vector<UTF16_UNIT> row(length + 1, 0xABCD);
+		UTF16_UNIT * end = formatRow(&row[0], data, size, offset, rowWidth);
+		CHECK(end == &row[0] + length);
+		CHECK(0xABCD == row[length]);
+		bool same = true;
+		for (size_t i = 0; i < expected.size(); ++i) {
+			same = same && (static_cast<unsigned char>(expected[i]) == row[i]);
+		}
+		CHECK(same);
+	}
+}
+
+static void CheckFormatter(FORMAT_ROW_FUNCTION formatRow) {
+	unsigned char allBytes[256];
+	for (int i = 0; i < 256; ++i) {
+		allBytes[i] = static_cast<unsigned char>(i);
+	}
+	const size_t rowWidths[] = { 1, 7, 16, 17, 32, 48 };
+	for (size_t w = 0; w < (sizeof(rowWidths) / sizeof(rowWidths[0])); ++w) {
+		for (size_t size = 1; size <= 256; size += 13) {
+			CheckRows(formatRow, allBytes + (256 - size), size, rowWidths[w]);
+		}
+		CheckRows(formatRow, allBytes, 256, rowWidths[w]);
+	}
+
+	// Random data, and an offset past 0xFFFF so the sequence number wraps
+	//
+	vector<unsigned char> randomBytes(0x10000 + 100);
+	for (size_t i = 0; i < randomBytes.size(); ++i) {
+		randomBytes[i] = static_cast<unsigned char>(rand());
+	}
+	CheckRows(formatRow, &randomBytes[0], randomBytes.size(), 16);
+}
+
+static double TimeFormatter(FORMAT_ROW_FUNCTION formatRow, const vector<unsigned char> & data, vector<UTF16_UNIT> & output) {
+	double start = TestSeconds();
+	UTF16_UNIT * p = &output[0];
+	for (size_t offset = 0; offset < data.size(); offset += BENCHMARK_ROW_WIDTH) {
+		p = formatRow(p, &data[0], data.size(), offset, BENCHMARK_ROW_WIDTH);
+		*p++ = '\r';
+		*p++ = '\n';
+	}
+	double elapsed = TestSeconds() - start;
+	CHECK(p == &output[0] + output.size());
+	return elapsed;
+}
+
+static void BenchmarkHexDump(void) {
+	vector<unsigned char> data(BENCHMARK_DUMP_SIZE);
+	for (size_t i = 0; i < data.size(); ++i) {
+		data[i] = static_cast<unsigned char>(rand());
+	}
+	size_t rowCount = BENCHMARK_DUMP_SIZE / BENCHMARK_ROW_WIDTH;
+	vector<UTF16_UNIT> output(rowCount * (HexDumpRowLength(data.size(), 0, BENCHMARK_ROW_WIDTH) + 2));
+
+	double start = TestSeconds();
+	size_t referenceLength = 0;
+	for (size_t offset = 0; offset < data.size(); offset += BENCHMARK_ROW_WIDTH) {
+		referenceLength += ReferenceRow(&data[0], data.size(), offset, BENCHMARK_ROW_WIDTH).size() + 2;
+	}
+	double referenceTime = TestSeconds() - start;
+	CHECK(referenceLength == output.size());
+
+	printf("Hex dump of %d bytes, %d per row:  sprintf %.4f s, scalar %.4f s",
+			BENCHMARK_DUMP_SIZE,
+			BENCHMARK_ROW_WIDTH,
+			referenceTime,
+			TimeFormatter(FormatHexDumpRowScalar, data, output) );
+#if CPU_X86
+	printf(", SSE2 %.4f s", TimeFormatter(FormatHexDumpRowSSE2, data, output));
+#endif
+	printf("\n");
+}
+
+// Swap from every alignment, for lengths on both sides of the 4- and 8-unit blocks, checking
+//  that nothing past 'count' is written
+//
+static void CheckByteSwap(BYTE_SWAP_FUNCTION byteSwap) {
+	unsigned char buffer[2 * 80 + 2];
+	for (size_t i = 0; i < sizeof(buffer); ++i) {
+		buffer[i] = static_cast<unsigned char>(rand());
+	}
+	for (size_t misalign = 0; misalign < 2; ++misalign) {
+		UTF16_UNIT input[80];
+		memcpy(input, buffer + misalign, sizeof(input));
+		for (size_t count = 0; count < 70; ++count) {
+			UTF16_UNIT output[81];
+			output[count] = 0xABCD;
+			byteSwap(input, output, count);
+			bool same = true;
+			for (size_t i = 0; i < count; ++i) {
+				same = same && (output[i] == static_cast<UTF16_UNIT>((input[i] << 8) | (input[i] >> 8)));
+			}
+			CHECK(same);
+			CHECK(0xABCD == output[count]);
+		}
+	}
+}
+
+// Put a stopping byte (NUL or one with the high bit set) at each position of a string that
+//  starts at each alignment
+//
+static void CheckAsciiLength(ASCII_LENGTH_FUNCTION asciiLength) {
+	char buffer[96];
+	const unsigned char stops[] = { 0, 0x80, 0xC3, 0xFF };
+	for (size_t start = 0; start < 16; ++start) {
+		for (size_t length = 0; length < 64; ++length) {
+			for (size_t s = 0; s < sizeof(stops); ++s) {
+				for (size_t i = 0; i < sizeof(buffer); ++i) {
+					buffer[i] = static_cast<char>(1 + (i % 127));
+				}
+				buffer[start + length] = static_cast<char>(stops[s]);
+				buffer[sizeof(buffer) - 1] = 0;
+				CHECK(length == asciiLength(buffer + start));
+			}
+		}
+	}
+}
+
+static void CheckWiden(WIDEN_FUNCTION widen) {
+	char text[64];
+	for (size_t i = 0; i < sizeof(text); ++i) {
+		text[i] = static_cast<char>(i * 2);
+	}
+	for (size_t start = 0; start < 16; ++start) {
+		for (size_t count = 0; count < 40; ++count) {
+			UTF16_UNIT output[41];
+			output[count] = 0xABCD;
+			widen(text + start, output, count);
+			bool same = true;
+			for (size_t i = 0; i < count; ++i) {
+				same = same && (output[i] == static_cast<unsigned char>(text[start + i]));
+			}
+			CHECK(same);
+			CHECK(0xABCD == output[count]);
+		}
+	}
+}
+
+// Convert many description-sized strings, the way Profile.cpp converts tag text
+//
+static double TimeByteSwap(BYTE_SWAP_FUNCTION byteSwap) {
+	UTF16_UNIT input[BENCHMARK_TEXT_LENGTH + 1];
+	UTF16_UNIT output[BENCHMARK_TEXT_LENGTH];
+	for (int i = 0; i <= BENCHMARK_TEXT_LENGTH; ++i) {
+		input[i] = static_cast<UTF16_UNIT>(('A' + (i % 26)) << 8);
+	}
+	unsigned int check = 0;
+	double start = TestSeconds();
+	for (int i = 0; i < BENCHMARK_TEXT_COUNT; ++i) {
+		byteSwap(input + (i & 1), output, BENCHMARK_TEXT_LENGTH);
+		check += output[i % BENCHMARK_TEXT_LENGTH];
+	}
+	double elapsed = TestSeconds() - start;
+	CHECK(0 != check);
+	return elapsed;
+}
+
+static double TimeAsciiToUTF16(ASCII_LENGTH_FUNCTION asciiLength, WIDEN_FUNCTION widen) {
+	char text[BENCHMARK_TEXT_LENGTH + 2];
+	for (int i = 0; i <= BENCHMARK_TEXT_LENGTH; ++i) {
+		text[i] = static_cast<char>('a' + (i % 26));
+	}
+	text[BENCHMARK_TEXT_LENGTH + 1] = 0;
+	UTF16_UNIT output[BENCHMARK_TEXT_LENGTH + 1];
+	unsigned int check = 0;
+	double start = TestSeconds();
+	for (int i = 0; i < BENCHMARK_TEXT_COUNT; ++i) {
+		const char * p = text + (i & 1);
+		size_t length = asciiLength(p);
+		widen(p, output, length);
+		check += output[i % length];
+	}
+	double elapsed = TestSeconds() - start;
+	CHECK(0 != check);
+	return elapsed;
+}
+
+static void BenchmarkConversion(void) {
+	printf("%d strings of %d characters:  byte swap scalar %.4f s", BENCHMARK_TEXT_COUNT, BENCHMARK_TEXT_LENGTH, TimeByteSwap(ByteSwapUTF16Scalar));
+#if CPU_X86
+	printf(", SSE2 %.4f s", TimeByteSwap(ByteSwapUTF16SSE2));
+#endif
+	printf(";  ASCII scan and widen scalar %.4f s", TimeAsciiToUTF16(AsciiLengthScalar, WidenAsciiScalar));
+#if CPU_X86
+	printf(", SSE2 %.4f s", TimeAsciiToUTF16(AsciiLengthSSE2, WidenAsciiSSE2));
+#endif
+	printf("\n");
+}
+
+int main() {
+	CheckFormatter(FormatHexDumpRowScalar);
+	CheckFormatter(FormatHexDumpRow);
+#if CPU_X86
+	CheckFormatter(FormatHexDumpRowSSE2);
+#endif
+	CheckByteSwap(ByteSwapUTF16Scalar);
+	CheckByteSwap(ByteSwapUTF16);
+	CheckAsciiLength(AsciiLengthScalar);
+	CheckAsciiLength(AsciiLength);
+	CheckWiden(WidenAsciiScalar);
+	CheckWiden(WidenAscii);
+#if CPU_X86
+	CheckByteSwap(ByteSwapUTF16SSE2);
+	CheckAsciiLength(AsciiLengthSSE2);
+	CheckWiden(WidenAsciiSSE2);
+#endif
+	BenchmarkHexDump();
+	BenchmarkConversion();
+	return TestSummary("TextConversionTest");
+}
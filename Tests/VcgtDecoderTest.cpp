@@ -0,0 +1,129 @@
+// VcgtDecoderTest.cpp -- Tests and a benchmark for the 'vcgt' table decoders
+//
+// Checks DecodeScalar() and DecodeSSE2() against the one-entry-at-a-time formulas the decoders
+//  replaced, for both item sizes and both ways of widening a byte, at every alignment of the
+//  table, and times each of them over many tables.
+//
+
+#include <stdlib.h>
+#include <string.h>
+#include "VcgtDecoder.h"
+#include "TestHarness.h"
+
+// Some constants
+//
+#define TABLE_BYTES				(2 * VCGT_TABLE_ENTRIES)
+#define BENCHMARK_DECODE_COUNT	200000
+
+typedef unsigned short (* DECODE_FUNCTION)(const unsigned char * items, unsigned short * entries);
+
+// Decode one entry at a time, the way Profile.cpp did before the decoders
+//
+static unsigned short ReferenceDecode(int itemSize, bool bothHalves, const unsigned char * items, unsigned short * entries) {
+	unsigned short allBits = 0;
+	for (int i = 0; i < VCGT_TABLE_ENTRIES; ++i) {
+		if ( 2 == itemSize ) {
+			entries[i] = static_cast<unsigned short>((items[2 * i] << 8) + items[(2 * i) + 1]);
+		} else if (bothHalves) {
+			entries[i] = static_cast<unsigned short>((items[i] << 8) + items[i]);
+		} else {
+			entries[i] = static_cast<unsigned short>(items[i] << 8);
+		}
+		allBits |= entries[i];
+	}
+	return allBits;
+}
+
+// Compare a decoder with the reference on random tables, starting at each offset within 16 bytes
+//
+static void CheckDecoder(DECODE_FUNCTION decode, int itemSize, bool bothHalves) {
+	unsigned char buffer[TABLE_BYTES + 16];
+	for (int trial = 0; trial < 50; ++trial) {
+		for (size_t i = 0; i < sizeof(buffer); ++i) {
+			buffer[i] = static_cast<unsigned char>(rand());
+		}
+		for (int offset = 0; offset < 16; ++offset) {
+			unsigned short expected[VCGT_TABLE_ENTRIES];
+			unsigned short actual[VCGT_TABLE_ENTRIES + 1];
+			actual[VCGT_TABLE_ENTRIES] = 0xABCD;
+			unsigned short expectedBits = ReferenceDecode(itemSize, bothHalves, buffer + offset, expected);
+			unsigned short actualBits = decode(buffer + offset, actual);
+			CHECK(0 == memcmp(expected, actual, sizeof(expected)));
+			CHECK(expectedBits == actualBits);
+			CHECK(0xABCD == actual[VCGT_TABLE_ENTRIES]);
+		}
+	}
+}
+
+// A 2-byte table with every low byte zero is how Profile.cpp spots one mislabeled as 1-byte;
+//  make sure one set bit anywhere in the table shows up in the result
+//
+static void CheckAllBits(DECODE_FUNCTION decode) {
+	unsigned char items[TABLE_BYTES];
+	unsigned short entries[VCGT_TABLE_ENTRIES];
+	for (int i = 0; i < VCGT_TABLE_ENTRIES; ++i) {
+		items[2 * i] = static_cast<unsigned char>(i);
+		items[(2 * i) + 1] = 0;
+	}
+	CHECK(0 == (decode(items, entries) & 0x00FF));
+	for (int i = 0; i < VCGT_TABLE_ENTRIES; i += 97) {
+		items[(2 * i) + 1] = 0x10;
+		CHECK(0x10 == (decode(items, entries) & 0x00FF));
+		items[(2 * i) + 1] = 0;
+	}
+}
+
+static double TimeDecoder(DECODE_FUNCTION decode, const unsigned char * items, unsigned short * entries) {
+	unsigned short allBits = 0;
+	double start = TestSeconds();
+	for (int i = 0; i < BENCHMARK_DECODE_COUNT; ++i) {
+		allBits |= decode(items + (i & 1), entries);
+	}
+	double elapsed = TestSeconds() - start;
+	CHECK(0 != allBits);
+	return elapsed;
+}
+
+static void BenchmarkDecoders(void) {
+	unsigned char items[TABLE_BYTES + 1];
+	unsigned short entries[VCGT_TABLE_ENTRIES];
+	for (size_t i = 0; i < sizeof(items); ++i) {
+		items[i] = static_cast<unsigned char>(i * 7);
+	}
+	printf("%d decodes of a 768-entry table:  2-byte scalar %.4f s", BENCHMARK_DECODE_COUNT, TimeDecoder(VcgtDecoder<2>::DecodeScalar, items, entries));
+#if CPU_X86
+	printf(", SSE2 %.4f s", TimeDecoder(VcgtDecoder<2>::DecodeSSE2, items, entries));
+#endif
+	printf(";  1-byte scalar %.4f s", TimeDecoder(VcgtDecoder<1>::DecodeScalar, items, entries));
+#if CPU_X86
+	printf(", SSE2 %.4f s", TimeDecoder(VcgtDecoder<1>::DecodeSSE2, items, entries));
+#endif
+	printf("\n");
+}
+
+// A processor that always has SSE2 should say so when asked
+//
+static void CheckCpuFeatures(void) {
+#if CPU_X86
+	CHECK(0 != (CpuFeatureBitsEDX() & (1 << 26)) || !CPU_ALWAYS_HAS_SSE2);
+#endif
+	CHECK(CPU_X86 || !CpuHasSSE2());
+}
+
+int main() {
+	CheckCpuFeatures();
+	CheckDecoder(VcgtDecoder<2>::DecodeScalar, 2, true);
+	CheckDecoder(VcgtDecoder<2>::Decode, 2, true);
+	CheckDecoder(VcgtDecoder<1, true>::DecodeScalar, 1, true);
+	CheckDecoder(VcgtDecoder<1, false>::DecodeScalar, 1, false);
+	CheckDecoder(VcgtDecoder<1>::Decode, 1, (0 != USE_BOTH_HALVES));
+	CheckAllBits(VcgtDecoder<2>::DecodeScalar);
+#if CPU_X86
+	CheckDecoder(VcgtDecoder<2>::DecodeSSE2, 2, true);
+	CheckDecoder(VcgtDecoder<1, true>::DecodeSSE2, 1, true);
+	CheckDecoder(VcgtDecoder<1, false>::DecodeSSE2, 1, false);
+	CheckAllBits(VcgtDecoder<2>::DecodeSSE2);
+#endif
+	BenchmarkDecoders();
+	return TestSummary("VcgtDecoderTest");
+}
@@ -0,0 +1,291 @@
+// TextConversion.cpp -- Hex dumps and UTF-16 conversion, in standard C++ and SSE2
+//
+// The hex digits of a dump row are laid out three units per byte ("ab "), a stride SSE2 can't
+//  shuffle into.  So the SSE2 version computes the digits for 16 bytes at once (each nibble
+//  plus '0', plus the gap up to 'a' where the nibble is over 9), widens them in pairs, and
+//  copies each pair into place with one 32-bit store.  The ANSI part is a straight 16-at-a-time
+//  select and widen.
+//
+// UTF-16 byte swapping and ASCII widening need nothing past SSE2 either:  a pair of 16-bit
+//  shifts swaps eight units, and an unpack with zero widens sixteen bytes.
+//
+
+#include <string.h>
+#include "TextConversion.h"
+
+// Some constants
+//
+#define HEX_LETTER_GAP				('a' - '0' - 10)	// Add to a nibble over 9 after adding '0'
+
+// Global static symbols internal to this file
+//
+static const char hexDigits[] = "0123456789abcdef";
+
+// Number of bytes of data in the row that starts at 'offset'
+//
+static size_t RowByteCount(size_t size, size_t offset, size_t rowWidth) {
+	return ( (size - offset) < rowWidth ) ? (size - offset) : rowWidth;
+}
+
+// Write "0x1234 | "; poor man's sequence numbers, so only the low 16 bits of the offset
+//
+static UTF16_UNIT * FormatPrefix(UTF16_UNIT * p, size_t offset) {
+	size_t j = offset & 0x0FFFF;
+	*p++ = '0';
+	*p++ = 'x';
+	*p++ = hexDigits[(j >> 12) & 0x0F];
+	*p++ = hexDigits[(j >> 8) & 0x0F];
+	*p++ = hexDigits[(j >> 4) & 0x0F];
+	*p++ = hexDigits[j & 0x0F];
+	*p++ = ' ';
+	*p++ = '|';
+	*p++ = ' ';
+	return p;
+}
+
+static UTF16_UNIT * FormatHexBytesScalar(UTF16_UNIT * p, const unsigned char * data, size_t count) {
+	for (size_t k = 0; k < count; ++k) {
+		*p++ = hexDigits[data[k] >> 4];
+		*p++ = hexDigits[data[k] & 0x0F];
+		*p++ = ' ';
+	}
+	return p;
+}
+
+// Spaces in place of the missing bytes of a partial last row, to align the ANSI part
+//
+static UTF16_UNIT * FormatPadding(UTF16_UNIT * p, size_t missingCount) {
+	for (size_t k = 0; k < (HEX_DUMP_CHARS_PER_BYTE * missingCount); ++k) {
+		*p++ = ' ';
+	}
+	return p;
+}
+
+// Control characters and 127 through 160 are non-printable using Courier New font, so print a
+//  period instead
+//
+static UTF16_UNIT * FormatAnsiScalar(UTF16_UNIT * p, const unsigned char * data, size_t count) {
+	for (size_t k = 0; k < count; ++k) {
+		unsigned char ch = data[k];
+		if ( (ch < 32) || ( (ch > 126) && (ch < 161) ) ) {
+			*p++ = '.';
+		} else {
+			*p++ = ch;
+		}
+	}
+	return p;
+}
+
+#if CPU_X86
+// Turn sixteen nibbles (one per byte) into lowercase hex digits
+//
+static __m128i HexDigitsSSE2(__m128i nibbles) {
+	__m128i letters = _mm_cmpgt_epi8(nibbles, _mm_set1_epi8(9));
+	__m128i digits = _mm_add_epi8(nibbles, _mm_set1_epi8('0'));
+	return _mm_add_epi8(digits, _mm_and_si128(letters, _mm_set1_epi8(HEX_LETTER_GAP)));
+}
+
+static UTF16_UNIT * FormatHexBytesSSE2(UTF16_UNIT * p, const unsigned char * data, size_t count) {
+	const __m128i nibbleMask = _mm_set1_epi8(0x0F);
+	const __m128i zero = _mm_setzero_si128();
+	size_t blockCount = count / 16;
+	for (size_t i = 0; i < blockCount; ++i) {
+		__m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(data + (16 * i)));
+		__m128i high = HexDigitsSSE2(_mm_and_si128(_mm_srli_epi16(v, 4), nibbleMask));
+		__m128i low = HexDigitsSSE2(_mm_and_si128(v, nibbleMask));
+
+		// Interleave high and low digits and widen them, so that each 32-bit lane holds the
+		//  two UTF-16 digits of one byte, in order
+		//
+		__m128i firstHalf = _mm_unpacklo_epi8(high, low);
+		__m128i secondHalf = _mm_unpackhi_epi8(high, low);
+		unsigned int pairs[16];
+		_mm_storeu_si128(reinterpret_cast<__m128i *>(&pairs[0]), _mm_unpacklo_epi8(firstHalf, zero));
+		_mm_storeu_si128(reinterpret_cast<__m128i *>(&pairs[4]), _mm_unpackhi_epi8(firstHalf, zero));
+		_mm_storeu_si128(reinterpret_cast<__m128i *>(&pairs[8]), _mm_unpacklo_epi8(secondHalf, zero));
+		_mm_storeu_si128(reinterpret_cast<__m128i *>(&pairs[12]), _mm_unpackhi_epi8(secondHalf, zero));
+		for (size_t k = 0; k < 16; ++k) {
+			memcpy(p, &pairs[k], sizeof(pairs[k]));
+			p[2] = ' ';
+			p += HEX_DUMP_CHARS_PER_BYTE;
+		}
+	}
+	return FormatHexBytesScalar(p, data + (16 * blockCount), count - (16 * blockCount));
+}
+
+static UTF16_UNIT * FormatAnsiSSE2(UTF16_UNIT * p, const unsigned char * data, size_t count) {
+	const __m128i zero = _mm_setzero_si128();
+	size_t blockCount = count / 16;
+	for (size_t i = 0; i < blockCount; ++i) {
+		__m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(data + (16 * i)));
+
+		// SSE2 has no unsigned byte compare, but 'x <= n' is 'min(x, n) == x'
+		//
+		__m128i control = _mm_cmpeq_epi8(_mm_min_epu8(v, _mm_set1_epi8(31)), v);
+		__m128i shifted = _mm_sub_epi8(v, _mm_set1_epi8(127));
+		__m128i upper = _mm_cmpeq_epi8(_mm_min_epu8(shifted, _mm_set1_epi8(160 - 127)), shifted);
+		__m128i hidden = _mm_or_si128(control, upper);
+		v = _mm_or_si128(_mm_and_si128(hidden, _mm_set1_epi8('.')), _mm_andnot_si128(hidden, v));
+		_mm_storeu_si128(reinterpret_cast<__m128i *>(p), _mm_unpacklo_epi8(v, zero));
+		_mm_storeu_si128(reinterpret_cast<__m128i *>(p + 8), _mm_unpackhi_epi8(v, zero));
+		p += 16;
+	}
+	return FormatAnsiScalar(p, data + (16 * blockCount), count - (16 * blockCount));
+}
+#endif
+
+// Return the length of the row of a hex dump that starts at 'offset', without a line ending
+//
+size_t HexDumpRowLength(size_t size, size_t offset, size_t rowWidth) {
+	return HEX_DUMP_PREFIX_LENGTH + (HEX_DUMP_CHARS_PER_BYTE * rowWidth) + RowByteCount(size, offset, rowWidth);
+}
+
+// Write one row of a hex & ANSI dump into 'p' (which must have room for HexDumpRowLength()
+//  units), returning the position after it
+//
+UTF16_UNIT * FormatHexDumpRow(UTF16_UNIT * p, const unsigned char * data, size_t size, size_t offset, size_t rowWidth) {
+#if CPU_X86
+	if ( CpuHasSSE2() ) {
+		return FormatHexDumpRowSSE2(p, data, size, offset, rowWidth);
+	}
+#endif
+	return FormatHexDumpRowScalar(p, data, size, offset, rowWidth);
+}
+
+UTF16_UNIT * FormatHexDumpRowScalar(UTF16_UNIT * p, const unsigned char * data, size_t size, size_t offset, size_t rowWidth) {
+	size_t count = RowByteCount(size, offset, rowWidth);
+	p = FormatPrefix(p, offset);
+	p = FormatHexBytesScalar(p, data + offset, count);
+	p = FormatPadding(p, rowWidth - count);
+	return FormatAnsiScalar(p, data + offset, count);
+}
+
+#if CPU_X86
+UTF16_UNIT * FormatHexDumpRowSSE2(UTF16_UNIT * p, const unsigned char * data, size_t size, size_t offset, size_t rowWidth) {
+	size_t count = RowByteCount(size, offset, rowWidth);
+	p = FormatPrefix(p, offset);
+	p = FormatHexBytesSSE2(p, data + offset, count);
+	p = FormatPadding(p, rowWidth - count);
+	return FormatAnsiSSE2(p, data + offset, count);
+}
+#endif
+
+// Swap the bytes of 'count' UTF-16 units, between big-endian and little-endian
+//
+void ByteSwapUTF16(const UTF16_UNIT * input, UTF16_UNIT * output, size_t count) {
+#if CPU_X86
+	if ( CpuHasSSE2() ) {
+		ByteSwapUTF16SSE2(input, output, count);
+		return;
+	}
+#endif
+	ByteSwapUTF16Scalar(input, output, count);
+}
+
+// Swap four units at a time by masking and shifting a 64-bit word; the input is often at an odd
+//  offset inside a tag, so load and store through memcpy()
+//
+void ByteSwapUTF16Scalar(const UTF16_UNIT * input, UTF16_UNIT * output, size_t count) {
+	size_t quadCount = count / 4;
+	for (size_t i = 0; i < quadCount; ++i) {
+		unsigned long long q;
+		memcpy(&q, input + (4 * i), sizeof(q));
+		q = ((q & 0x00FF00FF00FF00FFULL) << 8) | ((q >> 8) & 0x00FF00FF00FF00FFULL);
+		memcpy(output + (4 * i), &q, sizeof(q));
+	}
+	for (size_t i = quadCount * 4; i < count; ++i) {
+		output[i] = static_cast<UTF16_UNIT>((input[i] << 8) | (input[i] >> 8));
+	}
+}
+
+// Return the number of ASCII characters at the start of a NUL-terminated string; if
+//  text[AsciiLength(text)] is NUL, the whole string is ASCII
+//
+size_t AsciiLength(const char * text) {
+#if CPU_X86
+	if ( CpuHasSSE2() ) {
+		return AsciiLengthSSE2(text);
+	}
+#endif
+	return AsciiLengthScalar(text);
+}
+
+size_t AsciiLengthScalar(const char * text) {
+	const unsigned char * p = reinterpret_cast<const unsigned char *>(text);
+	while ( *p && (*p < 0x80) ) {
+		++p;
+	}
+	return p - reinterpret_cast<const unsigned char *>(text);
+}
+
+// Widen 'count' ASCII characters to UTF-16
+//
+void WidenAscii(const char * text, UTF16_UNIT * output, size_t count) {
+#if CPU_X86
+	if ( CpuHasSSE2() ) {
+		WidenAsciiSSE2(text, output, count);
+		return;
+	}
+#endif
+	WidenAsciiScalar(text, output, count);
+}
+
+void WidenAsciiScalar(const char * text, UTF16_UNIT * output, size_t count) {
+	const unsigned char * p = reinterpret_cast<const unsigned char *>(text);
+	for (size_t i = 0; i < count; ++i) {
+		output[i] = p[i];
+	}
+}
+
+#if CPU_X86
+void ByteSwapUTF16SSE2(const UTF16_UNIT * input, UTF16_UNIT * output, size_t count) {
+	size_t blockCount = count / 8;
+	for (size_t i = 0; i < blockCount; ++i) {
+		__m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(input + (8 * i)));
+		v = _mm_or_si128(_mm_slli_epi16(v, 8), _mm_srli_epi16(v, 8));
+		_mm_storeu_si128(reinterpret_cast<__m128i *>(output + (8 * i)), v);
+	}
+	ByteSwapUTF16Scalar(input + (8 * blockCount), output + (8 * blockCount), count - (8 * blockCount));
+}
+
+// Like strlen(), read aligned 16-byte blocks, which can run past the NUL but never into another
+//  page; a block is done when it has no NUL and no byte with the high bit set.  AddressSanitizer
+//  can't tell that read from a real overrun, so it is told to skip this function.
+//
+#if defined(__SANITIZE_ADDRESS__) || defined(__clang__)
+__attribute__((no_sanitize_address))
+#endif
+size_t AsciiLengthSSE2(const char * text) {
+	const unsigned char * p = reinterpret_cast<const unsigned char *>(text);
+	while ( 0 != (reinterpret_cast<size_t>(p) & 15) ) {
+		if ( (0 == *p) || (*p >= 0x80) ) {
+			return p - reinterpret_cast<const unsigned char *>(text);
+		}
+		++p;
+	}
+	const __m128i zero = _mm_setzero_si128();
+	for (;;) {
+		__m128i v = _mm_load_si128(reinterpret_cast<const __m128i *>(p));
+		int stopMask = _mm_movemask_epi8(_mm_or_si128(_mm_cmpeq_epi8(v, zero), v));
+		if (stopMask) {
+			while ( 0 == (stopMask & 1) ) {
+				stopMask >>= 1;
+				++p;
+			}
+			return p - reinterpret_cast<const unsigned char *>(text);
+		}
+		p += 16;
+	}
+}
+
+void WidenAsciiSSE2(const char * text, UTF16_UNIT * output, size_t count) {
+	const __m128i zero = _mm_setzero_si128();
+	size_t blockCount = count / 16;
+	for (size_t i = 0; i < blockCount; ++i) {
+		__m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(text + (16 * i)));
+		_mm_storeu_si128(reinterpret_cast<__m128i *>(output + (16 * i)), _mm_unpacklo_epi8(v, zero));
+		_mm_storeu_si128(reinterpret_cast<__m128i *>(output + (16 * i) + 8), _mm_unpackhi_epi8(v, zero));
+	}
+	WidenAsciiScalar(text + (16 * blockCount), output + (16 * blockCount), count - (16 * blockCount));
+}
+#endif
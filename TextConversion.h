@@ -0,0 +1,45 @@
+// TextConversion.h -- Hex dumps and UTF-16 conversion, in standard C++ and SSE2
+//
+// TextConversion.cpp uses only standard C++ (no <windows.h>, and no precompiled header), like
+//  GraphRaster.cpp, so Tests/TextConversionTest.cpp can check it and time it on any platform.
+//  Text is in UTF-16 code units rather than wchar_t, which is 32 bits outside Windows;
+//  Utility.cpp passes its wchar_t buffers straight through.
+//
+// Each kernel has a scalar version and, on x86 and x64, an SSE2 version; the plain name picks
+//  one with CpuHasSSE2().  The others are public so the tests can compare them.
+//
+
+#pragma once
+#include <stddef.h>
+#include "CpuFeatures.h"
+
+typedef unsigned short UTF16_UNIT;
+
+// Some constants
+//
+#define HEX_DUMP_PREFIX_LENGTH		9			// "0x1234 | "
+#define HEX_DUMP_CHARS_PER_BYTE		3			// "ab "
+
+// A row of a hex dump is "0x1234 | ", then "ab " for each byte (spaces past the end of the
+//  data), then the bytes as ANSI characters with a period for each one Courier New can't show
+//
+size_t HexDumpRowLength(size_t size, size_t offset, size_t rowWidth);
+UTF16_UNIT * FormatHexDumpRow(UTF16_UNIT * p, const unsigned char * data, size_t size, size_t offset, size_t rowWidth);
+UTF16_UNIT * FormatHexDumpRowScalar(UTF16_UNIT * p, const unsigned char * data, size_t size, size_t offset, size_t rowWidth);
+#if CPU_X86
+UTF16_UNIT * FormatHexDumpRowSSE2(UTF16_UNIT * p, const unsigned char * data, size_t size, size_t offset, size_t rowWidth);
+#endif
+
+// Profile text is big-endian UTF-16 ('mluc' and 'desc' tags) or, nearly always, plain ASCII
+//
+void ByteSwapUTF16(const UTF16_UNIT * input, UTF16_UNIT * output, size_t count);
+void ByteSwapUTF16Scalar(const UTF16_UNIT * input, UTF16_UNIT * output, size_t count);
+size_t AsciiLength(const char * text);
+size_t AsciiLengthScalar(const char * text);
+void WidenAscii(const char * text, UTF16_UNIT * output, size_t count);
+void WidenAsciiScalar(const char * text, UTF16_UNIT * output, size_t count);
+#if CPU_X86
+void ByteSwapUTF16SSE2(const UTF16_UNIT * input, UTF16_UNIT * output, size_t count);
+size_t AsciiLengthSSE2(const char * text);
+void WidenAsciiSSE2(const char * text, UTF16_UNIT * output, size_t count);
+#endif
@@ -0,0 +1,154 @@
+// Trace.cpp -- Lightweight timing of startup phases, written as a Chrome trace (chrome://tracing, Perfetto)
+//
+
+#include "stdafx.h"
+#include "Trace.h"
+#include <strsafe.h>
+//#include <banned.h>
+
+// Global static symbols internal to this file
+//
+static bool tracing = false;							// Checked by every TraceScope, so keep it simple
+static wstring * traceFilePath = 0;
+static vector <TRACE_EVENT> * traceEventList = 0;
+static CRITICAL_SECTION traceLock;
+static LONGLONG traceStart = 0;
+static LONGLONG traceFrequency = 1;
+
+// Constructor -- note the start time if we are tracing
+//
+TraceScope::TraceScope(const wchar_t * eventName, const wchar_t * eventDetail) :
+		name(eventName),
+		start(0)
+{
+	if (tracing) {
+		if (eventDetail) {
+			detail = eventDetail;
+		}
+		LARGE_INTEGER now;
+		QueryPerformanceCounter(&now);
+		start = now.QuadPart;
+	}
+}
+
+// Destructor -- record the event
+//
+TraceScope::~TraceScope() {
+	if ( tracing && start ) {
+		LARGE_INTEGER now;
+		QueryPerformanceCounter(&now);
+		TRACE_EVENT traceEvent;
+		traceEvent.name = name;
+		traceEvent.detail = detail;
+		traceEvent.start = start;
+		traceEvent.duration = now.QuadPart - start;
+		traceEvent.threadId = GetCurrentThreadId();
+		EnterCriticalSection(&traceLock);
+		traceEventList->push_back(traceEvent);
+		LeaveCriticalSection(&traceLock);
+	}
+}
+
+// Return 'true' if we are recording events
+//
+bool TraceScope::IsTracing(void) {
+	return tracing;
+}
+
+// Start recording events, to be written to 'tracePath' by StopTracing()
+//
+void StartTracing(const wchar_t * tracePath) {
+	if (tracing) {
+		return;
+	}
+	InitializeCriticalSection(&traceLock);
+	traceFilePath = new wstring(tracePath);
+	traceEventList = new vector <TRACE_EVENT>;
+	traceEventList->reserve(256);
+	LARGE_INTEGER li;
+	QueryPerformanceFrequency(&li);
+	traceFrequency = li.QuadPart ? li.QuadPart : 1;
+	QueryPerformanceCounter(&li);
+	traceStart = li.QuadPart;
+	tracing = true;
+}
+
+// Add a string to JSON output, escaped
+//
+static void AppendJsonString(wstring & json, const wchar_t * text) {
+	wchar_t buf[8];
+	json += L'"';
+	for ( ; *text; ++text ) {
+		switch (*text) {
+			case L'"':
+				json += L"\\\"";
+				break;
+			case L'\\':
+				json += L"\\\\";
+				break;
+			default:
+				if ( *text < 0x20 ) {
+					StringCchPrintf(buf, _countof(buf), L"\\u%04x", *text);
+					json += buf;
+				} else {
+					json += *text;
+				}
+				break;
+		}
+	}
+	json += L'"';
+}
+
+// Stop recording and write the trace file in Chrome's "Trace Event Format" (complete events)
+//
+bool StopTracing(void) {
+	if ( !tracing ) {
+		return false;
+	}
+	tracing = false;
+
+	wchar_t buf[256];
+	wstring json = L"{\"traceEvents\":[\n";
+	DWORD processId = GetCurrentProcessId();
+	size_t count = traceEventList->size();
+	for (size_t i = 0; i < count; ++i) {
+		const TRACE_EVENT & traceEvent = (*traceEventList)[i];
+		double startMicroseconds = static_cast<double>(traceEvent.start - traceStart) * 1000000.0 / traceFrequency;
+		double durationMicroseconds = static_cast<double>(traceEvent.duration) * 1000000.0 / traceFrequency;
+		json += L"{\"name\":";
+		AppendJsonString(json, traceEvent.name);
+		StringCchPrintf(buf, _countof(buf), L",\"cat\":\"LUTloader\",\"ph\":\"X\",\"ts\":%.3f,\"dur\":%.3f,\"pid\":%u,\"tid\":%u",
+				startMicroseconds, durationMicroseconds, processId, traceEvent.threadId);
+		json += buf;
+		if ( !traceEvent.detail.empty() ) {
+			json += L",\"args\":{\"detail\":";
+			AppendJsonString(json, traceEvent.detail.c_str());
+			json += L"}";
+		}
+		json += (i + 1 < count) ? L"},\n" : L"}\n";
+	}
+	json += L"],\"displayTimeUnit\":\"ms\"}\n";
+
+	// Write it as UTF-8
+	//
+	bool success = false;
+	int size = WideCharToMultiByte(CP_UTF8, 0, json.c_str(), static_cast<int>(json.size()), NULL, 0, NULL, NULL);
+	if (size > 0) {
+		char * utf8 = new char[size];
+		WideCharToMultiByte(CP_UTF8, 0, json.c_str(), static_cast<int>(json.size()), utf8, size, NULL, NULL);
+		HANDLE hFile = CreateFile(traceFilePath->c_str(), GENERIC_WRITE, 0, NULL, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, NULL);
+		if ( INVALID_HANDLE_VALUE != hFile ) {
+			DWORD cb = 0;
+			success = WriteFile(hFile, utf8, static_cast<DWORD>(size), &cb, NULL) && (static_cast<DWORD>(size) == cb);
+			CloseHandle(hFile);
+		}
+		delete [] utf8;
+	}
+
+	delete traceEventList;
+	traceEventList = 0;
+	delete traceFilePath;
+	traceFilePath = 0;
+	DeleteCriticalSection(&traceLock);
+	return success;
+}
@@ -0,0 +1,52 @@
+// Trace.h -- Lightweight timing of startup phases, written as a Chrome trace (chrome://tracing, Perfetto)
+//
+// Put TRACE_SCOPE(L"Name") or TRACE_SCOPE_DETAIL(L"Name", detailString) at the top of a block to
+//  time it.  Nothing is recorded unless StartTracing() was called (the /T:file switch), and
+//  with ENABLE_TRACING set to 0 the macros compile to nothing at all.
+//
+
+#pragma once
+#include "stdafx.h"
+
+// Optional "features"
+//
+#define ENABLE_TRACING 1
+
+// One completed timing
+//
+typedef struct tag_TRACE_EVENT {
+	const wchar_t *		name;							// Static string, not copied
+	wstring				detail;							// Monitor or profile name, for example
+	LONGLONG			start;							// QueryPerformanceCounter() ticks
+	LONGLONG			duration;
+	DWORD				threadId;
+} TRACE_EVENT;
+
+// Time a scope, recording it when the scope ends
+//
+class TraceScope {
+
+public:
+	TraceScope(const wchar_t * eventName, const wchar_t * eventDetail = 0);
+	~TraceScope();
+
+	static bool IsTracing(void);
+
+private:
+	const wchar_t *		name;
+	wstring				detail;							// Copied, since it is often from a temporary
+	LONGLONG			start;
+};
+
+void StartTracing(const wchar_t * tracePath);
+bool StopTracing(void);
+
+#if ENABLE_TRACING
+#define TRACE_CONCATENATE_(a, b) a##b
+#define TRACE_CONCATENATE(a, b) TRACE_CONCATENATE_(a, b)
+#define TRACE_SCOPE(name) TraceScope TRACE_CONCATENATE(traceScope, __LINE__)(name)
+#define TRACE_SCOPE_DETAIL(name, detail) TraceScope TRACE_CONCATENATE(traceScope, __LINE__)(name, TraceScope::IsTracing() ? (detail) : 0)
+#else
+#define TRACE_SCOPE(name)
+#define TRACE_SCOPE_DETAIL(name, detail)
+#endif
@@ -5,6 +5,7 @@
 #include "Monitor.h"
 #include "MonitorPage.h"
 #include "MonitorSummaryItem.h"
+#include "ProfileLoader.h"
 #include "resource.h"
 #include "TreeViewItem.h"
 #include "Utility.h"
@@ -68,13 +69,14 @@ void TreeViewItem::Handle_TVN_SELCHANGEDW(MonitorPage * monitorPage, NMTREEVIEWW
 	UNREFERENCED_PARAMETER(pNMTREEVIEWW);
 
 	wstring s;
+	DetailsDocument document;
 	switch (ItemType) {
 		case TREEVIEW_ITEM_TYPE_NONE:
 			s += L"TREEVIEW_ITEM_TYPE_NONE";
 			break;
 
 		case TREEVIEW_ITEM_TYPE_MONITOR:
-			s += MonitorPtr->SummaryString();
+			s += MonitorPtr->SummaryString(monitorPage->GetHwnd());
 			break;
 
 		case TREEVIEW_ITEM_TYPE_USER_PROFILES:
@@ -90,11 +92,11 @@ void TreeViewItem::Handle_TVN_SELCHANGEDW(MonitorPage * monitorPage, NMTREEVIEWW
 			break;
 
 		case TREEVIEW_ITEM_TYPE_USER_PROFILE:
-			s += ProfilePtr->DetailsString();
+			ProfileDetails(monitorPage, document);
 			break;
 
 		case TREEVIEW_ITEM_TYPE_SYSTEM_PROFILE:
-			s += ProfilePtr->DetailsString();
+			ProfileDetails(monitorPage, document);
 			break;
 
 		case TREEVIEW_ITEM_TYPE_OTHER_PROFILES:
@@ -102,11 +104,26 @@ void TreeViewItem::Handle_TVN_SELCHANGEDW(MonitorPage * monitorPage, NMTREEVIEWW
 			break;
 
 		case TREEVIEW_ITEM_TYPE_OTHER_PROFILE:
-			s += ProfilePtr->DetailsString();
+			ProfileDetails(monitorPage, document);
 			break;
 
 	}
-	monitorPage->SetEditControlText(s);
+	document.AddText(s);
+	monitorPage->SetDetailsDocument(document);
+}
+
+// Add the details of our profile to 'document', or a placeholder if it is still being loaded (the
+//  page will get WM_PROFILE_LOADED and select us again)
+//
+void TreeViewItem::ProfileDetails(MonitorPage * monitorPage, DetailsDocument & document) {
+	if ( ProfileLoader::RequestLoad(ProfilePtr, monitorPage->GetHwnd()) ) {
+		ProfilePtr->GetDetails(document);
+		return;
+	}
+	wstring s = L"Loading ";
+	s += ProfilePtr->GetName();
+	s += L" ...";
+	document.AddText(s);
 }
 
 void TreeViewItem::Handle_WM_CONTEXTMENU(MonitorPage * monitorPage, POINT * screenClickPoint) {
@@ -211,8 +228,9 @@ void TreeViewItem::ProfileListContextMenu(MonitorPage * monitorPage, POINT * scr
 	if (changeSetting) {
 		success = monitor->SetActiveProfileIsUserProfile(setUser);
 		if (success) {
-			LUT * pProfileLUT;
+			const LUT * pProfileLUT;
 			if (profile) {
+				profile->LoadFullProfile(false);		// The loader thread may not have reached it yet
 				pProfileLUT = profile->GetLutPointer();
 			} else {
 				pProfileLUT = 0;
@@ -253,7 +271,7 @@ void TreeViewItem::ProfileContextMenu(MonitorPage * monitorPage, POINT * screenC
 	MENUITEMINFO menuItemInfo;
 	TVINSERTSTRUCT tvInsertStruct;
 	int id;
-	LUT * pProfileLUT;
+	const LUT * pProfileLUT;
 	size_t count;
 	bool foundIt;
 	wchar_t buf[1024];
@@ -406,6 +424,7 @@ void TreeViewItem::ProfileContextMenu(MonitorPage * monitorPage, POINT * screenC
 				if ( isUser == monitor->GetActiveProfileIsUserProfile() ) {
 					Profile * profile = monitor->GetActiveProfile();
 					if (profile) {
+						profile->LoadFullProfile(false);
 						pProfileLUT = profile->GetLutPointer();
 					} else {
 						pProfileLUT = 0;
@@ -451,14 +470,16 @@ void TreeViewItem::ProfileContextMenu(MonitorPage * monitorPage, POINT * screenC
 				}
 			}
 			if (!foundIt) {
-				tvInsertStruct.hParent = monitorPage->GetOtherHTREEITEM();
-				tvInsertStruct.hInsertAfter = TVI_LAST;
-				tvInsertStruct.itemex.mask = TVIF_TEXT | TVIF_PARAM | TVIF_STATE | TVIF_IMAGE | TVIF_SELECTEDIMAGE;
-				StringCbCopy(buf, sizeof(buf), ProfilePtr->GetName().c_str());
-				tvInsertStruct.itemex.pszText = buf;
 				ItemType = TREEVIEW_ITEM_TYPE_OTHER_PROFILE;
-				hTreeItem = reinterpret_cast<HTREEITEM>( SendMessage(hwndTreeView, TVM_INSERTITEM, 0, reinterpret_cast<LPARAM>(&tvInsertStruct)) );
-				SendMessage(hwndTreeView, TVM_SORTCHILDREN, FALSE, reinterpret_cast<LPARAM>(tvInsertStruct.hParent));
+				tvInsertStruct.hParent = monitorPage->GetOtherHTREEITEM();
+				tvInsertStruct.hInsertAfter = monitorPage->GetOtherProfileInsertAfter(ProfilePtr);
+				if (tvInsertStruct.hInsertAfter) {
+					tvInsertStruct.itemex.mask = TVIF_TEXT | TVIF_PARAM | TVIF_STATE | TVIF_IMAGE | TVIF_SELECTEDIMAGE;
+					tvInsertStruct.itemex.pszText = LPSTR_TEXTCALLBACK;
+					hTreeItem = reinterpret_cast<HTREEITEM>( SendMessage(hwndTreeView, TVM_INSERTITEM, 0, reinterpret_cast<LPARAM>(&tvInsertStruct)) );
+				} else {
+					hTreeItem = 0;						// The "other" subtree will list it when it is populated
+				}
 			}
 
 			// If we just got a new default profile on the list that we just removed one from, then make it bold
@@ -595,7 +616,7 @@ void TreeViewItem::OtherProfileContextMenu(MonitorPage * monitorPage, POINT * sc
 	Profile * oldDefaultProfile = 0;
 	bool isUser = false;
 	bool settingNewDefault = false;
-	LUT * pProfileLUT = 0;
+	const LUT * pProfileLUT = 0;
 	TREEVIEW_ITEM_TYPE newType = ItemType;
 	SecureZeroMemory(&tvInsertStruct, sizeof(tvInsertStruct));
 	if (ID_ADD_USER_ASSOCIATION == id) {
@@ -620,6 +641,7 @@ void TreeViewItem::OtherProfileContextMenu(MonitorPage * monitorPage, POINT * sc
 		if ( 0 == oldDefaultProfile ) {
 			settingNewDefault = true;
 			if ( isUser == monitor->GetActiveProfileIsUserProfile() ) {
+				ProfilePtr->LoadFullProfile(false);
 				pProfileLUT = ProfilePtr->GetLutPointer();
 				if ( pProfileLUT ) {
 					monitor->WriteLutToCard(pProfileLUT);
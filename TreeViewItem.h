@@ -4,6 +4,7 @@
 #pragma once
 #include "stdafx.h"
 #include <commctrl.h>							// For HTREEITEM
+#include "DetailsView.h"
 
 // Forward references
 //
@@ -41,6 +42,7 @@ public:
 	static HTREEITEM Get_HTREEITEM_ForProfile(HWND hwndTreeView, HTREEITEM subTree, Profile * profile);
 
 private:
+	void ProfileDetails(MonitorPage * monitorPage, DetailsDocument & document);
 	void ProfileListContextMenu(MonitorPage * monitorPage, POINT * screenClickPoint);
 	void ProfileContextMenu(MonitorPage * monitorPage, POINT * screenClickPoint, bool isUser);
 	void OtherProfileContextMenu(MonitorPage * monitorPage, POINT * screenClickPoint);
@@ -3,39 +3,53 @@
 
 #pragma once
 #include "stdafx.h"
+#include "TextConversion.h"
 #include "Utility.h"
 #include <strsafe.h>
 //#include <banned.h>
 
+// Utility.cpp's wchar_t text is UTF-16, so TextConversion.cpp can work straight on it
+//
+C_ASSERT(sizeof(wchar_t) == sizeof(UTF16_UNIT));
+
+// Format a hex dump row into a wchar_t buffer
+//
+static wchar_t * FormatWideHexDumpRow(wchar_t * p, const BYTE * data, size_t size, size_t offset, size_t rowWidth) {
+	return reinterpret_cast<wchar_t *>(FormatHexDumpRow(reinterpret_cast<UTF16_UNIT *>(p), data, size, offset, rowWidth));
+}
+
 // Display data as a hex & ANSI dump
 //
-wstring HexDump(const LPBYTE data, size_t size, size_t rowWidth) {
+wstring HexDump(const BYTE * data, size_t size, size_t rowWidth) {
 	wstring s;
+	if ( (0 == size) || (0 == rowWidth) ) {
+		return s;
+	}
 
+	// Every row but the last is the same length, so we can size the string once and fill it in
+	//
+	size_t rowCount = (size + rowWidth - 1) / rowWidth;
+	size_t lastRow = (rowCount - 1) * rowWidth;
+	size_t length = (rowCount - 1) * (HexDumpRowLength(size, 0, rowWidth) + 2) + HexDumpRowLength(size, lastRow, rowWidth) + 2;
+	s.resize(length);
+	wchar_t * p = &s[0];
 	for (size_t i = 0; i < size; i+=rowWidth) {
-		size_t j, k, l;
-		wchar_t buf[16];
-		j = i & 0x0FFFF;					// Poor man's sequence numbers
-		StringCchPrintf(buf, _countof(buf), L"0x%04x | ", j);
-		s += buf;
-		l = min(i+rowWidth, size);			// Calculate last position for this row
-		for (k = i; k < l; ++k) {			// Print (up to) ROW_WIDTH hex bytes
-			StringCchPrintf(buf, _countof(buf), L"%02x ", data[k]);
-			s += buf;
-		}
-		for (; k < (i+rowWidth); ++k) {		// Handle partial last line
-			s += L"   ";					// Print spaces to align ANSI part
-		}
-		for (k = i; k < l; ++k) {			// Print (up to) rowWidth ANSI characters
-			int wch = static_cast<int>(data[k]);
-			if ( (wch < 32) || ( (wch > 126) && (wch < 161) ) ) {
-				s += L".";					// Non-printable using Courier New font, print a period instead
-			} else {
-				s += static_cast<wchar_t>(wch);
-			}
-		}
-		s += L"\r\n";							// New line after rowWidth bytes
+		p = FormatWideHexDumpRow(p, data, size, i, rowWidth);
+		*p++ = L'\r';						// New line after rowWidth bytes
+		*p++ = L'\n';
+	}
+	return s;
+}
+
+// Format the row of a hex dump that starts at 'offset', without a line ending
+//
+wstring HexDumpLine(const BYTE * data, size_t size, size_t offset, size_t rowWidth) {
+	wstring s;
+	if ( (offset >= size) || (0 == rowWidth) ) {
+		return s;
 	}
+	s.resize(HexDumpRowLength(size, offset, rowWidth));
+	FormatWideHexDumpRow(&s[0], data, size, offset, rowWidth);
 	return s;
 }
 
@@ -240,6 +254,22 @@ bool AnsiToUnicode(char * AnsiText, wchar_t * & RefUnicodeText, DWORD codePage)
 
 	bool success = false;
 
+	// Text in profiles is nearly always plain ASCII, which reads the same in every ANSI code page
+	//  and in UTF-8, so widen that ourselves instead of calling MultiByteToWideChar() twice
+	//
+	if ( (CP_ACP == codePage) || (CP_UTF8 == codePage) ) {
+		size_t characterCount = AsciiLength(AnsiText);
+		if ( 0 == AnsiText[characterCount] ) {
+			RefUnicodeText = reinterpret_cast<wchar_t *>(malloc(sizeof(wchar_t) * (1 + characterCount)));
+			if (RefUnicodeText) {
+				WidenAscii(AnsiText, reinterpret_cast<UTF16_UNIT *>(RefUnicodeText), characterCount);
+				RefUnicodeText[characterCount] = 0;
+				success = true;
+			}
+			return success;
+		}
+	}
+
 	// Call MultiByteToWideChar() to get the required size of the output buffer
 	//
 	int wideStringChars = MultiByteToWideChar(
@@ -281,32 +311,118 @@ bool AnsiToUnicode(char * AnsiText, wchar_t * & RefUnicodeText, DWORD codePage)
 //
 bool ByteSwapUnicode(wchar_t * InputUnicodeText, wchar_t * & RefOutputUnicodeText, size_t InputLengthInCharacters) {
 	bool success = false;
-	wchar_t * inputPtr;
 	size_t characterCount;
 	
 	// Use the provided input length unless it's the default value of -1
 	//
 	if ( -1 == InputLengthInCharacters ) {
-		inputPtr = InputUnicodeText;
-		while (*inputPtr) {
-			++inputPtr;
-		}
-		characterCount = inputPtr - InputUnicodeText;
+		characterCount = wcslen(InputUnicodeText);
 	} else {
 		characterCount = InputLengthInCharacters;
 	}
 
 	RefOutputUnicodeText = reinterpret_cast<wchar_t *>(malloc(sizeof(wchar_t) * (1 + characterCount)));
 	if (RefOutputUnicodeText) {
-		inputPtr = InputUnicodeText;
-		wchar_t * outputPtr = RefOutputUnicodeText;
-		for (size_t i = 0; i < characterCount; ++i) {
-			*outputPtr = swap16(*inputPtr);
-			++inputPtr;
-			++outputPtr;
-		}
-		*outputPtr = 0;
+
+		ByteSwapUTF16(reinterpret_cast<const UTF16_UNIT *>(InputUnicodeText), reinterpret_cast<UTF16_UNIT *>(RefOutputUnicodeText), characterCount);
+		RefOutputUnicodeText[characterCount] = 0;
 		success = true;
 	}
 	return success;
 }
+
+// Compute a cheap 32-bit hash (FNV-1a) of some bytes, for change detection rather than security
+//
+DWORD HashBytes(const void * data, size_t size, DWORD hash) {
+	const BYTE * p = reinterpret_cast<const BYTE *>(data);
+	const BYTE * pEnd = p + size;
+	while ( p < pEnd ) {
+		hash ^= *p++;
+		hash *= FNV_PRIME;
+	}
+	return hash;
+}
+
+// Match text against a pattern with '*' and '?' wildcards, not case-sensitive
+//
+bool WildcardMatch(const wchar_t * pattern, const wchar_t * text) {
+	const wchar_t * starPattern = 0;			// Just past the last '*' we saw
+	const wchar_t * starText = 0;				// Where in 'text' that '*' is currently matching up to
+
+	while (*text) {
+		if ( L'*' == *pattern ) {
+			starPattern = ++pattern;
+			starText = text;
+		} else if ( (L'?' == *pattern) || (towlower(*pattern) == towlower(*text)) ) {
+			++pattern;
+			++text;
+		} else if (starPattern) {
+			pattern = starPattern;				// Let the '*' swallow one more character and try again
+			text = ++starText;
+		} else {
+			return false;
+		}
+	}
+	while ( L'*' == *pattern ) {
+		++pattern;
+	}
+	return ( 0 == *pattern );
+}
+
+// Write text to the console of whoever started us (we are a GUI program and don't have one of
+// our own), or to wherever our output was redirected.  If there is nowhere to write it, send it
+// to the debugger.
+//
+void WriteToConsole(const wstring & text) {
+	static bool attachTried = false;
+	static bool attached = false;
+	if ( !attachTried ) {
+		attachTried = true;
+		attached = ( 0 != AttachConsole(ATTACH_PARENT_PROCESS) );
+	}
+
+	bool success = false;
+	bool closeHandle = false;
+	HANDLE hOut = GetStdHandle(STD_OUTPUT_HANDLE);
+	if ( (0 == hOut || INVALID_HANDLE_VALUE == hOut) && attached ) {
+		hOut = CreateFile(L"CONOUT$", GENERIC_WRITE, FILE_SHARE_WRITE, NULL, OPEN_EXISTING, 0, NULL);
+		closeHandle = true;
+	}
+	if ( hOut && (INVALID_HANDLE_VALUE != hOut) ) {
+		DWORD written = 0;
+		if ( FILE_TYPE_CHAR == GetFileType(hOut) ) {
+			success = ( 0 != WriteConsoleW(hOut, text.c_str(), static_cast<DWORD>(text.size()), &written, NULL) );
+		} else {
+
+			// Redirected to a file or pipe, so write UTF-8
+			//
+			int size = WideCharToMultiByte(CP_UTF8, 0, text.c_str(), static_cast<int>(text.size()), NULL, 0, NULL, NULL);
+			if (size > 0) {
+				char * buf = new char[size];
+				WideCharToMultiByte(CP_UTF8, 0, text.c_str(), static_cast<int>(text.size()), buf, size, NULL, NULL);
+				success = ( 0 != WriteFile(hOut, buf, static_cast<DWORD>(size), &written, NULL) );
+				delete [] buf;
+			}
+		}
+		if (closeHandle) {
+			CloseHandle(hOut);
+		}
+	}
+	if ( !success ) {
+		OutputDebugString(text.c_str());
+	}
+}
+
+// Write a block of bytes to a new file, replacing any file already there
+//
+bool WriteBytesToFile(const wchar_t * filePath, const vector <unsigned char> & fileBytes) {
+	bool success = false;
+	HANDLE hFile = CreateFile(filePath, GENERIC_WRITE, 0, NULL, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, NULL);
+	if ( INVALID_HANDLE_VALUE != hFile ) {
+		DWORD cb = 0;
+		DWORD size = static_cast<DWORD>(fileBytes.size());
+		success = WriteFile(hFile, &fileBytes[0], size, &cb, NULL) && (size == cb);
+		CloseHandle(hFile);
+	}
+	return success;
+}
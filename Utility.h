@@ -4,6 +4,11 @@
 #pragma once
 #include "stdafx.h"
 
+// Starting value for HashBytes() (FNV-1a); pass the previous result instead to hash in pieces
+//
+#define FNV_OFFSET_BASIS	2166136261
+#define FNV_PRIME			16777619
+
 typedef struct tagNAME_LOOKUP
 {
 	DWORD identifier;
@@ -17,7 +22,8 @@ typedef enum tag_FONT_CLASS {
 	FC_DIALOG = 3
 } FONT_CLASS;
 
-wstring HexDump(const LPBYTE data, size_t size, size_t rowWidth);
+wstring HexDump(const BYTE * data, size_t size, size_t rowWidth);
+wstring HexDumpLine(const BYTE * data, size_t size, size_t offset, size_t rowWidth);
 wstring ShowError(
 		const wchar_t * functionName,
 		const LONG errorReturn = 0,
@@ -31,3 +37,7 @@ const wchar_t * LookupName(
 HFONT GetFont(HDC hdc, FONT_CLASS fontClass, bool newCopy = false);
 bool AnsiToUnicode(char * AnsiText, wchar_t * & RefUnicodeText, DWORD codePage = CP_ACP);
 bool ByteSwapUnicode(wchar_t * InputUnicodeText, wchar_t * & RefOutputUnicodeText, size_t InputLengthInCharacters = -1);
+DWORD HashBytes(const void * data, size_t size, DWORD hash = FNV_OFFSET_BASIS);
+bool WildcardMatch(const wchar_t * pattern, const wchar_t * text);
+void WriteToConsole(const wstring & text);
+bool WriteBytesToFile(const wchar_t * filePath, const vector <unsigned char> & fileBytes);
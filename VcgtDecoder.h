@@ -0,0 +1,132 @@
+// VcgtDecoder.h -- Decode the color table of a 'vcgt' tag into a LUT
+//
+// A 'vcgt' color table is three channels of 256 big-endian items, each 1 or 2 bytes, laid out
+//  like a LUT (red, then green, then blue).  The item size is a template parameter, so each size
+//  gets its own straight-line loop over all 768 entries, with no per-entry tests.  Each Decode()
+//  also returns the OR of every entry it produced, which lets the caller check for a mislabeled
+//  table without making another pass over it.
+//
+// Decode() uses SSE2 when the processor has it (always, on x64) and a 64-bit scalar loop
+//  otherwise; both are public so Tests/VcgtDecoderTest.cpp can check one against the other.
+//  SSE2 does each step in one or two instructions (a shift pair to swap bytes, an unpack to
+//  widen them), so there is nothing for SSSE3's pshufb to add.  This header uses only standard
+//  C++ and intrinsics, and writes to the 768 WORDs of a LUT (&lut.red[0]).
+//
+
+#pragma once
+#include <string.h>
+#include "CpuFeatures.h"
+
+// Some constants
+//
+#define VCGT_TABLE_ENTRIES		(3 * 256)				// Entries in all three channels of a LUT
+
+// Optional "features"
+//
+// We can turn a 1-byte item into a LUT entry by just stuffing the byte into the high-order byte
+//  (e.g. 0x56 => 0x5600) or we can distribute the values better by putting the byte into both
+//  halves (e.g. 0x56 => 0x5656).  The template parameter lets the tests try both.
+//
+#define USE_BOTH_HALVES 1
+
+template <int itemSize, bool bothHalves = (0 != USE_BOTH_HALVES)>
+class VcgtDecoder;
+
+// 2-byte items match the LUT except for byte order.  The scalar loop swaps four of them at a
+//  time by masking and shifting a 64-bit word; SSE2 swaps eight.  The table is at an odd offset
+//  inside the tag, so every load is unaligned.
+//
+template <bool bothHalves>
+class VcgtDecoder <2, bothHalves> {
+
+public:
+	static unsigned short Decode(const unsigned char * items, unsigned short * entries) {
+#if CPU_X86
+		if ( CpuHasSSE2() ) {
+			return DecodeSSE2(items, entries);
+		}
+#endif
+		return DecodeScalar(items, entries);
+	}
+
+	static unsigned short DecodeScalar(const unsigned char * items, unsigned short * entries) {
+		unsigned long long allBits = 0;
+		for (size_t i = 0; i < (VCGT_TABLE_ENTRIES / 4); ++i) {
+			unsigned long long q;
+			memcpy(&q, items + (8 * i), sizeof(q));
+			q = ((q & 0x00FF00FF00FF00FFULL) << 8) | ((q >> 8) & 0x00FF00FF00FF00FFULL);
+			memcpy(entries + (4 * i), &q, sizeof(q));
+			allBits |= q;
+		}
+		allBits |= (allBits >> 32);
+		allBits |= (allBits >> 16);
+		return static_cast<unsigned short>(allBits);
+	}
+
+#if CPU_X86
+	static unsigned short DecodeSSE2(const unsigned char * items, unsigned short * entries) {
+		__m128i allBits = _mm_setzero_si128();
+		for (size_t i = 0; i < (VCGT_TABLE_ENTRIES / 8); ++i) {
+			__m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(items + (16 * i)));
+			v = _mm_or_si128(_mm_slli_epi16(v, 8), _mm_srli_epi16(v, 8));
+			_mm_storeu_si128(reinterpret_cast<__m128i *>(entries + (8 * i)), v);
+			allBits = _mm_or_si128(allBits, v);
+		}
+		return FoldBits(allBits);
+	}
+#endif
+
+#if CPU_X86
+	// OR the eight 16-bit lanes together
+	//
+	static unsigned short FoldBits(__m128i v) {
+		v = _mm_or_si128(v, _mm_srli_si128(v, 8));
+		v = _mm_or_si128(v, _mm_srli_si128(v, 4));
+		v = _mm_or_si128(v, _mm_srli_si128(v, 2));
+		return static_cast<unsigned short>(_mm_cvtsi128_si32(v));
+	}
+#endif
+};
+
+// 1-byte items are widened to 16 bits; SSE2 widens sixteen at a time by interleaving the bytes
+//  with themselves (both halves) or with zeros (high byte only)
+//
+template <bool bothHalves>
+class VcgtDecoder <1, bothHalves> {
+
+public:
+	static unsigned short Decode(const unsigned char * items, unsigned short * entries) {
+#if CPU_X86
+		if ( CpuHasSSE2() ) {
+			return DecodeSSE2(items, entries);
+		}
+#endif
+		return DecodeScalar(items, entries);
+	}
+
+	static unsigned short DecodeScalar(const unsigned char * items, unsigned short * entries) {
+		unsigned short allBits = 0;
+		for (size_t i = 0; i < VCGT_TABLE_ENTRIES; ++i) {
+			unsigned short entry = static_cast<unsigned short>(bothHalves ? (items[i] * 0x0101) : (items[i] << 8));
+			entries[i] = entry;
+			allBits |= entry;
+		}
+		return allBits;
+	}
+
+#if CPU_X86
+	static unsigned short DecodeSSE2(const unsigned char * items, unsigned short * entries) {
+		__m128i allBits = _mm_setzero_si128();
+		const __m128i zero = _mm_setzero_si128();
+		for (size_t i = 0; i < (VCGT_TABLE_ENTRIES / 16); ++i) {
+			__m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(items + (16 * i)));
+			__m128i low = _mm_unpacklo_epi8(bothHalves ? v : zero, v);
+			__m128i high = _mm_unpackhi_epi8(bothHalves ? v : zero, v);
+			_mm_storeu_si128(reinterpret_cast<__m128i *>(entries + (16 * i)), low);
+			_mm_storeu_si128(reinterpret_cast<__m128i *>(entries + (16 * i) + 8), high);
+			allBits = _mm_or_si128(allBits, _mm_or_si128(low, high));
+		}
+		return VcgtDecoder<2>::FoldBits(allBits);
+	}
+#endif
+};
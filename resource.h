@@ -16,6 +16,8 @@
 #define IDD_SUMMARY_PAGE_VISTA          201
 #define IDD_MONITOR_PAGE_XP             202
 #define IDD_MONITOR_PAGE_VISTA          203
+#define IDD_DIAGNOSTICS_PAGE_XP         204
+#define IDD_DIAGNOSTICS_PAGE_VISTA      205
 #define IDI_ICON_SETUPAPI_35            300
 #define IDC_SUMMARY_TEXT                1001
 #define IDC_MONITOR_TEXT                1002
@@ -26,6 +28,7 @@
 #define IDC_SUMMARY_LUT                 1007
 #define IDC_LOAD_BUTTON                 1008
 #define IDC_RESCAN_BUTTON               1009
+#define IDC_DIAGNOSTICS_TEXT            1010
 #define ID_WHITEBACKGROUND              40001
 #define ID_BLACKBACKGROUND              40002
 #define ID_GRADIENTBACKGROUND           40003
@@ -43,7 +46,7 @@
 #define _APS_NO_MFC                     1
 #define _APS_NEXT_RESOURCE_VALUE        110
 #define _APS_NEXT_COMMAND_VALUE         40010
-#define _APS_NEXT_CONTROL_VALUE         1010
+#define _APS_NEXT_CONTROL_VALUE         1011
 #define _APS_NEXT_SYMED_VALUE           101
 #endif
 #endif